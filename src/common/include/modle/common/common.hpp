@@ -25,6 +25,15 @@ namespace utils {
   return !ndebug_defined();
 }
 
+/// Return true when per-stage timers and counters should be collected (see profiler.hpp)
+[[maybe_unused]] [[nodiscard]] constexpr bool profiling_enabled() noexcept {
+#ifdef MODLE_ENABLE_PROFILING
+  return true;
+#else
+  return false;
+#endif
+}
+
 // to avoid useless casts (see https://github.com/nlohmann/json/issues/2893#issuecomment-889152324)
 template <class T, class U>
 [[maybe_unused]] [[nodiscard]] constexpr T conditional_static_cast(U value) {
@@ -4,9 +4,11 @@
 
 #pragma once
 #include <cassert>  // for assert
-#include <cmath>    // for log
+#include <cmath>    // for log, pow
 #include <limits>   // for numeric_limits
+#include <vector>   // for vector
 
+#include "modle/common/common.hpp"  // for usize, MODLE_UNLIKELY
 #include "modle/common/random.hpp"  // for generate_canonical
 
 namespace modle {
@@ -60,6 +62,15 @@ class genextreme_value_distribution {
   template <class URNG>
   inline result_type operator()(URNG& g, const param_type& p);
 
+  /// Map a number uniformly distributed in [0, 1) to a number following this distribution.
+
+  //! This is useful to generate numbers in bulk from uniform numbers generated in batches
+  //! (e.g. using random::BatchPRNG::fill_canonical).
+  [[nodiscard]] inline result_type from_canonical(RealType u) const {
+    return from_canonical(u, this->_p);
+  }
+  [[nodiscard]] static inline result_type from_canonical(RealType u, const param_type& p);
+
   // property functions
   [[nodiscard]] inline result_type mu() const { return this->_p.mu(); }
   [[nodiscard]] inline result_type sigma() const { return this->_p.sigma(); }
@@ -88,19 +99,94 @@ template <class RealType>
 template <class URNG>
 [[nodiscard]] inline typename genextreme_value_distribution<RealType>::result_type
 genextreme_value_distribution<RealType>::operator()(URNG& g, const param_type& p) {
+  return from_canonical(
+      random::generate_canonical<RealType, std::numeric_limits<RealType>::digits>(g), p);
+}
+
+template <class RealType>
+[[nodiscard]] inline typename genextreme_value_distribution<RealType>::result_type
+genextreme_value_distribution<RealType>::from_canonical(const RealType u, const param_type& p) {
   if (p.xi() == RealType(0)) {
-    return (p.mu() - p.sigma()) *
-           std::log(-std::log(
-               random::generate_canonical<RealType, std::numeric_limits<RealType>::digits>(g)));
+    return (p.mu() - p.sigma()) * std::log(-std::log(u));
+  }
+
+  return p.mu() + (p.sigma() * (RealType(1) - std::pow(-std::log(u), p.xi()))) / p.xi();
+}
+
+/// Fast approximation of genextreme_value_distribution based on a precomputed inverse CDF table.
+
+//! The inverse CDF is tabulated at table_size equally spaced points in [0, 1), and numbers are
+//! generated by linear interpolation between the two points surrounding a uniform number.
+//! The inverse CDF is very steep (or unbounded) close to 0 and 1, so numbers falling in the first
+//! and last table_size / 64 intervals of the table are computed analytically (i.e. ~3% of the
+//! draws). With the default table size, the interpolation error is then well below 1 bp for the
+//! range of parameters used to randomize molecular contacts.
+template <class RealType = double>
+class tabulated_genextreme_value_distribution {
+ public:
+  using result_type = RealType;
+  using param_type = typename genextreme_value_distribution<RealType>::param_type;
+  static constexpr usize default_table_size = usize(1) << 12U;
+
+ private:
+  param_type _p{};
+  std::vector<RealType> _table{};
+
+ public:
+  tabulated_genextreme_value_distribution() = default;
+  inline explicit tabulated_genextreme_value_distribution(
+      result_type mu, result_type sigma = 1, result_type xi = 0.1,
+      usize table_size = default_table_size);
+  inline explicit tabulated_genextreme_value_distribution(const param_type& p,
+                                                          usize table_size = default_table_size);
+
+  template <class URNG>
+  [[nodiscard]] inline result_type operator()(URNG& g) const {
+    return this->from_canonical(
+        random::generate_canonical<RealType, std::numeric_limits<RealType>::digits>(g));
+  }
+  /// Map a number uniformly distributed in [0, 1) to a number following this distribution
+  [[nodiscard]] inline result_type from_canonical(RealType u) const;
+
+  [[nodiscard]] inline result_type mu() const { return this->_p.mu(); }
+  [[nodiscard]] inline result_type sigma() const { return this->_p.sigma(); }
+  [[nodiscard]] inline result_type xi() const { return this->_p.xi(); }
+  [[nodiscard]] inline param_type param() const { return this->_p; }
+  [[nodiscard]] inline usize table_size() const { return this->_table.size(); }
+  [[nodiscard]] inline bool empty() const { return this->_table.empty(); }
+};
+
+template <class RealType>
+inline tabulated_genextreme_value_distribution<RealType>::tabulated_genextreme_value_distribution(
+    result_type mu, result_type sigma, result_type xi, usize table_size)
+    : tabulated_genextreme_value_distribution(param_type(mu, sigma, xi), table_size) {}
+
+template <class RealType>
+inline tabulated_genextreme_value_distribution<RealType>::tabulated_genextreme_value_distribution(
+    const param_type& p, usize table_size)
+    : _p(p), _table(table_size + 1) {
+  assert(table_size >= 128);
+  for (usize i = 0; i <= table_size; ++i) {
+    const auto u = static_cast<RealType>(i) / static_cast<RealType>(table_size);
+    this->_table[i] = genextreme_value_distribution<RealType>::from_canonical(u, this->_p);
+  }
+}
+
+template <class RealType>
+inline auto tabulated_genextreme_value_distribution<RealType>::from_canonical(RealType u) const
+    -> result_type {
+  assert(!this->empty());
+  assert(u >= 0 && u < 1);
+  const auto table_size = this->_table.size() - 1;
+  const auto tail_size = table_size / 64;
+  const auto x = u * static_cast<RealType>(table_size);
+  const auto i = static_cast<usize>(x);
+
+  if (MODLE_UNLIKELY(i < tail_size || i >= table_size - tail_size)) {
+    return genextreme_value_distribution<RealType>::from_canonical(u, this->_p);
   }
 
-  return p.mu() +
-         (p.sigma() *
-          (RealType(1) -
-           std::pow(
-               -std::log(
-                   random::generate_canonical<RealType, std::numeric_limits<RealType>::digits>(g)),
-               p.xi()))) /
-             p.xi();
+  const auto t = x - static_cast<RealType>(i);
+  return this->_table[i] + (t * (this->_table[i + 1] - this->_table[i]));
 }
 }  // namespace modle
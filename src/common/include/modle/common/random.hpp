@@ -4,8 +4,11 @@
 
 #pragma once
 
+#include <absl/types/span.h>           // for Span
 #include <xoshiro-cpp/XoshiroCpp.hpp>  // for SplitMix64, Xoshiro256PlusPlus
 
+#include <array>  // for array
+
 #include "modle/common/common.hpp"  // for u64
 
 #ifdef MODLE_WITH_BOOST_RANDOM
@@ -37,8 +40,8 @@ template <class N>
 using binomial_distribution = boost::random::binomial_distribution<N>;
 template <class N>
 using discrete_distribution = boost::random::discrete_distribution<N>;
-template <class N, usize bits>
-inline N generate_canonical(random::PRNG_t& rand_eng) {
+template <class N, usize bits, class URBG>
+inline N generate_canonical(URBG& rand_eng) {
   return boost::random::generate_canonical<N, bits>(rand_eng);
 }
 template <class N>
@@ -58,8 +61,8 @@ template <class N>
 using binomial_distribution = std::binomial_distribution<N>;
 template <class N>
 using discrete_distribution = std::discrete_distribution<N>;
-template <class N, usize bits>
-inline N generate_canonical(random::PRNG_t& rand_eng) {
+template <class N, usize bits, class URBG>
+inline N generate_canonical(URBG& rand_eng) {
   return std::generate_canonical<N, bits>(rand_eng);
 }
 template <class N>
@@ -75,4 +78,62 @@ using random_device = std::random_device;
 
 #endif
 
+/// Xoshiro256++ PRNG advancing several independent streams (lanes) in lock-step
+
+//! The state of the lanes is stored as a structure of arrays, so that advancing all lanes at once
+//! can be vectorized by the compiler.
+//! The fill_* methods are meant to be used to draw all the numbers required by a simulation step
+//! with a single call. operator() serves numbers from an internal buffer that is refilled in
+//! batches, which makes BatchPRNG a UniformRandomBitGenerator that can be used together with the
+//! distributions defined above (e.g. for draws whose number is not known in advance).
+//! The sequence of numbers generated by a BatchPRNG is fully determined by its seed.
+class BatchPRNG {
+ public:
+  using result_type = u64;
+  static constexpr usize num_lanes = 4;
+
+ private:
+  static constexpr usize buff_capacity = 16 * num_lanes;
+  std::array<std::array<u64, num_lanes>, 4> _state{};
+  std::array<u64, buff_capacity> _buff{};
+  usize _buff_idx{buff_capacity};
+
+ public:
+  constexpr BatchPRNG() noexcept;
+  constexpr explicit BatchPRNG(u64 seed) noexcept;
+
+  [[nodiscard]] static constexpr result_type min() noexcept;
+  [[nodiscard]] static constexpr result_type max() noexcept;
+  [[nodiscard]] constexpr result_type operator()() noexcept;
+
+  /// Fill \p buff with random 64-bit integers
+  constexpr void fill(absl::Span<u64> buff) noexcept;
+  /// Fill \p buff with doubles uniformly distributed in the [0, 1) interval
+  constexpr void fill_canonical(absl::Span<double> buff) noexcept;
+  /// Fill \p buff with integers uniformly distributed in the [lb, ub] interval
+  inline void fill_uniform_int(absl::Span<u64> buff, u64 lb, u64 ub) noexcept;
+  /// Fill \p buff with the outcome of Bernoulli trials with probability of success \p p
+  constexpr void fill_bernoulli(absl::Span<bool> buff, double p) noexcept;
+  /// Fill \p buff with normally distributed doubles (Box-Muller transform)
+  inline void fill_normal(absl::Span<double> buff, double mean = 0.0, double stddev = 1.0) noexcept;
+
+ private:
+  /// Advance all lanes, writing one number per lane to \p out
+  constexpr void next(u64* out) noexcept;
+  [[nodiscard]] static constexpr u64 rotl(u64 x, int k) noexcept;
+  [[nodiscard]] static constexpr double to_canonical(u64 x) noexcept;
+};
+
+/// Draw the number of Bernoulli trials with probability of success \p p up to and including the
+/// first success (i.e. a geometric distribution with support {1, 2, ...})
+
+//! Returns std::numeric_limits<u64>::max() when p is 0, or when the number of trials would exceed
+//! 2^62. Callers should treat this value as "never": adding it to a counter (e.g. the current
+//! epoch) overflows, so callers must check for it before adding the result to a counter.
+//! Any other value is at most 2^62, and can be added to counters smaller than 2^62.
+template <class URBG>
+[[nodiscard]] inline u64 geometric_trials(double p, URBG& rand_eng) noexcept;
+
 }  // namespace modle::random
+
+#include "../../../random_impl.hpp"  // IWYU pragma: export
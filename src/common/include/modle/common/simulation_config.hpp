@@ -6,6 +6,7 @@
 
 #include <absl/types/span.h>  // for Span
 
+#include <algorithm>  // for clamp
 #include <bitflags/bitflags.hpp>
 #include <cmath>       // for round
 #include <filesystem>  // for path
@@ -26,6 +27,7 @@ struct Config {
   friend Simulation;
 
   enum class StoppingCriterion : u8f { contact_density, simulation_epochs };
+  enum class TaskFileFormat : u8f { tsv, binary };
 
   // Even though we don't have any use for a none flag, it is required in order
   // for the automatically generated enum values make sense.
@@ -43,6 +45,7 @@ struct Config {
   std::filesystem::path path_to_config_file{};
   std::filesystem::path path_to_log_file;
   std::filesystem::path path_to_model_state_log_file;
+  std::filesystem::path path_to_profile_report;
   std::filesystem::path path_to_lef_1d_occupancy_bw_file;
   std::filesystem::path path_to_extr_barriers;
   bool force{false};
@@ -53,9 +56,11 @@ struct Config {
   std::filesystem::path path_to_deletion_bed{};
   std::filesystem::path path_to_task_file;
   std::filesystem::path path_to_task_filter_file{};
+  TaskFileFormat task_file_format{TaskFileFormat::tsv};
   bool write_header{true};
   bool skip_output{false};
   bool log_model_internal_state{false};
+  bool write_profile_report{false};
 
   // Stopping criteria
   usize target_simulation_epochs{2000};
@@ -72,6 +77,7 @@ struct Config {
   double genextreme_mu{0};
   double genextreme_sigma{5'000};
   double genextreme_xi{0.001};
+  bool tabulate_contact_noise{false};
 
   // LEFs params
   bp_t fwd_extrusion_speed{bin_size * 8 / 10};  // 80% of the bin size
@@ -98,6 +104,8 @@ struct Config {
   double probability_of_extrusion_unit_bypass{0.1};
   double lef_bar_major_collision_pblock{1.0};
   double lef_bar_minor_collision_pblock{0.0};
+  bool fused_collision_pipeline{false};
+  bool fast_sampling{false};
 
   // Miscellaneous
   bool simulate_chromosomes_wo_barriers{false};
@@ -106,11 +114,14 @@ struct Config {
   u64 seed{0};
   bp_t probability_normalization_factor{rev_extrusion_speed + fwd_extrusion_speed};
   bool normalize_probabilities{true};
+  usize max_memory{0};  // In bytes. 0 means that the memory budget is computed automatically
 
   // MoDLE perturbate
   bp_t deletion_size{10'000};
   bool compute_reference_matrix{false};
   usize block_size{9};
+  bool warm_start{false};
+  usize warm_start_epochs{100};  // Burn-in epochs used to re-equilibrate warm-started cells
 
   // Burn-in
   bool skip_burnin{false};
@@ -132,6 +143,38 @@ struct Config {
 
   absl::Span<char*> args;
   std::string argv_json{};
+
+  // The following two functions are the same as those defined by the ExtrusionBarrier class.
+  // This is not ideal, but I think it is better than making the CLI interface depend on the
+  // ExtrusionBarrier class (which is part of libmodle_internal)
+  [[nodiscard]] static constexpr double compute_stp_active_from_occupancy(
+      double stp_inactive, double occupancy) noexcept;
+  [[nodiscard]] static constexpr double compute_occupancy_from_stp(double stp_active,
+                                                                   double stp_inactive) noexcept;
 };
 
+constexpr double Config::compute_stp_active_from_occupancy(double stp_inactive,
+                                                           double occupancy) noexcept {
+  if (MODLE_UNLIKELY(occupancy == 0)) {
+    return 0.0;
+  }
+
+  const auto tp_inactive_to_active = 1.0 - stp_inactive;
+  const auto tp_active_to_inactive =
+      (tp_inactive_to_active - (occupancy * tp_inactive_to_active)) / occupancy;
+  return std::clamp(1.0 - tp_active_to_inactive, 0.0, 1.0);
+}
+
+constexpr double Config::compute_occupancy_from_stp(double stp_active,
+                                                    double stp_inactive) noexcept {
+  if (MODLE_UNLIKELY(stp_active + stp_inactive == 0)) {
+    return 0.0;
+  }
+
+  const auto tp_inactive_to_active = 1.0 - stp_inactive;
+  const auto tp_active_to_inactive = 1.0 - stp_active;
+  const auto occupancy = tp_inactive_to_active / (tp_inactive_to_active + tp_active_to_inactive);
+  return std::clamp(occupancy, 0.0, 1.0);
+}
+
 }  // namespace modle
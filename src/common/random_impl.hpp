@@ -0,0 +1,184 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// IWYU pragma: private, include "modle/common/random.hpp"
+
+#include <absl/numeric/int128.h>       // for uint128, Uint128High64, Uint128Low64
+#include <absl/types/span.h>           // for Span
+#include <xoshiro-cpp/XoshiroCpp.hpp>  // for SplitMix64
+
+#include <array>    // for array
+#include <cassert>  // for assert
+#include <cmath>    // for cos, floor, log, log1p, sin, sqrt
+#include <limits>   // for numeric_limits
+#include <tuple>    // for tie
+#include <utility>  // for make_pair
+
+#include "modle/common/common.hpp"  // for u64, usize
+
+namespace modle::random {
+
+constexpr BatchPRNG::BatchPRNG() noexcept : BatchPRNG(u64(0)) {}
+
+constexpr BatchPRNG::BatchPRNG(u64 seed) noexcept {
+  auto seeder = XoshiroCpp::SplitMix64(seed);
+  for (auto& state : this->_state) {
+    for (auto& s : state) {
+      s = seeder();
+    }
+  }
+}
+
+constexpr auto BatchPRNG::min() noexcept -> result_type { return 0; }
+
+constexpr auto BatchPRNG::max() noexcept -> result_type {
+  return (std::numeric_limits<result_type>::max)();
+}
+
+constexpr auto BatchPRNG::operator()() noexcept -> result_type {
+  if (MODLE_UNLIKELY(this->_buff_idx == this->_buff.size())) {
+    for (usize i = 0; i < this->_buff.size(); i += num_lanes) {
+      this->next(this->_buff.data() + i);
+    }
+    this->_buff_idx = 0;
+  }
+  return this->_buff[this->_buff_idx++];
+}
+
+constexpr void BatchPRNG::fill(absl::Span<u64> buff) noexcept {
+  usize i = 0;
+  for (; i + num_lanes <= buff.size(); i += num_lanes) {
+    this->next(buff.data() + i);
+  }
+
+  if (i != buff.size()) {
+    std::array<u64, num_lanes> tail{};
+    this->next(tail.data());
+    for (usize j = 0; j < num_lanes && i < buff.size(); ++i, ++j) {
+      buff[i] = tail[j];
+    }
+  }
+}
+
+constexpr void BatchPRNG::fill_canonical(absl::Span<double> buff) noexcept {
+  std::array<u64, num_lanes> chunk{};
+  for (usize i = 0; i < buff.size(); i += num_lanes) {
+    this->next(chunk.data());
+    for (usize j = 0; j < num_lanes && i + j < buff.size(); ++j) {
+      buff[i + j] = to_canonical(chunk[j]);
+    }
+  }
+}
+
+inline void BatchPRNG::fill_uniform_int(absl::Span<u64> buff, u64 lb, u64 ub) noexcept {
+  assert(lb <= ub);
+  this->fill(buff);
+  const auto range = ub - lb + 1;
+  if (MODLE_UNLIKELY(range == 0)) {  // [lb, ub] spans all 64-bit integers
+    return;
+  }
+
+  // Map numbers to [lb, ub] using Lemire's nearly divisionless method.
+  // Rejected numbers are replaced by drawing from the internal buffer
+  for (auto& n : buff) {
+    auto m = absl::uint128(n) * range;
+    if (MODLE_UNLIKELY(absl::Uint128Low64(m) < range)) {
+      const auto threshold = (0 - range) % range;
+      while (absl::Uint128Low64(m) < threshold) {
+        m = absl::uint128((*this)()) * range;
+      }
+    }
+    n = lb + absl::Uint128High64(m);
+  }
+}
+
+constexpr void BatchPRNG::fill_bernoulli(absl::Span<bool> buff, double p) noexcept {
+  assert(p >= 0.0 && p <= 1.0);
+  std::array<u64, num_lanes> chunk{};
+  for (usize i = 0; i < buff.size(); i += num_lanes) {
+    this->next(chunk.data());
+    for (usize j = 0; j < num_lanes && i + j < buff.size(); ++j) {
+      buff[i + j] = to_canonical(chunk[j]) < p;
+    }
+  }
+}
+
+inline void BatchPRNG::fill_normal(absl::Span<double> buff, double mean, double stddev) noexcept {
+  assert(stddev >= 0.0);
+  constexpr auto two_pi = 6.283185307179586;
+  auto box_muller = [&](double u1, double u2) {
+    // u1 is mapped to (0, 1] to avoid computing log(0)
+    const auto r = stddev * std::sqrt(-2.0 * std::log(1.0 - u1));
+    const auto theta = two_pi * u2;
+    return std::make_pair(mean + r * std::cos(theta), mean + r * std::sin(theta));
+  };
+
+  const auto num_pairs = buff.size() / 2;
+  this->fill_canonical(buff.subspan(0, 2 * num_pairs));
+  for (usize i = 0; i < 2 * num_pairs; i += 2) {
+    std::tie(buff[i], buff[i + 1]) = box_muller(buff[i], buff[i + 1]);
+  }
+
+  if (buff.size() % 2 != 0) {
+    const auto u1 = to_canonical((*this)());
+    const auto u2 = to_canonical((*this)());
+    buff.back() = box_muller(u1, u2).first;
+  }
+}
+
+constexpr void BatchPRNG::next(u64* out) noexcept {
+  auto& s0 = this->_state[0];
+  auto& s1 = this->_state[1];
+  auto& s2 = this->_state[2];
+  auto& s3 = this->_state[3];
+  // Each iteration of this loop is independent from the others, and the loop is simple enough to
+  // be vectorized by the compiler
+  for (usize i = 0; i < num_lanes; ++i) {
+    out[i] = rotl(s0[i] + s3[i], 23) + s0[i];
+
+    const auto t = s1[i] << 17U;
+    s2[i] ^= s0[i];
+    s3[i] ^= s1[i];
+    s1[i] ^= s2[i];
+    s0[i] ^= s3[i];
+    s2[i] ^= t;
+    s3[i] = rotl(s3[i], 45);
+  }
+}
+
+constexpr u64 BatchPRNG::rotl(u64 x, int k) noexcept {
+  return (x << static_cast<u64>(k)) | (x >> static_cast<u64>(64 - k));
+}
+
+constexpr double BatchPRNG::to_canonical(u64 x) noexcept {
+  // Use the 53 most significant bits to generate a double in the [0, 1) interval
+  constexpr auto scale = 1.0 / static_cast<double>(u64(1) << 53U);
+  return static_cast<double>(x >> 11U) * scale;
+}
+
+template <class URBG>
+inline u64 geometric_trials(const double p, URBG& rand_eng) noexcept {
+  assert(p >= 0.0 && p <= 1.0);
+  constexpr auto never = (std::numeric_limits<u64>::max)();
+  constexpr auto max_trials = u64(1) << 62U;
+  if (MODLE_UNLIKELY(p <= 0.0)) {
+    return never;
+  }
+  if (MODLE_UNLIKELY(p >= 1.0)) {
+    return 1;
+  }
+
+  // Inversion: given U ~ U[0, 1), 1 + floor(log(1 - U) / log(1 - p)) is geometrically
+  // distributed, as P(K > k) = P(1 - U <= (1 - p)^k) = (1 - p)^k
+  const auto u = generate_canonical<double, std::numeric_limits<double>::digits>(rand_eng);
+  const auto k = std::floor(std::log1p(-u) / std::log1p(-p));
+  if (MODLE_UNLIKELY(k >= static_cast<double>(max_trials))) {
+    return never;
+  }
+  return u64(1) + static_cast<u64>(k);
+}
+
+}  // namespace modle::random
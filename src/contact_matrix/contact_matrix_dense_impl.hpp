@@ -10,10 +10,11 @@
 
 #include <algorithm>     // for min, clamp
 #include <array>         // for array
+#include <atomic>        // for memory_order_relaxed
 #include <cassert>       // for assert
 #include <cmath>         // for sqrt
 #include <limits>        // for numeric_limits
-#include <mutex>         // for unique_lock
+#include <mutex>         // for unique_lock, try_to_lock
 #include <shared_mutex>  // for shared_lock, shared_mutex
 #include <stdexcept>     // for runtime_error, logic_error
 #include <utility>       // for make_pair, pair
@@ -34,7 +35,8 @@ ContactMatrixDense<N>::ContactMatrixDense(const ContactMatrixDense<N> &other)
       _tot_contacts(other._tot_contacts.load()),
       _nnz(other._nnz.load()),
       _global_stats_outdated(other._global_stats_outdated.load()),
-      _updates_missed(other._updates_missed.load()) {}
+      _updates_missed(other._updates_missed.load()),
+      _lock_waits(other._lock_waits.load()) {}
 
 template <class N>
 ContactMatrixDense<N>::ContactMatrixDense(const usize nrows, const usize ncols)
@@ -86,6 +88,7 @@ ContactMatrixDense<N> &ContactMatrixDense<N>::operator=(const ContactMatrixDense
   _nnz = other._nnz.load();
   _global_stats_outdated = other._global_stats_outdated.load();
   _updates_missed = other._updates_missed.load();
+  _lock_waits = other._lock_waits.load();
 
   return *this;
 }
@@ -93,8 +96,16 @@ ContactMatrixDense<N> &ContactMatrixDense<N>::operator=(const ContactMatrixDense
 template <class N>
 std::unique_lock<typename ContactMatrixDense<N>::mutex_t> ContactMatrixDense<N>::lock_pixel(
     usize row, usize col) const {
-  return std::unique_lock<ContactMatrixDense<N>::mutex_t>(
-      this->_mtxes[this->get_pixel_mutex_idx(row, col)]);
+  auto &mtx = this->_mtxes[this->get_pixel_mutex_idx(row, col)];
+  if constexpr (utils::profiling_enabled()) {
+    std::unique_lock<ContactMatrixDense<N>::mutex_t> lck(mtx, std::try_to_lock);
+    if (MODLE_UNLIKELY(!lck.owns_lock())) {
+      this->_lock_waits.fetch_add(1, std::memory_order_relaxed);
+      lck.lock();
+    }
+    return lck;
+  }
+  return std::unique_lock<ContactMatrixDense<N>::mutex_t>(mtx);
 }
 
 template <class N>
@@ -124,11 +135,24 @@ constexpr usize ContactMatrixDense<N>::get_n_of_missed_updates() const noexcept
   return this->_updates_missed.load();
 }
 
+template <class N>
+constexpr usize ContactMatrixDense<N>::get_n_of_lock_waits() const noexcept {
+  return this->_lock_waits.load();
+}
+
 template <class N>
 constexpr usize ContactMatrixDense<N>::get_matrix_size_in_bytes() const {
   return ((this->npixels() + 1) * sizeof(N)) + (this->_mtxes.size() * sizeof(mutex_t));
 }
 
+template <class N>
+usize ContactMatrixDense<N>::compute_matrix_size_in_bytes(usize nrows, const usize ncols) noexcept {
+  // Refer to ContactMatrixDense(usize, usize)
+  nrows = std::min(nrows, ncols);
+  return ((nrows * ncols + 1) * sizeof(N)) +
+         (compute_number_of_mutexes(nrows, ncols) * sizeof(mutex_t));
+}
+
 template <class N>
 void ContactMatrixDense<N>::clear_missed_updates_counter() {
   this->_updates_missed = 0;
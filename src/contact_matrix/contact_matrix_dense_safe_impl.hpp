@@ -65,6 +65,34 @@ void ContactMatrixDense<N>::add(const usize row, const usize col, const N n) {
   this->_global_stats_outdated = true;
 }
 
+template <class N>
+void ContactMatrixDense<N>::add(const absl::Span<const Pixel<N>> pixels) {
+  usize updates_missed = 0;
+  bool any_applied = false;
+  for (const auto& p : pixels) {
+    assert(p.count > 0);
+    const auto [i, j] = internal::transpose_coords(p.coords);
+    this->bound_check_coords(i, j);
+
+    if (i >= this->nrows()) {
+      updates_missed += utils::conditional_static_cast<usize>(p.count);
+      continue;
+    }
+
+    const auto lck = this->lock_pixel(i, j);
+    this->unsafe_at(i, j) += p.count;
+    any_applied = true;
+  }
+
+  if (updates_missed != 0) {
+    std::atomic_fetch_add_explicit(&this->_updates_missed, updates_missed,
+                                   std::memory_order_relaxed);
+  }
+  if (any_applied) {
+    this->_global_stats_outdated = true;
+  }
+}
+
 template <class N>
 void ContactMatrixDense<N>::subtract(const usize row, const usize col, const N n) {
   assert(n >= 0);
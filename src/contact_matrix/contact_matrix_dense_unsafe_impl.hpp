@@ -8,6 +8,7 @@
 #include <fmt/format.h>              // for FMT_STRING, join
 
 #include <algorithm>                                // for clamp, fill, max, min
+#include <array>                                    // for array
 #include <atomic>                                   // for atomic_fetch_add_explicit
 #include <boost/dynamic_bitset/dynamic_bitset.hpp>  // for dynamic_bitset
 #include <cassert>                                  // for assert
@@ -19,7 +20,7 @@
 #include <shared_mutex>                             // for shared_mutex
 #include <string>                                   // for allocator, string
 #include <string_view>                              // for string_view
-#include <utility>                                  // for make_pair
+#include <utility>                                  // for make_pair, swap
 #include <vector>                                   // for vector
 
 #include "modle/common/common.hpp"                // for usize, i64, u64, bp_t, isize
@@ -141,6 +142,138 @@ void ContactMatrixDense<N>::unsafe_get_block(const usize row, const usize col,
   }
 }
 
+template <class N>
+void ContactMatrixDense<N>::unsafe_compute_summed_area_table(SummedAreaTable &sat) const {
+  const auto nrows = this->nrows();
+  const auto ncols = this->ncols();
+  sat._nrows = nrows;
+  sat._ncols = ncols;
+  sat._cum_row_sums.assign(ncols + 1, SumT(0));
+  sat._prefix_sums.assign((ncols + 1) * nrows, SumT(0));
+  if (ncols == 0 || nrows == 0) {
+    return;
+  }
+
+  for (usize i = 0; i < ncols; ++i) {
+    // Pixels more than nrows bins away from the diagonal are always 0
+    const auto first_col = i < nrows ? usize(0) : i - nrows + 1;
+    const auto last_col = std::min(ncols, i + nrows);
+    SumT row_sum{0};
+    for (auto j = first_col; j < last_col; ++j) {
+      row_sum += utils::conditional_static_cast<SumT>(this->unsafe_get(i, j));
+    }
+    sat._cum_row_sums[i + 1] = sat._cum_row_sums[i] + row_sum;
+  }
+
+  // P(r, c) = M[r - 1][c - 1] + P(r - 1, c) + P(r, c - 1) - P(r - 1, c - 1)
+  // Prefix sums with c >= r + nrows - 1 are not stored, as they are equal to _cum_row_sums[r]
+  for (usize r = 1; r <= ncols; ++r) {
+    const auto last_col = std::min(ncols + 1, r + nrows - 1);
+    for (auto c = r; c < last_col; ++c) {
+      sat._prefix_sums[(r * nrows) + (c - r)] =
+          utils::conditional_static_cast<SumT>(this->unsafe_get(r - 1, c - 1)) +
+          sat.prefix_sum(r - 1, c) + sat.prefix_sum(r, c - 1) - sat.prefix_sum(r - 1, c - 1);
+    }
+  }
+}
+
+template <class N>
+auto ContactMatrixDense<N>::unsafe_compute_summed_area_table() const -> SummedAreaTable {
+  SummedAreaTable sat{};
+  this->unsafe_compute_summed_area_table(sat);
+  return sat;
+}
+
+template <class N>
+constexpr usize ContactMatrixDense<N>::SummedAreaTable::nrows() const noexcept {
+  return this->_nrows;
+}
+
+template <class N>
+constexpr usize ContactMatrixDense<N>::SummedAreaTable::ncols() const noexcept {
+  return this->_ncols;
+}
+
+template <class N>
+bool ContactMatrixDense<N>::SummedAreaTable::empty() const noexcept {
+  return this->_cum_row_sums.empty();
+}
+
+template <class N>
+N ContactMatrixDense<N>::SummedAreaTable::unsafe_get_block(const usize row, const usize col,
+                                                           const usize block_size) const {
+  assert(!this->empty());
+  assert(block_size > 0);
+  assert(block_size < this->nrows());
+  // For now we only support blocks with an odd size
+  assert(block_size % 2 != 0);
+  assert(row < this->ncols());
+  assert(col < this->ncols());
+
+  // Edges are handled like shown here: https://en.wikipedia.org/wiki/File:Extend_Edge-Handling.png
+  // Rows (and cols) falling outside of the matrix are replaced by copies of the first (or last)
+  // row. Thus, the rows overlapping a block can be split in up to three ranges: copies of the
+  // first row, rows located inside the matrix and copies of the last row. The same goes for cols.
+  struct Range {
+    usize first;
+    usize last;
+    SumT multiplicity;
+  };
+  const auto split_range = [&](const usize i) {
+    const auto n = static_cast<i64>(this->ncols());
+    const auto first = static_cast<i64>(i) - static_cast<i64>(block_size / 2);
+    const auto last = first + static_cast<i64>(block_size);
+    const auto first_clamped = std::max(first, i64(0));
+    const auto last_clamped = std::min(last, n);
+    assert(first_clamped < last_clamped);
+    return std::array<Range, 3>{
+        Range{0, 1, static_cast<SumT>(first_clamped - first)},
+        Range{static_cast<usize>(first_clamped), static_cast<usize>(last_clamped), SumT(1)},
+        Range{static_cast<usize>(n - 1), static_cast<usize>(n),
+              static_cast<SumT>(last - last_clamped)}};
+  };
+
+  SumT n{0};
+  for (const auto &rows : split_range(row)) {
+    if (rows.multiplicity == 0) {
+      continue;
+    }
+    for (const auto &cols : split_range(col)) {
+      if (cols.multiplicity != 0) {
+        n += rows.multiplicity * cols.multiplicity *
+             this->sum(rows.first, rows.last, cols.first, cols.last);
+      }
+    }
+  }
+  return utils::conditional_static_cast<N>(n);
+}
+
+template <class N>
+auto ContactMatrixDense<N>::SummedAreaTable::prefix_sum(usize row, usize col) const noexcept
+    -> SumT {
+  if (row > col) {  // The matrix is symmetric, so P(r, c) == P(c, r)
+    std::swap(row, col);
+  }
+  assert(col <= this->ncols());
+  if (row == 0 || this->nrows() == 0) {
+    return 0;
+  }
+  if (col - row >= this->nrows() - 1) {
+    return this->_cum_row_sums[row];
+  }
+  return this->_prefix_sums[(row * this->nrows()) + (col - row)];
+}
+
+template <class N>
+auto ContactMatrixDense<N>::SummedAreaTable::sum(const usize first_row, const usize last_row,
+                                                 const usize first_col,
+                                                 const usize last_col) const noexcept -> SumT {
+  assert(first_row <= last_row);
+  assert(first_col <= last_col);
+  return this->prefix_sum(last_row, last_col) - this->prefix_sum(first_row, last_col) -
+         this->prefix_sum(last_row, first_col) + this->prefix_sum(first_row, first_col);
+}
+
 template <class N>
 void ContactMatrixDense<N>::unsafe_set(const usize row, const usize col, const N n) {
   const auto [i, j] = internal::transpose_coords(row, col);
@@ -442,6 +575,26 @@ ContactMatrixDense<N> ContactMatrixDense<N>::unsafe_clamp(const N lb, const N ub
   return m;
 }
 
+template <class N>
+ContactMatrixDense<N> ContactMatrixDense<N>::unsafe_slice(const usize first_bin,
+                                                          const usize last_bin) const {
+  assert(first_bin < last_bin);
+  assert(last_bin <= this->ncols());
+  ContactMatrixDense<N> m(this->nrows(), last_bin - first_bin);
+
+  // Column j stores pixels (j - i, j) for i in [0, nrows), so each column of the slice can be
+  // copied from the corresponding column of the input matrix, dropping pixels where
+  // j - i < first_bin
+  for (usize j = first_bin; j < last_bin; ++j) {
+    const auto nrows = std::min(m.nrows(), j - first_bin + 1);
+    const auto first = this->_contacts.begin() + static_cast<isize>(j * this->nrows());
+    const auto dest = m._contacts.begin() + static_cast<isize>((j - first_bin) * m.nrows());
+    std::copy(first, first + static_cast<isize>(nrows), dest);
+  }
+  m._global_stats_outdated = true;
+  return m;
+}
+
 template <class N>
 inline void ContactMatrixDense<N>::unsafe_clamp_inplace(const N lb, const N ub) noexcept {
   ContactMatrixDense<N>::unsafe_clamp(*this, *this, lb, ub);
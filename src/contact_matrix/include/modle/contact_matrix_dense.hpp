@@ -18,6 +18,7 @@
 #include <vector>                                   // for vector
 
 #include "modle/common/common.hpp"  // for usize, bp_t, u64, contacts_t, i64
+#include "modle/common/pixel.hpp"   // for Pixel
 #include "modle/common/utils.hpp"   // for LockRangeExclusive
 
 namespace modle {
@@ -55,6 +56,8 @@ class ContactMatrixDense {
   mutable std::atomic<usize> _nnz{0};
   mutable std::atomic<bool> _global_stats_outdated{false};
   std::atomic<usize> _updates_missed{0};
+  // Only updated when profiling is enabled (see utils::profiling_enabled())
+  mutable std::atomic<usize> _lock_waits{0};
 
  public:
   // Constructors
@@ -86,6 +89,9 @@ class ContactMatrixDense {
   inline void subtract(usize row, usize col, N n);
   inline void increment(usize row, usize col);
   inline void decrement(usize row, usize col);
+  // Add a batch of pixels to the matrix. Each pixel mutex is locked once per entry in pixels, so
+  // pixels should be compacted (i.e. one entry per pair of coordinates) beforehand
+  inline void add(absl::Span<const Pixel<N>> pixels);
 
   // Thread-UNsafe count getters and setters
   [[nodiscard]] inline N unsafe_get(usize row, usize col) const;
@@ -101,16 +107,27 @@ class ContactMatrixDense {
   inline void unsafe_get_block(usize row, usize col, usize block_size, std::vector<N>& buff) const;
   [[nodiscard]] inline N unsafe_get_block(usize row, usize col, usize block_size) const;
 
+  class SummedAreaTable;
+  // Compute the summed-area table for the current matrix. The content of sat is overwritten
+  inline void unsafe_compute_summed_area_table(SummedAreaTable& sat) const;
+  [[nodiscard]] inline SummedAreaTable unsafe_compute_summed_area_table() const;
+
   // Shape/statistics getters
   [[nodiscard]] constexpr usize ncols() const;
   [[nodiscard]] constexpr usize nrows() const;
   [[nodiscard]] constexpr usize npixels() const;
   [[nodiscard]] constexpr usize get_n_of_missed_updates() const noexcept;
+  // Number of times a thread had to wait to acquire a pixel mutex. This is always 0 unless MoDLE
+  // was compiled with profiling enabled
+  [[nodiscard]] constexpr usize get_n_of_lock_waits() const noexcept;
   [[nodiscard]] inline double get_fraction_of_missed_updates() const;
   [[nodiscard]] inline SumT get_tot_contacts() const;
   [[nodiscard]] inline usize get_nnz() const;
   [[nodiscard]] inline double get_avg_contact_density() const;
   [[nodiscard]] constexpr usize get_matrix_size_in_bytes() const;
+  // Compute the size in bytes of a matrix with the given shape, including pixel mutexes, without
+  // allocating it
+  [[nodiscard]] static inline usize compute_matrix_size_in_bytes(usize nrows, usize ncols) noexcept;
   [[nodiscard]] inline N get_min_count() const noexcept;
   [[nodiscard]] inline N get_max_count() const noexcept;
 
@@ -151,6 +168,10 @@ class ContactMatrixDense {
   template <class FP = double, class = std::enable_if_t<std::is_floating_point_v<FP>>>
   [[nodiscard]] inline ContactMatrixDense<FP> normalize(double lb = 0.0, double ub = 1.0) const;
   [[nodiscard]] inline ContactMatrixDense<N> unsafe_clamp(N lb, N ub) const;
+  // Return the matrix for the region spanning bins [first_bin, last_bin). The result is the same
+  // as if the matrix had been generated for that region only: pixels involving bins outside of the
+  // region are dropped
+  [[nodiscard]] inline ContactMatrixDense<N> unsafe_slice(usize first_bin, usize last_bin) const;
   [[nodiscard]] inline ContactMatrixDense<N> clamp(N lb, N ub) const;
   template <class N1, class N2>
   [[nodiscard]] inline ContactMatrixDense<N1> discretize(const IITree<N2, N1>& mappings) const;
@@ -202,6 +223,40 @@ class ContactMatrixDense {
 
   inline void unsafe_update_global_stats() const noexcept;
 };
+
+/// Band-aware summed-area table (integral image) for a ContactMatrixDense.
+
+//! The table makes it possible to compute the sum of any block of pixels in constant time.
+//! Pixels located more than nrows() bins away from the diagonal are always 0, so each prefix sum
+//! P(r, c) = sum(M[i][j]) for i < r, j < c is either stored explicitly (when c and r are less
+//! than nrows() bins apart) or equal to the cumulative sum of the totals of the first min(r, c)
+//! rows. As the matrix is symmetric, only prefix sums with c >= r are stored explicitly.
+//! The table does not track changes to the matrix it was computed from.
+template <class N>
+class ContactMatrixDense<N>::SummedAreaTable {
+  friend class ContactMatrixDense<N>;
+
+  usize _nrows{0};
+  usize _ncols{0};
+  std::vector<SumT> _prefix_sums{};   // P(r, c) for r <= c < r + nrows - 1
+  std::vector<SumT> _cum_row_sums{};  // Cumulative row totals
+
+ public:
+  SummedAreaTable() = default;
+
+  [[nodiscard]] constexpr usize nrows() const noexcept;
+  [[nodiscard]] constexpr usize ncols() const noexcept;
+  [[nodiscard]] inline bool empty() const noexcept;
+
+  /// Same as ContactMatrixDense<N>::unsafe_get_block(), including how edges are handled
+  [[nodiscard]] inline N unsafe_get_block(usize row, usize col, usize block_size) const;
+
+ private:
+  [[nodiscard]] inline SumT prefix_sum(usize row, usize col) const noexcept;
+  // Sum pixels overlapping [first_row, last_row) x [first_col, last_col)
+  [[nodiscard]] inline SumT sum(usize first_row, usize last_row, usize first_col,
+                                usize last_col) const noexcept;
+};
 }  // namespace modle
 
 #include "../../contact_matrix_dense_impl.hpp"         // IWYU pragma: export
@@ -0,0 +1,130 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// IWYU pragma: private, include "modle/burnin_tracker.hpp"
+
+#include <cassert>  // for assert
+
+#include "modle/common/common.hpp"  // for usize
+
+namespace modle {
+
+inline BurninTracker::BurninTracker(const usize capacity, const usize window_size) {
+  this->reset(capacity, window_size);
+}
+
+inline void BurninTracker::reset(const usize capacity, const usize window_size) {
+  assert(capacity != 0);
+  assert(window_size <= capacity);
+  this->_capacity = capacity;
+  this->_window_size = window_size;
+  for (auto* s : {&this->_avg_loop_size, &this->_cfx_of_variation}) {
+    s->buff.resize(capacity);
+    s->decreasing.resize(capacity);
+  }
+  this->clear();
+}
+
+inline void BurninTracker::clear() noexcept {
+  this->_size = 0;
+  this->_head = 0;
+  for (auto* s : {&this->_avg_loop_size, &this->_cfx_of_variation}) {
+    s->num_decreasing = 0;
+    s->last_window_mean = 0.0;
+    s->prev_window_mean = 0.0;
+  }
+}
+
+inline void BurninTracker::push_back(const double avg_loop_size,
+                                     const double cfx_of_variation) noexcept {
+  assert(this->_capacity != 0);
+  this->push_back(this->_avg_loop_size, avg_loop_size);
+  this->push_back(this->_cfx_of_variation, cfx_of_variation);
+
+  if (this->full()) {
+    this->_head = this->physical_index(1);
+  } else {
+    ++this->_size;
+  }
+}
+
+inline usize BurninTracker::size() const noexcept { return this->_size; }
+inline usize BurninTracker::capacity() const noexcept { return this->_capacity; }
+inline usize BurninTracker::window_size() const noexcept { return this->_window_size; }
+inline bool BurninTracker::empty() const noexcept { return this->_size == 0; }
+inline bool BurninTracker::full() const noexcept { return this->_size == this->_capacity; }
+
+inline bool BurninTracker::is_stable() const noexcept {
+  return this->full() && this->is_stable(this->_cfx_of_variation) &&
+         this->is_stable(this->_avg_loop_size);
+}
+
+inline usize BurninTracker::physical_index(const usize i) const noexcept {
+  assert(i <= this->_capacity);
+  const auto j = this->_head + i;
+  return j >= this->_capacity ? j - this->_capacity : j;
+}
+
+inline double BurninTracker::window_mean(const Series& s, const usize i) const noexcept {
+  assert(this->_window_size != 0);
+  assert(i + this->_window_size <= this->_capacity + 1);
+  // Values are accumulated in the same order as stats::mean, so that results are bit-identical
+  double sum = 0.0;
+  for (usize j = i; j < i + this->_window_size; ++j) {
+    sum += s.buff[this->physical_index(j)];
+  }
+  return sum / static_cast<double>(this->_window_size);
+}
+
+inline void BurninTracker::push_comparison(Series& s, const usize i) noexcept {
+  const auto decreasing = s.prev_window_mean > s.last_window_mean;
+  s.decreasing[this->physical_index(i)] = decreasing;
+  s.num_decreasing += static_cast<usize>(decreasing);
+}
+
+inline void BurninTracker::push_back(Series& s, const double value) noexcept {
+  // Logical indices used in this function refer to the history before value is pushed.
+  // The most recent record is not used to compare windows: pushing a new value thus adds the pair
+  // of windows ending with the record that was the most recent one before the push
+  const auto n = this->_size;
+  const auto w = this->_window_size;
+  if (this->full()) {
+    // Discard the pair made up of the first two windows, as the oldest record is overwritten by
+    // the new value. When window_size + 1 >= capacity no pair of windows is ever compared
+    if (w + 1 < this->_capacity) {
+      s.num_decreasing -= static_cast<usize>(s.decreasing[this->_head]);
+      this->push_comparison(s, this->_capacity - w - 1);
+    }
+  } else if (n > w) {
+    this->push_comparison(s, n - w - 1);
+  }
+
+  // Slide the most recent window so that it ends with the new value.
+  // When the history is full, physical_index(n) is the offset of the oldest record
+  s.buff[this->physical_index(n)] = value;
+  if (n + 1 >= w) {
+    s.prev_window_mean = s.last_window_mean;
+    s.last_window_mean = this->window_mean(s, n + 1 - w);
+  }
+}
+
+inline bool BurninTracker::is_stable(const Series& s) const noexcept {
+  // Count the number of adjacent windows where the moving average of the first window is larger
+  // than that of the second. This visually corresponds to a local dip in the moving average.
+  // When we are in a stable state the moving average should be relatively flat.
+  // For this reason, we expect n to be roughly equal to 1/2 of all the measurements
+  assert(this->full());
+  if (this->_window_size >= this->_capacity) {
+    return false;
+  }
+  const auto n = s.num_decreasing;
+  assert(n < this->_capacity - this->_window_size);
+  const auto r =
+      static_cast<double>(n) / static_cast<double>(this->_capacity - this->_window_size - n);
+  return r >= 0.95 && r <= 1.05;
+}
+
+}  // namespace modle
@@ -87,7 +87,7 @@ constexpr I Collision<I>::encode(const usize idx,
 
 template <class I>
 constexpr bool Collision<I>::is_valid_index(const usize idx) noexcept(utils::ndebug_defined()) {
-  return usize(absl::countl_zero(idx)) >= RESERVED_EVENT_BITS;
+  return idx <= max_index();
 }
 
 template <class I>
@@ -209,6 +209,11 @@ constexpr usize Collision<I>::decode_index() const noexcept {
   return this->_collision & INDEX_MASK;
 }
 
+template <class I>
+constexpr usize Collision<I>::max_index() noexcept {
+  return usize(INDEX_MASK);
+}
+
 template <class I>
 constexpr auto Collision<I>::decode_event() const noexcept -> CollisionEventT {
   DISABLE_WARNING_PUSH
@@ -0,0 +1,77 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <vector>  // for vector
+
+#include "modle/common/common.hpp"  // for usize
+
+namespace modle {
+
+/// Fixed-size history of the loop size statistics used to detect the end of the burn-in phase.
+
+//! The average loop size and its coefficient of variation are stored in ring buffers.
+//! Burn-in is considered completed when the moving averages of both statistics are flat, that is
+//! when the moving average decreases roughly as many times as it increases over the history.
+//! Pushing a new value adds one pair of adjacent windows and evicts at most one. The outcome of
+//! each comparison is cached, as is the average of the two most recent windows, so pushing a new
+//! record only requires computing the average of the window ending with that record (i.e.
+//! O(window_size), regardless of the history length).
+//! Averages are computed from scratch exactly as stats::mean would, and windows are compared as in
+//! previous releases (including the most recent record being left out of the comparisons), so
+//! burn-in ends at the same epoch as before.
+class BurninTracker {
+  usize _capacity{};
+  usize _window_size{};
+  usize _size{};
+  usize _head{};  // Offset of the oldest record
+
+  struct Series {  // NOLINT(altera-struct-pack-align)
+    std::vector<double> buff{};
+    // Outcome of the comparison between the window starting at a given record and the next one
+    std::vector<bool> decreasing{};
+    usize num_decreasing{};
+    // Average of the most recent window, and of the window that precedes it
+    double last_window_mean{};
+    double prev_window_mean{};
+  };
+  Series _avg_loop_size{};
+  Series _cfx_of_variation{};
+
+ public:
+  BurninTracker() = default;
+  BurninTracker(usize capacity, usize window_size);
+
+  /// Clear the history and change its capacity and window size. Storage is reused when possible
+  void reset(usize capacity, usize window_size);
+  void clear() noexcept;
+
+  /// Record the statistics for the current epoch, discarding the oldest record if the history is
+  /// full
+  void push_back(double avg_loop_size, double cfx_of_variation) noexcept;
+
+  [[nodiscard]] usize size() const noexcept;
+  [[nodiscard]] usize capacity() const noexcept;
+  [[nodiscard]] usize window_size() const noexcept;
+  [[nodiscard]] bool empty() const noexcept;
+  [[nodiscard]] bool full() const noexcept;
+
+  /// Return true when the history is full and the moving averages of both statistics are stable
+  [[nodiscard]] bool is_stable() const noexcept;
+
+ private:
+  [[nodiscard]] usize physical_index(usize i) const noexcept;
+  void push_back(Series& s, double value) noexcept;
+  /// Record the outcome of the comparison between the window starting at logical index \p i and
+  /// the most recent window
+  void push_comparison(Series& s, usize i) noexcept;
+  /// Compute the average of the window starting at logical index \p i
+  [[nodiscard]] double window_mean(const Series& s, usize i) const noexcept;
+  [[nodiscard]] bool is_stable(const Series& s) const noexcept;
+};
+
+}  // namespace modle
+
+#include "../../burnin_tracker_impl.hpp"  // IWYU pragma: export
@@ -9,7 +9,7 @@
 #include <bitset>  // for bitset
 #include <type_traits>
 
-#include "modle/common/common.hpp"  // for u8f, u32f
+#include "modle/common/common.hpp"  // for u8f, u32
 #include "modle/common/utils.hpp"   // for ndebug_defined, ndebug_not_defined
 
 namespace modle {
@@ -51,7 +51,14 @@ class CollisionEvent {
   [[nodiscard]] constexpr I operator()() const noexcept;
 };
 
-template <class I = u32f>
+/// Compact encoding of a collision event together with the index of the LEF or barrier involved.
+
+//! The event is stored in the most significant bits, while the remaining bits store the index.
+//! The default storage type is exactly 32 bits wide, which is enough to address ~8M LEFs or
+//! barriers while keeping the collision buffers used by the simulation as small as possible.
+//! max_index() also bounds the number of LEFs per cell, which lets the simulation store LEF ranks
+//! as 32-bit indices.
+template <class I = u32>
 class Collision {
  private:
   I _collision{0};
@@ -80,6 +87,8 @@ class Collision {
   [[nodiscard]] constexpr I& operator()() noexcept;
 
   [[nodiscard]] constexpr usize decode_index() const noexcept;
+  /// Largest LEF/barrier index that can be encoded
+  [[nodiscard]] static constexpr usize max_index() noexcept;
   [[nodiscard]] constexpr CollisionEventT decode_event() const noexcept;
 
   [[nodiscard]] constexpr bool collision_occurred() const noexcept;
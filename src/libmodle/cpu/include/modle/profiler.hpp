@@ -0,0 +1,81 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <absl/types/span.h>  // for Span
+
+#include <chrono>       // for steady_clock
+#include <string>       // for string
+#include <string_view>  // for string_view
+
+#include "modle/common/common.hpp"  // for usize, u64, profiling_enabled
+
+namespace modle {
+
+/// Timers and counters collected on the hot path of modle sim.
+
+//! Counters are collected by each simulation instance (i.e. Simulation::State), and are then
+//! aggregated per thread and per chromosome by the scheduler.
+//! All the member functions updating counters are no-ops unless MoDLE was compiled with
+//! -DMODLE_ENABLE_PROFILING=ON (see utils::profiling_enabled()).
+//! Timers are not mutually exclusive: simulation_ns includes burnin_ns and
+//! contact_registration_ns, while contact_registration_ns includes contact_matrix_update_ns
+//! for the contacts that are merged into the contact matrix during the simulation.
+struct ProfileCounters {  // NOLINT(altera-struct-pack-align)
+  usize cells{};
+  usize epochs{};
+  usize burnin_epochs{};
+  usize chrom_boundary_collisions{};
+  usize lef_bar_collisions{};
+  usize lef_lef_primary_collisions{};
+  usize lef_lef_secondary_collisions{};
+  usize contacts_registered{};
+  usize contact_matrix_lock_waits{};
+  u64 simulation_ns{};
+  u64 burnin_ns{};
+  u64 contact_registration_ns{};
+  u64 contact_matrix_update_ns{};
+  u64 hdf5_write_ns{};
+
+  static constexpr std::string_view tsv_header{
+      "cells\tepochs\tburnin_epochs\t"
+      "chrom_boundary_collisions\tlef_bar_collisions\t"
+      "lef_lef_primary_collisions\tlef_lef_secondary_collisions\t"
+      "contacts_registered\tcontact_matrix_lock_waits\t"
+      "simulation_time_s\tburnin_time_s\tcontact_registration_time_s\t"
+      "contact_matrix_update_time_s\thdf5_write_time_s"};
+
+  constexpr ProfileCounters& operator+=(const ProfileCounters& other) noexcept;
+
+  /// Count the collisions of each type recorded in the current epoch
+  template <typename CollisionT>
+  constexpr void register_collisions(absl::Span<const CollisionT> rev_collisions,
+                                     absl::Span<const CollisionT> fwd_collisions) noexcept;
+
+  /// Format counters as a row of tab-separated values (see ProfileCounters::tsv_header)
+  [[nodiscard]] inline std::string to_tsv() const;
+};
+
+/// RAII timer adding the time elapsed between its construction and destruction to a counter.
+
+//! The timer does nothing when profiling is disabled.
+class ScopedTimer {
+  using clock = std::chrono::steady_clock;
+  u64* _ns{nullptr};
+  clock::time_point _t0{};
+
+ public:
+  explicit ScopedTimer(u64& ns) noexcept;
+  ~ScopedTimer() noexcept;
+
+  ScopedTimer(const ScopedTimer& other) = delete;
+  ScopedTimer(ScopedTimer&& other) = delete;
+  ScopedTimer& operator=(const ScopedTimer& other) = delete;
+  ScopedTimer& operator=(ScopedTimer&& other) = delete;
+};
+
+}  // namespace modle
+
+#include "../../profiler_impl.hpp"  // IWYU pragma: export
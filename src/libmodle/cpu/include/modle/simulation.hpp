@@ -8,32 +8,41 @@
 #include <absl/types/span.h>                     // for Span
 #include <fmt/format.h>                          // for format_parse_context, formatter
 #include <moodycamel/blockingconcurrentqueue.h>  // for BlockingConcurrentQueue
+#include <moodycamel/lightweightsemaphore.h>     // for LightweightSemaphore
 #include <xxhash.h>                              // for XXH_INLINE_XXH3_createState, XXH3...
 
 #include <BS_thread_pool.hpp>  // for BS::thread_pool
+#include <algorithm>           // for for_each
 #include <atomic>              // for atomic
+#include <condition_variable>  // for condition_variable
 #include <deque>               // for deque
 #include <exception>           // for exception_ptr
 #include <filesystem>          // for path
 #include <limits>              // for numeric_limits
 #include <memory>              // for shared_ptr, allocator, unique_ptr
-#include <mutex>               // for mutex
+#include <mutex>               // for mutex, once_flag
 #include <string>              // for string
 #include <string_view>         // for string_view
-#include <utility>             // for pair
+#include <type_traits>         // for conditional_t
+#include <utility>             // for pair, index_sequence
 #include <vector>              // for vector
 
-#include "modle/bed/bed.hpp"                            // for BED (ptr only), BED_tree
-#include "modle/collision_encoding.hpp"                 // for Collision<>
-#include "modle/common/common.hpp"                      // for usize, bp_t, contacts_t
-#include "modle/common/random.hpp"                      // for PRNG_t, normal_distribution, unif...
-#include "modle/common/simulation_config.hpp"           // for Config
-#include "modle/common/suppress_compiler_warnings.hpp"  // for DISABLE_WARNING_POP, DISABLE_WARN...
-#include "modle/common/utils.hpp"                       // for ndebug_defined, XXH3_Deleter, XXH...
-#include "modle/contact_matrix_dense.hpp"               // for ContactMatrixDense
-#include "modle/extrusion_barriers.hpp"                 // for ExtrusionBarrier
-#include "modle/extrusion_factors.hpp"                  // for Lef, ExtrusionUnit (ptr only)
-#include "modle/genome.hpp"                             // for Chromosome (ptr only), Genome
+#include "modle/bed/bed.hpp"                               // for BED (ptr only), BED_tree
+#include "modle/burnin_tracker.hpp"                        // for BurninTracker
+#include "modle/collision_encoding.hpp"                    // for Collision<>
+#include "modle/common/common.hpp"                         // for usize, bp_t, contacts_t
+#include "modle/common/genextreme_value_distribution.hpp"  // for tabulated_genextreme_value_...
+#include "modle/common/pixel.hpp"                          // for Pixel, PixelCoordinates
+#include "modle/common/random.hpp"                         // for PRNG_t, BatchPRNG, uniform_int...
+#include "modle/common/simulation_config.hpp"              // for Config
+#include "modle/common/suppress_compiler_warnings.hpp"     // for DISABLE_WARNING_POP, DISABLE_WA...
+#include "modle/common/utils.hpp"                          // for ndebug_defined, XXH3_Deleter, X...
+#include "modle/contact_matrix_dense.hpp"                  // for ContactMatrixDense
+#include "modle/extrusion_barriers.hpp"                    // for ExtrusionBarrier
+#include "modle/extrusion_factors.hpp"                     // for Lef, ExtrusionUnit (ptr only)
+#include "modle/genome.hpp"                                // for Chromosome (ptr only), Genome
+#include "modle/profiler.hpp"                              // for ProfileCounters
+#include "modle/task_file.hpp"                             // for task_file::Record
 
 namespace modle {
 
@@ -51,15 +60,26 @@ class Simulation : Config {
   void print() = delete;
 
   [[nodiscard]] usize size() const;
-  [[nodiscard]] usize simulated_size() const;
 
   using lef_move_generator_t = random::normal_distribution<double>;
+  [[nodiscard]] usize simulated_size() const;
+
   using chrom_pos_generator_t = random::uniform_int_distribution<bp_t>;
+  /// Index of a LEF in the LEF buffer. LEF ranks are stored as lists of LEF indices
+  using lef_idx_t = u32;
+  /// Displacement of an extrusion unit over a single epoch. Moves are bounded by the extrusion
+  /// speed rather than by the chromosome length, so 32 bits are more than enough
+  using lef_move_t = u32;
 
   static constexpr auto Mbp = 1.0e6;
 
  private:
-  using CollisionT = Collision<u32f>;
+  using CollisionT = Collision<u32>;
+  // Collision and rank buffers are scanned several times per epoch: keep them as compact as
+  // possible. The number of LEFs is bounded by CollisionT::max_index() (see
+  // State::resize_buffers), so LEF indices always fit in lef_idx_t
+  static_assert(sizeof(CollisionT) == sizeof(u32));
+  static_assert(CollisionT::max_index() <= (std::numeric_limits<lef_idx_t>::max)());
   struct BaseTask {  // NOLINT(altera-struct-pack-align)
     usize id{};
     Chromosome* chrom{};
@@ -68,6 +88,9 @@ class Simulation : Config {
     usize num_target_contacts{};
     usize num_lefs{};
     absl::Span<const ExtrusionBarrier> barriers{};
+    // Read-only barrier table built from barriers. The table is shared by all the tasks
+    // referring to the same chromosome (or window), and is null when tasks are read from a file
+    std::shared_ptr<const ExtrusionBarriers> barrier_table{};
   };
 
  public:
@@ -75,9 +98,16 @@ class Simulation : Config {
     static Task from_string(std::string_view serialized_task, Genome& genome);
   };
 
+  struct WindowSnapshot;
+
   struct TaskPW : BaseTask {  // NOLINT(altera-struct-pack-align)
     TaskPW() = default;
     static TaskPW from_string(std::string_view serialized_task, Genome& genome);
+    /// Build a task from its binary representation. \p chrom should be the chromosome referred to
+    /// by record.chrom_id in the chromosome table of the task file. Chromosome IDs from the table
+    /// need not match the IDs of the genome used to replay tasks
+    static TaskPW from_record(const task_file::Record& record, Chromosome& chrom);
+    [[nodiscard]] task_file::Record to_record() const;
 
     bp_t deletion_begin{};
     bp_t deletion_size{};
@@ -87,11 +117,85 @@ class Simulation : Config {
     bp_t active_window_end{};
 
     std::shared_ptr<const ContactMatrixDense<contacts_t>> reference_contacts{};
+    std::shared_ptr<const ContactMatrixDense<contacts_t>::SummedAreaTable> reference_block_sums{};
+    // Shared by all the tasks referring to the same window. Only used when warm-starting cells
+    std::shared_ptr<WindowSnapshot> window_snapshot{};
 
     absl::Span<const bed::BED> feats1{};
     absl::Span<const bed::BED> feats2{};
   };
 
+  /// Epoch at which a bound LEF is scheduled to be released (see Simulation::release_lefs)
+  struct LefRelease {  // NOLINT(altera-struct-pack-align)
+    usize epoch{(std::numeric_limits<usize>::max)()};
+    // Binding epoch and release hazard of the LEF at the time the release was scheduled
+    usize binding_epoch{(std::numeric_limits<usize>::max)()};
+    u8f hazard{(std::numeric_limits<u8f>::max)()};
+  };
+
+  /// State of a modle pert window at the end of the burn-in phase (see Config::warm_start)
+
+  //! The snapshot is taken with all the barriers mapping to the window in place, and is built by
+  //! the first task referring to the window that needs it. Tasks simulating deletions on the same
+  //! window are then started from the snapshot instead of going through a full burn-in.
+  //! Restored cells reseed their PRNGs from the snapshot seed and their cell id.
+  struct WindowSnapshot {  // NOLINT(altera-struct-pack-align)
+    std::once_flag initialized{};
+    usize epoch{};
+    usize num_burnin_epochs{};
+    usize num_active_lefs{};
+    u64 seed{};
+    std::vector<Lef> lefs{};
+    std::vector<lef_idx_t> rev_ranks{};
+    std::vector<lef_idx_t> fwd_ranks{};
+    std::vector<LefRelease> lef_releases{};
+    // Barrier states and pending state transitions (see ExtrusionBarriers::next_state_scheduled).
+    // The barrier table is shared with the cells restored from the snapshot
+    ExtrusionBarriers barriers{};
+  };
+
+  /// Scratch buffers used to sample contacts in bulk (see Simulation::sample_and_register_contacts)
+  struct ContactSamplingBuffers {
+    std::vector<usize> eligible_lefs{};  // Idx of the LEFs that can be sampled in the current epoch
+    std::vector<usize> sampled_lefs{};   // Idx of the sampled LEFs, grouped by LEF
+    std::vector<u64> draw_buff{};
+    std::vector<double> noise_buff{};
+  };
+
+  /// Optional features of the simulation kernels, encoded as a bitmask (see
+  /// Simulation::simulate_one_cell)
+
+  //! Kernels templated on a feature set check these features with if constexpr, so that the
+  //! corresponding runtime checks are performed once per task instead of once per epoch or element.
+  enum Feature : u8f {
+    NOISIFY_CONTACTS = 1U << 0U,
+    TRACK_1D_LEF_POSITION = 1U << 1U,
+    LOG_MODEL_INTERNAL_STATE = 1U << 2U,
+    STOCHASTIC_EXTR_SPEED = 1U << 3U,
+    FAST_SAMPLING = 1U << 4U
+  };
+  /// Number of feature sets, i.e. the number of instantiations of each kernel
+  static constexpr usize num_feature_sets = 1U << 5U;
+
+  [[nodiscard]] static constexpr bool has_feature(u8f features, Feature f) noexcept {
+    return (features & f) != 0;
+  }
+
+  /// PRNG used by kernels templated on \p Features to perform the draws required by each epoch
+
+  //! Draws are only batched when Config::fast_sampling is set. Otherwise all draws are performed
+  //! by the per-cell PRNG_t in the same order as in previous releases, so that simulations using
+  //! the default settings are not affected by changes to the batched sampling scheme.
+  template <u8f Features>
+  using epoch_rand_eng_t = std::conditional_t<(Features & FAST_SAMPLING) != 0, random::BatchPRNG,
+                                              random::PRNG_t>;
+
+  /// Position of extr. units in 5'-3' order (see Simulation::process_collisions_fused)
+  struct UnitPositionBuffers {
+    std::vector<bp_t> rev_pos{};
+    std::vector<bp_t> fwd_pos{};
+  };
+
   struct State : BaseTask {  // NOLINT(altera-struct-pack-align)
     State() = default;
     usize epoch{};                 // NOLINT
@@ -100,57 +204,62 @@ class Simulation : Config {
     usize num_burnin_epochs{0};    // NOLINT
     usize num_contacts{0};         // NOLINT
 
-    random::PRNG_t rand_eng{};  // NOLINT
-    u64 seed{};                 // NOLINT
+    random::PRNG_t rand_eng{};           // NOLINT
+    random::BatchPRNG batch_rand_eng{};  // NOLINT
+    u64 seed{};                          // NOLINT
     DISABLE_WARNING_PUSH
     DISABLE_WARNING_USED_BUT_MARKED_UNUSED
     std::unique_ptr<XXH3_state_t, utils::XXH3_Deleter> xxh_state{XXH3_createState()};  // NOLINT
     DISABLE_WARNING_POP
     std::unique_ptr<compressed_io::Writer> model_state_logger{nullptr};  // NOLINT
+    ProfileCounters profile{};  // NOLINT
 
     ExtrusionBarriers barriers{};
 
    protected:
     std::vector<Lef> lef_buff{};                 // NOLINT
-    std::vector<usize> rank_buff1{};             // NOLINT
-    std::vector<usize> rank_buff2{};             // NOLINT
-    ExtrusionBarriers _barriers{};               // NOLINT
-    std::vector<bp_t> moves_buff1{};             // NOLINT
-    std::vector<bp_t> moves_buff2{};             // NOLINT
+    std::vector<lef_idx_t> rank_buff1{};         // NOLINT
+    std::vector<lef_idx_t> rank_buff2{};         // NOLINT
+    std::vector<lef_move_t> moves_buff1{};       // NOLINT
+    std::vector<lef_move_t> moves_buff2{};       // NOLINT
     std::vector<usize> idx_buff{};               // NOLINT
     std::vector<CollisionT> collision_buff1{};   // NOLINT
     std::vector<CollisionT> collision_buff2{};   // NOLINT
-    std::deque<double> cfx_of_variation_buff{};  // NOLINT
-    std::deque<double> avg_loop_size_buff{};     // NOLINT
+    std::vector<LefRelease> release_buff{};      // NOLINT
+    BurninTracker burnin_history{};              // NOLINT
 
     static constexpr usize npos = absl::Span<usize>::npos;
 
    public:
     [[nodiscard]] absl::Span<Lef> get_lefs(usize size = npos) noexcept;
-    [[nodiscard]] absl::Span<usize> get_rev_ranks(usize size = npos) noexcept;
-    [[nodiscard]] absl::Span<usize> get_fwd_ranks(usize size = npos) noexcept;
-    [[nodiscard]] absl::Span<bp_t> get_rev_moves(usize size = npos) noexcept;
-    [[nodiscard]] absl::Span<bp_t> get_fwd_moves(usize size = npos) noexcept;
+    [[nodiscard]] absl::Span<lef_idx_t> get_rev_ranks(usize size = npos) noexcept;
+    [[nodiscard]] absl::Span<lef_idx_t> get_fwd_ranks(usize size = npos) noexcept;
+    [[nodiscard]] absl::Span<lef_move_t> get_rev_moves(usize size = npos) noexcept;
+    [[nodiscard]] absl::Span<lef_move_t> get_fwd_moves(usize size = npos) noexcept;
     [[nodiscard]] absl::Span<usize> get_idx_buff(usize size = npos) noexcept;
     [[nodiscard]] absl::Span<CollisionT> get_rev_collisions(usize size = npos) noexcept;
     [[nodiscard]] absl::Span<CollisionT> get_fwd_collisions(usize size = npos) noexcept;
-    [[nodiscard]] std::deque<double>& get_cfx_of_variation() noexcept;
-    [[nodiscard]] std::deque<double>& get_avg_loop_sizes() noexcept;
+    [[nodiscard]] absl::Span<LefRelease> get_lef_releases(usize size = npos) noexcept;
+    [[nodiscard]] BurninTracker& get_burnin_history() noexcept;
 
     [[nodiscard]] absl::Span<const Lef> get_lefs(usize size = npos) const noexcept;
-    [[nodiscard]] absl::Span<const usize> get_rev_ranks(usize size = npos) const noexcept;
-    [[nodiscard]] absl::Span<const usize> get_fwd_ranks(usize size = npos) const noexcept;
-    [[nodiscard]] absl::Span<const bp_t> get_rev_moves(usize size = npos) const noexcept;
-    [[nodiscard]] absl::Span<const bp_t> get_fwd_moves(usize size = npos) const noexcept;
+    [[nodiscard]] absl::Span<const lef_idx_t> get_rev_ranks(usize size = npos) const noexcept;
+    [[nodiscard]] absl::Span<const lef_idx_t> get_fwd_ranks(usize size = npos) const noexcept;
+    [[nodiscard]] absl::Span<const lef_move_t> get_rev_moves(usize size = npos) const noexcept;
+    [[nodiscard]] absl::Span<const lef_move_t> get_fwd_moves(usize size = npos) const noexcept;
     [[nodiscard]] absl::Span<const usize> get_idx_buff(usize size = npos) const noexcept;
     [[nodiscard]] absl::Span<const CollisionT> get_rev_collisions(usize size = npos) const noexcept;
     [[nodiscard]] absl::Span<const CollisionT> get_fwd_collisions(usize size = npos) const noexcept;
-    [[nodiscard]] const std::deque<double>& get_cfx_of_variation() const noexcept;
-    [[nodiscard]] const std::deque<double>& get_avg_loop_sizes() const noexcept;
+    [[nodiscard]] absl::Span<const LefRelease> get_lef_releases(usize size = npos) const noexcept;
+    [[nodiscard]] const BurninTracker& get_burnin_history() const noexcept;
 
     [[nodiscard]] bool is_modle_pert_state() const noexcept;
     [[nodiscard]] bool is_modle_sim_state() const noexcept;
 
+    /// PRNG used to perform per-epoch draws (see Simulation::epoch_rand_eng_t)
+    template <u8f Features>
+    [[nodiscard]] epoch_rand_eng_t<Features>& epoch_rand_eng() noexcept;
+
     // These fields are specific to modle pert
     bp_t deletion_begin{};       // NOLINT
     bp_t deletion_size{};        // NOLINT
@@ -166,12 +275,30 @@ class Simulation : Config {
     std::shared_ptr<const ContactMatrixDense<contacts_t>> reference_contacts{nullptr};  // NOLINT
     std::shared_ptr<ContactMatrixDense<contacts_t>> contacts{nullptr};                  // NOLINT
 
+    // Summed-area tables used by modle pert to compute the number of contacts around pairs of
+    // features in constant time
+    std::shared_ptr<const ContactMatrixDense<contacts_t>::SummedAreaTable>  // NOLINT
+        reference_block_sums{nullptr};
+    ContactMatrixDense<contacts_t>::SummedAreaTable block_sums{};  // NOLINT
+    std::shared_ptr<WindowSnapshot> window_snapshot{nullptr};      // NOLINT
+
+    // Thread-local buffers used by modle sim to register contacts without locking the contact
+    // matrix. See Simulation::flush_contact_buffer for more details
+    std::vector<PixelCoordinates> contact_buff{};  // NOLINT
+    std::vector<Pixel<contacts_t>> pixel_buff{};   // NOLINT
+    ContactSamplingBuffers sampling_buffs{};       // NOLINT
+    UnitPositionBuffers unit_pos_buffs{};          // NOLINT
+
     State& operator=(const Task& task);
     State& operator=(const TaskPW& task);
     [[nodiscard]] std::string to_string() const noexcept;
 
     void resize_buffers(usize size = (std::numeric_limits<usize>::max)());
     void reset_buffers();
+
+   private:
+    /// Share the barrier table of \p task (when available) instead of building a new one
+    void assign_barriers(const BaseTask& task);
   };
 
   void run_simulate();
@@ -180,13 +307,30 @@ class Simulation : Config {
 
  private:
   Genome _genome{};
+  // Only initialized when contact noise is tabulated (see Config::tabulate_contact_noise)
+  tabulated_genextreme_value_distribution<double> _contact_noise_table{};
   std::atomic<bool> _end_of_simulation{false};
   std::atomic<bool> _exception_thrown{false};
+  // Memory (in bytes) used by contact matrices, LEF occupancy buffers and State buffers
+  std::atomic<usize> _memory_in_use{0};
+  std::atomic<usize> _peak_memory_in_use{0};
   std::vector<std::exception_ptr> _exceptions{};  // NOLINT(bugprone-throw-keyword-missing)
   std::mutex _exceptions_mutex{};
+  // Profiling counters aggregated per thread (the last entry refers to the thread writing contacts
+  // to disk) and per chromosome (indexed by Chromosome::id()). These are only populated when
+  // profiling is enabled
+  std::vector<ProfileCounters> _thread_profiles{};
+  std::vector<ProfileCounters> _chrom_profiles{};
+  std::mutex _profiles_mutex{};
   BS::thread_pool _tpool;
 
   static constexpr auto& model_internal_state_log_header = Config::model_internal_state_log_header;
+  /// Max number of contacts buffered by a State before they are merged into the contact matrix
+  static constexpr usize max_contact_buff_size = 1'000'000;
+  /// Max number of threads used by the writer thread to extract and compress pixels.
+  /// Worker threads keep simulating while a chromosome is being written, so the writer only needs
+  /// a few threads to keep up with the simulation
+  static constexpr usize max_cooler_writer_threads = 2;
 
   [[nodiscard]] bool ok() const noexcept;
 
@@ -196,7 +340,50 @@ class Simulation : Config {
                                                                       bool clamp_nthreads);
 
   /// Simulate loop extrusion using the parameters and buffers passed through \p state
+
+  //! This overload dispatches to the instantiation of simulate_one_cell<Features> matching the
+  //! features enabled by the current Config (see Simulation::enabled_features).
+  //! The overloads taking \p params simulate a cell that has already been set up (see
+  //! Simulation::setup_cell).
   void simulate_one_cell(State& s) const;
+  struct CellParams;
+  void simulate_one_cell(State& s, const CellParams& params) const;
+  template <u8f Features>
+  void simulate_one_cell(State& s, const CellParams& params) const;
+  template <usize... Features>
+  [[nodiscard]] static constexpr auto make_simulate_one_cell_kernels(
+      std::index_sequence<Features...>) noexcept;
+
+  /// Parameters that are computed once per cell and are used by Simulation::simulate_one_epoch
+  struct CellParams {
+    double lef_binding_rate_burnin{};
+    usize sampling_events_per_epoch{};
+    // Used to warm-start cells (see Simulation::setup_cell_from_snapshot):
+    // - stop the simulation as soon as the burn-in phase is completed
+    // - end the burn-in phase after a fixed number of epochs instead of waiting for loop sizes to
+    //   stabilize
+    bool stop_after_burnin{false};
+    usize max_num_burnin_epochs{(std::numeric_limits<usize>::max)()};
+  };
+
+  /// Seed the PRNGs and initialize the extr. barrier states for the cell described by \p s
+  [[nodiscard]] CellParams setup_cell(State& s) const;
+  [[nodiscard]] CellParams setup_cell(State& s, u64 seed) const;
+  /// Restore the state of the cell described by \p s from the snapshot of its window.
+
+  //! The snapshot is built on first use by running the burn-in phase on \p s. This must be called
+  //! before disabling the barriers overlapping the deletion described by \p s. Cells restored
+  //! from a snapshot go through a short burn-in phase lasting Config::warm_start_epochs epochs to
+  //! adapt to the new barrier configuration.
+  [[nodiscard]] CellParams setup_cell_from_snapshot(State& s) const;
+  /// Simulate one epoch.
+
+  //! \return false when the stopping criterion has been met (i.e. the cell has been simulated)
+  template <u8f Features>
+  [[nodiscard]] bool simulate_one_epoch(State& s, const CellParams& params) const;
+
+  /// Compute the bitmask of Simulation::Feature enabled by the current Config
+  [[nodiscard]] u8f enabled_features() const noexcept;
 
   /// Simulate loop extrusion on a Chromosome window using the parameters and buffers passed through
   /// \p state
@@ -205,8 +392,7 @@ class Simulation : Config {
   //! contacts between a pair of features given a specific barrier configuration.
   //! The different configurations are generated by this function based on the parameters from
   //! \p state
-  void simulate_window(State& state, compressed_io::Writer& out_stream, std::mutex& cooler_mtx,
-                       bool write_contacts_to_cooler = false) const;
+  void simulate_window(State& state, compressed_io::Writer& out_stream) const;
 
   /// Advance the simulation window by one diagonal width.
 
@@ -224,12 +410,21 @@ class Simulation : Config {
   /// a given chromosome have been simulated.
 
   //! IMPORTANT: this function is meant to be run in a dedicated thread.
+  //! Worker threads notify \p progress_queue_cv when they are done simulating a chromosome.
   void write_contacts_to_disk(std::deque<std::pair<Chromosome*, usize>>& progress_queue,
-                              std::mutex& progress_queue_mtx);
+                              std::mutex& progress_queue_mtx,
+                              std::condition_variable& progress_queue_cv);
 
   /// Write LEF occupancy in 1D space to disk as a BigWig file
   void write_1d_lef_occupancy_to_disk() const;
 
+  /// Merge the profiling counters collected while simulating or writing \p chrom to disk into the
+  /// counters for thread \p tid and for \p chrom
+  void register_profile(usize tid, const Chromosome& chrom, const ProfileCounters& profile);
+
+  /// Write the profiling counters aggregated per thread and per chromosome to a TSV file
+  void write_profile_report_to_disk() const;
+
   /// Worker function used to run an instance of the simulation
 
   //! Worker function used to consume Simulation::Tasks from a task queue, setup a
@@ -239,17 +434,38 @@ class Simulation : Config {
   //! simulation.
   //! IMPORTANT: this function is meant to be run in a dedicated thread.
   void simulate_worker(u64 tid, moodycamel::BlockingConcurrentQueue<Simulation::Task>& task_queue,
+                       moodycamel::LightweightSemaphore& free_slots,
                        std::deque<std::pair<Chromosome*, usize>>& progress_queue,
-                       std::mutex& progress_queue_mtx, std::mutex& model_state_logger_mtx,
-                       usize task_batch_size = 32);
+                       std::mutex& progress_queue_mtx, std::condition_variable& progress_queue_cv,
+                       std::mutex& model_state_logger_mtx, usize task_batch_size = 32);
 
   void perturbate_worker(u64 tid,
                          moodycamel::BlockingConcurrentQueue<Simulation::TaskPW>& task_queue,
-                         const std::filesystem::path& tmp_output_path, std::mutex& cooler_mtx,
-                         usize task_batch_size = 1);
+                         moodycamel::LightweightSemaphore& free_slots,
+                         const std::filesystem::path& tmp_output_path, usize task_batch_size = 1);
 
+  /// Output file and queue of cells shared by replay_worker and write_replay_output (see
+  /// scheduler_replay.cpp)
+  struct ReplayOutput;
+
+  /// Worker function used to replay Simulation::TaskPWs
+
+  //! Once a task has been simulated, its contacts are converted to a compressed cell of the output
+  //! .scool file, which is then handed over to write_replay_output through \p output.
+  //! IMPORTANT: this function is meant to be run in a dedicated thread.
   void replay_worker(u64 tid, moodycamel::BlockingConcurrentQueue<Simulation::TaskPW>& task_queue,
-                     std::mutex& cooler_mtx, usize task_batch_size = 32);
+                     moodycamel::LightweightSemaphore& free_slots, ReplayOutput& output,
+                     usize task_batch_size = 32);
+
+  /// Append the cells produced by replay_worker to the output .scool file
+
+  //! IMPORTANT: this function is meant to be run in a dedicated thread. It returns once all
+  //! replay_worker threads have returned and all their cells have been written to disk.
+  void write_replay_output(ReplayOutput& output);
+
+  /// Write a batch of tasks to whichever of \p tsv_writer and \p bin_writer is open
+  static void write_tasks(compressed_io::Writer& tsv_writer, task_file::Writer& bin_writer,
+                          absl::Span<const TaskPW> tasks);
 
   /// Bind inactive LEFs, then sort them by their genomic coordinates.
 
@@ -259,14 +475,16 @@ class Simulation : Config {
   //! documentation and comments for Simulation::rank_lefs for more details).
   template <typename MaskT>
   inline static void bind_lefs(const Chromosome& chrom, absl::Span<Lef> lefs,
-                               absl::Span<usize> rev_lef_ranks, absl::Span<usize> fwd_lef_ranks,
-                               const MaskT& mask, random::PRNG_t& rand_eng,
+                               absl::Span<lef_idx_t> rev_lef_ranks,
+                               absl::Span<lef_idx_t> fwd_lef_ranks, const MaskT& mask,
+                               random::PRNG_t& rand_eng,
                                usize current_epoch) noexcept(utils::ndebug_defined());
 
   template <typename MaskT>
   inline static void bind_lefs(bp_t start_pos, bp_t end_pos, absl::Span<Lef> lefs,
-                               absl::Span<usize> rev_lef_ranks, absl::Span<usize> fwd_lef_ranks,
-                               const MaskT& mask, random::PRNG_t& rand_eng,
+                               absl::Span<lef_idx_t> rev_lef_ranks,
+                               absl::Span<lef_idx_t> fwd_lef_ranks, const MaskT& mask,
+                               random::PRNG_t& rand_eng,
                                usize current_epoch) noexcept(utils::ndebug_defined());
 
   static void select_and_bind_lefs(State& s) noexcept(utils::ndebug_defined());
@@ -279,10 +497,24 @@ class Simulation : Config {
   //! See Simulation::adjust_moves_of_consecutive_extr_units for more details
   // clang-format on
   void generate_moves(const Chromosome& chrom, absl::Span<const Lef> lefs,
-                      absl::Span<const usize> rev_lef_ranks, absl::Span<const usize> fwd_lef_ranks,
-                      absl::Span<bp_t> rev_moves, absl::Span<bp_t> fwd_moves, bool burnin_completed,
+                      absl::Span<const lef_idx_t> rev_lef_ranks,
+                      absl::Span<const lef_idx_t> fwd_lef_ranks, absl::Span<lef_move_t> rev_moves,
+                      absl::Span<lef_move_t> fwd_moves, bool burnin_completed,
                       random::PRNG_t& rand_eng, bool adjust_moves_ = true) const
       noexcept(utils::ndebug_defined());
+  void generate_moves(const Chromosome& chrom, absl::Span<const Lef> lefs,
+                      absl::Span<const lef_idx_t> rev_lef_ranks,
+                      absl::Span<const lef_idx_t> fwd_lef_ranks, absl::Span<lef_move_t> rev_moves,
+                      absl::Span<lef_move_t> fwd_moves, bool burnin_completed,
+                      random::BatchPRNG& rand_eng, bool adjust_moves_ = true) const
+      noexcept(utils::ndebug_defined());
+  template <u8f Features>
+  void generate_moves(const Chromosome& chrom, absl::Span<const Lef> lefs,
+                      absl::Span<const lef_idx_t> rev_lef_ranks,
+                      absl::Span<const lef_idx_t> fwd_lef_ranks, absl::Span<lef_move_t> rev_moves,
+                      absl::Span<lef_move_t> fwd_moves, bool burnin_completed,
+                      epoch_rand_eng_t<Features>& rand_eng, bool adjust_moves_ = true) const
+      noexcept(utils::ndebug_defined());
 
   // clang-format off
   //! Adjust moves of consecutive extr. units moving in the same direction to improve simulation realism
@@ -303,18 +535,20 @@ class Simulation : Config {
   //! against the fwd_unit of LEF2, temporarily increasing the fwd extr. speed of LEF2.
   // clang-format on
   static void adjust_moves_of_consecutive_extr_units(
-      const Chromosome& chrom, absl::Span<const Lef> lefs, absl::Span<const usize> rev_lef_ranks,
-      absl::Span<const usize> fwd_lef_ranks, absl::Span<bp_t> rev_moves,
-      absl::Span<bp_t> fwd_moves) noexcept(utils::ndebug_defined());
+      const Chromosome& chrom, absl::Span<const Lef> lefs,
+      absl::Span<const lef_idx_t> rev_lef_ranks, absl::Span<const lef_idx_t> fwd_lef_ranks,
+      absl::Span<lef_move_t> rev_moves,
+      absl::Span<lef_move_t> fwd_moves) noexcept(utils::ndebug_defined());
 
   /// Clamp moves to prevent LEFs from falling off chromosomal boundaries
   static void clamp_moves(const Chromosome& chrom, absl::Span<const Lef> lefs,
-                          absl::Span<bp_t> rev_moves, absl::Span<bp_t> fwd_moves) noexcept;
+                          absl::Span<lef_move_t> rev_moves,
+                          absl::Span<lef_move_t> fwd_moves) noexcept;
 
   /// Sort extr. units by index based on their position whilst properly dealing with ties. See
   /// comments in \p simulation_impl.hpp file for more details.
-  static void rank_lefs(absl::Span<const Lef> lefs, absl::Span<usize> rev_lef_ranks,
-                        absl::Span<usize> fwd_lef_ranks, bool ranks_are_partially_sorted = true,
+  static void rank_lefs(absl::Span<const Lef> lefs, absl::Span<lef_idx_t> rev_lef_ranks,
+                        absl::Span<lef_idx_t> fwd_lef_ranks, bool ranks_are_partially_sorted = true,
                         bool init_buffers = false) noexcept(utils::ndebug_defined());
 
   /// Extrude LEFs by applying the respective moves
@@ -324,8 +558,8 @@ class Simulation : Config {
   //! - Simulation::adjust_moves_of_consecutive_extr_units
   //! - Simulation::process_collisions
   static void extrude(const Chromosome& chrom, absl::Span<Lef> lefs,
-                      absl::Span<const bp_t> rev_moves,
-                      absl::Span<const bp_t> fwd_moves) noexcept(utils::ndebug_defined());
+                      absl::Span<const lef_move_t> rev_moves,
+                      absl::Span<const lef_move_t> fwd_moves) noexcept(utils::ndebug_defined());
 
   //! This is just a wrapper function used to make sure that process_* functions are always called
   //! in the right order
@@ -333,20 +567,66 @@ class Simulation : Config {
   //! \return number of rev units at the 5'-end, number of fwd units at the 3'-end
   std::pair<usize, usize> process_collisions(
       const Chromosome& chrom, absl::Span<Lef> lefs, ExtrusionBarriers& barriers,
-      absl::Span<usize> rev_lef_ranks, absl::Span<usize> fwd_lef_ranks, absl::Span<bp_t> rev_moves,
-      absl::Span<bp_t> fwd_moves, absl::Span<CollisionT> rev_collisions,
-      absl::Span<CollisionT> fwd_collisions, random::PRNG_t& rand_eng) const
+      absl::Span<lef_idx_t> rev_lef_ranks, absl::Span<lef_idx_t> fwd_lef_ranks,
+      absl::Span<lef_move_t> rev_moves, absl::Span<lef_move_t> fwd_moves,
+      absl::Span<CollisionT> rev_collisions, absl::Span<CollisionT> fwd_collisions,
+      random::PRNG_t& rand_eng) const
       noexcept(utils::ndebug_defined());
 
+  /// Alternative implementation of Simulation::process_collisions making fewer passes over LEFs.
+
+  //! Positions of the extr. units are gathered in 5'-3' order into \p buffs once per epoch, so
+  //! that collision detection scans contiguous buffers instead of going through the LEF array.
+  //! Moves are then corrected and secondary LEF-LEF collisions are detected in a single sweep per
+  //! direction.
+  //! Random numbers are drawn in the same order as in Simulation::process_collisions, thus the two
+  //! implementations produce identical moves and collisions. The implementation used by
+  //! Simulation::simulate_one_cell is selected through Config::fused_collision_pipeline.
+  std::pair<usize, usize> process_collisions_fused(
+      const Chromosome& chrom, absl::Span<Lef> lefs, const ExtrusionBarriers& barriers,
+      absl::Span<lef_idx_t> rev_lef_ranks, absl::Span<lef_idx_t> fwd_lef_ranks,
+      absl::Span<lef_move_t> rev_moves, absl::Span<lef_move_t> fwd_moves,
+      absl::Span<CollisionT> rev_collisions, absl::Span<CollisionT> fwd_collisions,
+      UnitPositionBuffers& buffs, random::PRNG_t& rand_eng) const noexcept(utils::ndebug_defined());
+
+  static void gather_unit_positions(absl::Span<const Lef> lefs,
+                                    absl::Span<const lef_idx_t> rev_lef_ranks,
+                                    absl::Span<const lef_idx_t> fwd_lef_ranks,
+                                    UnitPositionBuffers& buffs);
+
+  void detect_lef_bar_collisions_fused(
+      absl::Span<const lef_idx_t> rev_lef_ranks, absl::Span<const lef_idx_t> fwd_lef_ranks,
+      absl::Span<const lef_move_t> rev_moves, absl::Span<const lef_move_t> fwd_moves,
+      const ExtrusionBarriers& barriers, absl::Span<CollisionT> rev_collisions,
+      absl::Span<CollisionT> fwd_collisions, const UnitPositionBuffers& buffs,
+      random::PRNG_t& rand_eng, usize num_rev_units_at_5prime, usize num_fwd_units_at_3prime) const
+      noexcept(utils::ndebug_defined());
+
+  void detect_primary_lef_lef_collisions_fused(
+      absl::Span<const Lef> lefs, const ExtrusionBarriers& barriers,
+      absl::Span<const lef_idx_t> rev_lef_ranks, absl::Span<const lef_idx_t> fwd_lef_ranks,
+      absl::Span<const lef_move_t> rev_moves, absl::Span<const lef_move_t> fwd_moves,
+      absl::Span<CollisionT> rev_collisions, absl::Span<CollisionT> fwd_collisions,
+      const UnitPositionBuffers& buffs, random::PRNG_t& rand_eng, usize num_rev_units_at_5prime,
+      usize num_fwd_units_at_3prime) const noexcept(utils::ndebug_defined());
+
+  void correct_moves_and_detect_secondary_lef_lef_collisions(
+      absl::Span<const Lef> lefs, const ExtrusionBarriers& barriers,
+      absl::Span<const lef_idx_t> rev_lef_ranks, absl::Span<const lef_idx_t> fwd_lef_ranks,
+      absl::Span<lef_move_t> rev_moves, absl::Span<lef_move_t> fwd_moves,
+      absl::Span<CollisionT> rev_collisions, absl::Span<CollisionT> fwd_collisions,
+      const UnitPositionBuffers& buffs, random::PRNG_t& rand_eng, usize num_rev_units_at_5prime,
+      usize num_fwd_units_at_3prime) const noexcept(utils::ndebug_defined());
+
   /// Detect and stall LEFs with one or more extrusion units located at chromosomal boundaries.
 
   //! \return a pair of numbers consisting in the number of rev units located at the 5'-end and
   //! number of fwd units located at the 3'-end.
   static std::pair<usize, usize> detect_units_at_chrom_boundaries(
-      const Chromosome& chrom, absl::Span<const Lef> lefs, absl::Span<const usize> rev_lef_ranks,
-      absl::Span<const usize> fwd_lef_ranks, absl::Span<const bp_t> rev_moves,
-      absl::Span<const bp_t> fwd_moves, absl::Span<CollisionT> rev_collisions,
-      absl::Span<CollisionT> fwd_collisions);
+      const Chromosome& chrom, absl::Span<const Lef> lefs,
+      absl::Span<const lef_idx_t> rev_lef_ranks, absl::Span<const lef_idx_t> fwd_lef_ranks,
+      absl::Span<const lef_move_t> rev_moves, absl::Span<const lef_move_t> fwd_moves,
+      absl::Span<CollisionT> rev_collisions, absl::Span<CollisionT> fwd_collisions);
 
   /// Detect collisions between LEFs and extrusion barriers.
 
@@ -354,9 +634,11 @@ class Simulation : Config {
   //! corresponding to reverse or forward extrusion units that will collide with an extrusion
   //! barrier in the current iteration, will be set to the index corresponding to the barrier that
   //! is causing the collision.
-  void detect_lef_bar_collisions(absl::Span<const Lef> lefs, absl::Span<const usize> rev_lef_ranks,
-                                 absl::Span<const usize> fwd_lef_ranks,
-                                 absl::Span<const bp_t> rev_moves, absl::Span<const bp_t> fwd_moves,
+  void detect_lef_bar_collisions(absl::Span<const Lef> lefs,
+                                 absl::Span<const lef_idx_t> rev_lef_ranks,
+                                 absl::Span<const lef_idx_t> fwd_lef_ranks,
+                                 absl::Span<const lef_move_t> rev_moves,
+                                 absl::Span<const lef_move_t> fwd_moves,
                                  const ExtrusionBarriers& barriers,
                                  absl::Span<CollisionT> rev_collisions,
                                  absl::Span<CollisionT> fwd_collisions, random::PRNG_t& rand_eng,
@@ -374,8 +656,8 @@ class Simulation : Config {
   //! The index i is encoded as num_barriers + i.
   void detect_primary_lef_lef_collisions(
       absl::Span<const Lef> lefs, const ExtrusionBarriers& barriers,
-      absl::Span<const usize> rev_lef_ranks, absl::Span<const usize> fwd_lef_ranks,
-      absl::Span<const bp_t> rev_moves, absl::Span<const bp_t> fwd_moves,
+      absl::Span<const lef_idx_t> rev_lef_ranks, absl::Span<const lef_idx_t> fwd_lef_ranks,
+      absl::Span<const lef_move_t> rev_moves, absl::Span<const lef_move_t> fwd_moves,
       absl::Span<CollisionT> rev_collisions, absl::Span<CollisionT> fwd_collisions,
       random::PRNG_t& rand_eng, usize num_rev_units_at_5prime = 0,
       usize num_fwd_units_at_3prime = 0) const noexcept(utils::ndebug_defined());
@@ -396,64 +678,133 @@ class Simulation : Config {
   //! The index i is encoded as num_barriers + num_lefs + i.
   // clang-format on
   void process_secondary_lef_lef_collisions(
-      const Chromosome& chrom, absl::Span<const Lef> lefs, absl::Span<const usize> rev_lef_ranks,
-      absl::Span<const usize> fwd_lef_ranks, absl::Span<bp_t> rev_moves, absl::Span<bp_t> fwd_moves,
+      const Chromosome& chrom, absl::Span<const Lef> lefs,
+      absl::Span<const lef_idx_t> rev_lef_ranks, absl::Span<const lef_idx_t> fwd_lef_ranks,
+      absl::Span<lef_move_t> rev_moves, absl::Span<lef_move_t> fwd_moves,
       absl::Span<CollisionT> rev_collisions, absl::Span<CollisionT> fwd_collisions,
       random::PRNG_t& rand_eng, usize num_rev_units_at_5prime = 0,
       usize num_fwd_units_at_3prime = 0) const noexcept(utils::ndebug_defined());
 
   static void fix_secondary_lef_lef_collisions(
-      const Chromosome& chrom, absl::Span<Lef> lefs, absl::Span<usize> rev_lef_ranks,
-      absl::Span<usize> fwd_lef_ranks, absl::Span<bp_t> rev_moves, absl::Span<bp_t> fwd_moves,
-      absl::Span<CollisionT> rev_collisions, absl::Span<CollisionT> fwd_collisions,
+      const Chromosome& chrom, absl::Span<Lef> lefs, absl::Span<lef_idx_t> rev_lef_ranks,
+      absl::Span<lef_idx_t> fwd_lef_ranks, absl::Span<lef_move_t> rev_moves,
+      absl::Span<lef_move_t> fwd_moves, absl::Span<CollisionT> rev_collisions,
+      absl::Span<CollisionT> fwd_collisions,
       usize num_rev_units_at_5prime,
       usize num_fwd_units_at_3prime) noexcept(utils::ndebug_defined());
 
   /// Correct moves to comply with the constraints imposed by LEF-BAR collisions.
   static void correct_moves_for_lef_bar_collisions(
-      absl::Span<const Lef> lefs, const ExtrusionBarriers& barriers, absl::Span<bp_t> rev_moves,
-      absl::Span<bp_t> fwd_moves, absl::Span<const CollisionT> rev_collisions,
+      absl::Span<const Lef> lefs, const ExtrusionBarriers& barriers,
+      absl::Span<lef_move_t> rev_moves, absl::Span<lef_move_t> fwd_moves,
+      absl::Span<const CollisionT> rev_collisions,
       absl::Span<const CollisionT> fwd_collisions) noexcept(utils::ndebug_defined());
 
   /// Correct moves to comply with the constraints imposed by primary LEF-LEF collisions.
   static void correct_moves_for_primary_lef_lef_collisions(
-      absl::Span<const Lef> lefs, absl::Span<const usize> rev_ranks,
-      absl::Span<const usize> fwd_ranks, absl::Span<bp_t> rev_moves, absl::Span<bp_t> fwd_moves,
-      absl::Span<const CollisionT> rev_collisions,
+      absl::Span<const Lef> lefs, absl::Span<const lef_idx_t> rev_ranks,
+      absl::Span<const lef_idx_t> fwd_ranks, absl::Span<lef_move_t> rev_moves,
+      absl::Span<lef_move_t> fwd_moves, absl::Span<const CollisionT> rev_collisions,
       absl::Span<const CollisionT> fwd_collisions) noexcept(utils::ndebug_defined());
 
   /// Register contacts for chromosome \p chrom using the position the extrusion units of the LEFs
-  /// in \p lefs whose index is present in \p selected_lef_idx.
+  /// in \p lefs.
   void register_contacts_loop(Chromosome& chrom, absl::Span<const Lef> lefs,
                               usize num_contacts_to_register, random::PRNG_t& rand_eng) const;
-  void register_contacts_loop(bp_t start_pos, bp_t end_pos,
-                              ContactMatrixDense<contacts_t>& contacts, absl::Span<const Lef> lefs,
-                              usize num_contacts_to_register, random::PRNG_t& rand_eng) const;
+  //! \p contacts can be either a ContactMatrixDense or a std::vector<PixelCoordinates> used to
+  //! buffer contacts (see Simulation::flush_contact_buffer).
+  //! LEFs are sampled with replacement using Simulation::sample_lef_positions. When
+  //! Config::fast_sampling is set, LEFs are sampled among those listed in \p buffs.eligible_lefs
+  //! (see Simulation::select_lefs_for_contact_sampling).
+  //! \return the number of contacts that have been registered
+  template <u8f Features, typename ContactSinkT>
+  usize register_contacts_loop(bp_t start_pos, bp_t end_pos, ContactSinkT& contacts,
+                               absl::Span<const Lef> lefs, usize num_contacts_to_register,
+                               epoch_rand_eng_t<Features>& rand_eng,
+                               ContactSamplingBuffers& buffs) const;
   void register_contacts_tad(Chromosome& chrom, absl::Span<const Lef> lefs,
                              usize num_contacts_to_register, random::PRNG_t& rand_eng) const;
-  void register_contacts_tad(bp_t start_pos, bp_t end_pos, ContactMatrixDense<contacts_t>& contacts,
-                             absl::Span<const Lef> lefs, usize num_contacts_to_register,
-                             random::PRNG_t& rand_eng) const;
+  template <u8f Features, typename ContactSinkT>
+  usize register_contacts_tad(bp_t start_pos, bp_t end_pos, ContactSinkT& contacts,
+                              absl::Span<const Lef> lefs, usize num_contacts_to_register,
+                              epoch_rand_eng_t<Features>& rand_eng,
+                              ContactSamplingBuffers& buffs) const;
+
+  /// Store the idx of the LEFs that are bound and whose extr. units fall within
+  /// (start_pos, end_pos) in \p buff.
+  static void select_lefs_for_contact_sampling(bp_t start_pos, bp_t end_pos,
+                                               absl::Span<const Lef> lefs,
+                                               std::vector<usize>& buff);
+
+  /// Sample \p num_events LEFs with replacement and call \p fx(p1, p2) with the (noisy) position of
+  /// their extr. units.
+
+  //! LEFs are sampled one at a time among \p lefs. LEFs whose extr. units do not fall within
+  //! (start_pos, end_pos) and pairs of positions falling outside of [start_pos, end_pos) are
+  //! rejected and re-sampled. \p buffs is not used.
+  //! \return the number of times \p fx has been called
+  template <u8f Features, typename PositionConsumer>
+  usize sample_lef_positions(bp_t start_pos, bp_t end_pos, absl::Span<const Lef> lefs,
+                             usize num_events, random::PRNG_t& rand_eng,
+                             ContactSamplingBuffers& buffs, PositionConsumer&& fx) const;
+  //! Overload used when Config::fast_sampling is set.
+  //! Instead of sampling one LEF at a time, the number of times each LEF listed in
+  //! \p buffs.eligible_lefs is sampled is drawn in bulk from a multinomial distribution.
+  //! Noise is then generated in batches, and LEFs are visited in order.
+  //! Pairs of positions falling outside of [start_pos, end_pos) are rejected and re-sampled
+  //! (LEF included), which is equivalent to sampling LEFs one at a time with rejection.
+  //! No events are sampled when \p buffs.eligible_lefs is empty.
+  template <u8f Features, typename PositionConsumer>
+  usize sample_lef_positions(bp_t start_pos, bp_t end_pos, absl::Span<const Lef> lefs,
+                             usize num_events, random::BatchPRNG& rand_eng,
+                             ContactSamplingBuffers& buffs, PositionConsumer&& fx) const;
+
+  /// Merge the contacts buffered in \p s into the contact matrix referenced by \p s
+
+  //! Buffered contacts are sorted and compacted before being added to the contact matrix, so that
+  //! each pixel mutex is locked at most once per unique pixel instead of once per contact.
+  static void flush_contact_buffer(State& s);
 
   void register_1d_lef_occupancy(Chromosome& chrom, absl::Span<const Lef> lefs,
                                  usize num_sampling_events, random::PRNG_t& rand_eng) const;
+  void register_1d_lef_occupancy(Chromosome& chrom, absl::Span<const Lef> lefs,
+                                 usize num_sampling_events, random::BatchPRNG& rand_eng) const;
 
+  template <u8f Features>
   void register_1d_lef_occupancy(bp_t start_pos, bp_t end_pos,
                                  std::vector<std::atomic<u64>>& occupancy_buff,
                                  absl::Span<const Lef> lefs, usize num_sampling_events,
-                                 random::PRNG_t& rand_eng) const;
+                                 epoch_rand_eng_t<Features>& rand_eng,
+                                 ContactSamplingBuffers& buffs) const;
 
   template <typename MaskT>
   inline static void select_lefs_to_bind(absl::Span<const Lef> lefs,
                                          MaskT& mask) noexcept(utils::ndebug_defined());
 
+  /// Select LEFs to be released in the current epoch and release them.
+
+  //! The release hazard of a LEF depends on whether it is stalled by extr. barriers and on whether
+  //! the burn-in phase is completed. One Bernoulli trial is run for each bound LEF.
   usize release_lefs(absl::Span<Lef> lefs, const ExtrusionBarriers& barriers,
                      absl::Span<const CollisionT> rev_collisions,
                      absl::Span<const CollisionT> fwd_collisions, random::PRNG_t& rand_eng,
                      bool burnin_completed) const noexcept;
+  /// Release LEFs whose scheduled release epoch is \p current_epoch.
+
+  //! Overload used when Config::fast_sampling is set. Instead of running one Bernoulli trial per
+  //! LEF per epoch, the number of epochs until a LEF is released is drawn from a geometric
+  //! distribution every time the LEF is bound or its hazard changes, and is stored in
+  //! \p releases. This is equivalent to running one trial per epoch, as geometric waiting times
+  //! are memoryless.
+  usize release_lefs(absl::Span<Lef> lefs, const ExtrusionBarriers& barriers,
+                     absl::Span<const CollisionT> rev_collisions,
+                     absl::Span<const CollisionT> fwd_collisions, absl::Span<LefRelease> releases,
+                     usize current_epoch, random::BatchPRNG& rand_eng,
+                     bool burnin_completed) const noexcept;
 
   [[nodiscard]] static std::pair<bp_t /*rev*/, bp_t /*fwd*/> compute_lef_lef_collision_pos(
-      const ExtrusionUnit& rev_unit, const ExtrusionUnit& fwd_unit, bp_t rev_move, bp_t fwd_move);
+      const ExtrusionUnit& rev_unit, const ExtrusionUnit& fwd_unit, lef_move_t rev_move,
+      lef_move_t fwd_move);
 
   [[nodiscard]] bed::BED_tree<> import_deletions() const;
   [[nodiscard]] bed::BED_tree<> generate_deletions() const;
@@ -463,17 +814,17 @@ class Simulation : Config {
   [[noreturn]] void rethrow_exceptions() const;
   [[noreturn]] void handle_exceptions();
 
-  static void compute_loop_size_stats(absl::Span<const Lef> lefs,
-                                      std::deque<double>& cfx_of_variations,
-                                      std::deque<double>& avg_loop_sizes,
-                                      usize buff_capacity) noexcept;
+  /// Compute the average loop size and its coefficient of variation, and record them in \p history
 
-  static bool evaluate_burnin(const std::deque<double>& cfx_of_variations,
-                              const std::deque<double>& avg_loop_sizes, usize buff_capacity,
-                              usize window_size) noexcept;
+  //! This scans the LEF buffer once per burn-in epoch. Loop sizes change for every bound LEF at
+  //! every epoch, so keeping incremental sums in extrude() would not avoid that pass, and would
+  //! slow down the epochs following the burn-in, where these statistics are not used
+  static void compute_loop_size_stats(absl::Span<const Lef> lefs, BurninTracker& history) noexcept;
 
-  void run_burnin(State& s, double lef_binding_rate_burnin) const;
+  void run_burnin(State& s, const CellParams& params) const;
 
+  void sample_and_register_contacts(State& s, usize num_sampling_events) const;
+  template <u8f Features>
   void sample_and_register_contacts(State& s, usize num_sampling_events) const;
   void dump_stats(usize task_id, usize epoch, usize cell_id, bool burnin, const Chromosome& chrom,
                   absl::Span<const Lef> lefs, const ExtrusionBarriers& barriers,
@@ -484,14 +835,39 @@ class Simulation : Config {
   [[nodiscard]] usize compute_tot_target_epochs(usize nlefs, usize npixels) const noexcept;
   [[nodiscard]] usize compute_contacts_per_epoch(usize nlefs) const noexcept;
   [[nodiscard]] usize compute_num_lefs(usize size_bp) const noexcept;
+  /// Compute the amount of memory (in bytes) required to store the contacts for \p chrom
+  [[nodiscard]] usize compute_contact_matrix_size(const Chromosome& chrom) const noexcept;
+  /// Compute the amount of memory (in bytes) required to store LEF occupancy for \p chrom
+  [[nodiscard]] usize compute_lef_occupancy_buffer_size(const Chromosome& chrom) const noexcept;
+  /// Estimate the amount of memory (in bytes) used by the buffers owned by a State
+  [[nodiscard]] static usize compute_state_buffers_size(usize nlefs, usize nbarriers) noexcept;
+
+  /// Update the memory accounting after allocating or deallocating \p size bytes
+  void register_allocation(usize size) noexcept;
+  void register_deallocation(usize size) noexcept;
 
   void print_status_update(const Task& t) const noexcept;
 
+  /// Dequeue a batch of tasks, blocking until one or more tasks become available
+
+  //! Return 0 once the end of simulation has been signaled and no tasks are left in the queue.
+  //! \p free_slots is signaled with the number of tasks that have been dequeued.
   template <class TaskT>
   [[nodiscard]] usize consume_tasks_blocking(moodycamel::BlockingConcurrentQueue<TaskT>& task_queue,
                                              moodycamel::ConsumerToken& ctok,
+                                             moodycamel::LightweightSemaphore& free_slots,
                                              absl::FixedArray<TaskT>& task_buff);
 
+  /// Enqueue \p ntasks tasks, blocking until the queue has room for them
+
+  //! \p free_slots should be initialized with the capacity of \p task_queue and is decremented
+  //! by \p ntasks.
+  template <class TaskT, class TaskIt>
+  void enqueue_tasks_blocking(moodycamel::BlockingConcurrentQueue<TaskT>& task_queue,
+                              moodycamel::ProducerToken& ptok,
+                              moodycamel::LightweightSemaphore& free_slots, TaskIt first_task,
+                              usize ntasks);
+
   [[nodiscard]] constexpr bool run_lef_lef_collision_trial(random::PRNG_t& rand_eng) const noexcept;
   [[nodiscard]] constexpr bool run_lef_bar_collision_trial(double pblock,
                                                            random::PRNG_t& rand_eng) const noexcept;
@@ -507,37 +883,37 @@ class Simulation : Config {
   }
 
   static inline void test_adjust_moves(const Chromosome& chrom, const absl::Span<const Lef> lefs,
-                                       const absl::Span<const usize> rev_lef_ranks,
-                                       const absl::Span<const usize> fwd_lef_ranks,
-                                       const absl::Span<bp_t> rev_moves,
-                                       const absl::Span<bp_t> fwd_moves) {
+                                       const absl::Span<const lef_idx_t> rev_lef_ranks,
+                                       const absl::Span<const lef_idx_t> fwd_lef_ranks,
+                                       const absl::Span<lef_move_t> rev_moves,
+                                       const absl::Span<lef_move_t> fwd_moves) {
     Simulation::adjust_moves_of_consecutive_extr_units(chrom, lefs, rev_lef_ranks, fwd_lef_ranks,
                                                        rev_moves, fwd_moves);
   }
   static inline void test_adjust_and_clamp_moves(const Chromosome& chrom,
                                                  const absl::Span<const Lef> lefs,
-                                                 const absl::Span<const usize> rev_lef_ranks,
-                                                 const absl::Span<const usize> fwd_lef_ranks,
-                                                 const absl::Span<bp_t> rev_moves,
-                                                 const absl::Span<bp_t> fwd_moves) {
+                                                 const absl::Span<const lef_idx_t> rev_lef_ranks,
+                                                 const absl::Span<const lef_idx_t> fwd_lef_ranks,
+                                                 const absl::Span<lef_move_t> rev_moves,
+                                                 const absl::Span<lef_move_t> fwd_moves) {
     Simulation::adjust_moves_of_consecutive_extr_units(chrom, lefs, rev_lef_ranks, fwd_lef_ranks,
                                                        rev_moves, fwd_moves);
     Simulation::clamp_moves(chrom, lefs, absl::MakeSpan(rev_moves), absl::MakeSpan(fwd_moves));
   }
 
   inline void test_generate_moves(const Chromosome& chrom, const absl::Span<const Lef> lefs,
-                                  const absl::Span<const usize> rev_lef_ranks,
-                                  const absl::Span<const usize> fwd_lef_ranks,
-                                  const absl::Span<bp_t> rev_moves,
-                                  const absl::Span<bp_t> fwd_moves, random::PRNG_t& rand_eng,
+                                  const absl::Span<const lef_idx_t> rev_lef_ranks,
+                                  const absl::Span<const lef_idx_t> fwd_lef_ranks,
+                                  const absl::Span<lef_move_t> rev_moves,
+                                  const absl::Span<lef_move_t> fwd_moves, random::PRNG_t& rand_eng,
                                   bool adjust_moves_ = false) {
     this->generate_moves(chrom, lefs, rev_lef_ranks, fwd_lef_ranks, rev_moves, fwd_moves, false,
                          rand_eng, adjust_moves_);
   }
 
   inline static void test_rank_lefs(const absl::Span<const Lef> lefs,
-                                    const absl::Span<usize> rev_lef_ranks,
-                                    const absl::Span<usize> fwd_lef_ranks,
+                                    const absl::Span<lef_idx_t> rev_lef_ranks,
+                                    const absl::Span<lef_idx_t> fwd_lef_ranks,
                                     bool ranks_are_partially_sorted = true,
                                     bool init_buffers = false) {
     Simulation::rank_lefs(lefs, rev_lef_ranks, fwd_lef_ranks, ranks_are_partially_sorted,
@@ -546,18 +922,19 @@ class Simulation : Config {
 
   inline static void test_detect_units_at_chrom_boundaries(
       const Chromosome& chrom, const absl::Span<const Lef> lefs,
-      const absl::Span<const usize> rev_lef_ranks, const absl::Span<const usize> fwd_lef_ranks,
-      const absl::Span<const bp_t> rev_moves, const absl::Span<const bp_t> fwd_moves,
-      const absl::Span<CollisionT> rev_collisions, const absl::Span<CollisionT> fwd_collisions) {
+      const absl::Span<const lef_idx_t> rev_lef_ranks,
+      const absl::Span<const lef_idx_t> fwd_lef_ranks, const absl::Span<const lef_move_t> rev_moves,
+      const absl::Span<const lef_move_t> fwd_moves, const absl::Span<CollisionT> rev_collisions,
+      const absl::Span<CollisionT> fwd_collisions) {
     Simulation::detect_units_at_chrom_boundaries(chrom, lefs, rev_lef_ranks, fwd_lef_ranks,
                                                  rev_moves, fwd_moves, rev_collisions,
                                                  fwd_collisions);
   }
 
   inline void test_detect_lef_bar_collisions(
-      const absl::Span<const Lef> lefs, const absl::Span<const usize> rev_lef_ranks,
-      const absl::Span<const usize> fwd_lef_ranks, const absl::Span<const bp_t> rev_moves,
-      const absl::Span<const bp_t> fwd_moves, const ExtrusionBarriers& barriers,
+      const absl::Span<const Lef> lefs, const absl::Span<const lef_idx_t> rev_lef_ranks,
+      const absl::Span<const lef_idx_t> fwd_lef_ranks, const absl::Span<const lef_move_t> rev_moves,
+      const absl::Span<const lef_move_t> fwd_moves, const ExtrusionBarriers& barriers,
       const absl::Span<CollisionT> rev_collisions, const absl::Span<CollisionT> fwd_collisions,
       random::PRNG_t& rand_eng) {
     Simulation::detect_lef_bar_collisions(lefs, rev_lef_ranks, fwd_lef_ranks, rev_moves, fwd_moves,
@@ -566,7 +943,7 @@ class Simulation : Config {
 
   inline static void test_correct_moves_for_lef_bar_collisions(
       const absl::Span<const Lef> lefs, const ExtrusionBarriers& barriers,
-      const absl::Span<bp_t> rev_moves, const absl::Span<bp_t> fwd_moves,
+      const absl::Span<lef_move_t> rev_moves, const absl::Span<lef_move_t> fwd_moves,
       const absl::Span<const CollisionT> rev_collisions,
       const absl::Span<const CollisionT> fwd_collisions) {
     Simulation::correct_moves_for_lef_bar_collisions(lefs, barriers, rev_moves, fwd_moves,
@@ -574,19 +951,21 @@ class Simulation : Config {
   }
 
   inline static void test_adjust_moves_for_primary_lef_lef_collisions(
-      absl::Span<const Lef> lefs, absl::Span<const usize> rev_ranks,
-      absl::Span<const usize> fwd_ranks, absl::Span<bp_t> rev_moves, absl::Span<bp_t> fwd_moves,
-      absl::Span<const CollisionT> rev_collisions, absl::Span<const CollisionT> fwd_collisions) {
+      absl::Span<const Lef> lefs, absl::Span<const lef_idx_t> rev_ranks,
+      absl::Span<const lef_idx_t> fwd_ranks, absl::Span<lef_move_t> rev_moves,
+      absl::Span<lef_move_t> fwd_moves, absl::Span<const CollisionT> rev_collisions,
+      absl::Span<const CollisionT> fwd_collisions) {
     Simulation::correct_moves_for_primary_lef_lef_collisions(
         lefs, rev_ranks, fwd_ranks, rev_moves, fwd_moves, rev_collisions, fwd_collisions);
   }
 
   inline void test_process_collisions(
       const Chromosome& chrom, const absl::Span<const Lef> lefs,
-      const absl::Span<const usize> rev_lef_ranks, const absl::Span<const usize> fwd_lef_ranks,
-      const absl::Span<bp_t> rev_moves, const absl::Span<bp_t> fwd_moves,
-      const ExtrusionBarriers& barriers, const absl::Span<CollisionT> rev_collisions,
-      const absl::Span<CollisionT> fwd_collisions, random::PRNG_t& rand_eng) {
+      const absl::Span<const lef_idx_t> rev_lef_ranks,
+      const absl::Span<const lef_idx_t> fwd_lef_ranks, const absl::Span<lef_move_t> rev_moves,
+      const absl::Span<lef_move_t> fwd_moves, const ExtrusionBarriers& barriers,
+      const absl::Span<CollisionT> rev_collisions, const absl::Span<CollisionT> fwd_collisions,
+      random::PRNG_t& rand_eng) {
     const auto [num_rev_units_at_5prime, num_fwd_units_at_3prime] =
         Simulation::detect_units_at_chrom_boundaries(chrom, lefs, rev_lef_ranks, fwd_lef_ranks,
                                                      rev_moves, fwd_moves, rev_collisions,
@@ -612,20 +991,40 @@ class Simulation : Config {
   }
 
   static inline void test_fix_secondary_lef_lef_collisions(
-      const Chromosome& chrom, const absl::Span<Lef> lefs, const absl::Span<usize> rev_lef_ranks,
-      const absl::Span<usize> fwd_lef_ranks, const absl::Span<bp_t> rev_moves,
-      const absl::Span<bp_t> fwd_moves, const absl::Span<CollisionT> rev_collisions,
-      const absl::Span<CollisionT> fwd_collisions) {
+      const Chromosome& chrom, const absl::Span<Lef> lefs,
+      const absl::Span<lef_idx_t> rev_lef_ranks, const absl::Span<lef_idx_t> fwd_lef_ranks,
+      const absl::Span<lef_move_t> rev_moves, const absl::Span<lef_move_t> fwd_moves,
+      const absl::Span<CollisionT> rev_collisions, const absl::Span<CollisionT> fwd_collisions) {
     Simulation::fix_secondary_lef_lef_collisions(chrom, lefs, rev_lef_ranks, fwd_lef_ranks,
                                                  rev_moves, fwd_moves, rev_collisions,
                                                  fwd_collisions, 0, 0);
   }
 
+  // Run the collision pipeline selected through Config::fused_collision_pipeline, exactly like
+  // Simulation::simulate_one_cell does
+  inline void test_process_collisions_pipeline(
+      const Chromosome& chrom, const absl::Span<Lef> lefs, ExtrusionBarriers& barriers,
+      const absl::Span<lef_idx_t> rev_lef_ranks, const absl::Span<lef_idx_t> fwd_lef_ranks,
+      const absl::Span<lef_move_t> rev_moves, const absl::Span<lef_move_t> fwd_moves,
+      const absl::Span<CollisionT> rev_collisions, const absl::Span<CollisionT> fwd_collisions,
+      random::PRNG_t& rand_eng) {
+    if (this->fused_collision_pipeline) {
+      UnitPositionBuffers buffs{};
+      this->process_collisions_fused(chrom, lefs, barriers, rev_lef_ranks, fwd_lef_ranks,
+                                     rev_moves, fwd_moves, rev_collisions, fwd_collisions, buffs,
+                                     rand_eng);
+    } else {
+      this->process_collisions(chrom, lefs, barriers, rev_lef_ranks, fwd_lef_ranks, rev_moves,
+                               fwd_moves, rev_collisions, fwd_collisions, rand_eng);
+    }
+  }
+
   inline void test_process_lef_lef_collisions(
       const Chromosome& chrom, absl::Span<const Lef> lefs, const ExtrusionBarriers& barriers,
-      absl::Span<const usize> rev_lef_ranks, absl::Span<const usize> fwd_lef_ranks,
-      absl::Span<bp_t> rev_moves, absl::Span<bp_t> fwd_moves, absl::Span<CollisionT> rev_collisions,
-      absl::Span<CollisionT> fwd_collisions, random::PRNG_t& rand_eng) {
+      absl::Span<const lef_idx_t> rev_lef_ranks, absl::Span<const lef_idx_t> fwd_lef_ranks,
+      absl::Span<lef_move_t> rev_moves, absl::Span<lef_move_t> fwd_moves,
+      absl::Span<CollisionT> rev_collisions, absl::Span<CollisionT> fwd_collisions,
+      random::PRNG_t& rand_eng) {
     Simulation::detect_primary_lef_lef_collisions(lefs, barriers, rev_lef_ranks, fwd_lef_ranks,
                                                   rev_moves, fwd_moves, rev_collisions,
                                                   fwd_collisions, rand_eng);
@@ -640,14 +1039,149 @@ class Simulation : Config {
 
   inline void test_detect_primary_lef_lef_collisions(
       absl::Span<const Lef> lefs, const ExtrusionBarriers& barriers,
-      absl::Span<const usize> rev_lef_ranks, absl::Span<const usize> fwd_lef_ranks,
-      absl::Span<bp_t> rev_moves, absl::Span<bp_t> fwd_moves, absl::Span<CollisionT> rev_collisions,
-      absl::Span<CollisionT> fwd_collisions, random::PRNG_t& rand_eng) {
+      absl::Span<const lef_idx_t> rev_lef_ranks, absl::Span<const lef_idx_t> fwd_lef_ranks,
+      absl::Span<lef_move_t> rev_moves, absl::Span<lef_move_t> fwd_moves,
+      absl::Span<CollisionT> rev_collisions, absl::Span<CollisionT> fwd_collisions,
+      random::PRNG_t& rand_eng) {
     Simulation::detect_primary_lef_lef_collisions(lefs, barriers, rev_lef_ranks, fwd_lef_ranks,
                                                   rev_moves, fwd_moves, rev_collisions,
                                                   fwd_collisions, rand_eng);
   }
 
+  inline usize test_release_lefs(const absl::Span<Lef> lefs, const ExtrusionBarriers& barriers,
+                                 const absl::Span<const CollisionT> rev_collisions,
+                                 const absl::Span<const CollisionT> fwd_collisions,
+                                 const absl::Span<LefRelease> releases, const usize current_epoch,
+                                 random::BatchPRNG& rand_eng, const bool burnin_completed) const {
+    return this->release_lefs(lefs, barriers, rev_collisions, fwd_collisions, releases,
+                              current_epoch, rand_eng, burnin_completed);
+  }
+
+  inline void test_register_1d_lef_occupancy(Chromosome& chrom, const absl::Span<const Lef> lefs,
+                                             const usize num_sampling_events,
+                                             random::BatchPRNG& rand_eng) const {
+    this->register_1d_lef_occupancy(chrom, lefs, num_sampling_events, rand_eng);
+  }
+
+  inline void test_sample_and_register_contacts(State& s, const usize num_sampling_events) const {
+    this->sample_and_register_contacts(s, num_sampling_events);
+  }
+
+  inline void test_simulate_one_cell(State& s, const u64 seed) const {
+    this->simulate_one_cell(s, this->setup_cell(s, seed));
+  }
+
+  inline void test_simulate_one_cell_from_snapshot(State& s) const {
+    this->simulate_one_cell(s, this->setup_cell_from_snapshot(s));
+  }
+
+  inline void test_write_profile_report(std::vector<ProfileCounters> thread_profiles,
+                                        std::vector<ProfileCounters> chrom_profiles) {
+    this->_thread_profiles = std::move(thread_profiles);
+    this->_chrom_profiles = std::move(chrom_profiles);
+    this->write_profile_report_to_disk();
+  }
+#endif
+
+#ifdef ENABLE_BENCHMARKS
+ public:
+  // The following functions are used by modle_bench to time each step of
+  // Simulation::simulate_one_cell separately. All of them operate on the buffers owned by \p s
+  using BenchCollisionCounts = std::pair<usize /*rev units at 5'*/, usize /*fwd units at 3'*/>;
+
+  inline static void bench_bind_lefs(State& s) { Simulation::select_and_bind_lefs(s); }
+
+  inline static void bench_rank_lefs(State& s) {
+    Simulation::rank_lefs(s.get_lefs(), s.get_rev_ranks(), s.get_fwd_ranks(), s.epoch != 0);
+  }
+
+  inline void bench_register_contacts(State& s) const {
+    this->sample_and_register_contacts(s, this->compute_contacts_per_epoch(s.num_lefs));
+  }
+
+  inline static void bench_flush_contact_buffer(State& s) { Simulation::flush_contact_buffer(s); }
+
+  inline void bench_generate_moves(State& s) const {
+    if (this->fast_sampling) {
+      this->generate_moves(*s.chrom, s.get_lefs(), s.get_rev_ranks(), s.get_fwd_ranks(),
+                           s.get_rev_moves(), s.get_fwd_moves(), s.burnin_completed,
+                           s.batch_rand_eng);
+    } else {
+      this->generate_moves(*s.chrom, s.get_lefs(), s.get_rev_ranks(), s.get_fwd_ranks(),
+                           s.get_rev_moves(), s.get_fwd_moves(), s.burnin_completed, s.rand_eng);
+    }
+  }
+
+  inline void bench_update_barriers(State& s) const {
+    if (this->fast_sampling) {
+      s.barriers.next_state_scheduled(s.rand_eng);
+    } else {
+      s.barriers.next_state(s.rand_eng);
+    }
+  }
+
+  inline static void bench_reset_collisions(State& s) {
+    std::for_each(s.get_rev_collisions().begin(), s.get_rev_collisions().end(),
+                  [&](auto& c) { c.clear(); });
+    std::for_each(s.get_fwd_collisions().begin(), s.get_fwd_collisions().end(),
+                  [&](auto& c) { c.clear(); });
+  }
+
+  [[nodiscard]] inline static BenchCollisionCounts bench_detect_units_at_chrom_boundaries(
+      State& s) {
+    return Simulation::detect_units_at_chrom_boundaries(
+        *s.chrom, s.get_lefs(), s.get_rev_ranks(), s.get_fwd_ranks(), s.get_rev_moves(),
+        s.get_fwd_moves(), s.get_rev_collisions(), s.get_fwd_collisions());
+  }
+
+  inline void bench_detect_lef_bar_collisions(State& s, const BenchCollisionCounts& n) const {
+    this->detect_lef_bar_collisions(s.get_lefs(), s.get_rev_ranks(), s.get_fwd_ranks(),
+                                    s.get_rev_moves(), s.get_fwd_moves(), s.barriers,
+                                    s.get_rev_collisions(), s.get_fwd_collisions(), s.rand_eng,
+                                    n.first, n.second);
+  }
+
+  inline void bench_detect_primary_lef_lef_collisions(State& s,
+                                                      const BenchCollisionCounts& n) const {
+    this->detect_primary_lef_lef_collisions(s.get_lefs(), s.barriers, s.get_rev_ranks(),
+                                            s.get_fwd_ranks(), s.get_rev_moves(),
+                                            s.get_fwd_moves(), s.get_rev_collisions(),
+                                            s.get_fwd_collisions(), s.rand_eng, n.first, n.second);
+  }
+
+  inline static void bench_correct_moves(State& s) {
+    Simulation::correct_moves_for_lef_bar_collisions(s.get_lefs(), s.barriers, s.get_rev_moves(),
+                                                     s.get_fwd_moves(), s.get_rev_collisions(),
+                                                     s.get_fwd_collisions());
+    Simulation::correct_moves_for_primary_lef_lef_collisions(
+        s.get_lefs(), s.get_rev_ranks(), s.get_fwd_ranks(), s.get_rev_moves(), s.get_fwd_moves(),
+        s.get_rev_collisions(), s.get_fwd_collisions());
+  }
+
+  inline void bench_process_secondary_lef_lef_collisions(State& s,
+                                                         const BenchCollisionCounts& n) const {
+    this->process_secondary_lef_lef_collisions(
+        *s.chrom, s.get_lefs(), s.get_rev_ranks(), s.get_fwd_ranks(), s.get_rev_moves(),
+        s.get_fwd_moves(), s.get_rev_collisions(), s.get_fwd_collisions(), s.rand_eng, n.first,
+        n.second);
+    Simulation::fix_secondary_lef_lef_collisions(
+        *s.chrom, s.get_lefs(), s.get_rev_ranks(), s.get_fwd_ranks(), s.get_rev_moves(),
+        s.get_fwd_moves(), s.get_rev_collisions(), s.get_fwd_collisions(), n.first, n.second);
+  }
+
+  inline static void bench_extrude(State& s) {
+    Simulation::extrude(*s.chrom, s.get_lefs(), s.get_rev_moves(), s.get_fwd_moves());
+  }
+
+  inline usize bench_release_lefs(State& s) const {
+    if (this->fast_sampling) {
+      return this->release_lefs(s.get_lefs(), s.barriers, s.get_rev_collisions(),
+                                s.get_fwd_collisions(), s.get_lef_releases(), s.epoch,
+                                s.batch_rand_eng, s.burnin_completed);
+    }
+    return this->release_lefs(s.get_lefs(), s.barriers, s.get_rev_collisions(),
+                              s.get_fwd_collisions(), s.rand_eng, s.burnin_completed);
+  }
 #endif
 };
 }  // namespace modle
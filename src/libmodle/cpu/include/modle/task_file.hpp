@@ -0,0 +1,148 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <absl/types/span.h>  // for Span
+
+#include <filesystem>   // for path
+#include <fstream>      // for ifstream, ofstream
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include "modle/common/common.hpp"  // for u32, u64, usize
+
+namespace modle::task_file {
+
+/// Binary task files produced by modle perturbate and consumed by modle replay.
+
+//! Layout (all integers are stored in native byte order):
+//!  - header: magic string, format version, record size and the table mapping chromosome IDs to
+//!    chromosome names
+//!  - blocks: sequence of zstd frames, each storing up to block_size fixed-width records
+//!  - index: one BlockIndexEntry for each block
+//!  - footer: offset of the index, number of blocks and magic string
+//!
+//! The index stores the smallest and largest task ID found in each block, so that readers can
+//! seek directly to the blocks containing the tasks they are interested in.
+inline constexpr std::string_view MAGIC{"MODLETSK"};
+inline constexpr u32 VERSION{1};
+
+/// Fixed-width representation of a Simulation::TaskPW
+
+//! Besides the numeric fields of a task, records store the number of barriers and features that
+//! are expected to map to the task window. These are used to validate records when replaying
+//! tasks. Chromosomes are referred to by ID (see ChromInfo).
+struct Record {
+  u64 id{};
+  u64 chrom_id{};
+  u64 cell_id{};
+  u64 num_target_epochs{};
+  u64 num_target_contacts{};
+  u64 num_lefs{};
+  u64 num_barriers{};
+  u64 deletion_begin{};
+  u64 deletion_size{};
+  u64 window_start{};
+  u64 window_end{};
+  u64 active_window_start{};
+  u64 active_window_end{};
+  u64 num_feats1{};
+  u64 num_feats2{};
+};
+
+struct ChromInfo {  // NOLINT(altera-struct-pack-align)
+  u64 id{};
+  std::string name{};
+};
+
+struct BlockIndexEntry {
+  u64 offset{};
+  u64 compressed_size{};
+  u64 num_records{};
+  u64 first_id{};  // Smallest task ID in the block
+  u64 last_id{};   // Largest task ID in the block
+};
+
+/// Return true when the file at \p path starts with the magic string of binary task files
+[[nodiscard]] bool is_task_file(const std::filesystem::path& path);
+
+class Writer {
+  std::filesystem::path _path{};
+  std::ofstream _fs{};
+  std::vector<Record> _block{};
+  std::vector<BlockIndexEntry> _index{};
+  std::string _compression_buff{};
+  usize _block_size{DEFAULT_BLOCK_SIZE};
+  u32 _compression_lvl{DEFAULT_COMPRESSION_LVL};
+
+ public:
+  static constexpr usize DEFAULT_BLOCK_SIZE{4096};
+  static constexpr u32 DEFAULT_COMPRESSION_LVL{3};
+
+  Writer() = default;
+  Writer(const std::filesystem::path& path, absl::Span<const ChromInfo> chroms,
+         usize block_size = DEFAULT_BLOCK_SIZE, u32 compression_lvl = DEFAULT_COMPRESSION_LVL);
+  Writer(const Writer& other) = delete;
+  Writer(Writer&& other) = default;
+  /// Finalize the file if it is still open. Errors are ignored: call close() to handle them
+  ~Writer() noexcept;
+
+  Writer& operator=(const Writer& other) = delete;
+  Writer& operator=(Writer&& other);
+
+  [[nodiscard]] bool is_open() const noexcept;
+  [[nodiscard]] explicit operator bool() const noexcept;
+  [[nodiscard]] const std::filesystem::path& path() const noexcept;
+
+  void write(const Record& record);
+  void write(absl::Span<const Record> records);
+
+  /// Flush buffered records and write the block index
+
+  //! Files are also closed when the Writer is destroyed or assigned to. Files that are never
+  //! finalized (e.g. because modle crashed) are missing the index, and are rejected by Reader.
+  void close();
+
+ private:
+  void write_header(absl::Span<const ChromInfo> chroms);
+  void write_block();
+  void write_index();
+};
+
+class Reader {
+  std::filesystem::path _path{};
+  std::ifstream _fs{};
+  u64 _file_size{};
+  std::vector<ChromInfo> _chroms{};
+  std::vector<BlockIndexEntry> _index{};
+  std::string _compression_buff{};
+
+ public:
+  Reader() = default;
+  explicit Reader(const std::filesystem::path& path);
+
+  [[nodiscard]] const std::filesystem::path& path() const noexcept;
+  [[nodiscard]] absl::Span<const ChromInfo> chromosomes() const noexcept;
+  [[nodiscard]] usize num_blocks() const noexcept;
+  [[nodiscard]] usize num_records() const noexcept;
+
+  /// Return the indices of the blocks that may contain any of the given task IDs
+
+  //! \p task_ids should be sorted in ascending order. Only the block index is accessed, so the
+  //! lookup does not require any IO.
+  [[nodiscard]] std::vector<usize> find_blocks(absl::Span<const u64> task_ids) const;
+
+  /// Seek to the i-th block and decompress its records into \p buff
+  void read_block(usize i, std::vector<Record>& buff);
+
+ private:
+  void read_header();
+  void read_index();
+  /// Return the number of bytes between the current read position and the end of the file
+  [[nodiscard]] u64 remaining_bytes();
+};
+
+}  // namespace modle::task_file
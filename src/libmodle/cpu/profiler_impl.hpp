@@ -0,0 +1,93 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// IWYU pragma: private, include "modle/profiler.hpp"
+
+#include <absl/types/span.h>  // for Span
+#include <fmt/compile.h>      // for FMT_COMPILE
+#include <fmt/format.h>       // for format
+
+#include <chrono>  // for duration_cast, nanoseconds
+#include <string>  // for string
+
+#include "modle/common/common.hpp"  // for usize, u64, profiling_enabled
+
+namespace modle {
+
+constexpr ProfileCounters& ProfileCounters::operator+=(const ProfileCounters& other) noexcept {
+  this->cells += other.cells;
+  this->epochs += other.epochs;
+  this->burnin_epochs += other.burnin_epochs;
+  this->chrom_boundary_collisions += other.chrom_boundary_collisions;
+  this->lef_bar_collisions += other.lef_bar_collisions;
+  this->lef_lef_primary_collisions += other.lef_lef_primary_collisions;
+  this->lef_lef_secondary_collisions += other.lef_lef_secondary_collisions;
+  this->contacts_registered += other.contacts_registered;
+  this->contact_matrix_lock_waits += other.contact_matrix_lock_waits;
+  this->simulation_ns += other.simulation_ns;
+  this->burnin_ns += other.burnin_ns;
+  this->contact_registration_ns += other.contact_registration_ns;
+  this->contact_matrix_update_ns += other.contact_matrix_update_ns;
+  this->hdf5_write_ns += other.hdf5_write_ns;
+  return *this;
+}
+
+template <typename CollisionT>
+constexpr void ProfileCounters::register_collisions(
+    const absl::Span<const CollisionT> rev_collisions,
+    const absl::Span<const CollisionT> fwd_collisions) noexcept {
+  if constexpr (utils::profiling_enabled()) {
+    auto count = [&](const auto collisions) {
+      for (const auto& c : collisions) {
+        // NOLINTBEGIN(readability-implicit-bool-conversion)
+        this->chrom_boundary_collisions += c.collision_occurred(CollisionT::CHROM_BOUNDARY);
+        this->lef_bar_collisions += c.collision_occurred(CollisionT::LEF_BAR);
+        this->lef_lef_primary_collisions += c.collision_occurred(CollisionT::LEF_LEF_PRIMARY);
+        this->lef_lef_secondary_collisions += c.collision_occurred(CollisionT::LEF_LEF_SECONDARY);
+        // NOLINTEND(readability-implicit-bool-conversion)
+      }
+    };
+    count(rev_collisions);
+    count(fwd_collisions);
+  }
+}
+
+inline std::string ProfileCounters::to_tsv() const {
+  constexpr auto to_seconds = [](const u64 ns) { return static_cast<double>(ns) / 1.0e9; };
+  // clang-format off
+  return fmt::format(
+      FMT_COMPILE("{}\t{}\t{}\t"
+                  "{}\t{}\t"
+                  "{}\t{}\t"
+                  "{}\t{}\t"
+                  "{:.6f}\t{:.6f}\t{:.6f}\t"
+                  "{:.6f}\t{:.6f}"),
+      this->cells, this->epochs, this->burnin_epochs,
+      this->chrom_boundary_collisions, this->lef_bar_collisions,
+      this->lef_lef_primary_collisions, this->lef_lef_secondary_collisions,
+      this->contacts_registered, this->contact_matrix_lock_waits,
+      to_seconds(this->simulation_ns), to_seconds(this->burnin_ns),
+      to_seconds(this->contact_registration_ns),
+      to_seconds(this->contact_matrix_update_ns), to_seconds(this->hdf5_write_ns));
+  // clang-format on
+}
+
+inline ScopedTimer::ScopedTimer(u64& ns) noexcept {
+  if constexpr (utils::profiling_enabled()) {
+    this->_ns = &ns;
+    this->_t0 = clock::now();
+  }
+}
+
+inline ScopedTimer::~ScopedTimer() noexcept {
+  if constexpr (utils::profiling_enabled()) {
+    const auto elapsed = clock::now() - this->_t0;
+    *this->_ns += static_cast<u64>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  }
+}
+
+}  // namespace modle
@@ -6,17 +6,22 @@
 #include "modle/simulation.hpp"
 // clang-format on
 
-#include <absl/types/span.h>  // for Span
+#include <absl/types/span.h>              // for Span
+#include <cpp-sort/sorters/pdq_sorter.h>  // for pdq_sort
 
-#include <algorithm>  // for min, all_of
+#include <algorithm>  // for min, minmax, transform, fill
 #include <cassert>    // for assert
+#include <iterator>   // for back_inserter
+#include <vector>     // for vector
 
 #include "modle/common/common.hpp"                         // for usize, bp_t, contacts_t, MODLE...
-#include "modle/common/genextreme_value_distribution.hpp"  // for genextreme_value_distribution
-#include "modle/common/random.hpp"                         // for PRNG_t, uniform_int_distribution
+#include "modle/common/genextreme_value_distribution.hpp"  // for genextreme_value_distrib...
+#include "modle/common/pixel.hpp"                          // for Pixel, PixelCoordinates
+#include "modle/common/random.hpp"                         // for PRNG_t, BatchPRNG, uniform_in...
 #include "modle/contact_matrix_dense.hpp"                  // for ContactMatrixDense
 #include "modle/extrusion_factors.hpp"                     // for Lef, ExtrusionUnit
 #include "modle/genome.hpp"                                // for Chromosome
+#include "modle/profiler.hpp"                              // for ScopedTimer
 
 namespace modle {
 
@@ -40,29 +45,6 @@ namespace modle {
   return MODLE_LIKELY(p1 >= start_pos_ && p2 >= start_pos_ && p1 < end_pos_ && p2 < end_pos_);
 }
 
-struct PosPair {
-  double p1{};
-  double p2{};
-};
-
-[[nodiscard]] static constexpr PosPair randomize_extrusion_unit_positions(
-    const Lef& lef, const double mu, const double sigma, const double xi,
-    const bool randomize_contacts, random::PRNG_t& rand_eng) {
-  auto noise_gen = [&]() constexpr noexcept {
-    if (randomize_contacts) {
-      return genextreme_value_distribution<double>{mu, sigma, xi}(rand_eng);
-    }
-    return 0.0;
-  };
-
-  // We are performing most operations using double to deal with the possibility that the
-  // noise generated to compute p1 is larger than the pos of the rev unit
-  const auto [p1, p2] = std::minmax({static_cast<double>(lef.rev_unit.pos()) - noise_gen(),
-                                     static_cast<double>(lef.fwd_unit.pos()) + noise_gen()});
-
-  return {p1, p2};
-}
-
 [[nodiscard]] static const Lef& sample_lef_with_replacement(const absl::Span<const Lef> lefs,
                                                             random::PRNG_t& rand_eng) noexcept {
   assert(!lefs.empty());
@@ -70,9 +52,47 @@ struct PosPair {
   return lefs[i];
 }
 
+/// Draw the number of times each LEF in \p eligible_lefs is sampled when drawing \p num_samples
+/// LEFs with replacement, and store the idx of the sampled LEFs in \p sampled_lefs (grouped by LEF)
+static void sample_lefs_with_replacement(const absl::Span<const usize> eligible_lefs,
+                                         usize num_samples, random::BatchPRNG& rand_eng,
+                                         std::vector<u64>& draw_buff,
+                                         std::vector<usize>& sampled_lefs) {
+  assert(!eligible_lefs.empty());
+  const auto num_lefs = eligible_lefs.size();
+  sampled_lefs.clear();
+
+  if (num_samples < num_lefs) {
+    // When sampling fewer LEFs than there are eligible LEFs, drawing one idx per sample and sorting
+    // the idx is cheaper than visiting every LEF
+    draw_buff.resize(num_samples);
+    rand_eng.fill_uniform_int(absl::MakeSpan(draw_buff), 0, num_lefs - 1);
+    cppsort::pdq_sort(draw_buff.begin(), draw_buff.end());
+    std::transform(draw_buff.begin(), draw_buff.end(), std::back_inserter(sampled_lefs),
+                   [&](const auto i) { return eligible_lefs[i]; });
+    return;
+  }
+
+  // Otherwise split samples across LEFs with a sequence of conditional binomial draws
+  sampled_lefs.reserve(num_samples);
+  for (usize i = 0; i < num_lefs && num_samples != 0; ++i) {
+    const auto p = 1.0 / static_cast<double>(num_lefs - i);
+    // Using usize as template param the distribution causes an ambiguous call to abs() inside
+    // boost::random (boost v1.79)
+    const auto n = i == num_lefs - 1
+                       ? num_samples
+                       : static_cast<usize>(random::binomial_distribution<isize>{
+                             static_cast<isize>(num_samples), p}(rand_eng));
+    sampled_lefs.insert(sampled_lefs.end(), n, eligible_lefs[i]);
+    num_samples -= n;
+  }
+  assert(num_samples == 0);
+}
+
+template <class PRNG>
 [[nodiscard]] static usize compute_num_contacts_loop(const usize num_contacts,
                                                      const double tad_to_loop_contact_ratio,
-                                                     random::PRNG_t& rand_eng) {
+                                                     PRNG& rand_eng) {
   // Handle special case where TAD contact sampling has been disabled
   if (tad_to_loop_contact_ratio == 0) {
     return num_contacts;
@@ -91,8 +111,49 @@ struct PosPair {
       random::binomial_distribution<isize>{isize(num_contacts), prob_loop_contact}(rand_eng));
 }
 
+static void register_contact(ContactMatrixDense<contacts_t>& contacts, const usize bin1,
+                             const usize bin2) {
+  contacts.increment(bin1, bin2);
+}
+
+static void register_contact(std::vector<PixelCoordinates>& contact_buff, const usize bin1,
+                             const usize bin2) {
+  contact_buff.push_back(PixelCoordinates{std::min(bin1, bin2), std::max(bin1, bin2)});
+}
+
+void Simulation::sample_and_register_contacts(State& s, usize num_sampling_events) const {
+  const auto features = this->enabled_features();
+  const auto features_ =
+      static_cast<u8f>(features & (NOISIFY_CONTACTS | TRACK_1D_LEF_POSITION | FAST_SAMPLING));
+  switch (features_) {
+    case 0:
+      return this->sample_and_register_contacts<0>(s, num_sampling_events);
+    case NOISIFY_CONTACTS:
+      return this->sample_and_register_contacts<NOISIFY_CONTACTS>(s, num_sampling_events);
+    case TRACK_1D_LEF_POSITION:
+      return this->sample_and_register_contacts<TRACK_1D_LEF_POSITION>(s, num_sampling_events);
+    case NOISIFY_CONTACTS | TRACK_1D_LEF_POSITION:
+      return this->sample_and_register_contacts<NOISIFY_CONTACTS | TRACK_1D_LEF_POSITION>(
+          s, num_sampling_events);
+    case FAST_SAMPLING:
+      return this->sample_and_register_contacts<FAST_SAMPLING>(s, num_sampling_events);
+    case NOISIFY_CONTACTS | FAST_SAMPLING:
+      return this->sample_and_register_contacts<NOISIFY_CONTACTS | FAST_SAMPLING>(
+          s, num_sampling_events);
+    case TRACK_1D_LEF_POSITION | FAST_SAMPLING:
+      return this->sample_and_register_contacts<TRACK_1D_LEF_POSITION | FAST_SAMPLING>(
+          s, num_sampling_events);
+    default:
+      assert(features_ == (NOISIFY_CONTACTS | TRACK_1D_LEF_POSITION | FAST_SAMPLING));
+      return this->sample_and_register_contacts<NOISIFY_CONTACTS | TRACK_1D_LEF_POSITION |
+                                                FAST_SAMPLING>(s, num_sampling_events);
+  }
+}
+
+template <u8f Features>
 void Simulation::sample_and_register_contacts(State& s, usize num_sampling_events) const {
   assert(s.num_active_lefs == s.num_lefs);
+  const ScopedTimer timer(s.profile.contact_registration_ns);
 
   // Ensure we do not overshoot the target contact density
   if (this->target_contact_density > 0.0) {
@@ -107,149 +168,328 @@ void Simulation::sample_and_register_contacts(State& s, usize num_sampling_event
   const auto start_pos = s.is_modle_sim_state() ? s.chrom->start_pos() : s.window_start;
   const auto end_pos = s.is_modle_sim_state() ? s.chrom->end_pos() : s.window_end;
 
+  auto& rand_eng = s.epoch_rand_eng<Features>();
   const auto num_loop_contacts =
-      compute_num_contacts_loop(num_sampling_events, this->tad_to_loop_contact_ratio, s.rand_eng);
+      compute_num_contacts_loop(num_sampling_events, this->tad_to_loop_contact_ratio, rand_eng);
   const auto num_tad_contacts = num_sampling_events - num_loop_contacts;
 
+  if constexpr (has_feature(Features, FAST_SAMPLING)) {
+    // The same set of LEFs is eligible for all the sampling steps of the current epoch
+    Simulation::select_lefs_for_contact_sampling(start_pos + 1, end_pos - 1, s.get_lefs(),
+                                                 s.sampling_buffs.eligible_lefs);
+  }
+
+  // Contacts are registered in a thread-local buffer, which is then sorted and merged into the
+  // contact matrix in a single pass (see Simulation::flush_contact_buffer)
   assert(s.contacts);
-  this->register_contacts_loop(start_pos + 1, end_pos - 1, *s.contacts, s.get_lefs(),
-                               num_loop_contacts, s.rand_eng);
-  this->register_contacts_tad(start_pos + 1, end_pos - 1, *s.contacts, s.get_lefs(),
-                              num_tad_contacts, s.rand_eng);
+  // Fewer contacts than requested are registered when no LEF can be sampled (e.g. because no LEF
+  // is bound within the region of interest)
+  const auto num_registered_contacts =
+      this->register_contacts_loop<Features>(start_pos + 1, end_pos - 1, s.contact_buff,
+                                             s.get_lefs(), num_loop_contacts, rand_eng,
+                                             s.sampling_buffs) +
+      this->register_contacts_tad<Features>(start_pos + 1, end_pos - 1, s.contact_buff,
+                                            s.get_lefs(), num_tad_contacts, rand_eng,
+                                            s.sampling_buffs);
+  if (s.is_modle_sim_state()) {
+    // The contact matrix is shared across threads: merge contacts into the contact matrix once
+    // the buffer is full or the task is completed
+    if (s.contact_buff.size() >= Simulation::max_contact_buff_size) {
+      Simulation::flush_contact_buffer(s);
+    }
+  } else {
+    Simulation::flush_contact_buffer(s);
+  }
 
-  if (this->track_1d_lef_position) {
-    this->register_1d_lef_occupancy(start_pos + 1, end_pos - 1, s.chrom->lef_1d_occupancy(),
-                                    s.get_lefs(), num_sampling_events, s.rand_eng);
+  if constexpr (has_feature(Features, TRACK_1D_LEF_POSITION)) {
+    assert(this->track_1d_lef_position);
+    this->register_1d_lef_occupancy<Features>(start_pos + 1, end_pos - 1,
+                                              s.chrom->lef_1d_occupancy(), s.get_lefs(),
+                                              num_sampling_events, rand_eng, s.sampling_buffs);
   }
 
-  s.num_contacts += num_sampling_events;
+  s.num_contacts += num_registered_contacts;
   assert(s.num_contacts <= s.num_target_contacts);
 }
 
-void Simulation::register_contacts_loop(const bp_t start_pos, const bp_t end_pos,
-                                        ContactMatrixDense<contacts_t>& contacts,
-                                        const absl::Span<const Lef> lefs,
-                                        usize num_contacts_to_register,
-                                        random::PRNG_t& rand_eng) const {
-  if (num_contacts_to_register == 0) {
-    return;
+void Simulation::select_lefs_for_contact_sampling(const bp_t start_pos, const bp_t end_pos,
+                                                  const absl::Span<const Lef> lefs,
+                                                  std::vector<usize>& buff) {
+  buff.clear();
+  for (usize i = 0; i < lefs.size(); ++i) {
+    const auto& lef = lefs[i];
+    if (MODLE_LIKELY(lef.is_bound() && lef_within_bound(lef, start_pos, end_pos))) {
+      buff.push_back(i);
+    }
   }
+}
 
-  using CS = ContactSamplingStrategy;
-  assert(this->contact_sampling_strategy & CS::loop);
-
-  // NOLINTNEXTLINE(readability-implicit-bool-conversion)
-  const bool noisify_contacts = this->contact_sampling_strategy & CS::noisify;
+template <u8f Features, typename PositionConsumer>
+usize Simulation::sample_lef_positions(const bp_t start_pos, const bp_t end_pos,
+                                       const absl::Span<const Lef> lefs, const usize num_events,
+                                       random::PRNG_t& rand_eng,
+                                       [[maybe_unused]] ContactSamplingBuffers& buffs,
+                                       PositionConsumer&& fx) const {
+  auto generate_noise = [&]() {
+    if constexpr (has_feature(Features, NOISIFY_CONTACTS)) {
+      assert(this->contact_sampling_strategy & ContactSamplingStrategy::noisify);
+      if (this->tabulate_contact_noise) {
+        assert(!this->_contact_noise_table.empty());
+        return this->_contact_noise_table(rand_eng);
+      }
+      return genextreme_value_distribution<double>{this->genextreme_mu, this->genextreme_sigma,
+                                                   this->genextreme_xi}(rand_eng);
+    } else {
+      return 0.0;
+    }
+  };
 
-  while (num_contacts_to_register != 0) {
+  for (usize num_events_left = num_events; num_events_left != 0;) {
     const auto& lef = sample_lef_with_replacement(lefs, rand_eng);
     if (MODLE_LIKELY(lef.is_bound() && lef_within_bound(lef, start_pos, end_pos))) {
+      // We are performing most operations using double to deal with the possibility that the
+      // noise generated to compute p1 is larger than the pos of the rev unit
       const auto [p1, p2] =
-          randomize_extrusion_unit_positions(lef, this->genextreme_mu, this->genextreme_sigma,
-                                             this->genextreme_xi, noisify_contacts, rand_eng);
+          std::minmax({static_cast<double>(lef.rev_unit.pos()) - generate_noise(),
+                       static_cast<double>(lef.fwd_unit.pos()) + generate_noise()});
+
+      if (MODLE_LIKELY(pos_within_bound(p1, p2, start_pos, end_pos))) {
+        fx(p1, p2);
+        --num_events_left;
+      }
+    }
+  }
+  return num_events;
+}
+
+template <u8f Features, typename PositionConsumer>
+usize Simulation::sample_lef_positions(const bp_t start_pos, const bp_t end_pos,
+                                       const absl::Span<const Lef> lefs, const usize num_events,
+                                       random::BatchPRNG& rand_eng, ContactSamplingBuffers& buffs,
+                                       PositionConsumer&& fx) const {
+  // This can happen when no LEF is bound within the region of interest
+  if (MODLE_UNLIKELY(buffs.eligible_lefs.empty())) {
+    return 0;
+  }
 
-      if (!pos_within_bound(p1, p2, start_pos, end_pos)) {
-        continue;
+  for (usize num_events_left = num_events; num_events_left != 0;) {
+    sample_lefs_with_replacement(buffs.eligible_lefs, num_events_left, rand_eng, buffs.draw_buff,
+                                 buffs.sampled_lefs);
+
+    // Generate noise in bulk: noise_buff[2 * i] and noise_buff[2 * i + 1] are used to randomize
+    // the position of the rev and fwd units of the i-th sampled LEF respectively
+    auto& noise = buffs.noise_buff;
+    noise.resize(2 * buffs.sampled_lefs.size());
+    if constexpr (has_feature(Features, NOISIFY_CONTACTS)) {
+      assert(this->contact_sampling_strategy & ContactSamplingStrategy::noisify);
+      rand_eng.fill_canonical(absl::MakeSpan(noise));
+      if (this->tabulate_contact_noise) {
+        assert(!this->_contact_noise_table.empty());
+        std::transform(noise.begin(), noise.end(), noise.begin(),
+                       [&](const auto u) { return this->_contact_noise_table.from_canonical(u); });
+      } else {
+        const genextreme_value_distribution<double>::param_type params{
+            this->genextreme_mu, this->genextreme_sigma, this->genextreme_xi};
+        std::transform(noise.begin(), noise.end(), noise.begin(), [&](const auto u) {
+          return genextreme_value_distribution<double>::from_canonical(u, params);
+        });
       }
+    } else {
+      std::fill(noise.begin(), noise.end(), 0.0);
+    }
+
+    for (usize i = 0; i < buffs.sampled_lefs.size(); ++i) {
+      const auto& lef = lefs[buffs.sampled_lefs[i]];
+      assert(lef.is_bound() && lef_within_bound(lef, start_pos, end_pos));
+      // We are performing most operations using double to deal with the possibility that the
+      // noise generated to compute p1 is larger than the pos of the rev unit
+      const auto [p1, p2] =
+          std::minmax({static_cast<double>(lef.rev_unit.pos()) - noise[2 * i],
+                       static_cast<double>(lef.fwd_unit.pos()) + noise[(2 * i) + 1]});
 
-      const auto pos1 = static_cast<bp_t>(p1) - start_pos;
-      const auto pos2 = static_cast<bp_t>(p2) - start_pos;
-      contacts.increment(pos1 / this->bin_size, pos2 / this->bin_size);
-      --num_contacts_to_register;
+      // Rejected events are re-sampled in the next iteration
+      if (MODLE_LIKELY(pos_within_bound(p1, p2, start_pos, end_pos))) {
+        fx(p1, p2);
+        --num_events_left;
+      }
     }
   }
+  return num_events;
 }
 
-void Simulation::register_contacts_tad(bp_t start_pos, bp_t end_pos,
-                                       ContactMatrixDense<contacts_t>& contacts,
-                                       absl::Span<const Lef> lefs, usize num_contacts_to_register,
-                                       random::PRNG_t& rand_eng) const {
+template <u8f Features, typename ContactSinkT>
+usize Simulation::register_contacts_loop(const bp_t start_pos, const bp_t end_pos,
+                                         ContactSinkT& contacts, const absl::Span<const Lef> lefs,
+                                         usize num_contacts_to_register,
+                                         epoch_rand_eng_t<Features>& rand_eng,
+                                         ContactSamplingBuffers& buffs) const {
   if (num_contacts_to_register == 0) {
-    return;
+    return 0;
   }
 
   using CS = ContactSamplingStrategy;
-  assert(this->contact_sampling_strategy & CS::tad);
+  assert(this->contact_sampling_strategy & CS::loop);
 
-  // NOLINTNEXTLINE(readability-implicit-bool-conversion)
-  const bool noisify_contacts = this->contact_sampling_strategy & CS::noisify;
+  return this->sample_lef_positions<Features>(
+      start_pos, end_pos, lefs, num_contacts_to_register, rand_eng, buffs,
+      [&](const double p1, const double p2) {
+        const auto pos1 = static_cast<bp_t>(p1) - start_pos;
+        const auto pos2 = static_cast<bp_t>(p2) - start_pos;
+        register_contact(contacts, pos1 / this->bin_size, pos2 / this->bin_size);
+      });
+}
 
-  while (num_contacts_to_register != 0) {
-    const auto& lef = sample_lef_with_replacement(lefs, rand_eng);
-    if (MODLE_LIKELY(lef.is_bound() && lef_within_bound(lef, start_pos, end_pos))) {
-      const auto [p1, p2] =
-          randomize_extrusion_unit_positions(lef, this->genextreme_mu, this->genextreme_sigma,
-                                             this->genextreme_xi, noisify_contacts, rand_eng);
+template <u8f Features, typename ContactSinkT>
+usize Simulation::register_contacts_tad(bp_t start_pos, bp_t end_pos, ContactSinkT& contacts,
+                                        absl::Span<const Lef> lefs, usize num_contacts_to_register,
+                                        epoch_rand_eng_t<Features>& rand_eng,
+                                        ContactSamplingBuffers& buffs) const {
+  if (num_contacts_to_register == 0) {
+    return 0;
+  }
 
-      if (!pos_within_bound(p1, p2, start_pos, end_pos)) {
-        continue;
-      }
-      const auto p11 = random::uniform_int_distribution<bp_t>{static_cast<bp_t>(p1),
-                                                              static_cast<bp_t>(p2)}(rand_eng);
-      const auto p22 = random::uniform_int_distribution<bp_t>{static_cast<bp_t>(p1),
-                                                              static_cast<bp_t>(p2)}(rand_eng);
-
-      const auto pos1 = static_cast<bp_t>(p11) - start_pos;
-      const auto pos2 = static_cast<bp_t>(p22) - start_pos;
-      contacts.increment(pos1 / this->bin_size, pos2 / this->bin_size);
-      --num_contacts_to_register;
+  using CS = ContactSamplingStrategy;
+  assert(this->contact_sampling_strategy & CS::tad);
+
+  return this->sample_lef_positions<Features>(
+      start_pos, end_pos, lefs, num_contacts_to_register, rand_eng, buffs,
+      [&](const double p1, const double p2) {
+        const auto p11 = random::uniform_int_distribution<bp_t>{static_cast<bp_t>(p1),
+                                                                static_cast<bp_t>(p2)}(rand_eng);
+        const auto p22 = random::uniform_int_distribution<bp_t>{static_cast<bp_t>(p1),
+                                                                static_cast<bp_t>(p2)}(rand_eng);
+
+        const auto pos1 = static_cast<bp_t>(p11) - start_pos;
+        const auto pos2 = static_cast<bp_t>(p22) - start_pos;
+        register_contact(contacts, pos1 / this->bin_size, pos2 / this->bin_size);
+      });
+}
+
+void Simulation::flush_contact_buffer(State& s) {
+  if (s.contact_buff.empty()) {
+    return;
+  }
+  assert(s.contacts);
+  const ScopedTimer timer(s.profile.contact_matrix_update_ns);
+
+  // Sort contacts by coordinates, then collapse contacts for the same pixel into a single entry
+  cppsort::pdq_sort(s.contact_buff.begin(), s.contact_buff.end());
+  s.pixel_buff.clear();
+  for (const auto& coords : s.contact_buff) {
+    if (!s.pixel_buff.empty() && s.pixel_buff.back().coords == coords) {
+      ++s.pixel_buff.back().count;
+      continue;
     }
+    s.pixel_buff.emplace_back(coords, contacts_t(1));
   }
+
+  s.contacts->add(absl::MakeConstSpan(s.pixel_buff));
+  s.contact_buff.clear();
 }
 
+template <u8f Features>
 void Simulation::register_1d_lef_occupancy(bp_t start_pos, bp_t end_pos,
                                            std::vector<std::atomic<u64>>& occupancy_buff,
                                            absl::Span<const Lef> lefs, usize num_sampling_events,
-                                           random::PRNG_t& rand_eng) const {
+                                           epoch_rand_eng_t<Features>& rand_eng,
+                                           ContactSamplingBuffers& buffs) const {
   if (num_sampling_events == 0) {
     return;
   }
 
-  using CS = ContactSamplingStrategy;
-  // NOLINTNEXTLINE(readability-implicit-bool-conversion)
-  const bool noisify_positions = this->contact_sampling_strategy & CS::noisify;
-
-  while (num_sampling_events != 0) {
-    const auto& lef = sample_lef_with_replacement(lefs, rand_eng);
-    if (MODLE_LIKELY(lef.is_bound() && lef_within_bound(lef, start_pos, end_pos))) {
-      const auto [p1, p2] =
-          randomize_extrusion_unit_positions(lef, this->genextreme_mu, this->genextreme_sigma,
-                                             this->genextreme_xi, noisify_positions, rand_eng);
-
-      if (!pos_within_bound(p1, p2, start_pos, end_pos)) {
-        continue;
-      }
-
-      const auto i1 = utils::conditional_static_cast<usize>((static_cast<bp_t>(p1) - start_pos) /
-                                                            this->bin_size);
-      const auto i2 = utils::conditional_static_cast<usize>((static_cast<bp_t>(p2) - start_pos) /
-                                                            this->bin_size);
-      occupancy_buff[i1]++;
-      occupancy_buff[i2]++;
-      --num_sampling_events;
-    }
-  }
+  this->sample_lef_positions<Features>(
+      start_pos, end_pos, lefs, num_sampling_events, rand_eng, buffs,
+      [&](const double p1, const double p2) {
+        const auto i1 = utils::conditional_static_cast<usize>(
+            (static_cast<bp_t>(p1) - start_pos) / this->bin_size);
+        const auto i2 = utils::conditional_static_cast<usize>(
+            (static_cast<bp_t>(p2) - start_pos) / this->bin_size);
+        occupancy_buff[i1]++;
+        occupancy_buff[i2]++;
+      });
 }
 
 void Simulation::register_contacts_loop(Chromosome& chrom, const absl::Span<const Lef> lefs,
                                         usize num_contacts_to_register,
                                         random::PRNG_t& rand_eng) const {
-  this->register_contacts_loop(chrom.start_pos() + 1, chrom.end_pos() - 1, chrom.contacts(), lefs,
-                               num_contacts_to_register, rand_eng);
+  ContactSamplingBuffers buffs{};
+  if (has_feature(this->enabled_features(), NOISIFY_CONTACTS)) {
+    this->register_contacts_loop<NOISIFY_CONTACTS>(chrom.start_pos() + 1, chrom.end_pos() - 1,
+                                                   chrom.contacts(), lefs,
+                                                   num_contacts_to_register, rand_eng, buffs);
+  } else {
+    this->register_contacts_loop<0>(chrom.start_pos() + 1, chrom.end_pos() - 1, chrom.contacts(),
+                                    lefs, num_contacts_to_register, rand_eng, buffs);
+  }
 }
 
 void Simulation::register_contacts_tad(Chromosome& chrom, absl::Span<const Lef> lefs,
                                        usize num_contacts_to_register,
                                        random::PRNG_t& rand_eng) const {
-  this->register_contacts_tad(chrom.start_pos() + 1, chrom.end_pos() - 1, chrom.contacts(), lefs,
-                              num_contacts_to_register, rand_eng);
+  ContactSamplingBuffers buffs{};
+  if (has_feature(this->enabled_features(), NOISIFY_CONTACTS)) {
+    this->register_contacts_tad<NOISIFY_CONTACTS>(chrom.start_pos() + 1, chrom.end_pos() - 1,
+                                                  chrom.contacts(), lefs, num_contacts_to_register,
+                                                  rand_eng, buffs);
+  } else {
+    this->register_contacts_tad<0>(chrom.start_pos() + 1, chrom.end_pos() - 1, chrom.contacts(),
+                                   lefs, num_contacts_to_register, rand_eng, buffs);
+  }
 }
 
 void Simulation::register_1d_lef_occupancy(modle::Chromosome& chrom, absl::Span<const Lef> lefs,
                                            usize num_sampling_events,
                                            random::PRNG_t& rand_eng) const {
-  this->register_1d_lef_occupancy(chrom.start_pos() + 1, chrom.end_pos() - 1,
-                                  chrom.lef_1d_occupancy(), lefs, num_sampling_events, rand_eng);
+  ContactSamplingBuffers buffs{};
+  if (has_feature(this->enabled_features(), NOISIFY_CONTACTS)) {
+    this->register_1d_lef_occupancy<NOISIFY_CONTACTS>(chrom.start_pos() + 1, chrom.end_pos() - 1,
+                                                      chrom.lef_1d_occupancy(), lefs,
+                                                      num_sampling_events, rand_eng, buffs);
+  } else {
+    this->register_1d_lef_occupancy<0>(chrom.start_pos() + 1, chrom.end_pos() - 1,
+                                       chrom.lef_1d_occupancy(), lefs, num_sampling_events,
+                                       rand_eng, buffs);
+  }
 }
 
+void Simulation::register_1d_lef_occupancy(modle::Chromosome& chrom, absl::Span<const Lef> lefs,
+                                           usize num_sampling_events,
+                                           random::BatchPRNG& rand_eng) const {
+  ContactSamplingBuffers buffs{};
+  Simulation::select_lefs_for_contact_sampling(chrom.start_pos() + 1, chrom.end_pos() - 1, lefs,
+                                               buffs.eligible_lefs);
+  if (has_feature(this->enabled_features(), NOISIFY_CONTACTS)) {
+    this->register_1d_lef_occupancy<NOISIFY_CONTACTS | FAST_SAMPLING>(
+        chrom.start_pos() + 1, chrom.end_pos() - 1, chrom.lef_1d_occupancy(), lefs,
+        num_sampling_events, rand_eng, buffs);
+  } else {
+    this->register_1d_lef_occupancy<FAST_SAMPLING>(chrom.start_pos() + 1, chrom.end_pos() - 1,
+                                                   chrom.lef_1d_occupancy(), lefs,
+                                                   num_sampling_events, rand_eng, buffs);
+  }
+}
+
+// Instantiations used by Simulation::simulate_one_cell<Features> (see simulation.cpp).
+// Only the noisify, 1D LEF tracking and fast sampling features affect contact sampling
+template void Simulation::sample_and_register_contacts<0>(State&, usize) const;
+template void Simulation::sample_and_register_contacts<Simulation::NOISIFY_CONTACTS>(State&,
+                                                                                    usize) const;
+template void Simulation::sample_and_register_contacts<Simulation::TRACK_1D_LEF_POSITION>(
+    State&, usize) const;
+template void Simulation::sample_and_register_contacts<Simulation::NOISIFY_CONTACTS |
+                                                       Simulation::TRACK_1D_LEF_POSITION>(
+    State&, usize) const;
+template void Simulation::sample_and_register_contacts<Simulation::FAST_SAMPLING>(State&,
+                                                                                 usize) const;
+template void Simulation::sample_and_register_contacts<Simulation::NOISIFY_CONTACTS |
+                                                       Simulation::FAST_SAMPLING>(State&,
+                                                                                  usize) const;
+template void Simulation::sample_and_register_contacts<Simulation::TRACK_1D_LEF_POSITION |
+                                                       Simulation::FAST_SAMPLING>(State&,
+                                                                                  usize) const;
+template void Simulation::sample_and_register_contacts<Simulation::NOISIFY_CONTACTS |
+                                                       Simulation::TRACK_1D_LEF_POSITION |
+                                                       Simulation::FAST_SAMPLING>(State&,
+                                                                                  usize) const;
+
 }  // namespace modle
@@ -24,6 +24,7 @@
 #include <exception>           // for exception, rethrow_exception
 #include <filesystem>          // for operator<<, path
 #include <iosfwd>              // for streamsize
+#include <memory>              // for make_shared
 #include <stdexcept>           // for runtime_error
 #include <string>              // for string
 #include <vector>              // for vector
@@ -33,7 +34,7 @@
 #include "modle/common/fmt_helpers.hpp"
 #include "modle/common/utils.hpp"                 // for parse_numeric_or_throw
 #include "modle/compressed_io/compressed_io.hpp"  // for Reader
-#include "modle/extrusion_barriers.hpp"           // for ExtrusionBarrier
+#include "modle/extrusion_barriers.hpp"           // for ExtrusionBarrier, ExtrusionBarriers
 #include "modle/genome.hpp"                       // for Chromosome, Genome
 #include "modle/interval_tree.hpp"  // for IITree, IITree::data_end, IITree::equal_range
 
@@ -123,6 +124,9 @@ bool Simulation::map_barriers_to_window(TaskPW& base_task, const Chromosome& chr
   }
 
   base_task.barriers = absl::MakeConstSpan(&(*first_barrier), &(*last_barrier));
+  // All the tasks generated from base_task share the same barrier table
+  base_task.barrier_table = std::make_shared<const ExtrusionBarriers>(base_task.barriers.begin(),
+                                                                      base_task.barriers.end());
   return true;
 }
 
@@ -8,13 +8,12 @@
 
 #include <absl/container/fixed_array.h>          // for FixedArray
 #include <absl/strings/str_cat.h>                // for StrAppend, StrCat
-#include <absl/time/clock.h>                     // for Now
-#include <absl/time/time.h>                      // for FormatDuration, operator-, Duration, Time
 #include <absl/types/span.h>                     // for Span, MakeConstSpan
 #include <fmt/compile.h>                         // for format, FMT_COMPILE
 #include <fmt/format.h>                          // for format, make_format_args, vformat_to
 #include <moodycamel/blockingconcurrentqueue.h>  // for BlockingConcurrentQueue
 #include <moodycamel/concurrentqueue.h>          // for ConsumerToken, ProducerToken
+#include <moodycamel/lightweightsemaphore.h>     // for LightweightSemaphore
 #include <spdlog/spdlog.h>                       // for info
 
 #include <BS_thread_pool.hpp>  // for BS::thread_pool
@@ -23,11 +22,11 @@
 #include <atomic>              // for atomic
 #include <cassert>             // for assert
 #include <cerrno>              // for errno
-#include <chrono>              // for microseconds, milliseconds
 #include <cmath>               // for round
 #include <exception>           // for exception_ptr, exception, current_exception
 #include <filesystem>          // for operator<<, path
 #include <fstream>             // for streamsize, operator|
+#include <future>              // for future, async
 #include <iterator>            // for move_iterator, make_move_iterator
 #include <limits>              // for numeric_limits
 #include <memory>              // for shared_ptr, __shared_pt...
@@ -44,11 +43,12 @@
 #include "modle/common/suppress_compiler_warnings.hpp"  // for DISABLE_WARNING_POP
 #include "modle/compressed_io/compressed_io.hpp"        // for Writer
 #include "modle/contact_matrix_dense.hpp"               // for ContactMatrixDense
-#include "modle/cooler/cooler.hpp"                      // for Cooler, Cooler::WRITE_ONLY
+#include "modle/cooler/cooler.hpp"                      // for Cooler, Cooler::READ_ONLY
 #include "modle/extrusion_barriers.hpp"                 // for ExtrusionBarrier
 #include "modle/genome.hpp"                             // for Chromosome, Genome
 #include "modle/interval_tree.hpp"  // for IITree, IITree::empty, IITree::equal_range
 #include "modle/stats/tests.hpp"    // for binomial_test
+#include "modle/task_file.hpp"      // for task_file::Writer, task_file::ChromInfo
 
 namespace modle {
 
@@ -74,17 +74,72 @@ static void validate_reference_contacts(const Genome& genome, cooler::Cooler<con
   }
 }
 
-[[nodiscard]] static ContactMatrixDense<> read_reference_contacts(
-    cooler::Cooler<contacts_t>& c, std::string_view chrom_name, const bp_t window_start,
-    const bp_t window_end, const bp_t bin_size, const bp_t diagonal_width) {
-  const auto nrows = (diagonal_width + bin_size - 1) / bin_size;
-  const auto chrom_boundaries = std::make_pair(window_start, window_end - 1);
-  const auto try_common_prefixes = false;
-  const auto prefer_balanced_counts = false;
+/// Provide the reference contacts for the windows simulated by modle perturbate.
+
+//! Consecutive windows overlap by 3*D, so reading the contacts for each window straight from the
+//! reference cooler would read most pixels four times. Instead, the band of the reference matrix
+//! is read once for each chromosome, and the contacts for each window are sliced from it.
+//! The band for the next chromosome is read in the background while the windows of the current
+//! chromosome are being processed.
+class ReferenceContactsCache {
+  cooler::Cooler<contacts_t>* _cooler{};
+  bp_t _bin_size{};
+  bp_t _diagonal_width{};
+
+  ContactMatrixDense<> _contacts{};
+  std::string _next_chrom_name{};
+  std::future<ContactMatrixDense<>> _next_contacts{};
+
+ public:
+  ReferenceContactsCache(cooler::Cooler<contacts_t>& c, bp_t bin_size, bp_t diagonal_width)
+      : _cooler(&c), _bin_size(bin_size), _diagonal_width(diagonal_width) {}
+
+  /// Load the contacts for \p chrom_name, and start reading the contacts for \p next_chrom_name
+  /// (if any) in the background
+  void load(std::string_view chrom_name, std::string_view next_chrom_name = "") {
+    if (this->_next_contacts.valid() && this->_next_chrom_name == chrom_name) {
+      this->_contacts = this->_next_contacts.get();
+    } else {
+      // Cooler objects cannot be accessed concurrently
+      if (this->_next_contacts.valid()) {
+        this->_next_contacts.wait();
+      }
+      this->_contacts = this->read_contacts(chrom_name);
+    }
 
-  return c.cooler_to_cmatrix(chrom_name, nrows, chrom_boundaries, try_common_prefixes,
-                             prefer_balanced_counts);
-}
+    this->_next_chrom_name = std::string{next_chrom_name};
+    this->_next_contacts = {};
+    if (!next_chrom_name.empty()) {
+      this->_next_contacts = std::async(std::launch::async, [this]() {
+        return this->read_contacts(this->_next_chrom_name);
+      });
+    }
+  }
+
+  /// Return the contacts for the window [window_start, window_end) of the current chromosome.
+
+  //! The result is identical to reading the contacts for the window straight from the cooler.
+  [[nodiscard]] ContactMatrixDense<> get(const bp_t window_start, const bp_t window_end) const {
+    assert(!this->_contacts.empty());
+    assert(window_start < window_end);
+    const auto first_bin = window_start / this->_bin_size;
+    const auto last_bin = std::min(this->_contacts.ncols(),
+                                   (window_end - 1 + this->_bin_size - 1) / this->_bin_size);
+    return this->_contacts.unsafe_slice(first_bin, last_bin);
+  }
+
+ private:
+  [[nodiscard]] ContactMatrixDense<> read_contacts(std::string_view chrom_name) const {
+    const auto nrows = (this->_diagonal_width + this->_bin_size - 1) / this->_bin_size;
+    const auto chrom_boundaries =
+        std::make_pair(usize(0), (std::numeric_limits<usize>::max)());  // Entire chromosome
+    const auto try_common_prefixes = false;
+    const auto prefer_balanced_counts = false;
+
+    return this->_cooler->cooler_to_cmatrix(chrom_name, nrows, chrom_boundaries,
+                                            try_common_prefixes, prefer_balanced_counts);
+  }
+};
 
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void Simulation::run_perturbate() {
@@ -103,19 +158,36 @@ void Simulation::run_perturbate() {
         "once.");
   }
   const usize task_batch_size_enq = 32;
-  moodycamel::BlockingConcurrentQueue<TaskPW> task_queue(this->nthreads * 2, 1, 0);
+  const usize queue_capacity = std::max(this->nthreads * 2, task_batch_size_enq);
+  moodycamel::BlockingConcurrentQueue<TaskPW> task_queue(queue_capacity, 1, 0);
   moodycamel::ProducerToken ptok(task_queue);
+  moodycamel::LightweightSemaphore free_slots(
+      static_cast<moodycamel::LightweightSemaphore::ssize_t>(queue_capacity));
   std::array<TaskPW, task_batch_size_enq> tasks;
 
   std::mutex out_stream_mutex;
-  std::mutex cooler_mutex;
 
   const auto write_bedpe_to_stdout = this->path_to_output_file_bedpe.empty();
-  auto out_task_stream = compressed_io::Writer(this->path_to_task_file);
+  // Tasks are written to a TSV or to a binary task file, depending on the output format
+  auto out_task_stream = this->task_file_format == Config::TaskFileFormat::tsv
+                             ? compressed_io::Writer(this->path_to_task_file)
+                             : compressed_io::Writer{};
+  auto out_task_file = [&]() {
+    if (this->task_file_format != Config::TaskFileFormat::binary ||
+        this->path_to_task_file.empty()) {
+      return task_file::Writer{};
+    }
+    std::vector<task_file::ChromInfo> chroms;
+    for (const auto& chrom : this->_genome) {
+      chroms.push_back(task_file::ChromInfo{chrom.id(), std::string{chrom.name()}});
+    }
+    return task_file::Writer(this->path_to_task_file, chroms);
+  }();
 
   cooler::Cooler reference_cooler(this->path_to_reference_contacts,
                                   cooler::Cooler<contacts_t>::IO_MODE::READ_ONLY, bin_size);
   validate_reference_contacts(this->_genome, reference_cooler);
+  ReferenceContactsCache reference_contacts(reference_cooler, this->bin_size, this->diagonal_width);
 
   if (this->write_header) {
     // clang-format off
@@ -168,7 +240,7 @@ void Simulation::run_perturbate() {
         auto tmp_output_path = this->path_to_output_file_bedpe;
         tmp_output_path.replace_extension(
             fmt::format(FMT_STRING("{}{}"), tid, tmp_output_path.extension().string()));
-        this->perturbate_worker(tid, task_queue, tmp_output_path, cooler_mutex);
+        this->perturbate_worker(tid, task_queue, free_slots, tmp_output_path);
 
         if (!this->path_to_output_file_bedpe.empty()) {
           if (this->ok()) {
@@ -186,22 +258,27 @@ void Simulation::run_perturbate() {
     const auto all_deletions =
         this->path_to_deletion_bed.empty() ? this->generate_deletions() : this->import_deletions();
 
+    const auto chrom_has_tasks = [&](const Chromosome& chrom) {
+      // Skip chromosomes that have less than two "kinds" of features, no barriers or no deletions
+      return chrom.get_features().size() == 2 && !chrom.barriers().empty() &&
+             all_deletions.contains(std::string{chrom.name()});
+    };
+
     usize task_id = 0;
     usize num_tasks = 0;
-    for (auto& chrom : this->_genome) {
+    for (auto it = this->_genome.begin(); it != this->_genome.end(); ++it) {
       if (!this->ok()) {
         this->handle_exceptions();
       }
-      const auto chrom_name = std::string{chrom.name()};
-      const auto& features = chrom.get_features();
-      const auto& barriers = chrom.barriers();
-      if (features.size() != 2 || barriers.empty()) {
-        continue;  // Skip chromosomes that have less than two "kinds" of features or no barriers
-      }
-
-      if (!all_deletions.contains(chrom_name)) {
+      auto& chrom = *it;
+      if (!chrom_has_tasks(chrom)) {
         continue;
       }
+      const auto chrom_name = std::string{chrom.name()};
+
+      const auto next_chrom = std::find_if(std::next(it), this->_genome.end(), chrom_has_tasks);
+      reference_contacts.load(chrom_name,
+                              next_chrom == this->_genome.end() ? "" : next_chrom->name());
 
       // The idea here is that given a diagonal width D and a feature F1, in order to track all
       // possible interactions between F1 and nearby features we need to simulate at least window
@@ -249,6 +326,8 @@ void Simulation::run_perturbate() {
 
       base_task.chrom = &chrom;
       base_task.reference_contacts = nullptr;
+      base_task.reference_block_sums = nullptr;
+      base_task.window_snapshot = nullptr;
       base_task.window_end = 4 * this->diagonal_width;
       base_task.active_window_start = 0;
       base_task.active_window_end = 3 * this->diagonal_width;
@@ -288,8 +367,15 @@ void Simulation::run_perturbate() {
         // When fetching a block of pixels from the 20th Mbp of c, the edge-extension logic will
         // only be applied to the second matrix, leading to inconsistent results.
         base_task.reference_contacts = std::make_shared<const ContactMatrixDense<>>(
-            read_reference_contacts(reference_cooler, chrom_name, base_task.window_start,
-                                    base_task.window_end, this->bin_size, this->diagonal_width));
+            reference_contacts.get(base_task.window_start, base_task.window_end));
+        // The reference matrix is shared by all deletions mapping to the current window, so its
+        // summed-area table is computed only once per window
+        base_task.reference_block_sums =
+            std::make_shared<const ContactMatrixDense<>::SummedAreaTable>(
+                base_task.reference_contacts->unsafe_compute_summed_area_table());
+        if (this->warm_start) {  // Built by the first task that needs it
+          base_task.window_snapshot = std::make_shared<WindowSnapshot>();
+        }
         for (const auto& deletion : deletions) {
           // Add task to the current batch
           auto& t = (tasks[num_tasks++] = base_task);
@@ -324,18 +410,8 @@ void Simulation::run_perturbate() {
                                                              : (std::numeric_limits<usize>::max)();
 
           if (num_tasks == tasks.size()) {  // Enqueue a batch of tasks
-            if (out_task_stream) {
-              out_task_stream.write(fmt::format(FMT_STRING("{}\n"), fmt::join(tasks, "\n")));
-            }
-            auto sleep_us = 100;
-            while (!task_queue.try_enqueue_bulk(ptok, std::make_move_iterator(tasks.begin()),
-                                                num_tasks)) {
-              if (!this->ok()) {
-                this->handle_exceptions();
-              }
-              sleep_us = std::min(100000, sleep_us * 2);
-              std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
-            }
+            this->write_tasks(out_task_stream, out_task_file, absl::MakeConstSpan(tasks));
+            this->enqueue_tasks_blocking(task_queue, ptok, free_slots, tasks.begin(), num_tasks);
             num_tasks = 0;
           }
         }
@@ -344,21 +420,14 @@ void Simulation::run_perturbate() {
 
     // Submit any remaining task
     if (num_tasks != 0) {
-      if (out_task_stream) {
-        out_task_stream.write(fmt::format(
-            FMT_STRING("{}\n"), fmt::join(tasks.begin(), tasks.begin() + num_tasks, "\n")));
-      }
-      while (
-          !task_queue.try_enqueue_bulk(ptok, std::make_move_iterator(tasks.begin()), num_tasks)) {
-        if (!this->ok()) {
-          this->handle_exceptions();
-        }
-        std::this_thread::sleep_for(std::chrono::microseconds(100));
-      }
+      this->write_tasks(out_task_stream, out_task_file,
+                        absl::MakeConstSpan(tasks.data(), num_tasks));
+      this->enqueue_tasks_blocking(task_queue, ptok, free_slots, tasks.begin(), num_tasks);
     }
 
     this->_end_of_simulation = true;
     out_task_stream.close();
+    out_task_file.close();
     this->_tpool.wait_for_tasks();  // Wait on simulate_worker threads
     assert(!this->_exception_thrown);
   } catch (...) {
@@ -369,10 +438,23 @@ void Simulation::run_perturbate() {
   }
 }
 
+void Simulation::write_tasks(compressed_io::Writer& tsv_writer, task_file::Writer& bin_writer,
+                             absl::Span<const TaskPW> tasks) {
+  if (tsv_writer) {
+    tsv_writer.write(fmt::format(FMT_STRING("{}\n"), fmt::join(tasks, "\n")));
+  }
+  if (bin_writer) {
+    for (const auto& t : tasks) {
+      bin_writer.write(t.to_record());
+    }
+  }
+}
+
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void Simulation::perturbate_worker(
     const u64 tid, moodycamel::BlockingConcurrentQueue<Simulation::TaskPW>& task_queue,
-    const std::filesystem::path& output_path, std::mutex& cooler_mtx, const usize task_batch_size) {
+    moodycamel::LightweightSemaphore& free_slots, const std::filesystem::path& output_path,
+    const usize task_batch_size) {
   spdlog::info(FMT_STRING("Spawning simulation thread {}..."), tid);
   moodycamel::ConsumerToken ctok(task_queue);
 
@@ -384,7 +466,8 @@ void Simulation::perturbate_worker(
 
   try {
     while (this->ok()) {  // Try to dequeue a batch of tasks
-      const auto avail_tasks = this->consume_tasks_blocking(task_queue, ctok, task_buff);
+      const auto avail_tasks =
+          this->consume_tasks_blocking(task_queue, ctok, free_slots, task_buff);
       if (avail_tasks == 0) {
         assert(this->_end_of_simulation);
         // Reached end of simulation (i.e. all tasks have been processed)
@@ -408,7 +491,7 @@ void Simulation::perturbate_worker(
         assert(local_state.contacts->nrows() == local_state.reference_contacts->nrows());
         assert(local_state.contacts->ncols() == local_state.reference_contacts->ncols());
 
-        Simulation::simulate_window(local_state, tmp_output_bedpe, cooler_mtx);
+        Simulation::simulate_window(local_state, tmp_output_bedpe);
       }
     }
   } catch (const std::exception& e) {
@@ -426,8 +509,8 @@ void Simulation::perturbate_worker(
 }
 
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
-void Simulation::simulate_window(Simulation::State& state, compressed_io::Writer& out_stream,
-                                 std::mutex& cooler_mtx, bool write_contacts_to_cooler) const {
+void Simulation::simulate_window(Simulation::State& state,
+                                 compressed_io::Writer& out_stream) const {
   spdlog::info(FMT_STRING("Processing {}[{}-{}]; outer_window=[{}-{}]; deletion=[{}-{}];"),
                state.chrom->name(), state.active_window_start, state.active_window_end,
                state.window_start, state.window_end, state.deletion_begin,
@@ -461,28 +544,45 @@ void Simulation::simulate_window(Simulation::State& state, compressed_io::Writer
   const auto last_window = state.active_window_end == state.chrom->end_pos();
   const auto partition_point = state.active_window_start + this->diagonal_width;
 
+  // Resize and reset state buffers
+  state.resize_buffers();
+  state.reset_buffers();
+  state.contacts->unsafe_resize(state.window_end - state.window_start, this->diagonal_width,
+                                this->bin_size);
+  state.contacts->unsafe_reset();
+
+  // When warm-starting, the cell is restored from the state reached at the end of the burn-in
+  // phase with all barriers in place. This must happen before generating the barrier configuration
+  const auto params =
+      this->warm_start ? Simulation::setup_cell_from_snapshot(state) : CellParams{};
+
   // Generate barrier configuration
   usize num_active_barriers = state.barriers.size();
   for (usize i = 0; i < state.barriers.size(); ++i) {
     if (state.barriers.pos(i) >= state.deletion_begin &&
         state.barriers.pos(i) < state.deletion_begin + state.deletion_size) {
-      state.barriers.set(i, state.barriers.pos(i), state.barriers.direction(i), 0.0, 1.0,
-                         ExtrusionBarriers::State::INACTIVE);
+      // Barriers are disabled through a per-task mask, so that the barrier table shared by all
+      // tasks for the current window is not copied
+      state.barriers.disable(i);
       num_active_barriers--;
     }
   }
 
-  // Resize and reset state buffers
-  state.resize_buffers();
-  state.reset_buffers();
-  state.contacts->unsafe_resize(state.window_end - state.window_start, this->diagonal_width,
-                                this->bin_size);
-  state.contacts->unsafe_reset();
-
-  Simulation::simulate_one_cell(state);
+  if (this->warm_start) {
+    Simulation::simulate_one_cell(state, params);
+  } else {
+    Simulation::simulate_one_cell(state);
+  }
 
   assert(state.reference_contacts);
   if (out_stream) {  // Output contacts for valid pairs of features
+    // Block sums are computed in constant time using summed-area tables. The table for the
+    // simulated contacts is computed once per deletion, while the one for the reference contacts
+    // is computed once per window
+    assert(state.reference_block_sums);
+    state.contacts->unsafe_compute_summed_area_table(state.block_sums);
+    const auto& block_sums = state.block_sums;
+    const auto& reference_block_sums = *state.reference_block_sums;
     for (usize i = 0; i < state.feats1.size(); ++i) {
       const auto& feat1 = state.feats1[i];
       const auto feat1_abs_center_pos = (feat1.chrom_start + feat1.chrom_end + 1) / 2;
@@ -507,9 +607,9 @@ void Simulation::simulate_window(Simulation::State& state, compressed_io::Writer
         const auto feat2_rel_bin = feat2_rel_center_pos / this->bin_size;
 
         const auto contacts =
-            state.contacts->unsafe_get_block(feat1_rel_bin, feat2_rel_bin, this->block_size);
-        const auto reference_contacts = state.reference_contacts->unsafe_get_block(
-            feat1_rel_bin, feat2_rel_bin, this->block_size);
+            block_sums.unsafe_get_block(feat1_rel_bin, feat2_rel_bin, this->block_size);
+        const auto reference_contacts =
+            reference_block_sums.unsafe_get_block(feat1_rel_bin, feat2_rel_bin, this->block_size);
         if (contacts == 0 && reference_contacts == 0) {  // Don't output entries with 0 contacts
           continue;
         }
@@ -569,45 +669,6 @@ void Simulation::simulate_window(Simulation::State& state, compressed_io::Writer
       }
     }
   }
-
-  if (write_contacts_to_cooler) {
-    const auto file_name = std::filesystem::path(fmt::format(
-        FMT_STRING("{}_{:06d}_{}_window_{}-{}_deletion_{}-{}.cool"),
-        this->path_to_output_prefix.string(), state.id, state.chrom->name(), state.window_start,
-        state.window_end, state.deletion_begin, state.deletion_begin + state.deletion_size));
-
-    if (!this->force && std::filesystem::exists(file_name)) {
-      throw std::runtime_error(fmt::format(
-          FMT_STRING("Refusing to overwrite output file {}. Pass --force to overwrite."),
-          file_name));
-    }
-
-    spdlog::info(FMT_STRING("Writing contacts for \"{}\" to file {}..."), state.chrom->name(),
-                 file_name);
-
-    absl::Duration duration;
-    {
-      std::scoped_lock lck(cooler_mtx);
-      const auto t0 = absl::Now();
-      auto c =
-          cooler::Cooler(file_name, cooler::Cooler<contacts_t>::IO_MODE::WRITE_ONLY, this->bin_size,
-                         this->_genome.chromosome_with_longest_name().name().size());
-      for (const auto& chrom : this->_genome) {
-        if (&chrom == state.chrom) {
-          c.write_or_append_cmatrix_to_file(*state.contacts, state.chrom->name(),
-                                            state.window_start, state.window_end,
-                                            state.chrom->size());
-          continue;
-        }
-        assert(chrom.contacts_ptr() == nullptr);
-        c.write_or_append_empty_cmatrix_to_file(chrom.name(), chrom.start_pos(), chrom.end_pos(),
-                                                chrom.size());
-      }
-      duration = absl::Now() - t0;
-    }
-    spdlog::info(FMT_STRING("DONE writing file {} in {}"), file_name,
-                 absl::FormatDuration(duration));
-  }
 }
 
 }  // namespace modle
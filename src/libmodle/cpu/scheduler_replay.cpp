@@ -7,91 +7,196 @@
 // clang-format on
 
 #include <absl/container/fixed_array.h>          // for FixedArray
+#include <absl/container/flat_hash_map.h>        // for flat_hash_map
 #include <absl/container/flat_hash_set.h>        // for flat_hash_set, BitMask
+#include <absl/time/clock.h>                     // for Now
+#include <absl/time/time.h>                      // for FormatDuration, operator-
 #include <absl/types/span.h>                     // for Span, MakeConstSpan
 #include <fmt/format.h>                          // for format, make_format_args, vformat_to
 #include <moodycamel/blockingconcurrentqueue.h>  // for BlockingConcurrentQueue
 #include <moodycamel/concurrentqueue.h>          // for ConsumerToken, ProducerToken
+#include <moodycamel/lightweightsemaphore.h>     // for LightweightSemaphore
 #include <spdlog/spdlog.h>                       // for info
 
 #include <BS_thread_pool.hpp>  // for BS::thread_pool
-#include <algorithm>           // for max, min
+#include <algorithm>           // for max, min, sort
 #include <array>               // for array, array<>::value_type
 #include <atomic>              // for atomic
 #include <cassert>             // for assert
-#include <chrono>              // for microseconds, milliseconds
+#include <chrono>              // for milliseconds
 #include <exception>           // for exception_ptr, exception, current_exception
 #include <filesystem>          // for exists
 #include <iterator>            // for move_iterator, make_move_iterator
 #include <memory>              // for shared_ptr, make_shared, __shared...
 #include <mutex>               // for mutex, scoped_lock
+#include <numeric>             // for iota
 #include <stdexcept>           // for runtime_error
 #include <string>              // for string
-#include <thread>              // IWYU pragma: keep for sleep_for
+#include <utility>             // for move, pair
 #include <vector>              // for vector
 
 #include "modle/common/common.hpp"                // for bp_t, contacts_t, u64
+#include "modle/common/fmt_helpers.hpp"           // IWYU pragma: keep
 #include "modle/compressed_io/compressed_io.hpp"  // for Reader, Writer
 #include "modle/contact_matrix_dense.hpp"         // for ContactMatrixDense
+#include "modle/cooler/scool.hpp"                 // for SCoolWriter
+#include "modle/genome.hpp"                       // for Chromosome, Genome
+#include "modle/task_file.hpp"                    // for task_file::Reader, task_file::Record
 
 namespace modle {
 
+/// Tasks are replayed by a pool of replay_worker threads, which also take care of extracting and
+/// compressing pixels from the contact matrix of each task. Cells are then handed over to a single
+/// writer thread (write_replay_output), as HDF5 files cannot be written concurrently.
+struct Simulation::ReplayOutput {  // NOLINT(altera-struct-pack-align)
+  using Cell = cooler::SCoolWriter<contacts_t>::Cell;
+
+  cooler::SCoolWriter<contacts_t> scool;
+  moodycamel::BlockingConcurrentQueue<Cell> cell_queue;
+  // Bound the number of cells waiting to be written to disk to limit memory usage
+  moodycamel::LightweightSemaphore free_slots;
+  std::atomic<usize> num_active_workers;
+
+  ReplayOutput(const std::filesystem::path& path, const Genome& genome, usize bin_size,
+               usize nthreads)
+      : scool(path, list_chromosomes(genome), bin_size),
+        cell_queue(2 * nthreads),
+        free_slots(static_cast<moodycamel::LightweightSemaphore::ssize_t>(2 * nthreads)),
+        num_active_workers(nthreads) {}
+
+ private:
+  [[nodiscard]] static std::vector<std::pair<std::string, usize>> list_chromosomes(
+      const Genome& genome) {
+    std::vector<std::pair<std::string, usize>> chroms{};
+    for (const auto& chrom : genome) {
+      chroms.emplace_back(std::string{chrom.name()}, static_cast<usize>(chrom.size()));
+    }
+    return chroms;
+  }
+};
+
+using ChromosomeMappings = absl::flat_hash_map<u64, Chromosome*>;
+
+/// Map the IDs from the chromosome table of a binary task file to chromosomes from the genome
+[[nodiscard]] static ChromosomeMappings map_chromosomes(const task_file::Reader& reader,
+                                                        Genome& genome) {
+  ChromosomeMappings chroms{};
+  for (const auto& chrom : reader.chromosomes()) {
+    auto chrom_it = genome.find(chrom.name);
+    if (chrom_it != genome.end()) {
+      chroms.emplace(chrom.id, &(*chrom_it));
+    }
+  }
+  return chroms;
+}
+
+/// Return the indices of the blocks from a binary task file containing the tasks to be replayed
+[[nodiscard]] static std::vector<usize> find_task_blocks(
+    const task_file::Reader& reader, const absl::flat_hash_set<usize>& task_filter) {
+  if (task_filter.empty()) {
+    std::vector<usize> blocks(reader.num_blocks());
+    std::iota(blocks.begin(), blocks.end(), usize(0));
+    return blocks;
+  }
+  std::vector<u64> task_ids(task_filter.begin(), task_filter.end());
+  std::sort(task_ids.begin(), task_ids.end());
+  return reader.find_blocks(task_ids);
+}
+
+[[nodiscard]] static Simulation::TaskPW load_task(const task_file::Reader& reader,
+                                                  const task_file::Record& record,
+                                                  const ChromosomeMappings& chroms) {
+  try {
+    const auto chrom_it = chroms.find(record.chrom_id);
+    if (chrom_it == chroms.end()) {
+      throw std::runtime_error(
+          fmt::format(FMT_STRING("Unable to find a chromosome with ID {}"), record.chrom_id));
+    }
+    return Simulation::TaskPW::from_record(record, *chrom_it->second);
+  } catch (const std::runtime_error& e) {
+    throw std::runtime_error(
+        fmt::format(FMT_STRING("An error occourred while loading task #{} from file {}.\n"
+                               "Reason: {}"),
+                    record.id, reader.path(), e.what()));
+  }
+}
+
 void Simulation::run_replay() {
   assert(std::filesystem::exists(this->path_to_task_file));
-  compressed_io::Reader task_reader(this->path_to_task_file);
 
   const usize task_batch_size_enq = 32;
-  moodycamel::BlockingConcurrentQueue<TaskPW> task_queue(this->nthreads * 2, 1, 0);
+  const usize queue_capacity = std::max(this->nthreads * 2, task_batch_size_enq);
+  moodycamel::BlockingConcurrentQueue<TaskPW> task_queue(queue_capacity, 1, 0);
   moodycamel::ProducerToken ptok(task_queue);
+  moodycamel::LightweightSemaphore free_slots(
+      static_cast<moodycamel::LightweightSemaphore::ssize_t>(queue_capacity));
   std::array<TaskPW, task_batch_size_enq> tasks;
 
-  std::mutex cooler_mutex;
+  spdlog::info(FMT_STRING("Contacts will be written to file {}"), this->path_to_output_file_cool);
+  ReplayOutput output(this->path_to_output_file_cool, this->_genome, this->bin_size,
+                      this->nthreads);
 
   try {
-    this->_tpool.reset(utils::conditional_static_cast<BS::concurrency_t>(this->nthreads));
+    this->_tpool.reset(utils::conditional_static_cast<BS::concurrency_t>(this->nthreads + 1));
+    this->_tpool.push_task([&]() {  // This thread is in charge of writing contacts to disk
+      this->write_replay_output(output);
+    });
     for (u64 tid = 0; tid < this->nthreads; ++tid) {  // Start simulation threads
-      this->_tpool.push_task([&, tid]() { this->replay_worker(tid, task_queue, cooler_mutex); });
+      this->_tpool.push_task([&, tid]() {
+        this->replay_worker(tid, task_queue, free_slots, output);
+        --output.num_active_workers;
+      });
     }
 
     const auto task_filter = import_task_filter(this->path_to_task_filter_file);
 
-    std::string task_definition;
     usize num_tasks = 0;
-    while (task_reader.getline(task_definition)) {
+    auto enqueue_task = [&](TaskPW&& t) {
       if (!this->ok()) {
         this->handle_exceptions();
       }
       if (num_tasks == tasks.size()) {  // Enqueue a batch of tasks
-        auto sleep_us = 100;
-        while (
-            !task_queue.try_enqueue_bulk(ptok, std::make_move_iterator(tasks.begin()), num_tasks)) {
-          if (!this->ok()) {
-            this->handle_exceptions();
+        this->enqueue_tasks_blocking(task_queue, ptok, free_slots, tasks.begin(), num_tasks);
+        num_tasks = 0;
+      }
+      tasks[num_tasks++] = std::move(t);
+    };
+
+    if (task_file::is_task_file(this->path_to_task_file)) {
+      task_file::Reader task_reader(this->path_to_task_file);
+      const auto chroms = map_chromosomes(task_reader, this->_genome);
+      std::vector<task_file::Record> records{};
+      // When a filter is given, only the blocks containing the selected tasks are decompressed
+      for (const auto i : find_task_blocks(task_reader, task_filter)) {
+        task_reader.read_block(i, records);
+        for (const auto& r : records) {
+          if (task_filter.empty() || task_filter.contains(r.id)) {
+            enqueue_task(load_task(task_reader, r, chroms));
           }
-          sleep_us = std::min(100000, sleep_us * 2);
-          std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
         }
-        num_tasks = 0;
       }
-      const auto& t = (tasks[num_tasks] = TaskPW::from_string(task_definition, this->_genome));
-      if (task_filter.empty() || task_filter.contains(t.id)) {
-        ++num_tasks;
+    } else {
+      compressed_io::Reader task_reader(this->path_to_task_file);
+      std::string task_definition;
+      while (task_reader.getline(task_definition)) {
+        auto t = TaskPW::from_string(task_definition, this->_genome);
+        if (task_filter.empty() || task_filter.contains(t.id)) {
+          enqueue_task(std::move(t));
+        }
       }
     }
 
     if (num_tasks != 0) {
-      while (
-          !task_queue.try_enqueue_bulk(ptok, std::make_move_iterator(tasks.begin()), num_tasks)) {
-        if (!this->ok()) {
-          this->handle_exceptions();
-        }
-        std::this_thread::sleep_for(std::chrono::microseconds(100));
-      }
+      this->enqueue_tasks_blocking(task_queue, ptok, free_slots, tasks.begin(), num_tasks);
     }
 
     this->_end_of_simulation = true;
-    this->_tpool.wait_for_tasks();  // Wait on simulate_worker threads
-    assert(!this->_exception_thrown);
+    this->_tpool.wait_for_tasks();  // Wait on replay_worker and writer threads
+    if (!this->ok()) {  // The writer thread may fail after the last task has been enqueued
+      this->rethrow_exceptions();
+    }
+    spdlog::info(FMT_STRING("Written {} cells to file {}"), output.scool.get_ncells(),
+                 output.scool.get_path());
   } catch (...) {
     this->_exception_thrown = true;
     this->_tpool.pause();
@@ -102,9 +207,11 @@ void Simulation::run_replay() {
 
 void Simulation::replay_worker(const u64 tid,
                                moodycamel::BlockingConcurrentQueue<Simulation::TaskPW>& task_queue,
-                               std::mutex& cooler_mtx, const usize task_batch_size) {
+                               moodycamel::LightweightSemaphore& free_slots,
+                               ReplayOutput& output, const usize task_batch_size) {
   spdlog::info(FMT_STRING("Spawning simulation thread {}..."), tid);
   moodycamel::ConsumerToken ctok(task_queue);
+  moodycamel::ProducerToken ptok(output.cell_queue);
 
   absl::FixedArray<TaskPW> task_buff(task_batch_size);  // Tasks are dequeue in batch.
 
@@ -114,7 +221,8 @@ void Simulation::replay_worker(const u64 tid,
 
   try {
     while (this->ok()) {  // Try to dequeue a batch of tasks
-      const auto avail_tasks = this->consume_tasks_blocking(task_queue, ctok, task_buff);
+      const auto avail_tasks =
+          this->consume_tasks_blocking(task_queue, ctok, free_slots, task_buff);
       if (avail_tasks == 0) {
         assert(this->_end_of_simulation);
         // Reached end of simulation (i.e. all tasks have been processed)
@@ -135,7 +243,26 @@ void Simulation::replay_worker(const u64 tid,
         local_state.contacts->unsafe_resize(local_state.window_end - local_state.window_start,
                                             this->diagonal_width, this->bin_size);
 
-        Simulation::simulate_window(local_state, null_stream, cooler_mtx, true);
+        Simulation::simulate_window(local_state, null_stream);
+
+        auto cell = output.scool.make_cell(
+            fmt::format(FMT_STRING("{:06d}_{}_window_{}-{}_deletion_{}-{}"), local_state.id,
+                        local_state.chrom->name(), local_state.window_start,
+                        local_state.window_end, local_state.deletion_begin,
+                        local_state.deletion_begin + local_state.deletion_size),
+            *local_state.contacts, local_state.chrom->name(), local_state.window_start);
+
+        // Block until the writer thread has made room for the new cell. The timeout is only used to
+        // periodically check whether one of the other threads failed
+        constexpr std::int64_t timeout_us = 10'000;
+        while (!output.free_slots.wait(timeout_us)) {
+          if (!this->ok()) {
+            return;
+          }
+        }
+        if (!output.cell_queue.enqueue(ptok, std::move(cell))) {
+          throw std::runtime_error("Failed to enqueue cell: unable to allocate memory");
+        }
       }
     }
   } catch (const std::exception& e) {
@@ -151,4 +278,41 @@ void Simulation::replay_worker(const u64 tid,
     this->_exception_thrown = true;
   }
 }
+
+void Simulation::write_replay_output(ReplayOutput& output) {
+  moodycamel::ConsumerToken ctok(output.cell_queue);
+  ReplayOutput::Cell cell{};
+
+  try {
+    while (this->ok()) {
+      // The number of active workers must be read before trying to dequeue a cell: if the queue is
+      // empty and no worker was active, then all cells have been written to disk
+      const auto workers_done = output.num_active_workers == 0;
+      if (!output.cell_queue.wait_dequeue_timed(ctok, cell, std::chrono::milliseconds(10))) {
+        if (workers_done) {
+          return;
+        }
+        continue;
+      }
+      // Wake up workers waiting for room in the queue
+      output.free_slots.signal();
+
+      const auto t0 = absl::Now();
+      output.scool.append_cell(cell);
+      spdlog::info(FMT_STRING("DONE writing cell \"{}\" ({} pixels) to file {} in {}"), cell.name,
+                   cell.nnz(), output.scool.get_path(), absl::FormatDuration(absl::Now() - t0));
+    }
+  } catch (const std::exception& e) {
+    std::scoped_lock<std::mutex> l(this->_exceptions_mutex);
+    this->_exceptions.emplace_back(std::make_exception_ptr(std::runtime_error(
+        fmt::format(FMT_STRING("Detected an error in the thread writing contacts to file {}:\n{}"),
+                    output.scool.get_path(), e.what()))));
+    this->_exception_thrown = true;
+  } catch (...) {
+    std::scoped_lock<std::mutex> l(this->_exceptions_mutex);
+    this->_exceptions.emplace_back(std::current_exception());
+    this->_exception_thrown = true;
+  }
+}
+
 }  // namespace modle
@@ -12,33 +12,65 @@
 #include <fmt/format.h>                          // for make_format_args, vformat_to, FMT_STRING
 #include <moodycamel/blockingconcurrentqueue.h>  // for BlockingConcurrentQueue
 #include <moodycamel/concurrentqueue.h>          // for ConsumerToken, ProducerToken
+#include <moodycamel/lightweightsemaphore.h>     // for LightweightSemaphore
 #include <spdlog/spdlog.h>                       // for info
 
 #include <BS_thread_pool.hpp>  // for BS::thread_pool
-#include <algorithm>           // for max, copy, min, find_if, generate
+#include <algorithm>           // for max, copy, min, find_if, generate, max_element, stable_sort
 #include <atomic>              // for atomic
 #include <cassert>             // for assert
-#include <chrono>              // for microseconds, milliseconds
+#include <chrono>              // for milliseconds
+#include <condition_variable>  // for condition_variable
 #include <cmath>               // for round
 #include <deque>               // for deque, operator-, operator!=, _Deque_ite...
 #include <exception>           // for exception_ptr, exception, current_exception
 #include <filesystem>          // for path
 #include <iterator>            // for move_iterator, make_move_iterator
 #include <limits>              // for numeric_limits
+#include <memory>              // for make_shared, shared_ptr
 #include <mutex>               // for mutex, scoped_lock
+#include <numeric>             // for accumulate
 #include <stdexcept>           // for runtime_error
-#include <thread>              // IWYU pragma: keep for sleep_for
 #include <utility>             // for pair
 #include <vector>              // for vector
 
 #include "modle/common/common.hpp"  // for u64
 #include "modle/common/fmt_helpers.hpp"
 #include "modle/common/suppress_compiler_warnings.hpp"  // for DISABLE_WARNING_POP, DISABLE_WARN...
+#include "modle/extrusion_barriers.hpp"                 // for ExtrusionBarriers
 #include "modle/genome.hpp"                             // for Chromosome, Genome
 #include "modle/interval_tree.hpp"                      // for IITree, IITree::data
+#include "modle/profiler.hpp"                           // for ProfileCounters
 
 namespace modle {
 
+namespace {
+/// Book-keeping used by Simulation::run_simulate to interleave tasks from multiple chromosomes
+struct ChromSimulationJob {  // NOLINT(altera-struct-pack-align)
+  Chromosome* chrom{};
+  usize nlefs{};
+  usize target_epochs{};
+  usize tot_target_contacts{};
+  usize target_contacts_per_cell{};
+  usize tot_target_contacts_rolling_count{};
+  usize next_cell_id{};
+  usize contact_matrix_size{};        // in bytes
+  usize lef_occupancy_buffer_size{};  // in bytes
+  double cost_per_cell{};             // in LEF-epochs
+  // Built when the job is admitted, and shared by all the tasks generated for the chromosome
+  std::shared_ptr<const ExtrusionBarriers> barrier_table{};
+
+  [[nodiscard]] usize memory_footprint() const noexcept {
+    return contact_matrix_size + lef_occupancy_buffer_size;
+  }
+
+  [[nodiscard]] double remaining_work(usize num_cells) const noexcept {
+    assert(next_cell_id <= num_cells);
+    return cost_per_cell * static_cast<double>(num_cells - next_cell_id);
+  }
+};
+}  // namespace
+
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void Simulation::run_simulate() {
   if (!this->skip_output) {  // Write simulation params to file
@@ -48,6 +80,11 @@ void Simulation::run_simulate() {
     }
   }
   this->_tpool.reset(utils::conditional_static_cast<BS::concurrency_t>(this->nthreads + 1));
+  if constexpr (utils::profiling_enabled()) {
+    // One entry for each simulation thread plus one for the thread writing contacts to disk
+    this->_thread_profiles.assign(this->nthreads + 1, ProfileCounters{});
+    this->_chrom_profiles.assign(this->_genome.number_of_chromosomes(), ProfileCounters{});
+  }
 
   // These are the threads spawned by run_simulate:
   // - 1 thread to write contacts to disk. This thread pops Chromosome* from a std::deque once the
@@ -65,6 +102,9 @@ void Simulation::run_simulate() {
   // light-weight structs
 
   std::mutex progress_queue_mutex;  // Protect rw access to progress_queue
+  // Used to notify the writer thread that a chromosome has been simulated, and the main thread
+  // that a chromosome has been written to disk
+  std::condition_variable progress_queue_cv;
   std::deque<std::pair<Chromosome*, usize>> progress_queue;
 
   const auto task_batch_size_deq = [this]() -> usize {
@@ -80,6 +120,9 @@ void Simulation::run_simulate() {
   // Queue used to submit simulation tasks to the thread pool
   moodycamel::BlockingConcurrentQueue<Simulation::Task> task_queue(queue_capacity, 1, 0);
   moodycamel::ProducerToken ptok(task_queue);
+  // Number of tasks that can be enqueued without exceeding the queue capacity
+  moodycamel::LightweightSemaphore free_slots(
+      static_cast<moodycamel::LightweightSemaphore::ssize_t>(queue_capacity));
 
   std::mutex model_state_logger_mtx;  // Protect rw access to the log file located at
                                       // this->path_to_model_state_log_file
@@ -88,93 +131,204 @@ void Simulation::run_simulate() {
         .write(model_internal_state_log_header);
   }
 
+  // Chromosomes are written to disk in the same order they appear in the Genome, while
+  // simulation tasks for different chromosomes are interleaved (see below). For this reason we
+  // populate the progress queue before spawning any thread.
+  // Chromosomes that are not going to be simulated are marked as completed right away.
+  std::vector<ChromSimulationJob> pending_jobs;
+  for (auto& chrom : this->_genome) {
+    // Don't bother simulating chromosomes without barriers
+    if (!this->simulate_chromosomes_wo_barriers && chrom.num_barriers() == 0) {
+      spdlog::info(FMT_STRING("SKIPPING \"{}\"..."), chrom.name());
+      progress_queue.emplace_back(&chrom, num_cells);
+      continue;
+    }
+    progress_queue.emplace_back(&chrom, usize(0));
+
+    ChromSimulationJob job{};
+    job.chrom = &chrom;
+    // Compute # of LEFs to be simulated based on chrom.sizes
+    job.nlefs = this->compute_num_lefs(chrom.simulated_size());
+
+    const auto npixels = chrom.npixels(this->diagonal_width, this->bin_size);
+    job.tot_target_contacts = static_cast<usize>(
+        std::round(static_cast<double>(npixels) * this->target_contact_density));
+    job.target_epochs = this->compute_tot_target_epochs(job.nlefs, npixels);
+    job.target_contacts_per_cell =
+        (job.tot_target_contacts + this->num_cells - 1) / this->num_cells;
+    job.contact_matrix_size = this->compute_contact_matrix_size(chrom);
+    if (this->track_1d_lef_position) {
+      job.lef_occupancy_buffer_size = this->compute_lef_occupancy_buffer_size(chrom);
+    }
+    job.cost_per_cell = static_cast<double>(job.nlefs) * static_cast<double>(job.target_epochs) /
+                        static_cast<double>(this->num_cells);
+    pending_jobs.emplace_back(job);
+  }
+  // Signal end of simulation to the thread that is writing contacts to disk
+  progress_queue.emplace_back(nullptr, usize(0));
+
+  // Chromosomes are admitted for simulation following the longest-processing-time-first rule, so
+  // that large chromosomes do not end up being simulated last while most threads are idle
+  std::stable_sort(pending_jobs.begin(), pending_jobs.end(), [&](const auto& j1, const auto& j2) {
+    return j1.remaining_work(this->num_cells) > j2.remaining_work(this->num_cells);
+  });
+
+  // Buffers owned by simulate_worker threads are allocated once and live for the entire
+  // simulation. Account for them assuming every thread ends up simulating the largest chromosome
+  const auto state_buffers_size = [&]() {
+    usize max_nlefs = 0;
+    usize max_nbarriers = 0;
+    for (const auto& job : pending_jobs) {
+      max_nlefs = std::max(max_nlefs, job.nlefs);
+      max_nbarriers = std::max(max_nbarriers, job.chrom->num_barriers());
+    }
+    return this->nthreads * Simulation::compute_state_buffers_size(max_nlefs, max_nbarriers);
+  }();
+  this->register_allocation(state_buffers_size);
+
+  // LEF occupancy buffers are written to disk at the end of the simulation
+  const auto lef_occupancy_buffers_size =
+      std::accumulate(pending_jobs.begin(), pending_jobs.end(), usize(0),
+                      [](auto accumulator, const auto& job) {
+                        return accumulator + job.lef_occupancy_buffer_size;
+                      });
+
+  // Memory budget for the buffers that are alive at any given time. The default budget is roughly
+  // equivalent to what the scheduler used to allocate when simulating one chromosome at a time
+  // (i.e. the contact matrix of the chromosome being simulated plus the one being written to disk)
+  const auto memory_budget = [&]() -> usize {
+    if (this->max_memory != 0) {
+      return this->max_memory;
+    }
+    std::vector<usize> sizes(pending_jobs.size());
+    std::transform(pending_jobs.begin(), pending_jobs.end(), sizes.begin(),
+                   [](const auto& job) { return job.contact_matrix_size; });
+    std::sort(sizes.rbegin(), sizes.rend());
+    return state_buffers_size + lef_occupancy_buffers_size +
+           std::accumulate(sizes.begin(), sizes.begin() + std::min(usize(2), sizes.size()),
+                           usize(0));
+  }();
+
+  constexpr auto MiB = static_cast<double>(1ULL << 20ULL);
+  if (const auto min_memory_required =
+          state_buffers_size +
+          std::accumulate(pending_jobs.begin(), pending_jobs.end(), usize(0),
+                          [](auto accumulator, const auto& job) {
+                            return std::max(accumulator, job.memory_footprint());
+                          });
+      min_memory_required > memory_budget) {
+    spdlog::warn(
+        FMT_STRING("Simulating the largest chromosome requires ~{:.2f} MiB of memory, which is "
+                   "more than the memory budget ({:.2f} MiB). The memory budget will be exceeded!"),
+        static_cast<double>(min_memory_required) / MiB, static_cast<double>(memory_budget) / MiB);
+  }
+
   try {
     this->_tpool.push_task([&]() {  // This thread is in charge of writing contacts to disk
-      this->write_contacts_to_disk(progress_queue, progress_queue_mutex);
+      this->write_contacts_to_disk(progress_queue, progress_queue_mutex, progress_queue_cv);
     });
 
     for (u64 tid = 0; tid < this->nthreads; ++tid) {  // Start simulation threads
       this->_tpool.push_task([&, tid]() {
-        this->simulate_worker(tid, task_queue, progress_queue, progress_queue_mutex,
-                              model_state_logger_mtx, task_batch_size_deq);
+        this->simulate_worker(tid, task_queue, free_slots, progress_queue, progress_queue_mutex,
+                              progress_queue_cv, model_state_logger_mtx, task_batch_size_deq);
       });
     }
 
     // The remaining code submits simulation tasks to the queue. Then it waits until all the tasks
     // have been completed and contacts have been written to disk
 
+    // Try to admit pending chromosomes for simulation.
+    // A chromosome is admitted when its buffers fit in the memory budget. Regardless of the
+    // budget, we always admit the chromosome that the writer thread is waiting on once all the
+    // chromosomes preceding it have been written to disk: this guarantees progress even when a
+    // single contact matrix is larger than the memory budget, or when the budget is taken by
+    // chromosomes that cannot be written to disk before the one the writer is waiting on.
+    std::vector<ChromSimulationJob> active_jobs;
+    auto get_writer_head = [&]() {
+      std::scoped_lock lck(progress_queue_mutex);
+      return progress_queue.front().first;
+    };
+    auto admit_jobs = [&]() {
+      const auto writer_head = get_writer_head();
+      for (auto it = pending_jobs.begin(); it != pending_jobs.end();) {
+        const auto fits_in_budget =
+            this->_memory_in_use.load() + it->memory_footprint() <= memory_budget;
+        if (fits_in_budget || it->chrom == writer_head) {
+          this->register_allocation(it->memory_footprint());
+          active_jobs.emplace_back(*it);
+          const auto& barriers = it->chrom->barriers().data();
+          active_jobs.back().barrier_table =
+              std::make_shared<const ExtrusionBarriers>(barriers.begin(), barriers.end());
+          it = pending_jobs.erase(it);
+          continue;
+        }
+        ++it;
+      }
+    };
+
     absl::FixedArray<Task> tasks(task_batch_size_enq);
     usize taskid = 0;
 
-    // Loop over chromosomes
-    for (auto& chrom : this->_genome) {
+    while (!pending_jobs.empty() || !active_jobs.empty()) {
       if (!this->ok()) {
         this->handle_exceptions();
       }
-      // Don't bother simulating chromosomes without barriers
-      if (!this->simulate_chromosomes_wo_barriers && chrom.num_barriers() == 0) {
-        spdlog::info(FMT_STRING("SKIPPING \"{}\"..."), chrom.name());
-        std::scoped_lock lck(progress_queue_mutex);
-        progress_queue.emplace_back(&chrom, num_cells);
+      if (!pending_jobs.empty()) {
+        admit_jobs();
+      }
+
+      if (active_jobs.empty()) {
+        // All admitted chromosomes have been submitted and none of the pending chromosomes fits in
+        // the memory budget: wait for the writer thread to write the next chromosome to disk.
+        // The timeout is only used to periodically check whether one of the worker threads failed
+        const auto writer_head = get_writer_head();
+        std::unique_lock lck(progress_queue_mutex);
+        progress_queue_cv.wait_for(lck, std::chrono::milliseconds(100),
+                                   [&]() { return progress_queue.front().first != writer_head; });
         continue;
       }
 
-      {
-        std::scoped_lock lck(progress_queue_mutex);
+      // Generate a batch of tasks for the chromosome with the most remaining work
+      auto job = std::max_element(active_jobs.begin(), active_jobs.end(),
+                                  [&](const auto& j1, const auto& j2) {
+                                    return j1.remaining_work(this->num_cells) <
+                                           j2.remaining_work(this->num_cells);
+                                  });
+      const auto ntasks = std::min(tasks.size(), this->num_cells - job->next_cell_id);
+      std::generate(tasks.begin(), tasks.begin() + ntasks, [&]() {
+        // This is needed to not overshoot the target contact density
+        const auto effective_target_contacts =
+            std::min(job->target_contacts_per_cell,
+                     job->tot_target_contacts - job->tot_target_contacts_rolling_count);
+        job->tot_target_contacts_rolling_count += effective_target_contacts;
+
+        return Task{{taskid++, job->chrom, job->next_cell_id++, job->target_epochs,
+                     effective_target_contacts, job->nlefs, job->chrom->barriers().data(),
+                     job->barrier_table}};
+      });
 
-        // Signal that we have started processing the current chrom
-        progress_queue.emplace_back(&chrom, usize(0));
-      }
+      this->enqueue_tasks_blocking(task_queue, ptok, free_slots, tasks.begin(), ntasks);
 
-      // Compute # of LEFs to be simulated based on chrom.sizes
-      const auto nlefs = this->compute_num_lefs(chrom.simulated_size());
-
-      const auto npixels = chrom.npixels(this->diagonal_width, this->bin_size);
-      const auto tot_target_contacts = static_cast<usize>(
-          std::round(static_cast<double>(npixels) * this->target_contact_density));
-      const auto target_epochs = this->compute_tot_target_epochs(nlefs, npixels);
-
-      const auto target_contacts_per_cell =
-          (tot_target_contacts + this->num_cells - 1) / this->num_cells;
-
-      usize tot_target_contacts_rolling_count = 0;
-      usize cellid = 0;
-      const auto nbatches = (this->num_cells + task_batch_size_enq - 1) / task_batch_size_enq;
-      for (usize batchid = 0; batchid < nbatches; ++batchid) {
-        // Generate a batch of tasks for the current chrom
-        std::generate(tasks.begin(), tasks.end(), [&]() {
-          // This is needed to not overshoot the target contact density
-          const auto effective_target_contacts = std::min(
-              target_contacts_per_cell, tot_target_contacts - tot_target_contacts_rolling_count);
-          tot_target_contacts_rolling_count += effective_target_contacts;
-
-          return Task{{taskid++, &chrom, cellid++, target_epochs, effective_target_contacts, nlefs,
-                       chrom.barriers().data()}};
-        });
-        const auto ntasks =
-            cellid > this->num_cells ? tasks.size() - (cellid - this->num_cells) : tasks.size();
-        auto sleep_us = 100;
-        while (  // Enqueue tasks
-            !task_queue.try_enqueue_bulk(ptok, std::make_move_iterator(tasks.begin()), ntasks)) {
-          if (!this->ok()) {
-            this->handle_exceptions();
-          }
-          sleep_us = std::min(100000, sleep_us * 2);
-          std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
-        }
+      if (job->next_cell_id == this->num_cells) {
+        active_jobs.erase(job);
       }
     }
 
-    {  // Signal end of simulation to the thread that is writing contacts to disk
-      std::scoped_lock lck(progress_queue_mutex);
-      progress_queue.emplace_back(nullptr, usize(0));
-    }
     this->_tpool.wait_for_tasks();
     if (this->track_1d_lef_position) {
       this->write_1d_lef_occupancy_to_disk();
     }
+    this->write_profile_report_to_disk();
     assert(this->_end_of_simulation);
     assert(!this->_exception_thrown);
+
+    this->register_deallocation(lef_occupancy_buffers_size);
+    this->register_deallocation(state_buffers_size);
+    spdlog::info(FMT_STRING("Peak memory usage for contact matrices and simulation buffers: "
+                            "~{:.2f} MiB (budget: {:.2f} MiB)."),
+                 static_cast<double>(this->_peak_memory_in_use.load()) / MiB,
+                 static_cast<double>(memory_budget) / MiB);
   } catch (...) {
     this->_exception_thrown = true;
     this->_tpool.pause();
@@ -185,9 +339,11 @@ void Simulation::run_simulate() {
 
 void Simulation::simulate_worker(const u64 tid,
                                  moodycamel::BlockingConcurrentQueue<Simulation::Task>& task_queue,
+                                 moodycamel::LightweightSemaphore& free_slots,
                                  std::deque<std::pair<Chromosome*, usize>>& progress_queue,
-                                 std::mutex& progress_queue_mtx, std::mutex& model_state_logger_mtx,
-                                 const usize task_batch_size) {
+                                 std::mutex& progress_queue_mtx,
+                                 std::condition_variable& progress_queue_cv,
+                                 std::mutex& model_state_logger_mtx, const usize task_batch_size) {
   spdlog::info(FMT_STRING("Spawning simulation thread {}..."), tid);
 
   moodycamel::ConsumerToken ctok(task_queue);
@@ -211,7 +367,8 @@ void Simulation::simulate_worker(const u64 tid,
 
   try {
     while (this->ok()) {
-      const auto avail_tasks = this->consume_tasks_blocking(task_queue, ctok, task_buff);
+      const auto avail_tasks =
+          this->consume_tasks_blocking(task_queue, ctok, free_slots, task_buff);
       if (avail_tasks == 0) {
         assert(this->_end_of_simulation);
         // Reached end of simulation (i.e. all tasks have been processed)
@@ -253,6 +410,18 @@ void Simulation::simulate_worker(const u64 tid,
         if (MODLE_LIKELY(task.num_target_epochs != (std::numeric_limits<usize>::max)() ||
                          task.num_target_contacts != 0)) {
           Simulation::simulate_one_cell(local_state);
+          // Merge contacts that are still buffered into the contact matrix for the current chrom
+          Simulation::flush_contact_buffer(local_state);
+        }
+
+        if constexpr (utils::profiling_enabled()) {
+          auto& profile = local_state.profile;
+          ++profile.cells;
+          profile.epochs += local_state.epoch;
+          profile.burnin_epochs += local_state.num_burnin_epochs;
+          profile.contacts_registered += local_state.num_contacts;
+          this->register_profile(tid, *task.chrom, profile);
+          profile = ProfileCounters{};
         }
 
         // Update progress for the current chrom
@@ -265,6 +434,8 @@ void Simulation::simulate_worker(const u64 tid,
           // We are done simulating loop-extrusion on task.chrom: print a status update
           spdlog::info(FMT_STRING("Simulation of \"{}\" successfully completed."),
                        task.chrom->name());
+          // Wake up the writer thread
+          progress_queue_cv.notify_all();
         }
       }
     }
@@ -10,18 +10,19 @@
 #include <absl/strings/str_split.h>             // for StrSplit, Splitter
 #include <absl/types/span.h>                    // for Span, MakeConstSpan, MakeSpan
 #include <cpp-sort/sorter_facade.h>             // for sorter_facade
-#include <cpp-sort/sorters/insertion_sorter.h>  // for insertion_sort, insertion_so...
 #include <cpp-sort/sorters/pdq_sorter.h>        // for pdq_sort, pdq_sorter
-#include <cpp-sort/sorters/split_sorter.h>      // for split_sort, split_sorter
 #include <fmt/compile.h>
+#include <fmt/os.h>         // for output_file
 #include <spdlog/spdlog.h>  // for info, warn
 
 #include <BS_thread_pool.hpp>  // for BS::thread_pool
-#include <algorithm>           // for max, fill, min, copy, clamp
+#include <algorithm>           // for max, fill, min, copy, clamp, move_backward
+#include <array>               // for array
 #include <atomic>              // for atomic
 #include <cassert>             // for assert
-#include <chrono>              // for microseconds
+#include <chrono>              // for milliseconds
 #include <cmath>               // for log, round, exp, floor, sqrt
+#include <condition_variable>  // for condition_variable
 #include <cstdlib>             // for abs
 #include <deque>               // for _Deque_iterator<>::_Self
 #include <filesystem>          // for operator<<, path
@@ -33,8 +34,7 @@
 #include <stdexcept>           // for runtime_error
 #include <string>              // for string
 #include <string_view>         // for string_view
-#include <thread>              // IWYU pragma: keep for sleep_for
-#include <utility>             // for make_pair, pair
+#include <utility>             // for make_pair, pair, swap, index_sequence
 #include <vector>              // for vector, vector<>::iterator
 
 #include "modle/bigwig/bigwig.hpp"
@@ -42,7 +42,7 @@
 #include "modle/common/dna.hpp"     // for dna::REV, dna::FWD
 #include "modle/common/fmt_helpers.hpp"
 #include "modle/common/genextreme_value_distribution.hpp"  // for genextreme_value_distribution
-#include "modle/common/random.hpp"             // for bernoulli_trial, poisson_distribution
+#include "modle/common/random.hpp"             // for BatchPRNG, poisson_distribution
 #include "modle/common/random_sampling.hpp"    // for random_sample
 #include "modle/common/simulation_config.hpp"  // for Config
 #include "modle/common/utils.hpp"              // for parse_numeric_or_throw, ndeb...
@@ -51,6 +51,7 @@
 #include "modle/extrusion_factors.hpp"         // for Lef, ExtrusionUnit
 #include "modle/genome.hpp"                    // for Genome::iterator, Chromosome
 #include "modle/interval_tree.hpp"             // for IITree, IITree::data
+#include "modle/profiler.hpp"                  // for ProfileCounters, ScopedTimer
 #include "modle/stats/descriptive.hpp"
 
 namespace modle {
@@ -64,6 +65,11 @@ Simulation::Simulation(const Config& c, bool import_chroms)
                             : Genome{}) {
   _tpool.reset(utils::conditional_static_cast<BS::concurrency_t>(c.nthreads + 1));
 
+  if (c.tabulate_contact_noise) {
+    _contact_noise_table = tabulated_genextreme_value_distribution<double>{
+        c.genextreme_mu, c.genextreme_sigma, c.genextreme_xi};
+  }
+
   // Override barrier occupancies read from BED file
   if (c.override_extrusion_barrier_occupancy) {
     for (auto& chrom : this->_genome) {
@@ -112,7 +118,8 @@ usize Simulation::simulated_size() const { return this->_genome.simulated_size()
 
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void Simulation::write_contacts_to_disk(std::deque<std::pair<Chromosome*, usize>>& progress_queue,
-                                        std::mutex& progress_queue_mtx) {
+                                        std::mutex& progress_queue_mtx,
+                                        std::condition_variable& progress_queue_cv) {
   // This thread is in charge of writing contacts to disk
   Chromosome* chrom_to_be_written = nullptr;
   const auto max_str_length =
@@ -132,32 +139,35 @@ void Simulation::write_contacts_to_disk(std::deque<std::pair<Chromosome*, usize>
     if (c && !this->argv_json.empty()) {
       c->write_metadata_attribute(this->argv_json);
     }
-    auto sleep_us = 100;
-    while (this->ok()) {  // Structuring the loop in this way allows us to sleep without
-                          // holding the mutex
-      sleep_us = std::min(500000, sleep_us * 2);
-      std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
+    // The first chromosome in the queue is ready to be written when either:
+    // - chrom == nullptr: this is the end-of-queue signal
+    // - count == ncells: we are done simulating the current chromosome
+    auto front_is_ready = [&]() {
+      if (progress_queue.empty()) {
+        return false;
+      }
+      const auto& [chrom, count] = progress_queue.front();
+      assert(count <= num_cells);
+      return chrom == nullptr || count == num_cells;
+    };
+
+    while (this->ok()) {
       {
-        std::scoped_lock lck(progress_queue_mtx);
-        if (progress_queue.empty()) {
-          // There are no contacts to write to disk at the moment. Go back to sleep
+        std::unique_lock lck(progress_queue_mtx);
+        // Worker threads notify progress_queue_cv as soon as a chromosome has been simulated. The
+        // timeout is only used to periodically check whether one of the worker threads failed
+        if (!progress_queue_cv.wait_for(lck, std::chrono::milliseconds(100), front_is_ready)) {
           continue;
         }
 
         // chrom == nullptr is the end-of-queue signal
-        if (auto& [chrom, count] = progress_queue.front(); chrom == nullptr) {
+        if (progress_queue.front().first == nullptr) {
           break;
         }
-        // count == ncells signals that we are done simulating the current chromosome
-        else if (count == num_cells) {
-          chrom_to_be_written = chrom;
-          progress_queue.pop_front();
-        } else {
-          assert(count < num_cells);
-          continue;
-        }
+        chrom_to_be_written = progress_queue.front().first;
+        progress_queue.pop_front();
       }
-      sleep_us = 100;
+      ProfileCounters profile{};
       if (c) {  // c == nullptr only when --skip-output is used
         // NOTE here we have to use pointers instead of references because
         // chrom_to_be_written.contacts() == nullptr is used to signal an empty matrix.
@@ -171,10 +181,14 @@ void Simulation::write_contacts_to_disk(std::deque<std::pair<Chromosome*, usize>
                        chrom_to_be_written->name(), c->get_path());
         }
 
-        c->write_or_append_cmatrix_to_file(
-            chrom_to_be_written->contacts_ptr().get(), chrom_to_be_written->name(),
-            chrom_to_be_written->start_pos(), chrom_to_be_written->end_pos(),
-            chrom_to_be_written->size());
+        {
+          const ScopedTimer timer(profile.hdf5_write_ns);
+          c->write_or_append_cmatrix_to_file(
+              chrom_to_be_written->contacts_ptr().get(), chrom_to_be_written->name(),
+              chrom_to_be_written->start_pos(), chrom_to_be_written->end_pos(),
+              chrom_to_be_written->size(),
+              std::min(this->nthreads, Simulation::max_cooler_writer_threads));
+        }
 
         if (chrom_to_be_written->contacts_ptr()) {
           spdlog::info(
@@ -185,8 +199,23 @@ void Simulation::write_contacts_to_disk(std::deque<std::pair<Chromosome*, usize>
               static_cast<double>(chrom_to_be_written->contacts().npixels()) / 1.0e6);
         }
       }
+      if constexpr (utils::profiling_enabled()) {
+        if (chrom_to_be_written->contacts_ptr()) {
+          profile.contact_matrix_lock_waits =
+              chrom_to_be_written->contacts().get_n_of_lock_waits();
+        }
+        this->register_profile(this->nthreads, *chrom_to_be_written, profile);
+      }
       // Deallocate the contact matrix to free up unused memory
-      chrom_to_be_written->deallocate_contact_matrix();
+      if (chrom_to_be_written->deallocate_contact_matrix()) {
+        this->register_deallocation(this->compute_contact_matrix_size(*chrom_to_be_written));
+      }
+      {
+        // Wake up the main thread in case it is waiting for memory to be released. Locking the
+        // mutex ensures the notification cannot get lost
+        std::scoped_lock lck(progress_queue_mtx);
+        progress_queue_cv.notify_all();
+      }
     }
   } catch (const std::exception& err) {
     std::scoped_lock lck(this->_exceptions_mutex);
@@ -261,40 +290,173 @@ void Simulation::write_1d_lef_occupancy_to_disk() const {
   }
 }
 
+void Simulation::register_profile(const usize tid, const Chromosome& chrom,
+                                  const ProfileCounters& profile) {
+  if constexpr (utils::profiling_enabled()) {
+    std::scoped_lock lck(this->_profiles_mutex);
+    assert(tid < this->_thread_profiles.size());
+    assert(chrom.id() < this->_chrom_profiles.size());
+    this->_thread_profiles[tid] += profile;
+    this->_chrom_profiles[chrom.id()] += profile;
+  }
+}
+
+void Simulation::write_profile_report_to_disk() const {
+  if (!this->write_profile_report || this->path_to_profile_report.empty()) {
+    return;
+  }
+
+  try {
+    auto fp = fmt::output_file(this->path_to_profile_report.string());
+    fp.print(FMT_STRING("scope\tname\t{}\n"), ProfileCounters::tsv_header);
+
+    for (usize tid = 0; tid < this->_thread_profiles.size(); ++tid) {
+      const auto is_writer = tid == this->_thread_profiles.size() - 1;
+      fp.print(FMT_STRING("thread\t{}\t{}\n"), is_writer ? "writer" : fmt::to_string(tid),
+               this->_thread_profiles[tid].to_tsv());
+    }
+
+    // Contact matrix lock waits can only be attributed to chromosomes, so totals are computed by
+    // summing counters across chromosomes
+    ProfileCounters tot{};
+    for (const auto& chrom : this->_genome) {
+      const auto& profile = this->_chrom_profiles[chrom.id()];
+      fp.print(FMT_STRING("chrom\t{}\t{}\n"), chrom.name(), profile.to_tsv());
+      tot += profile;
+    }
+    fp.print(FMT_STRING("total\t-\t{}\n"), tot.to_tsv());
+  } catch (const std::exception& e) {
+    throw std::runtime_error(
+        fmt::format(FMT_STRING("An error occurred while writing the profile report to file {}: {}"),
+                    this->path_to_profile_report, e.what()));
+  }
+}
+
+// Round a candidate move and convert it to lef_move_t. Moves are clamped to the range of
+// lef_move_t first, as casting a double that does not fit in the target type is UB
+[[nodiscard]] static Simulation::lef_move_t to_lef_move(const double move) noexcept {
+  constexpr auto max_move = static_cast<double>(std::numeric_limits<Simulation::lef_move_t>::max());
+  return static_cast<Simulation::lef_move_t>(std::round(std::clamp(move, 0.0, max_move)));
+}
+
+// Assign the same move to all active LEFs.
+// Inactive LEFs are assigned a move of 0 without branching, so that the loop can be vectorized
+static void generate_fixed_moves(const absl::Span<const Lef> lefs,
+                                 const absl::Span<Simulation::lef_move_t> moves,
+                                 const Simulation::lef_move_t move) {
+  assert(lefs.size() == moves.size());
+  for (usize i = 0; i < lefs.size(); ++i) {
+    moves[i] = static_cast<Simulation::lef_move_t>(lefs[i].is_bound()) * move;
+  }
+}
+
 // Generate moves for extrusion units moving in the same direction
 template <class MoveGeneratorT>
-static void generate_moves_helper(const absl::Span<const Lef> lefs, const absl::Span<bp_t> moves,
+static void generate_moves_helper(const absl::Span<const Lef> lefs,
+                                  const absl::Span<Simulation::lef_move_t> moves,
                                   const double avg_extr_speed, const double extr_speed_std,
                                   random::PRNG_t& rand_eng) {
-  const bp_t move_int = static_cast<bp_t>(std::round(avg_extr_speed));
-  auto generate_move = [&](const auto& lef) -> bp_t {
-    // Don't bother geerating move for inactive LEFs
-    if (!lef.is_bound()) {
-      return 0;
-    }
+  assert(lefs.size() == moves.size());
+  // When std == 0 always use the avg. extrusion speed
+  if (extr_speed_std == 0.0) {
+    generate_fixed_moves(lefs, moves, to_lef_move(avg_extr_speed));
+    return;
+  }
 
-    // When std == 0 always return the avg. extrusion speed
-    if (extr_speed_std == 0.0) {
-      return move_int;
+  // Variates are only drawn for active LEFs: branching on Lef::is_bound() is required to preserve
+  // the sequence of numbers drawn from rand_eng, and thus the simulation output.
+  // Drawing the variates dominates the cost of this loop, and counting active LEFs, drawing
+  // variates in bulk and then scattering them without branching is not any faster when most LEFs
+  // are bound (which is the case after the burn-in phase).
+  // NOTE: on my laptop generating doubles from a normal distribution, rounding them, then
+  // casting double to uint is a lot faster (~4x) than drawing uints directly from a Poisson
+  // distr.
+  for (usize i = 0; i < lefs.size(); ++i) {
+    if (!lefs[i].is_bound()) {
+      moves[i] = 0;
+      continue;
     }
-    // NOTE: on my laptop generating doubles from a normal distribution, rounding them, then
-    // casting double to uint is a lot faster (~4x) than drawing uints directly from a Poisson
-    // distr.
-    return static_cast<bp_t>(
-        std::round(std::max(0.0, MoveGeneratorT{avg_extr_speed, extr_speed_std}(rand_eng))));
-  };
+    const auto move = MoveGeneratorT{avg_extr_speed, extr_speed_std}(rand_eng);
+    moves[i] = to_lef_move(move);
+  }
+}
 
-  for (usize i = 0; i < lefs.size(); ++i) {
-    moves[i] = generate_move(lefs[i]);
+// Same as above, but draws are batched (used when Config::fast_sampling is set).
+// When StochasticExtrSpeed is false, extr_speed_std is known to be 0
+template <bool StochasticExtrSpeed>
+static void generate_moves_helper(const absl::Span<const Lef> lefs,
+                                  const absl::Span<Simulation::lef_move_t> moves,
+                                  const double avg_extr_speed, const double extr_speed_std,
+                                  random::BatchPRNG& rand_eng) {
+  assert(lefs.size() == moves.size());
+  assert(StochasticExtrSpeed || extr_speed_std == 0.0);
+
+  // When std == 0 always use the avg. extrusion speed
+  if (!StochasticExtrSpeed || extr_speed_std == 0.0) {
+    generate_fixed_moves(lefs, moves, to_lef_move(avg_extr_speed));
+    return;
+  }
+
+  // NOTE: on my laptop generating doubles from a normal distribution, rounding them, then
+  // casting double to uint is a lot faster (~4x) than drawing uints directly from a Poisson
+  // distr.
+  // Normal variates are drawn in chunks, so that the PRNG can generate several numbers at once.
+  // Variates are drawn for inactive LEFs as well: this is cheaper than branching on is_bound()
+  std::array<double, 64> buff;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+  for (usize i = 0; i < lefs.size(); i += buff.size()) {
+    const auto chunk_size = std::min(buff.size(), lefs.size() - i);
+    const auto chunk = absl::MakeSpan(buff.data(), chunk_size);
+    rand_eng.fill_normal(chunk, avg_extr_speed, extr_speed_std);
+    for (usize j = 0; j < chunk_size; ++j) {
+      moves[i + j] =
+          static_cast<Simulation::lef_move_t>(lefs[i + j].is_bound()) * to_lef_move(chunk[j]);
+    }
   }
 }
 
 void Simulation::generate_moves(const Chromosome& chrom, const absl::Span<const Lef> lefs,
-                                const absl::Span<const usize> rev_lef_ranks,
-                                const absl::Span<const usize> fwd_lef_ranks,
-                                const absl::Span<bp_t> rev_moves, const absl::Span<bp_t> fwd_moves,
+                                const absl::Span<const lef_idx_t> rev_lef_ranks,
+                                const absl::Span<const lef_idx_t> fwd_lef_ranks,
+                                const absl::Span<lef_move_t> rev_moves,
+                                const absl::Span<lef_move_t> fwd_moves,
                                 const bool burnin_completed, random::PRNG_t& rand_eng,
                                 bool adjust_moves_) const noexcept(utils::ndebug_defined()) {
+  if (has_feature(this->enabled_features(), STOCHASTIC_EXTR_SPEED)) {
+    this->generate_moves<STOCHASTIC_EXTR_SPEED>(chrom, lefs, rev_lef_ranks, fwd_lef_ranks,
+                                                rev_moves, fwd_moves, burnin_completed, rand_eng,
+                                                adjust_moves_);
+  } else {
+    this->generate_moves<0>(chrom, lefs, rev_lef_ranks, fwd_lef_ranks, rev_moves, fwd_moves,
+                            burnin_completed, rand_eng, adjust_moves_);
+  }
+}
+
+void Simulation::generate_moves(const Chromosome& chrom, const absl::Span<const Lef> lefs,
+                                const absl::Span<const lef_idx_t> rev_lef_ranks,
+                                const absl::Span<const lef_idx_t> fwd_lef_ranks,
+                                const absl::Span<lef_move_t> rev_moves,
+                                const absl::Span<lef_move_t> fwd_moves,
+                                const bool burnin_completed, random::BatchPRNG& rand_eng,
+                                bool adjust_moves_) const noexcept(utils::ndebug_defined()) {
+  if (has_feature(this->enabled_features(), STOCHASTIC_EXTR_SPEED)) {
+    this->generate_moves<STOCHASTIC_EXTR_SPEED | FAST_SAMPLING>(
+        chrom, lefs, rev_lef_ranks, fwd_lef_ranks, rev_moves, fwd_moves, burnin_completed,
+        rand_eng, adjust_moves_);
+  } else {
+    this->generate_moves<FAST_SAMPLING>(chrom, lefs, rev_lef_ranks, fwd_lef_ranks, rev_moves,
+                                        fwd_moves, burnin_completed, rand_eng, adjust_moves_);
+  }
+}
+
+template <u8f Features>
+void Simulation::generate_moves(const Chromosome& chrom, const absl::Span<const Lef> lefs,
+                                const absl::Span<const lef_idx_t> rev_lef_ranks,
+                                const absl::Span<const lef_idx_t> fwd_lef_ranks,
+                                const absl::Span<lef_move_t> rev_moves,
+                                const absl::Span<lef_move_t> fwd_moves,
+                                const bool burnin_completed,
+                                epoch_rand_eng_t<Features>& rand_eng,
+                                bool adjust_moves_) const noexcept(utils::ndebug_defined()) {
   {
     assert(lefs.size() == fwd_lef_ranks.size());
     assert(lefs.size() == rev_lef_ranks.size());
@@ -306,11 +468,23 @@ void Simulation::generate_moves(const Chromosome& chrom, const absl::Span<const
       burnin_completed ? this->rev_extrusion_speed : this->rev_extrusion_speed_burnin);
   const auto fwd_extr_speed = static_cast<double>(
       burnin_completed ? this->fwd_extrusion_speed : this->fwd_extrusion_speed_burnin);
-
-  generate_moves_helper<lef_move_generator_t>(lefs, rev_moves, rev_extr_speed,
-                                              rev_extrusion_speed_std, rand_eng);
-  generate_moves_helper<lef_move_generator_t>(lefs, fwd_moves, fwd_extr_speed,
-                                              fwd_extrusion_speed_std, rand_eng);
+  // Extrusion speeds that do not fit in a lef_move_t are rejected by the CLI. Moves drawn from
+  // the tails of the normal distribution are clamped by to_lef_move()
+  assert(rev_extr_speed <= static_cast<double>(std::numeric_limits<lef_move_t>::max()));
+  assert(fwd_extr_speed <= static_cast<double>(std::numeric_limits<lef_move_t>::max()));
+
+  if constexpr (has_feature(Features, FAST_SAMPLING)) {
+    constexpr auto stochastic_extr_speed = has_feature(Features, STOCHASTIC_EXTR_SPEED);
+    generate_moves_helper<stochastic_extr_speed>(lefs, rev_moves, rev_extr_speed,
+                                                 rev_extrusion_speed_std, rand_eng);
+    generate_moves_helper<stochastic_extr_speed>(lefs, fwd_moves, fwd_extr_speed,
+                                                 fwd_extrusion_speed_std, rand_eng);
+  } else {
+    generate_moves_helper<lef_move_generator_t>(lefs, rev_moves, rev_extr_speed,
+                                                rev_extrusion_speed_std, rand_eng);
+    generate_moves_helper<lef_move_generator_t>(lefs, fwd_moves, fwd_extr_speed,
+                                                fwd_extrusion_speed_std, rand_eng);
+  }
 
   if (adjust_moves_) {  // Adjust moves of consecutive extr. units to make LEF behavior more
     // realistic See comments in adjust_moves_of_consecutive_extr_units for more
@@ -323,27 +497,32 @@ void Simulation::generate_moves(const Chromosome& chrom, const absl::Span<const
 }
 
 void Simulation::clamp_moves(const Chromosome& chrom, const absl::Span<const Lef> lefs,
-                             const absl::Span<bp_t> rev_moves,
-                             const absl::Span<bp_t> fwd_moves) noexcept {
+                             const absl::Span<lef_move_t> rev_moves,
+                             const absl::Span<lef_move_t> fwd_moves) noexcept {
+  assert(lefs.size() == rev_moves.size());
+  assert(lefs.size() == fwd_moves.size());
+  // Inactive LEFs have both units parked at bp_t max and moves of 0. Clamping their moves is a
+  // no-op (the distance to the chromosome boundary wraps around, but std::min() always picks 0),
+  // so we can avoid branching on Lef::is_bound() and let the compiler vectorize the loop
+  const auto start_pos = chrom.start_pos();
+  const auto last_pos = chrom.end_pos() - 1;
   for (usize i = 0; i < lefs.size(); ++i) {
-    if (!lefs[i].is_bound()) {
-      assert(rev_moves[i] == 0);
-      assert(fwd_moves[i] == 0);
-      continue;
-    }
-
-    assert(lefs[i].rev_unit.pos() >= chrom.start_pos());
-    assert(lefs[i].fwd_unit.pos() < chrom.end_pos());
-    rev_moves[i] = std::min(rev_moves[i], lefs[i].rev_unit.pos() - chrom.start_pos());
-    fwd_moves[i] = std::min(fwd_moves[i], chrom.end_pos() - lefs[i].fwd_unit.pos() - 1);
+    assert(lefs[i].is_bound() || (rev_moves[i] == 0 && fwd_moves[i] == 0));
+    assert(!lefs[i].is_bound() || lefs[i].rev_unit.pos() >= start_pos);
+    assert(!lefs[i].is_bound() || lefs[i].fwd_unit.pos() <= last_pos);
+    rev_moves[i] = static_cast<lef_move_t>(
+        std::min<bp_t>(rev_moves[i], lefs[i].rev_unit.pos() - start_pos));
+    fwd_moves[i] = static_cast<lef_move_t>(
+        std::min<bp_t>(fwd_moves[i], last_pos - lefs[i].fwd_unit.pos()));
   }
 }
 
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void Simulation::adjust_moves_of_consecutive_extr_units(
     [[maybe_unused]] const Chromosome& chrom, absl::Span<const Lef> lefs,
-    absl::Span<const usize> rev_lef_ranks, absl::Span<const usize> fwd_lef_ranks,
-    absl::Span<bp_t> rev_moves, absl::Span<bp_t> fwd_moves) noexcept(utils::ndebug_defined()) {
+    absl::Span<const lef_idx_t> rev_lef_ranks, absl::Span<const lef_idx_t> fwd_lef_ranks,
+    absl::Span<lef_move_t> rev_moves,
+    absl::Span<lef_move_t> fwd_moves) noexcept(utils::ndebug_defined()) {
   assert(!lefs.empty());
 
   // Loop over pairs of consecutive extr. units.
@@ -371,7 +550,7 @@ void Simulation::adjust_moves_of_consecutive_extr_units(
       // This mimics what would probably happen in a real system, where extr. unit 2 would most
       // likely push extr. unit 1, temporarily increasing extr. speed of unit 1.
       if (pos2 <= pos1) {
-        rev_moves[i1] += (pos1 - pos2) + 1;
+        rev_moves[i1] += static_cast<lef_move_t>((pos1 - pos2) + 1);
       }
     }
   }
@@ -392,120 +571,154 @@ void Simulation::adjust_moves_of_consecutive_extr_units(
       const auto pos2 = lefs[i2].fwd_unit.pos() + fwd_moves[i2];
 
       if (pos1 >= pos2) {
-        fwd_moves[i2] += (pos1 - pos2) + 1;
+        fwd_moves[i2] += static_cast<lef_move_t>((pos1 - pos2) + 1);
       }
     }
   }
 }
 
+// Repair the order of a rank buffer that was sorted in the previous epoch.
+// Unbound LEFs are moved to the end of the buffer, while bound LEFs are ranked using a bounded
+// insertion sort. Units that would have to travel more than max_displacement positions (usually
+// LEFs that were bound in the current epoch) are set aside, sorted and then merged back.
+// Returns false when too many units are out of place, in which case the buffer is left in a
+// valid but unsorted state and should be sorted from scratch.
+template <typename RankComparator>
+[[nodiscard]] static bool repair_lef_ranks(const absl::Span<const Lef> lefs,
+                                           const absl::Span<Simulation::lef_idx_t> rank_buff,
+                                           const RankComparator& comp) noexcept {
+  constexpr usize max_displacement = 32;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
+  std::array<Simulation::lef_idx_t, 256> displaced_buff;
+
+  // Move unbound LEFs to the end of the buffer while preserving the order of bound LEFs.
+  // Unbound LEFs all compare equal, so their relative order does not matter
+  usize num_bound = 0;
+  for (usize i = 0; i < rank_buff.size(); ++i) {
+    if (MODLE_LIKELY(lefs[rank_buff[i]].is_bound())) {
+      std::swap(rank_buff[num_bound++], rank_buff[i]);
+    }
+  }
+
+  // Bounded insertion sort: units that are only slightly out of place are fixed in place, while
+  // the others are moved to displaced_buff
+  usize num_ranked = 0;
+  usize num_displaced = 0;
+  for (usize i = 0; i < num_bound; ++i) {
+    const auto r = rank_buff[i];
+    const auto last = num_ranked > max_displacement ? num_ranked - max_displacement : usize(0);
+    auto j = num_ranked;
+    while (j != last && comp(r, rank_buff[j - 1])) {
+      --j;
+    }
+
+    if (MODLE_UNLIKELY(j != 0 && comp(r, rank_buff[j - 1]))) {
+      if (MODLE_UNLIKELY(num_displaced == displaced_buff.size())) {
+        return false;
+      }
+      displaced_buff[num_displaced++] = r;
+      continue;
+    }
+
+    std::move_backward(rank_buff.begin() + static_cast<isize>(j),
+                       rank_buff.begin() + static_cast<isize>(num_ranked),
+                       rank_buff.begin() + static_cast<isize>(num_ranked + 1));
+    rank_buff[j] = r;
+    ++num_ranked;
+  }
+
+  if (MODLE_LIKELY(num_displaced == 0)) {
+    return true;
+  }
+
+  // Merge displaced units back into the buffer starting from the back. The free slots between
+  // num_ranked and num_bound are used as scratch space
+  assert(num_ranked + num_displaced == num_bound);
+  const auto displaced = absl::MakeSpan(displaced_buff.data(), num_displaced);
+  cppsort::pdq_sort(displaced.begin(), displaced.end(), comp);
+  auto i = num_ranked;
+  auto j = num_displaced;
+  for (auto k = num_bound; j != 0; --k) {
+    if (i != 0 && comp(displaced[j - 1], rank_buff[i - 1])) {
+      rank_buff[k - 1] = rank_buff[--i];
+    } else {
+      rank_buff[k - 1] = displaced[--j];
+    }
+  }
+  return true;
+}
+
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void Simulation::rank_lefs(const absl::Span<const Lef> lefs,
-                           const absl::Span<usize> rev_lef_rank_buff,
-                           const absl::Span<usize> fwd_lef_rank_buff,
+                           const absl::Span<lef_idx_t> rev_lef_rank_buff,
+                           const absl::Span<lef_idx_t> fwd_lef_rank_buff,
                            bool ranks_are_partially_sorted,
                            bool init_buffers) noexcept(utils::ndebug_defined()) {
   assert(lefs.size() == fwd_lef_rank_buff.size());
   assert(lefs.size() == rev_lef_rank_buff.size());
 
+  // Ties are broken using the binding epoch, so that no separate pass is required to deal with them
+  // (rev units are sorted by ascending epoch, fwd units by descending epoch)
   auto rev_comparator = [&](const auto r1, const auto r2) constexpr noexcept {
     assert(r1 < lefs.size());
     assert(r2 < lefs.size());
-    return lefs[r1].rev_unit.pos() < lefs[r2].rev_unit.pos();
+    const auto& lef1 = lefs[r1];
+    const auto& lef2 = lefs[r2];
+    if (MODLE_LIKELY(lef1.rev_unit.pos() != lef2.rev_unit.pos())) {
+      return lef1.rev_unit.pos() < lef2.rev_unit.pos();
+    }
+    return lef1.binding_epoch < lef2.binding_epoch;
   };
 
   auto fwd_comparator = [&](const auto r1, const auto r2) constexpr noexcept {
     assert(r1 < lefs.size());
     assert(r2 < lefs.size());
-    return lefs[r1].fwd_unit.pos() < lefs[r2].fwd_unit.pos();
+    const auto& lef1 = lefs[r1];
+    const auto& lef2 = lefs[r2];
+    if (MODLE_LIKELY(lef1.fwd_unit.pos() != lef2.fwd_unit.pos())) {
+      return lef1.fwd_unit.pos() < lef2.fwd_unit.pos();
+    }
+    return lef2.binding_epoch < lef1.binding_epoch;
   };
 
   if (MODLE_UNLIKELY(init_buffers)) {  // Init rank buffers
-    std::iota(fwd_lef_rank_buff.begin(), fwd_lef_rank_buff.end(), 0);
-    std::iota(rev_lef_rank_buff.begin(), rev_lef_rank_buff.end(), 0);
+    std::iota(fwd_lef_rank_buff.begin(), fwd_lef_rank_buff.end(), lef_idx_t(0));
+    std::iota(rev_lef_rank_buff.begin(), rev_lef_rank_buff.end(), lef_idx_t(0));
   }
 
-  if (MODLE_LIKELY(ranks_are_partially_sorted)) {
-    cppsort::split_sort(rev_lef_rank_buff.begin(), rev_lef_rank_buff.end(), rev_comparator);
-    cppsort::split_sort(fwd_lef_rank_buff.begin(), fwd_lef_rank_buff.end(), fwd_comparator);
-  } else {
-    // Fallback to pattern-defeating quicksort we have no information regarding the level of
-    // pre-sortedness of LEFs
+  // Ranks computed in the previous epoch are only off by the few units that moved past each
+  // other, were bound or were released, so we try to repair them locally.
+  // Fallback to pattern-defeating quicksort when we have no information regarding the level of
+  // pre-sortedness of LEFs or when too many units are out of place
+  if (!ranks_are_partially_sorted || !repair_lef_ranks(lefs, rev_lef_rank_buff, rev_comparator)) {
     cppsort::pdq_sort(rev_lef_rank_buff.begin(), rev_lef_rank_buff.end(), rev_comparator);
-    cppsort::pdq_sort(fwd_lef_rank_buff.begin(), fwd_lef_rank_buff.end(), fwd_comparator);
   }
-
-  // TODO Figure out a better way to deal with ties
-  usize begin{};
-  usize end{};
-  for (usize i = 1; i < rev_lef_rank_buff.size(); ++i) {
-    const auto& r1 = rev_lef_rank_buff[i - 1];
-    const auto& r2 = rev_lef_rank_buff[i];
-    if (MODLE_UNLIKELY(lefs[r1].rev_unit.pos() == lefs[r2].rev_unit.pos())) {
-      begin = i - 1;
-      for (; i < rev_lef_rank_buff.size(); ++i) {
-        const auto& r11 = rev_lef_rank_buff[i - 1];
-        const auto& r22 = rev_lef_rank_buff[i];
-        if (lefs[r11].rev_unit.pos() != lefs[r22].rev_unit.pos()) {
-          break;
-        }
-      }
-
-      end = i;
-      cppsort::insertion_sort(rev_lef_rank_buff.begin() + begin, rev_lef_rank_buff.begin() + end,
-                              [&lefs](const auto r11, const auto r22) {
-                                assert(r11 < lefs.size());
-                                assert(r22 < lefs.size());
-                                return lefs[r11].binding_epoch < lefs[r22].binding_epoch;
-                              });
-      // begin = end;
-    }
+  if (!ranks_are_partially_sorted || !repair_lef_ranks(lefs, fwd_lef_rank_buff, fwd_comparator)) {
+    cppsort::pdq_sort(fwd_lef_rank_buff.begin(), fwd_lef_rank_buff.end(), fwd_comparator);
   }
 
-  for (usize i = 1; i < fwd_lef_rank_buff.size(); ++i) {
-    const auto& r1 = fwd_lef_rank_buff[i - 1];
-    const auto& r2 = fwd_lef_rank_buff[i];
-    if (MODLE_UNLIKELY(lefs[r1].fwd_unit.pos() == lefs[r2].fwd_unit.pos())) {
-      begin = i - 1;
-      for (; i < fwd_lef_rank_buff.size(); ++i) {
-        const auto& r11 = fwd_lef_rank_buff[i - 1];
-        const auto& r22 = fwd_lef_rank_buff[i];
-        if (lefs[r11].fwd_unit.pos() != lefs[r22].fwd_unit.pos()) {
-          break;
-        }
-      }
-
-      end = i;
-      cppsort::insertion_sort(fwd_lef_rank_buff.begin() + begin, fwd_lef_rank_buff.begin() + end,
-                              [&lefs](const auto r11, const auto r22) {
-                                assert(r11 < lefs.size());
-                                assert(r22 < lefs.size());
-                                return lefs[r22].binding_epoch < lefs[r11].binding_epoch;
-                              });
-      // begin = end;
-    }
-  }
+  assert(std::is_sorted(rev_lef_rank_buff.begin(), rev_lef_rank_buff.end(), rev_comparator));
+  assert(std::is_sorted(fwd_lef_rank_buff.begin(), fwd_lef_rank_buff.end(), fwd_comparator));
 }
 
-void Simulation::extrude([[maybe_unused]] const Chromosome& chrom, const absl::Span<Lef> lefs,
-                         const absl::Span<const bp_t> rev_moves,
-                         const absl::Span<const bp_t> fwd_moves) noexcept(utils::ndebug_defined()) {
+void Simulation::extrude(
+    [[maybe_unused]] const Chromosome& chrom, const absl::Span<Lef> lefs,
+    const absl::Span<const lef_move_t> rev_moves,
+    const absl::Span<const lef_move_t> fwd_moves) noexcept(utils::ndebug_defined()) {
   assert(lefs.size() == rev_moves.size());
   assert(lefs.size() == fwd_moves.size());
 
+  // Moves for inactive LEFs are always 0, so extruding them leaves their units parked at bp_t max.
+  // This allows us to avoid branching on Lef::is_bound() (see also clamp_moves())
   for (usize i = 0; i < lefs.size(); ++i) {
     auto& lef = lefs[i];
     const auto& rev_move = rev_moves[i];
     const auto& fwd_move = fwd_moves[i];
-    if (MODLE_UNLIKELY(!lef.is_bound())) {  // Do not process inactive LEFs
-      continue;
-    }
-    assert(lef.rev_unit.pos() >= chrom.start_pos() + rev_move);
-    assert(lef.fwd_unit.pos() + fwd_move < chrom.end_pos());
+    assert(lef.is_bound() || (rev_move == 0 && fwd_move == 0));
+    assert(!lef.is_bound() || lef.rev_unit.pos() >= chrom.start_pos() + rev_move);
+    assert(!lef.is_bound() || lef.fwd_unit.pos() + fwd_move < chrom.end_pos());
 
-    // Extrude rev unit
     lef.rev_unit._pos -= rev_move;  // Advance extr. unit in 3'-5' direction
-
-    // Extrude fwd unit
     lef.fwd_unit._pos += fwd_move;  // Advance extr. unit in 5'-3' direction
     assert(lef.rev_unit.pos() <= lef.fwd_unit.pos());
   }
@@ -513,7 +726,8 @@ void Simulation::extrude([[maybe_unused]] const Chromosome& chrom, const absl::S
 
 std::pair<bp_t, bp_t> Simulation::compute_lef_lef_collision_pos(const ExtrusionUnit& rev_unit,
                                                                 const ExtrusionUnit& fwd_unit,
-                                                                bp_t rev_move, bp_t fwd_move) {
+                                                                lef_move_t rev_move,
+                                                                lef_move_t fwd_move) {
   const auto& rev_speed = rev_move;
   const auto& fwd_speed = fwd_move;
   const auto& rev_pos = rev_unit.pos();
@@ -591,6 +805,79 @@ usize Simulation::release_lefs(const absl::Span<Lef> lefs, const ExtrusionBarrie
   return lefs_released;
 }
 
+usize Simulation::release_lefs(const absl::Span<Lef> lefs, const ExtrusionBarriers& barriers,
+                               const absl::Span<const CollisionT> rev_collisions,
+                               const absl::Span<const CollisionT> fwd_collisions,
+                               const absl::Span<LefRelease> releases, const usize current_epoch,
+                               random::BatchPRNG& rand_eng,
+                               const bool burnin_completed) const noexcept {
+  assert(releases.size() >= lefs.size());
+  auto count_hard_collisions = [&](const auto j) {
+    assert(lefs[j].is_bound());
+
+    auto is_lef_bar_hard_collision = [&](const auto c, dna::Direction d) {
+      assert(d == dna::REV || d == dna::FWD);
+      if (c.collision_occurred(CollisionT::LEF_BAR)) {
+        assert(c.decode_index() <= barriers.size());
+        return barriers.direction(c.decode_index()) == d;
+      }
+      return false;
+    };
+
+    return static_cast<u8f>(is_lef_bar_hard_collision(rev_collisions[j], dna::REV) +
+                            is_lef_bar_hard_collision(fwd_collisions[j], dna::FWD));
+  };
+
+  auto compute_lef_unloader_affinity = [&](const auto num_hard_collisions) {
+    switch (num_hard_collisions) {
+      case 0:
+        return 1.0;
+      case 1:
+        return 1.0 / this->soft_stall_lef_stability_multiplier;
+      case 2:
+        return 1.0 / this->hard_stall_lef_stability_multiplier;
+      default:
+        MODLE_UNREACHABLE_CODE;
+    }
+  };
+
+  const auto& base_prob_lef_release =
+      burnin_completed ? this->prob_of_lef_release : this->prob_of_lef_release_burnin;
+  // Hazards 0-2 are used after the burn-in phase, while 3-5 are used during the burn-in phase
+  const auto hazard_offset = burnin_completed ? u8f(0) : u8f(3);
+
+  usize lefs_released = 0;
+  for (usize i = 0; i < lefs.size(); ++i) {
+    auto& lef = lefs[i];
+    if (MODLE_UNLIKELY(!lef.is_bound())) {
+      continue;
+    }
+
+    const auto num_hard_collisions = count_hard_collisions(i);
+    const auto hazard = static_cast<u8f>(num_hard_collisions + hazard_offset);
+    auto& release = releases[i];
+    // Reschedule the release when the LEF was (re)bound or when its hazard changed
+    if (MODLE_UNLIKELY(release.hazard != hazard || release.binding_epoch != lef.binding_epoch)) {
+      const auto p = compute_lef_unloader_affinity(num_hard_collisions) * base_prob_lef_release;
+      assert(p >= 0 && p <= 1);
+      const auto trials = random::geometric_trials(p, rand_eng);
+      release.epoch = trials == (std::numeric_limits<u64>::max)()
+                          ? (std::numeric_limits<usize>::max)()
+                          : current_epoch + static_cast<usize>(trials - 1);
+      release.binding_epoch = lef.binding_epoch;
+      release.hazard = hazard;
+    }
+
+    assert(release.epoch >= current_epoch);
+    if (MODLE_UNLIKELY(release.epoch == current_epoch)) {
+      ++lefs_released;
+      lef.release();
+      release = LefRelease{};
+    }
+  }
+  return lefs_released;
+}
+
 BS::thread_pool Simulation::instantiate_thread_pool() const {
   return BS::thread_pool{utils::conditional_static_cast<BS::concurrency_t>(this->nthreads)};
 }
@@ -644,49 +931,32 @@ Simulation::TaskPW Simulation::TaskPW::from_string(std::string_view serialized_t
   const std::vector<std::string_view> toks = absl::StrSplit(serialized_task, sep);
   assert(toks.size() == ntoks);
 
-  TaskPW t;
   try {
+    task_file::Record r{};
     usize i = 0;
-    utils::parse_numeric_or_throw(toks[i++], t.id);
+    utils::parse_numeric_or_throw(toks[i++], r.id);
     const auto& chrom_name = toks[i++];
-    utils::parse_numeric_or_throw(toks[i++], t.cell_id);
-    utils::parse_numeric_or_throw(toks[i++], t.num_target_epochs);
-    utils::parse_numeric_or_throw(toks[i++], t.num_target_contacts);
-    utils::parse_numeric_or_throw(toks[i++], t.num_lefs);
-    const auto num_barriers_expected = utils::parse_numeric_or_throw<usize>(toks[i++]);
-    utils::parse_numeric_or_throw(toks[i++], t.deletion_begin);
-    utils::parse_numeric_or_throw(toks[i++], t.deletion_size);
-    utils::parse_numeric_or_throw(toks[i++], t.window_start);
-    utils::parse_numeric_or_throw(toks[i++], t.window_end);
-    utils::parse_numeric_or_throw(toks[i++], t.active_window_start);
-    utils::parse_numeric_or_throw(toks[i++], t.active_window_end);
-    const auto num_feats1_expected = utils::parse_numeric_or_throw<usize>(toks[i++]);
-    const auto num_feats2_expected = utils::parse_numeric_or_throw<usize>(toks[i++]);
+    utils::parse_numeric_or_throw(toks[i++], r.cell_id);
+    utils::parse_numeric_or_throw(toks[i++], r.num_target_epochs);
+    utils::parse_numeric_or_throw(toks[i++], r.num_target_contacts);
+    utils::parse_numeric_or_throw(toks[i++], r.num_lefs);
+    utils::parse_numeric_or_throw(toks[i++], r.num_barriers);
+    utils::parse_numeric_or_throw(toks[i++], r.deletion_begin);
+    utils::parse_numeric_or_throw(toks[i++], r.deletion_size);
+    utils::parse_numeric_or_throw(toks[i++], r.window_start);
+    utils::parse_numeric_or_throw(toks[i++], r.window_end);
+    utils::parse_numeric_or_throw(toks[i++], r.active_window_start);
+    utils::parse_numeric_or_throw(toks[i++], r.active_window_end);
+    utils::parse_numeric_or_throw(toks[i++], r.num_feats1);
+    utils::parse_numeric_or_throw(toks[i++], r.num_feats2);
 
     auto chrom_it = genome.find(chrom_name);
     if (chrom_it == genome.end()) {
       throw std::runtime_error(
           fmt::format(FMT_STRING("Unable to find a chromosome named \"{}\""), chrom_name));
     }
-    t.chrom = &(*chrom_it);
-
-    if (t.chrom->num_barriers() < num_barriers_expected) {
-      throw std::runtime_error(
-          fmt::format(FMT_STRING("Expected {} extrusion barriers for chromosome \"{}\". Found {}"),
-                      num_barriers_expected, t.chrom->name(), t.chrom->num_barriers()));
-    }
-    t.barriers = absl::MakeConstSpan(t.chrom->barriers().data());
-
-    assert(t.chrom->get_features().size() == 2);
-    Simulation::map_barriers_to_window(t, *t.chrom);
-    Simulation::map_features_to_window(t, *t.chrom);
-
-    if (t.feats1.size() != num_feats1_expected || t.feats2.size() != num_feats2_expected) {
-      throw std::runtime_error(fmt::format(
-          FMT_STRING("Expected {} and {} features for chromosome \"{}\". Found {} and {}"),
-          num_feats1_expected, num_feats2_expected, t.chrom->name(), t.feats1.size(),
-          t.feats2.size()));
-    }
+    r.chrom_id = chrom_it->id();
+    return TaskPW::from_record(r, *chrom_it);
 
   } catch (const std::runtime_error& e) {
     throw std::runtime_error(
@@ -695,13 +965,74 @@ Simulation::TaskPW Simulation::TaskPW::from_string(std::string_view serialized_t
                                "Reason: {}"),
                     toks.front(), serialized_task, e.what()));
   }
+}
+
+Simulation::TaskPW Simulation::TaskPW::from_record(const task_file::Record& record,
+                                                   Chromosome& chrom) {
+  TaskPW t;
+  t.id = utils::conditional_static_cast<usize>(record.id);
+  t.chrom = &chrom;
+  t.cell_id = utils::conditional_static_cast<usize>(record.cell_id);
+  t.num_target_epochs = utils::conditional_static_cast<usize>(record.num_target_epochs);
+  t.num_target_contacts = utils::conditional_static_cast<usize>(record.num_target_contacts);
+  t.num_lefs = utils::conditional_static_cast<usize>(record.num_lefs);
+  t.deletion_begin = utils::conditional_static_cast<bp_t>(record.deletion_begin);
+  t.deletion_size = utils::conditional_static_cast<bp_t>(record.deletion_size);
+  t.window_start = utils::conditional_static_cast<bp_t>(record.window_start);
+  t.window_end = utils::conditional_static_cast<bp_t>(record.window_end);
+  t.active_window_start = utils::conditional_static_cast<bp_t>(record.active_window_start);
+  t.active_window_end = utils::conditional_static_cast<bp_t>(record.active_window_end);
+
+  if (t.chrom->num_barriers() < record.num_barriers) {
+    throw std::runtime_error(
+        fmt::format(FMT_STRING("Expected {} extrusion barriers for chromosome \"{}\". Found {}"),
+                    record.num_barriers, t.chrom->name(), t.chrom->num_barriers()));
+  }
+  t.barriers = absl::MakeConstSpan(t.chrom->barriers().data());
+
+  assert(t.chrom->get_features().size() == 2);
+  Simulation::map_barriers_to_window(t, *t.chrom);
+  Simulation::map_features_to_window(t, *t.chrom);
+
+  if (t.feats1.size() != record.num_feats1 || t.feats2.size() != record.num_feats2) {
+    throw std::runtime_error(fmt::format(
+        FMT_STRING("Expected {} and {} features for chromosome \"{}\". Found {} and {}"),
+        record.num_feats1, record.num_feats2, t.chrom->name(), t.feats1.size(), t.feats2.size()));
+  }
   return t;
 }
 
+task_file::Record Simulation::TaskPW::to_record() const {
+  assert(this->chrom);
+  return task_file::Record{this->id,
+                           this->chrom->id(),
+                           this->cell_id,
+                           this->num_target_epochs,
+                           this->num_target_contacts,
+                           this->num_lefs,
+                           this->barriers.size(),
+                           this->deletion_begin,
+                           this->deletion_size,
+                           this->window_start,
+                           this->window_end,
+                           this->active_window_start,
+                           this->active_window_end,
+                           this->feats1.size(),
+                           this->feats2.size()};
+}
+
 void Simulation::State::resize_buffers(usize new_size) {
   if (new_size == (std::numeric_limits<usize>::max)()) {
     new_size = this->num_lefs;
   }
+  // Collisions store the index of the LEF or barrier involved using fewer than 32 bits
+  if (MODLE_UNLIKELY(new_size > CollisionT::max_index() ||
+                     this->barriers.size() > CollisionT::max_index())) {
+    throw std::runtime_error(fmt::format(
+        FMT_STRING("simulating {} LEFs and {} extrusion barriers on a single chromosome is not "
+                   "supported: the maximum number of LEFs and barriers is {}"),
+        new_size, this->barriers.size(), CollisionT::max_index()));
+  }
   lef_buff.resize(new_size);
   rank_buff1.resize(new_size);
   rank_buff2.resize(new_size);
@@ -710,18 +1041,19 @@ void Simulation::State::resize_buffers(usize new_size) {
   idx_buff.resize(new_size);
   collision_buff1.resize(new_size);
   collision_buff2.resize(new_size);
+  release_buff.resize(new_size);
 }
 
 void Simulation::State::reset_buffers() {  // TODO figure out which resets are redundant
   std::for_each(lef_buff.begin(), lef_buff.end(), [](auto& lef) { lef.reset(); });
-  std::iota(rank_buff1.begin(), rank_buff1.end(), 0);
+  std::iota(rank_buff1.begin(), rank_buff1.end(), lef_idx_t(0));
   std::copy(rank_buff1.begin(), rank_buff1.end(), rank_buff2.begin());
   std::fill(moves_buff1.begin(), moves_buff1.end(), 0);
   std::fill(moves_buff2.begin(), moves_buff2.end(), 0);
   std::for_each(collision_buff1.begin(), collision_buff1.end(), [&](auto& c) { c.clear(); });
   std::for_each(collision_buff2.begin(), collision_buff2.end(), [&](auto& c) { c.clear(); });
-  cfx_of_variation_buff.clear();
-  avg_loop_size_buff.clear();
+  std::fill(release_buff.begin(), release_buff.end(), LefRelease{});
+  burnin_history.clear();
 }
 
 absl::Span<Lef> Simulation::State::get_lefs(usize size) noexcept {
@@ -731,25 +1063,25 @@ absl::Span<Lef> Simulation::State::get_lefs(usize size) noexcept {
   assert(size <= this->lef_buff.size());
   return absl::MakeSpan(this->lef_buff.data(), size);
 }
-absl::Span<usize> Simulation::State::get_rev_ranks(usize size) noexcept {
+auto Simulation::State::get_rev_ranks(usize size) noexcept -> absl::Span<lef_idx_t> {
   if (size == State::npos) {
     size = this->num_active_lefs;
   }
   return absl::MakeSpan(this->rank_buff1.data(), size);
 }
-absl::Span<usize> Simulation::State::get_fwd_ranks(usize size) noexcept {
+auto Simulation::State::get_fwd_ranks(usize size) noexcept -> absl::Span<lef_idx_t> {
   if (size == State::npos) {
     size = this->num_active_lefs;
   }
   return absl::MakeSpan(this->rank_buff2.data(), size);
 }
-absl::Span<bp_t> Simulation::State::get_rev_moves(usize size) noexcept {
+auto Simulation::State::get_rev_moves(usize size) noexcept -> absl::Span<lef_move_t> {
   if (size == State::npos) {
     size = this->num_active_lefs;
   }
   return absl::MakeSpan(this->moves_buff1.data(), size);
 }
-absl::Span<bp_t> Simulation::State::get_fwd_moves(usize size) noexcept {
+auto Simulation::State::get_fwd_moves(usize size) noexcept -> absl::Span<lef_move_t> {
   if (size == State::npos) {
     size = this->num_active_lefs;
   }
@@ -773,12 +1105,13 @@ auto Simulation::State::get_fwd_collisions(usize size) noexcept -> absl::Span<Co
   }
   return absl::MakeSpan(this->collision_buff2.data(), size);
 }
-std::deque<double>& Simulation::State::get_cfx_of_variation() noexcept {
-  return this->cfx_of_variation_buff;
-}
-std::deque<double>& Simulation::State::get_avg_loop_sizes() noexcept {
-  return this->avg_loop_size_buff;
+auto Simulation::State::get_lef_releases(usize size) noexcept -> absl::Span<LefRelease> {
+  if (size == State::npos) {
+    size = this->num_active_lefs;
+  }
+  return absl::MakeSpan(this->release_buff.data(), size);
 }
+BurninTracker& Simulation::State::get_burnin_history() noexcept { return this->burnin_history; }
 
 absl::Span<const Lef> Simulation::State::get_lefs(usize size) const noexcept {
   if (size == State::npos) {
@@ -787,25 +1120,25 @@ absl::Span<const Lef> Simulation::State::get_lefs(usize size) const noexcept {
   return absl::MakeConstSpan(this->lef_buff.data(), size);
 }
 
-absl::Span<const usize> Simulation::State::get_rev_ranks(usize size) const noexcept {
+auto Simulation::State::get_rev_ranks(usize size) const noexcept -> absl::Span<const lef_idx_t> {
   if (size == State::npos) {
     size = this->num_active_lefs;
   }
   return absl::MakeConstSpan(this->rank_buff1.data(), size);
 }
-absl::Span<const usize> Simulation::State::get_fwd_ranks(usize size) const noexcept {
+auto Simulation::State::get_fwd_ranks(usize size) const noexcept -> absl::Span<const lef_idx_t> {
   if (size == State::npos) {
     size = this->num_active_lefs;
   }
   return absl::MakeConstSpan(this->rank_buff2.data(), size);
 }
-absl::Span<const bp_t> Simulation::State::get_rev_moves(usize size) const noexcept {
+auto Simulation::State::get_rev_moves(usize size) const noexcept -> absl::Span<const lef_move_t> {
   if (size == State::npos) {
     size = this->num_active_lefs;
   }
   return absl::MakeConstSpan(this->moves_buff1.data(), size);
 }
-absl::Span<const bp_t> Simulation::State::get_fwd_moves(usize size) const noexcept {
+auto Simulation::State::get_fwd_moves(usize size) const noexcept -> absl::Span<const lef_move_t> {
   if (size == State::npos) {
     size = this->num_active_lefs;
   }
@@ -831,11 +1164,15 @@ auto Simulation::State::get_fwd_collisions(usize size) const noexcept
   }
   return absl::MakeConstSpan(this->collision_buff2.data(), size);
 }
-const std::deque<double>& Simulation::State::get_cfx_of_variation() const noexcept {
-  return this->cfx_of_variation_buff;
+auto Simulation::State::get_lef_releases(usize size) const noexcept
+    -> absl::Span<const LefRelease> {
+  if (size == State::npos) {
+    size = this->num_active_lefs;
+  }
+  return absl::MakeConstSpan(this->release_buff.data(), size);
 }
-const std::deque<double>& Simulation::State::get_avg_loop_sizes() const noexcept {
-  return this->avg_loop_size_buff;
+const BurninTracker& Simulation::State::get_burnin_history() const noexcept {
+  return this->burnin_history;
 }
 
 bool Simulation::State::is_modle_pert_state() const noexcept { return !this->is_modle_sim_state(); }
@@ -844,6 +1181,16 @@ bool Simulation::State::is_modle_sim_state() const noexcept {
   return feats1.empty() && feats2.empty();
 }
 
+void Simulation::State::assign_barriers(const BaseTask& task) {
+  if (task.barrier_table) {
+    assert(task.barrier_table->size() == task.barriers.size());
+    this->barriers.assign(*task.barrier_table);
+    return;
+  }
+  // Tasks parsed from a task file do not come with a pre-built barrier table
+  this->barriers = ExtrusionBarriers{task.barriers.begin(), task.barriers.end()};
+}
+
 Simulation::State& Simulation::State::operator=(const Task& task) {
   this->epoch = 0;
   this->num_burnin_epochs = 0;
@@ -857,7 +1204,7 @@ Simulation::State& Simulation::State::operator=(const Task& task) {
   this->num_target_epochs = task.num_target_epochs;
   this->num_target_contacts = task.num_target_contacts;
   this->num_lefs = task.num_lefs;
-  this->barriers = ExtrusionBarriers{task.barriers.begin(), task.barriers.end()};
+  this->assign_barriers(task);
 
   this->deletion_begin = 0;
   this->deletion_size = 0;
@@ -873,6 +1220,8 @@ Simulation::State& Simulation::State::operator=(const Task& task) {
     this->contacts = this->chrom->contacts_ptr();
   }
   this->reference_contacts = nullptr;
+  this->reference_block_sums = nullptr;
+  this->window_snapshot = nullptr;
   return *this;
 }
 
@@ -889,7 +1238,7 @@ Simulation::State& Simulation::State::operator=(const TaskPW& task) {
   this->num_target_epochs = task.num_target_epochs;
   this->num_target_contacts = task.num_target_contacts;
   this->num_lefs = task.num_lefs;
-  this->barriers = ExtrusionBarriers{task.barriers.begin(), task.barriers.end()};
+  this->assign_barriers(task);
 
   this->deletion_begin = task.deletion_begin;
   this->deletion_size = task.deletion_size;
@@ -903,6 +1252,8 @@ Simulation::State& Simulation::State::operator=(const TaskPW& task) {
 
   assert(task.reference_contacts);
   this->reference_contacts = task.reference_contacts;
+  this->reference_block_sums = task.reference_block_sums;
+  this->window_snapshot = task.window_snapshot;
   return *this;
 }
 
@@ -924,8 +1275,8 @@ std::string Simulation::State::to_string() const noexcept {
 
 std::pair<usize, usize> Simulation::process_collisions(
     const Chromosome& chrom, const absl::Span<Lef> lefs, ExtrusionBarriers& barriers,
-    const absl::Span<usize> rev_lef_ranks, const absl::Span<usize> fwd_lef_ranks,
-    const absl::Span<bp_t> rev_moves, const absl::Span<bp_t> fwd_moves,
+    const absl::Span<lef_idx_t> rev_lef_ranks, const absl::Span<lef_idx_t> fwd_lef_ranks,
+    const absl::Span<lef_move_t> rev_moves, const absl::Span<lef_move_t> fwd_moves,
     const absl::Span<CollisionT> rev_collisions, const absl::Span<CollisionT> fwd_collisions,
     random::PRNG_t& rand_eng) const noexcept(utils::ndebug_defined()) {
   const auto& [num_rev_units_at_5prime, num_fwd_units_at_3prime] =
@@ -955,13 +1306,9 @@ std::pair<usize, usize> Simulation::process_collisions(
 }
 
 void Simulation::compute_loop_size_stats(const absl::Span<const Lef> lefs,
-                                         std::deque<double>& cfx_of_variation_buff,
-                                         std::deque<double>& avg_loop_size_buff,
-                                         const usize buff_capacity) noexcept {
-  assert(cfx_of_variation_buff.size() == avg_loop_size_buff.size());
+                                         BurninTracker& history) noexcept {
   if (lefs.empty()) {
-    cfx_of_variation_buff.clear();
-    avg_loop_size_buff.clear();
+    history.clear();
     return;
   }
 
@@ -971,73 +1318,23 @@ void Simulation::compute_loop_size_stats(const absl::Span<const Lef> lefs,
   const auto avg_loop_size_std = stats::standard_dev(
       lefs.begin(), lefs.end(), avg_loop_size, [](const auto& lef) { return lef.loop_size(); });
 
-  if (avg_loop_size_buff.size() == buff_capacity) {
-    avg_loop_size_buff.pop_front();
-    cfx_of_variation_buff.pop_front();
-  }
-
-  avg_loop_size_buff.push_back(avg_loop_size);
-  cfx_of_variation_buff.push_back(avg_loop_size_std / avg_loop_size_buff.back());
-}
-
-bool Simulation::evaluate_burnin(const std::deque<double>& cfx_of_variation_buff,
-                                 [[maybe_unused]] const std::deque<double>& avg_loop_size_buff,
-                                 const usize buff_capacity, const usize window_size) noexcept {
-  assert(cfx_of_variation_buff.size() == avg_loop_size_buff.size());
-  assert(cfx_of_variation_buff.size() <= buff_capacity);
-
-  if (cfx_of_variation_buff.size() != buff_capacity) {
-    return false;
-  }
-
-  // Count the number of adjacent pairs of values where the first value is larger than the second.
-  // This visually corresponds to a local dip in the avg loop size plot.
-  // When we are in a stable state the above line should be relatively flat.
-  // For this reason, we expect n to be roughly equal to 1/2 of all the measurements
-  usize n = 0;
-  assert(window_size < buff_capacity);
-  for (auto it1 = cfx_of_variation_buff.begin() + 1,
-            it2 = cfx_of_variation_buff.begin() + static_cast<isize>(window_size + 1);
-       it2 != cfx_of_variation_buff.end(); ++it1, ++it2) {
-    const auto n1 = stats::mean(it1 - 1, it2 - 1);
-    const auto n2 = stats::mean(it1, it2);
-    n += static_cast<usize>(n1 > n2);
-  }
-  const auto r1 = static_cast<double>(n) / static_cast<double>(buff_capacity - window_size - n);
-
-  const auto cfx_of_variation_is_stable = r1 >= 0.95 && r1 <= 1.05;
-  if (!cfx_of_variation_is_stable) {
-    return false;
-  }
-
-  n = 0;
-  for (auto it1 = avg_loop_size_buff.begin() + 1,
-            it2 = avg_loop_size_buff.begin() + static_cast<isize>(window_size + 1);
-       it2 != avg_loop_size_buff.end(); ++it1, ++it2) {
-    const auto n1 = stats::mean(it1 - 1, it2 - 1);
-    const auto n2 = stats::mean(it1, it2);
-    n += static_cast<usize>(n1 > n2);
-  }
-  const auto r2 = static_cast<double>(n) / static_cast<double>(buff_capacity - window_size - n);
-
-  const auto avg_loop_size_is_stable = r2 >= 0.95 && r2 <= 1.05;
-  return avg_loop_size_is_stable;
+  history.push_back(avg_loop_size, avg_loop_size_std / avg_loop_size);
 }
 
-void Simulation::run_burnin(State& s, const double lef_binding_rate_burnin) const {
+void Simulation::run_burnin(State& s, const CellParams& params) const {
+  const ScopedTimer timer(s.profile.burnin_ns);
   do {
     ++s.num_burnin_epochs;
     if (s.num_active_lefs != s.num_lefs) {
       const auto num_lefs_to_bind =
-          modle::random::poisson_distribution<usize>{lef_binding_rate_burnin}(s.rand_eng);
+          modle::random::poisson_distribution<usize>{params.lef_binding_rate_burnin}(s.rand_eng);
       s.num_active_lefs = std::min(s.num_active_lefs + num_lefs_to_bind, s.num_lefs);
+    } else if (params.max_num_burnin_epochs != (std::numeric_limits<usize>::max)()) {
+      s.burnin_completed = s.num_burnin_epochs >= params.max_num_burnin_epochs;
     } else {
-      Simulation::compute_loop_size_stats(s.get_lefs(), s.get_cfx_of_variation(),
-                                          s.get_avg_loop_sizes(), this->burnin_history_length);
+      Simulation::compute_loop_size_stats(s.get_lefs(), s.get_burnin_history());
 
-      s.burnin_completed = Simulation::evaluate_burnin(
-          s.get_cfx_of_variation(), s.get_avg_loop_sizes(), this->burnin_history_length,
-          this->burnin_smoothing_window_size);
+      s.burnin_completed = s.get_burnin_history().is_stable();
       s.burnin_completed &= s.epoch > this->min_burnin_epochs;
 
       if (!s.burnin_completed && s.epoch >= this->max_burnin_epochs) {
@@ -1053,102 +1350,252 @@ void Simulation::run_burnin(State& s, const double lef_binding_rate_burnin) cons
   } while (s.num_active_lefs == 0);
 }
 
+u8f Simulation::enabled_features() const noexcept {
+  u8f features = 0;
+  if (this->contact_sampling_strategy & ContactSamplingStrategy::noisify) {
+    features |= NOISIFY_CONTACTS;
+  }
+  if (this->track_1d_lef_position) {
+    features |= TRACK_1D_LEF_POSITION;
+  }
+  if (this->log_model_internal_state) {
+    features |= LOG_MODEL_INTERNAL_STATE;
+  }
+  if (this->rev_extrusion_speed_std != 0.0 || this->fwd_extrusion_speed_std != 0.0) {
+    features |= STOCHASTIC_EXTR_SPEED;
+  }
+  if (this->fast_sampling) {
+    features |= FAST_SAMPLING;
+  }
+  return features;
+}
+
+template <usize... Features>
+constexpr auto Simulation::make_simulate_one_cell_kernels(
+    std::index_sequence<Features...>) noexcept {
+  using KernelT = void (Simulation::*)(State&, const CellParams&) const;
+  return std::array<KernelT, sizeof...(Features)>{
+      &Simulation::simulate_one_cell<static_cast<u8f>(Features)>...};
+}
+
 void Simulation::simulate_one_cell(State& s) const {
+  this->simulate_one_cell(s, this->setup_cell(s));
+}
+
+void Simulation::simulate_one_cell(State& s, const CellParams& params) const {
+  // Resolve the feature set once per task: the kernels for all feature sets are instantiated here
+  static constexpr auto kernels =
+      make_simulate_one_cell_kernels(std::make_index_sequence<num_feature_sets>{});
+  const auto features = this->enabled_features();
+  assert(features < kernels.size());
+  (this->*kernels[features])(s, params);
+}
+
+template <u8f Features>
+void Simulation::simulate_one_cell(State& s, const CellParams& params) const {
+  const ScopedTimer timer(s.profile.simulation_ns);
+  try {
+    while (this->simulate_one_epoch<Features>(s, params)) {
+    }
+  } catch (const std::exception& err) {
+    throw std::runtime_error(fmt::format(
+        FMT_STRING("Caught an exception while simulating epoch #{} in cell #{} of {}:\n{}"),
+        s.epoch, s.cell_id, s.chrom->name(), err.what()));
+  }
+}
+
+auto Simulation::setup_cell(State& s) const -> CellParams {
+  // Seed is computed based on chrom. name, size and cellid
+  return this->setup_cell(s, s.chrom->hash(s.xxh_state.get(), this->seed, s.cell_id));
+}
+
+auto Simulation::setup_cell(State& s, const u64 seed) const -> CellParams {
   assert(s.epoch == 0);
   assert(s.num_burnin_epochs == 0);
   assert(!s.burnin_completed);
   assert(s.num_active_lefs == 0);
   assert(s.num_target_epochs != (std::numeric_limits<usize>::max)());
 
-  try {
-    // Seed is computed based on chrom. name, size and cellid
-    s.seed = s.chrom->hash(s.xxh_state.get(), this->seed, s.cell_id);
-    s.rand_eng = random::PRNG(s.seed);
+  s.seed = seed;
+  s.rand_eng = random::PRNG(s.seed);
+  if (this->fast_sampling) {
+    s.batch_rand_eng = random::BatchPRNG(s.rand_eng());
+  }
 
-    const auto lef_binding_rate_burnin =
-        static_cast<double>(s.num_lefs) /
-        static_cast<double>(this->burnin_target_epochs_for_lef_activation);
+  const auto lef_binding_rate_burnin =
+      static_cast<double>(s.num_lefs) /
+      static_cast<double>(this->burnin_target_epochs_for_lef_activation);
 
-    const auto sampling_events_per_epoch = this->compute_contacts_per_epoch(s.num_lefs);
+  const auto sampling_events_per_epoch = this->compute_contacts_per_epoch(s.num_lefs);
 
-    // Init the local counter for the number of contacts generated by the current simulation
-    // instance
-    s.num_contacts = 0;
+  // Init the local counter for the number of contacts generated by the current simulation
+  // instance
+  s.num_contacts = 0;
 
-    // Generate initial extr. barrier states, so that they are already at or close to
-    // equilibrium
-    s.barriers.init_states(s.rand_eng);
+  // Generate initial extr. barrier states, so that they are already at or close to
+  // equilibrium
+  s.barriers.init_states(s.rand_eng);
 
-    if (this->skip_burnin) {
-      s.num_active_lefs = s.num_lefs;
-      s.burnin_completed = true;
-    }
+  if (this->skip_burnin) {
+    s.num_active_lefs = s.num_lefs;
+    s.burnin_completed = true;
+  } else {
+    s.get_burnin_history().reset(this->burnin_history_length, this->burnin_smoothing_window_size);
+  }
 
-    auto stop_condition = [this, &s]() {
-      if (this->target_contact_density >= 0) {
-        assert(s.num_target_contacts != 0);
-        return s.num_contacts < s.num_target_contacts;
-      }
-      return s.epoch - s.num_burnin_epochs < s.num_target_epochs;
-    };
+  return {lef_binding_rate_burnin, sampling_events_per_epoch};
+}
 
-    for (; stop_condition(); ++s.epoch) {
-      if (!s.burnin_completed) {
-        this->Simulation::run_burnin(s, lef_binding_rate_burnin);
-      }
+auto Simulation::setup_cell_from_snapshot(State& s) const -> CellParams {
+  assert(this->warm_start);
+  assert(!this->skip_burnin);
+  if (!s.window_snapshot) {
+    // Tasks read from a task file (e.g. by modle replay) do not come with a snapshot
+    s.window_snapshot = std::make_shared<WindowSnapshot>();
+  }
+  auto& snapshot = *s.window_snapshot;
+
+  std::call_once(snapshot.initialized, [&]() {
+    // The snapshot is seeded based on the window rather than the cell, so that it does not depend
+    // on which of the tasks referring to the window builds it
+    auto params = this->setup_cell(s, s.chrom->hash(s.xxh_state.get(), this->seed, s.window_start));
+    params.stop_after_burnin = true;
+    Simulation::simulate_one_cell(s, params);
+
+    snapshot.epoch = s.epoch;
+    snapshot.num_burnin_epochs = s.num_burnin_epochs;
+    snapshot.num_active_lefs = s.num_active_lefs;
+    snapshot.seed = s.seed;
+    const auto lefs = s.get_lefs();
+    const auto rev_ranks = s.get_rev_ranks();
+    const auto fwd_ranks = s.get_fwd_ranks();
+    const auto lef_releases = s.get_lef_releases();
+    snapshot.lefs.assign(lefs.begin(), lefs.end());
+    snapshot.rev_ranks.assign(rev_ranks.begin(), rev_ranks.end());
+    snapshot.fwd_ranks.assign(fwd_ranks.begin(), fwd_ranks.end());
+    snapshot.lef_releases.assign(lef_releases.begin(), lef_releases.end());
+    snapshot.barriers = s.barriers;
+  });
+
+  assert(snapshot.barriers.size() == s.barriers.size());
+  s.epoch = snapshot.epoch;
+  s.num_burnin_epochs = snapshot.num_burnin_epochs;
+  s.num_active_lefs = snapshot.num_active_lefs;
+  s.num_contacts = 0;
+  // Cells restored from the same snapshot share the LEF and barrier states, but should not draw the
+  // same random numbers: reseed the PRNGs based on the snapshot seed and the cell id
+  s.seed = s.chrom->hash(s.xxh_state.get(), snapshot.seed, s.cell_id);
+  s.rand_eng = random::PRNG(s.seed);
+  if (this->fast_sampling) {
+    s.batch_rand_eng = random::BatchPRNG(s.rand_eng());
+  }
+  std::copy(snapshot.lefs.begin(), snapshot.lefs.end(), s.get_lefs().begin());
+  std::copy(snapshot.rev_ranks.begin(), snapshot.rev_ranks.end(), s.get_rev_ranks().begin());
+  std::copy(snapshot.fwd_ranks.begin(), snapshot.fwd_ranks.end(), s.get_fwd_ranks().begin());
+  std::copy(snapshot.lef_releases.begin(), snapshot.lef_releases.end(),
+            s.get_lef_releases().begin());
+  // Restoring barriers through ExtrusionBarriers::set would discard the pending state transitions
+  s.barriers = snapshot.barriers;
+
+  // All LEFs are already bound: re-equilibrate the cell through a short, fixed-length burn-in
+  s.burnin_completed = this->warm_start_epochs == 0;
+  CellParams params{};
+  params.sampling_events_per_epoch = this->compute_contacts_per_epoch(s.num_lefs);
+  params.max_num_burnin_epochs = s.num_burnin_epochs + this->warm_start_epochs;
+  return params;
+}
 
-      ////////////////////////
-      // Simulate one epoch //
-      ////////////////////////
-
-      // Select inactive LEFs and bind them
-      Simulation::select_and_bind_lefs(s);
-      if (s.burnin_completed) {  // Register contacts
-        this->sample_and_register_contacts(s, sampling_events_per_epoch);
-        if (s.num_target_contacts != 0 && s.num_contacts >= s.num_target_contacts) {
-          spdlog::debug(FMT_STRING("Simulation for cell #{} of {} took {} epochs ({} for burnin "
-                                   "and {} for the rest of the simulation)"),
-                        s.cell_id, s.chrom->name(), s.epoch, s.num_burnin_epochs,
-                        s.epoch - s.num_burnin_epochs);
-          return;  // Enough contacts have been generated. Yay!
-        }
-      }
+template <u8f Features>
+bool Simulation::simulate_one_epoch(State& s, const CellParams& params) const {
+  const auto stop_condition = [&]() {
+    if (this->target_contact_density >= 0) {
+      assert(s.num_target_contacts != 0);
+      return s.num_contacts >= s.num_target_contacts;
+    }
+    return s.epoch - s.num_burnin_epochs >= s.num_target_epochs;
+  };
 
-      this->generate_moves(*s.chrom, s.get_lefs(), s.get_rev_ranks(), s.get_fwd_ranks(),
-                           s.get_rev_moves(), s.get_fwd_moves(), s.burnin_completed, s.rand_eng);
-
-      s.barriers.next_state(s.rand_eng);
-
-      // Reset collision masks
-      std::for_each(s.get_rev_collisions().begin(), s.get_rev_collisions().end(),
-                    [&](auto& c) { c.clear(); });
-      std::for_each(s.get_fwd_collisions().begin(), s.get_fwd_collisions().end(),
-                    [&](auto& c) { c.clear(); });
-
-      // Detect collision and correct moves
-      Simulation::process_collisions(*s.chrom, s.get_lefs(), s.barriers, s.get_rev_ranks(),
-                                     s.get_fwd_ranks(), s.get_rev_moves(), s.get_fwd_moves(),
-                                     s.get_rev_collisions(), s.get_fwd_collisions(), s.rand_eng);
-      // Advance LEFs
-      Simulation::extrude(*s.chrom, s.get_lefs(), s.get_rev_moves(), s.get_fwd_moves());
-
-      // Log model internal state
-      if (MODLE_UNLIKELY(this->log_model_internal_state)) {
-        assert(s.model_state_logger);
-        Simulation::dump_stats(s.id, s.epoch, s.cell_id, !s.burnin_completed, *s.chrom,
-                               s.get_lefs(), s.barriers, s.get_rev_collisions(),
-                               s.get_fwd_collisions(), *s.model_state_logger);
-      }
+  if (stop_condition()) {
+    return false;
+  }
 
-      // Select LEFs to be released in the current epoch and release them
-      this->release_lefs(s.get_lefs(), s.barriers, s.get_rev_collisions(), s.get_fwd_collisions(),
-                         s.rand_eng, s.burnin_completed);
+  if (!s.burnin_completed) {
+    this->Simulation::run_burnin(s, params);
+    if (s.burnin_completed && params.stop_after_burnin) {
+      return false;
     }
-  } catch (const std::exception& err) {
-    throw std::runtime_error(fmt::format(
-        FMT_STRING("Caught an exception while simulating epoch #{} in cell #{} of {}:\n{}"),
-        s.epoch, s.cell_id, s.chrom->name(), err.what()));
   }
+
+  ////////////////////////
+  // Simulate one epoch //
+  ////////////////////////
+
+  // Select inactive LEFs and bind them
+  Simulation::select_and_bind_lefs(s);
+  if (s.burnin_completed) {  // Register contacts
+    constexpr auto contact_sampling_features =
+        static_cast<u8f>(Features & (NOISIFY_CONTACTS | TRACK_1D_LEF_POSITION | FAST_SAMPLING));
+    this->sample_and_register_contacts<contact_sampling_features>(
+        s, params.sampling_events_per_epoch);
+    if (s.num_target_contacts != 0 && s.num_contacts >= s.num_target_contacts) {
+      spdlog::debug(FMT_STRING("Simulation for cell #{} of {} took {} epochs ({} for burnin "
+                               "and {} for the rest of the simulation)"),
+                    s.cell_id, s.chrom->name(), s.epoch, s.num_burnin_epochs,
+                    s.epoch - s.num_burnin_epochs);
+      return false;  // Enough contacts have been generated. Yay!
+    }
+  }
+
+  this->generate_moves<Features>(*s.chrom, s.get_lefs(), s.get_rev_ranks(), s.get_fwd_ranks(),
+                                 s.get_rev_moves(), s.get_fwd_moves(), s.burnin_completed,
+                                 s.epoch_rand_eng<Features>());
+
+  if constexpr (has_feature(Features, FAST_SAMPLING)) {
+    s.barriers.next_state_scheduled(s.rand_eng);
+  } else {
+    s.barriers.next_state(s.rand_eng);
+  }
+
+  // Reset collision masks
+  std::for_each(s.get_rev_collisions().begin(), s.get_rev_collisions().end(),
+                [&](auto& c) { c.clear(); });
+  std::for_each(s.get_fwd_collisions().begin(), s.get_fwd_collisions().end(),
+                [&](auto& c) { c.clear(); });
+
+  // Detect collision and correct moves
+  if (this->fused_collision_pipeline) {
+    this->process_collisions_fused(*s.chrom, s.get_lefs(), s.barriers, s.get_rev_ranks(),
+                                   s.get_fwd_ranks(), s.get_rev_moves(), s.get_fwd_moves(),
+                                   s.get_rev_collisions(), s.get_fwd_collisions(),
+                                   s.unit_pos_buffs, s.rand_eng);
+  } else {
+    Simulation::process_collisions(*s.chrom, s.get_lefs(), s.barriers, s.get_rev_ranks(),
+                                   s.get_fwd_ranks(), s.get_rev_moves(), s.get_fwd_moves(),
+                                   s.get_rev_collisions(), s.get_fwd_collisions(), s.rand_eng);
+  }
+  s.profile.register_collisions<CollisionT>(s.get_rev_collisions(), s.get_fwd_collisions());
+  // Advance LEFs
+  Simulation::extrude(*s.chrom, s.get_lefs(), s.get_rev_moves(), s.get_fwd_moves());
+
+  // Log model internal state
+  if constexpr (has_feature(Features, LOG_MODEL_INTERNAL_STATE)) {
+    assert(this->log_model_internal_state);
+    assert(s.model_state_logger);
+    Simulation::dump_stats(s.id, s.epoch, s.cell_id, !s.burnin_completed, *s.chrom, s.get_lefs(),
+                           s.barriers, s.get_rev_collisions(), s.get_fwd_collisions(),
+                           *s.model_state_logger);
+  }
+
+  // Select LEFs to be released in the current epoch and release them
+  if constexpr (has_feature(Features, FAST_SAMPLING)) {
+    this->release_lefs(s.get_lefs(), s.barriers, s.get_rev_collisions(), s.get_fwd_collisions(),
+                       s.get_lef_releases(), s.epoch, s.batch_rand_eng, s.burnin_completed);
+  } else {
+    this->release_lefs(s.get_lefs(), s.barriers, s.get_rev_collisions(), s.get_fwd_collisions(),
+                       s.rand_eng, s.burnin_completed);
+  }
+  ++s.epoch;
+  return true;
 }
 
 void Simulation::select_and_bind_lefs(State& s) noexcept(utils::ndebug_defined()) {
@@ -1256,6 +1703,47 @@ usize Simulation::compute_num_lefs(const usize size_bp) const noexcept {
                   static_cast<usize>(std::round(this->number_of_lefs_per_mbp * size_mbp)));
 }
 
+usize Simulation::compute_contact_matrix_size(const Chromosome& chrom) const noexcept {
+  // Refer to Chromosome::allocate_contact_matrix
+  return ContactMatrixDense<contacts_t>::compute_matrix_size_in_bytes(
+      (this->diagonal_width + this->bin_size - 1) / this->bin_size,
+      (chrom.simulated_size() + this->bin_size - 1) / this->bin_size);
+}
+
+usize Simulation::compute_lef_occupancy_buffer_size(const Chromosome& chrom) const noexcept {
+  return ((chrom.size() + this->bin_size - 1) / this->bin_size) * sizeof(std::atomic<u64>);
+}
+
+usize Simulation::compute_state_buffers_size(usize nlefs, usize nbarriers) noexcept {
+  // Refer to State::resize_buffers and State::sampling_buffs
+  const auto lef_buffers_size =
+      nlefs * (sizeof(Lef) + (2 * sizeof(lef_idx_t)) + (2 * sizeof(usize)) +
+               (2 * sizeof(lef_move_t)) + (2 * sizeof(bp_t)) + (2 * sizeof(CollisionT)) +
+               sizeof(LefRelease));
+  // Barrier tables are shared across States: each State only stores barrier states and pending
+  // state transitions
+  const auto barrier_buffers_size =
+      nbarriers * (sizeof(ExtrusionBarriers::State) + sizeof(u64) + sizeof(usize));
+  const auto contact_buffers_size =
+      Simulation::max_contact_buff_size * (sizeof(PixelCoordinates) + sizeof(Pixel<contacts_t>));
+
+  return lef_buffers_size + barrier_buffers_size + contact_buffers_size;
+}
+
+void Simulation::register_allocation(usize size) noexcept {
+  const auto memory_in_use = (this->_memory_in_use += size);
+  auto peak = this->_peak_memory_in_use.load();
+  // compare_exchange_weak updates peak when the exchange fails
+  while (memory_in_use > peak &&
+         !this->_peak_memory_in_use.compare_exchange_weak(peak, memory_in_use)) {
+  }
+}
+
+void Simulation::register_deallocation(usize size) noexcept {
+  assert(this->_memory_in_use >= size);
+  this->_memory_in_use -= size;
+}
+
 void Simulation::print_status_update(const Task& t) const noexcept {
   auto tot_target_epochs = this->compute_tot_target_epochs(t.num_lefs, t.chrom->npixels());
   spdlog::info(FMT_STRING("Begin processing \"{}\": simulating ~{} epochs across {} cells using {} "
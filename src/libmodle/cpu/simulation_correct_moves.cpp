@@ -19,7 +19,7 @@ namespace modle {
 
 void Simulation::correct_moves_for_lef_bar_collisions(
     const absl::Span<const Lef> lefs, const ExtrusionBarriers& barriers,
-    const absl::Span<bp_t> rev_moves, const absl::Span<bp_t> fwd_moves,
+    const absl::Span<lef_move_t> rev_moves, const absl::Span<lef_move_t> fwd_moves,
     const absl::Span<const CollisionT> rev_collisions,
     const absl::Span<const CollisionT> fwd_collisions) noexcept(utils::ndebug_defined()) {
   for (usize i = 0; i < lefs.size(); ++i) {
@@ -33,7 +33,7 @@ void Simulation::correct_moves_for_lef_bar_collisions(
       // of the current LEF will be located 1bp downstream of the extr. barrier.
       const auto distance = lefs[i].rev_unit.pos() - barrier_pos;
       assert(distance != 0);
-      rev_moves[i] = distance - 1;
+      rev_moves[i] = static_cast<lef_move_t>(distance - 1);
     }
 
     if (MODLE_UNLIKELY(
@@ -45,16 +45,16 @@ void Simulation::correct_moves_for_lef_bar_collisions(
       // Same as above. In this case the unit will be located 1bp upstream of the extr. barrier.
       const auto distance = barrier_pos - lefs[i].fwd_unit.pos();
       assert(distance != 0);
-      fwd_moves[i] = distance - 1;
+      fwd_moves[i] = static_cast<lef_move_t>(distance - 1);
     }
   }
 }
 
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void Simulation::correct_moves_for_primary_lef_lef_collisions(
-    const absl::Span<const Lef> lefs, const absl::Span<const usize> rev_ranks,
-    const absl::Span<const usize> fwd_ranks, const absl::Span<bp_t> rev_moves,
-    const absl::Span<bp_t> fwd_moves, const absl::Span<const CollisionT> rev_collisions,
+    const absl::Span<const Lef> lefs, const absl::Span<const lef_idx_t> rev_ranks,
+    const absl::Span<const lef_idx_t> fwd_ranks, const absl::Span<lef_move_t> rev_moves,
+    const absl::Span<lef_move_t> fwd_moves, const absl::Span<const CollisionT> rev_collisions,
     const absl::Span<const CollisionT> fwd_collisions) noexcept(utils::ndebug_defined()) {
   // Primary LEF-LEF collisions are encoded with a number between nbarriers and nbarriers + nlefs.
   // Given a pair of extr. units that are moving in opposite directions, the index i corresponding
@@ -78,8 +78,8 @@ void Simulation::correct_moves_for_primary_lef_lef_collisions(
 
         // Update the moves of the involved units, so that after the next call to extrude these
         // two units will be located nex to each others at the collision site.
-        rev_move = rev_unit.pos() - p1;
-        fwd_move = p2 - fwd_unit.pos();
+        rev_move = static_cast<lef_move_t>(rev_unit.pos() - p1);
+        fwd_move = static_cast<lef_move_t>(p2 - fwd_unit.pos());
 
       } else if (fwd_collisions[fwd_idx].collision_occurred(CollisionT::LEF_BAR)) {
         // This branch handles the special case where the fwd unit involved in the collision is
@@ -93,7 +93,7 @@ void Simulation::correct_moves_for_primary_lef_lef_collisions(
         const auto& fwd_move = fwd_moves[fwd_idx];
 
         assert(rev_unit.pos() >= fwd_unit.pos() + fwd_move);
-        rev_move = rev_unit.pos() - (fwd_unit.pos() + fwd_move) - 1;
+        rev_move = static_cast<lef_move_t>(rev_unit.pos() - (fwd_unit.pos() + fwd_move) - 1);
       }
     }
   }
@@ -115,7 +115,7 @@ void Simulation::correct_moves_for_primary_lef_lef_collisions(
         auto& fwd_move = fwd_moves[fwd_idx];
 
         assert(rev_unit.pos() >= fwd_unit.pos() + rev_move);
-        fwd_move = (rev_unit.pos() - rev_move) - fwd_unit.pos() - 1;
+        fwd_move = static_cast<lef_move_t>((rev_unit.pos() - rev_move) - fwd_unit.pos() - 1);
       }
     }
   }
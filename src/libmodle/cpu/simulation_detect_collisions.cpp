@@ -28,9 +28,9 @@ namespace modle {
 
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 std::pair<usize, usize> Simulation::detect_units_at_chrom_boundaries(
-    const Chromosome& chrom, absl::Span<const Lef> lefs, absl::Span<const usize> rev_lef_ranks,
-    absl::Span<const usize> fwd_lef_ranks, absl::Span<const bp_t> rev_moves,
-    absl::Span<const bp_t> fwd_moves, absl::Span<CollisionT> rev_collisions,
+    const Chromosome& chrom, absl::Span<const Lef> lefs, absl::Span<const lef_idx_t> rev_lef_ranks,
+    absl::Span<const lef_idx_t> fwd_lef_ranks, absl::Span<const lef_move_t> rev_moves,
+    absl::Span<const lef_move_t> fwd_moves, absl::Span<CollisionT> rev_collisions,
     absl::Span<CollisionT> fwd_collisions) {
   {
     assert(lefs.size() == fwd_lef_ranks.size());
@@ -126,9 +126,9 @@ std::pair<usize, usize> Simulation::detect_units_at_chrom_boundaries(
 
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void Simulation::detect_lef_bar_collisions(
-    const absl::Span<const Lef> lefs, const absl::Span<const usize> rev_lef_ranks,
-    const absl::Span<const usize> fwd_lef_ranks, const absl::Span<const bp_t> rev_moves,
-    const absl::Span<const bp_t> fwd_moves, const ExtrusionBarriers& barriers,
+    const absl::Span<const Lef> lefs, const absl::Span<const lef_idx_t> rev_lef_ranks,
+    const absl::Span<const lef_idx_t> fwd_lef_ranks, const absl::Span<const lef_move_t> rev_moves,
+    const absl::Span<const lef_move_t> fwd_moves, const ExtrusionBarriers& barriers,
     const absl::Span<CollisionT> rev_collisions, const absl::Span<CollisionT> fwd_collisions,
     random::PRNG_t& rand_eng, usize num_rev_units_at_5prime, usize num_fwd_units_at_3prime) const
     noexcept(utils::ndebug_defined()) {
@@ -254,8 +254,9 @@ process_fwd_unit:
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void Simulation::detect_primary_lef_lef_collisions(
     const absl::Span<const Lef> lefs, const ExtrusionBarriers& barriers,
-    const absl::Span<const usize> rev_lef_ranks, const absl::Span<const usize> fwd_lef_ranks,
-    const absl::Span<const bp_t> rev_moves, const absl::Span<const bp_t> fwd_moves,
+    const absl::Span<const lef_idx_t> rev_lef_ranks,
+    const absl::Span<const lef_idx_t> fwd_lef_ranks,
+    const absl::Span<const lef_move_t> rev_moves, const absl::Span<const lef_move_t> fwd_moves,
     const absl::Span<CollisionT> rev_collisions, const absl::Span<CollisionT> fwd_collisions,
     random::PRNG_t& rand_eng, usize num_rev_units_at_5prime, usize num_fwd_units_at_3prime) const
     noexcept(utils::ndebug_defined()) {
@@ -403,8 +404,9 @@ void Simulation::detect_primary_lef_lef_collisions(
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void Simulation::process_secondary_lef_lef_collisions(
     [[maybe_unused]] const Chromosome& chrom, const absl::Span<const Lef> lefs,
-    const absl::Span<const usize> rev_lef_ranks, const absl::Span<const usize> fwd_lef_ranks,
-    const absl::Span<bp_t> rev_moves, const absl::Span<bp_t> fwd_moves,
+    const absl::Span<const lef_idx_t> rev_lef_ranks,
+    const absl::Span<const lef_idx_t> fwd_lef_ranks,
+    const absl::Span<lef_move_t> rev_moves, const absl::Span<lef_move_t> fwd_moves,
     const absl::Span<CollisionT> rev_collisions, const absl::Span<CollisionT> fwd_collisions,
     random::PRNG_t& rand_eng, usize num_rev_units_at_5prime, usize num_fwd_units_at_3prime) const
     noexcept(utils::ndebug_defined()) {
@@ -469,7 +471,7 @@ void Simulation::process_secondary_lef_lef_collisions(
         rev_collisions[rev_idx2].set(rev_idx1,
                                      CollisionT::COLLISION | CollisionT::LEF_LEF_SECONDARY);
         const auto move = rev_pos2 - (rev_pos1 - move1);
-        move2 = std::min(move, move - 1);
+        move2 = static_cast<lef_move_t>(std::min(move, move - 1));
       } else {
         assert(rev_collisions[rev_idx1].collision_occurred());
         rev_collisions[rev_idx2].set(rev_idx1, CollisionT::LEF_LEF_SECONDARY);
@@ -508,7 +510,7 @@ void Simulation::process_secondary_lef_lef_collisions(
         fwd_collisions[fwd_idx1].set(fwd_idx2,
                                      CollisionT::COLLISION | CollisionT::LEF_LEF_SECONDARY);
         const auto move = (fwd_pos2 + move2) - fwd_pos1;
-        move1 = std::min(move, move - 1);
+        move1 = static_cast<lef_move_t>(std::min(move, move - 1));
       } else {
         assert(fwd_collisions[fwd_idx2].collision_occurred());
         fwd_collisions[fwd_idx1].set(fwd_idx2, CollisionT::LEF_LEF_SECONDARY);
@@ -519,8 +521,8 @@ void Simulation::process_secondary_lef_lef_collisions(
 
 void Simulation::fix_secondary_lef_lef_collisions(
     [[maybe_unused]] const Chromosome& chrom, const absl::Span<Lef> lefs,
-    const absl::Span<usize> rev_lef_ranks, const absl::Span<usize> fwd_lef_ranks,
-    const absl::Span<bp_t> rev_moves, const absl::Span<bp_t> fwd_moves,
+    const absl::Span<lef_idx_t> rev_lef_ranks, const absl::Span<lef_idx_t> fwd_lef_ranks,
+    const absl::Span<lef_move_t> rev_moves, const absl::Span<lef_move_t> fwd_moves,
     const absl::Span<CollisionT> rev_collisions, const absl::Span<CollisionT> fwd_collisions,
     const usize num_rev_units_at_5prime,
     const usize num_fwd_units_at_3prime) noexcept(utils::ndebug_defined()) {
@@ -571,7 +573,7 @@ void Simulation::fix_secondary_lef_lef_collisions(
       // If possible, adjust EU2's move so that after extrusion EU2 will be located 1bp upstream of
       // EU1
       if (MODLE_LIKELY(lef2.rev_unit.pos() > pos1 + 1)) {
-        rev_moves[rev_idx2] = lef2.rev_unit.pos() - (pos1 + 1);
+        rev_moves[rev_idx2] = static_cast<lef_move_t>(lef2.rev_unit.pos() - (pos1 + 1));
       } else {
         rev_moves[rev_idx2] = 0;
       }
@@ -594,11 +596,11 @@ void Simulation::fix_secondary_lef_lef_collisions(
       // Sometime when swapping moves it is possible that the resulting move will cause an extrusion
       // unit to cross chromosomal boundaries. Right now I can't think of a way around this other
       // than clamping the moves once again
-      rev_moves[rev_lef_ranks[i - 1]] =
-          std::min(lefs[rev_lef_ranks[i - 1]].rev_unit.pos() - chrom.start_pos(),
-                   rev_moves[rev_lef_ranks[i - 1]]);
-      rev_moves[rev_lef_ranks[i]] = std::min(
-          lefs[rev_lef_ranks[i]].rev_unit.pos() - chrom.start_pos(), rev_moves[rev_lef_ranks[i]]);
+      rev_moves[rev_lef_ranks[i - 1]] = static_cast<lef_move_t>(
+          std::min<bp_t>(lefs[rev_lef_ranks[i - 1]].rev_unit.pos() - chrom.start_pos(),
+                         rev_moves[rev_lef_ranks[i - 1]]));
+      rev_moves[rev_lef_ranks[i]] = static_cast<lef_move_t>(std::min<bp_t>(
+          lefs[rev_lef_ranks[i]].rev_unit.pos() - chrom.start_pos(), rev_moves[rev_lef_ranks[i]]));
       assert(lefs[rev_lef_ranks[i - 1]].rev_unit.pos() >= rev_moves[rev_lef_ranks[i - 1]]);
       assert(lefs[rev_lef_ranks[i]].rev_unit.pos() >= rev_moves[rev_lef_ranks[i]]);
     }
@@ -619,7 +621,7 @@ void Simulation::fix_secondary_lef_lef_collisions(
 
       const auto pos2 = lef2.fwd_unit.pos() + fwd_moves[fwd_idx2];
       if (pos2 > lef1.fwd_unit.pos() + 1) {
-        fwd_moves[fwd_idx1] = pos2 - (lef1.fwd_unit.pos() + 1);
+        fwd_moves[fwd_idx1] = static_cast<lef_move_t>(pos2 - (lef1.fwd_unit.pos() + 1));
       } else {
         fwd_moves[fwd_idx1] = 0;
       }
@@ -633,11 +635,12 @@ void Simulation::fix_secondary_lef_lef_collisions(
       std::swap(fwd_moves[fwd_idx1], fwd_moves[fwd_idx2]);
       std::swap(fwd_lef_ranks[i], fwd_lef_ranks[i + 1]);
 
-      fwd_moves[fwd_lef_ranks[i]] = std::min(
-          chrom.end_pos() - 1 - lefs[fwd_lef_ranks[i]].fwd_unit.pos(), fwd_moves[fwd_lef_ranks[i]]);
-      fwd_moves[fwd_lef_ranks[i + 1]] =
-          std::min(chrom.end_pos() - 1 - lefs[fwd_lef_ranks[i + 1]].fwd_unit.pos(),
-                   fwd_moves[fwd_lef_ranks[i + 1]]);
+      fwd_moves[fwd_lef_ranks[i]] = static_cast<lef_move_t>(
+          std::min<bp_t>(chrom.end_pos() - 1 - lefs[fwd_lef_ranks[i]].fwd_unit.pos(),
+                         fwd_moves[fwd_lef_ranks[i]]));
+      fwd_moves[fwd_lef_ranks[i + 1]] = static_cast<lef_move_t>(
+          std::min<bp_t>(chrom.end_pos() - 1 - lefs[fwd_lef_ranks[i + 1]].fwd_unit.pos(),
+                         fwd_moves[fwd_lef_ranks[i + 1]]));
 
       assert(lefs[fwd_lef_ranks[i]].fwd_unit.pos() + fwd_moves[fwd_lef_ranks[i]] < chrom.end_pos());
       assert(lefs[fwd_lef_ranks[i + 1]].fwd_unit.pos() + fwd_moves[fwd_lef_ranks[i + 1]] <
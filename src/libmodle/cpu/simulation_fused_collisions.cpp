@@ -0,0 +1,381 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+// clang-format off
+#include "modle/simulation.hpp"
+// clang-format on
+
+#include <absl/types/span.h>  // for Span
+
+#include <algorithm>  // for min, max, find_if
+#include <cassert>    // for assert
+#include <limits>     // for numeric_limits
+#include <utility>    // for make_pair, pair
+
+#include "modle/collision_encoding.hpp"
+#include "modle/common/common.hpp"       // for bp_t, usize
+#include "modle/common/dna.hpp"          // for dna::REV, dna::FWD
+#include "modle/common/random.hpp"       // for PRNG_t
+#include "modle/common/utils.hpp"        // for ndebug_defined
+#include "modle/extrusion_barriers.hpp"  // for ExtrusionBarriers
+#include "modle/extrusion_factors.hpp"   // for ExtrusionUnit, Lef
+#include "modle/genome.hpp"              // for Chromosome
+
+namespace modle {
+
+// Released extr. units are parked at this position (see ExtrusionUnit::release)
+static constexpr auto unbound_pos = (std::numeric_limits<bp_t>::max)();
+
+void Simulation::gather_unit_positions(const absl::Span<const Lef> lefs,
+                                       const absl::Span<const lef_idx_t> rev_lef_ranks,
+                                       const absl::Span<const lef_idx_t> fwd_lef_ranks,
+                                       UnitPositionBuffers& buffs) {
+  assert(lefs.size() == rev_lef_ranks.size());
+  assert(lefs.size() == fwd_lef_ranks.size());
+  buffs.rev_pos.resize(lefs.size());
+  buffs.fwd_pos.resize(lefs.size());
+
+  for (usize i = 0; i < lefs.size(); ++i) {
+    buffs.rev_pos[i] = lefs[rev_lef_ranks[i]].rev_unit.pos();
+    buffs.fwd_pos[i] = lefs[fwd_lef_ranks[i]].fwd_unit.pos();
+    assert((buffs.rev_pos[i] != unbound_pos) == lefs[rev_lef_ranks[i]].is_bound());
+    assert((buffs.fwd_pos[i] != unbound_pos) == lefs[fwd_lef_ranks[i]].is_bound());
+  }
+}
+
+std::pair<usize, usize> Simulation::process_collisions_fused(
+    const Chromosome& chrom, const absl::Span<Lef> lefs, const ExtrusionBarriers& barriers,
+    const absl::Span<lef_idx_t> rev_lef_ranks, const absl::Span<lef_idx_t> fwd_lef_ranks,
+    const absl::Span<lef_move_t> rev_moves, const absl::Span<lef_move_t> fwd_moves,
+    const absl::Span<CollisionT> rev_collisions, const absl::Span<CollisionT> fwd_collisions,
+    UnitPositionBuffers& buffs, random::PRNG_t& rand_eng) const noexcept(utils::ndebug_defined()) {
+  Simulation::gather_unit_positions(lefs, rev_lef_ranks, fwd_lef_ranks, buffs);
+
+  // Units at chrom. boundaries are detected exactly like in Simulation::process_collisions
+  const auto [num_rev_units_at_5prime, num_fwd_units_at_3prime] =
+      Simulation::detect_units_at_chrom_boundaries(chrom, lefs, rev_lef_ranks, fwd_lef_ranks,
+                                                   rev_moves, fwd_moves, rev_collisions,
+                                                   fwd_collisions);
+
+  this->detect_lef_bar_collisions_fused(rev_lef_ranks, fwd_lef_ranks, rev_moves, fwd_moves,
+                                        barriers, rev_collisions, fwd_collisions, buffs, rand_eng,
+                                        num_rev_units_at_5prime, num_fwd_units_at_3prime);
+  this->detect_primary_lef_lef_collisions_fused(
+      lefs, barriers, rev_lef_ranks, fwd_lef_ranks, rev_moves, fwd_moves, rev_collisions,
+      fwd_collisions, buffs, rand_eng, num_rev_units_at_5prime, num_fwd_units_at_3prime);
+  this->correct_moves_and_detect_secondary_lef_lef_collisions(
+      lefs, barriers, rev_lef_ranks, fwd_lef_ranks, rev_moves, fwd_moves, rev_collisions,
+      fwd_collisions, buffs, rand_eng, num_rev_units_at_5prime, num_fwd_units_at_3prime);
+
+  // Fixing secondary LEF-LEF collisions requires swapping the position of extr. units, which is a
+  // rare event: this step is shared with Simulation::process_collisions
+  Simulation::fix_secondary_lef_lef_collisions(chrom, lefs, rev_lef_ranks, fwd_lef_ranks, rev_moves,
+                                               fwd_moves, rev_collisions, fwd_collisions,
+                                               num_rev_units_at_5prime, num_fwd_units_at_3prime);
+  return std::make_pair(num_rev_units_at_5prime, num_fwd_units_at_3prime);
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+void Simulation::detect_lef_bar_collisions_fused(
+    const absl::Span<const lef_idx_t> rev_lef_ranks,
+    const absl::Span<const lef_idx_t> fwd_lef_ranks,
+    const absl::Span<const lef_move_t> rev_moves, const absl::Span<const lef_move_t> fwd_moves,
+    const ExtrusionBarriers& barriers, const absl::Span<CollisionT> rev_collisions,
+    const absl::Span<CollisionT> fwd_collisions, const UnitPositionBuffers& buffs,
+    random::PRNG_t& rand_eng, usize num_rev_units_at_5prime, usize num_fwd_units_at_3prime) const
+    noexcept(utils::ndebug_defined()) {
+  // See Simulation::detect_lef_bar_collisions for detailed comments
+  const auto& rev_pos = buffs.rev_pos;
+  const auto& fwd_pos = buffs.fwd_pos;
+  const auto nunits = rev_pos.size();
+  assert(fwd_pos.size() == nunits);
+
+  auto j = std::min(num_rev_units_at_5prime, num_rev_units_at_5prime - 1);
+  auto unit_pos = rev_pos[j];
+
+  for (usize i = 0; i < barriers.size(); ++i) {
+    if (barriers.is_not_active(i)) {
+      continue;
+    }
+
+    const auto barrier_pos = barriers.pos(i);
+    const auto& pblock = barriers.direction(i) == dna::REV ? this->lef_bar_major_collision_pblock
+                                                           : this->lef_bar_minor_collision_pblock;
+    while (unit_pos <= barrier_pos) {
+      if (MODLE_UNLIKELY(++j == nunits)) {
+        goto process_fwd_unit;
+      }
+      unit_pos = rev_pos[j];
+    }
+
+    if (MODLE_LIKELY(unit_pos != unbound_pos)) {
+      const auto unit_idx = rev_lef_ranks[j];
+      const auto delta = unit_pos - barrier_pos;
+      if (delta > 0 && delta <= rev_moves[unit_idx] &&
+          Simulation::run_lef_bar_collision_trial(pblock, rand_eng)) {
+        rev_collisions[unit_idx].set(i, CollisionT::COLLISION | CollisionT::LEF_BAR);
+      }
+    }
+  }
+
+process_fwd_unit:
+  j = nunits - std::min(num_fwd_units_at_3prime, num_fwd_units_at_3prime - 1);
+  assert(j != 0);
+  unit_pos = fwd_pos[--j];
+
+  assert(!barriers.empty());
+  const auto sentinel_idx = (std::numeric_limits<usize>::max)();
+  for (auto i = barriers.size() - 1; i != sentinel_idx; --i) {
+    if (barriers.is_not_active(i)) {
+      continue;
+    }
+
+    const auto barrier_pos = barriers.pos(i);
+    const auto& pblock = barriers.direction(i) == dna::FWD ? this->lef_bar_major_collision_pblock
+                                                           : this->lef_bar_minor_collision_pblock;
+    while (unit_pos >= barrier_pos) {
+      if (MODLE_UNLIKELY(--j == sentinel_idx)) {
+        return;
+      }
+      unit_pos = fwd_pos[j];
+    }
+
+    if (MODLE_LIKELY(unit_pos != unbound_pos)) {
+      const auto unit_idx = fwd_lef_ranks[j];
+      const auto delta = barrier_pos - unit_pos;
+      if (delta > 0 && delta <= fwd_moves[unit_idx] &&
+          Simulation::run_lef_bar_collision_trial(pblock, rand_eng)) {
+        fwd_collisions[unit_idx].set(i, CollisionT::COLLISION | CollisionT::LEF_BAR);
+      }
+    }
+  }
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+void Simulation::detect_primary_lef_lef_collisions_fused(
+    const absl::Span<const Lef> lefs, const ExtrusionBarriers& barriers,
+    const absl::Span<const lef_idx_t> rev_lef_ranks,
+    const absl::Span<const lef_idx_t> fwd_lef_ranks,
+    const absl::Span<const lef_move_t> rev_moves, const absl::Span<const lef_move_t> fwd_moves,
+    const absl::Span<CollisionT> rev_collisions, const absl::Span<CollisionT> fwd_collisions,
+    const UnitPositionBuffers& buffs, random::PRNG_t& rand_eng, usize num_rev_units_at_5prime,
+    usize num_fwd_units_at_3prime) const noexcept(utils::ndebug_defined()) {
+  // See Simulation::detect_primary_lef_lef_collisions for detailed comments
+  if (MODLE_UNLIKELY(num_rev_units_at_5prime == lefs.size() ||
+                     num_fwd_units_at_3prime == lefs.size())) {
+    return;
+  }
+
+  const auto& rev_pos_buff = buffs.rev_pos;
+  const auto& fwd_pos_buff = buffs.fwd_pos;
+
+  usize i1 = 0;
+  auto j1 = num_rev_units_at_5prime;
+  const auto i2 = lefs.size() - std::min(num_fwd_units_at_3prime, num_fwd_units_at_3prime - 1);
+  const auto j2 = lefs.size();
+
+  while (true) {
+    auto rev_pos = rev_pos_buff[j1];
+    auto fwd_pos = fwd_pos_buff[i1];
+
+    while (rev_pos <= fwd_pos) {
+      if (MODLE_UNLIKELY(++j1 == j2)) {
+        return;
+      }
+      rev_pos = rev_pos_buff[j1];
+    }
+
+    while (fwd_pos < rev_pos) {
+      if (MODLE_UNLIKELY(++i1 == i2)) {
+        return;
+      }
+      fwd_pos = fwd_pos_buff[i1];
+    }
+
+    const auto fwd_rank = std::min(i1, i1 - 1);
+    fwd_pos = fwd_pos_buff[fwd_rank];
+
+    const auto rev_idx = rev_lef_ranks[j1];
+    const auto fwd_idx = fwd_lef_ranks[fwd_rank];
+    if (const auto delta = rev_pos - fwd_pos; delta > 0 &&
+                                              delta < rev_moves[rev_idx] + fwd_moves[fwd_idx] &&
+                                              this->run_lef_lef_collision_trial(rand_eng)) {
+      auto& rev_collision = rev_collisions[rev_idx];
+      auto& fwd_collision = fwd_collisions[fwd_idx];
+
+      auto [collision_pos_rev, collision_pos_fwd] =
+          compute_lef_lef_collision_pos(lefs[rev_idx].rev_unit, lefs[fwd_idx].fwd_unit,
+                                        rev_moves[rev_idx], fwd_moves[fwd_idx]);
+
+      if (!rev_collision.collision_occurred() && !fwd_collision.collision_occurred()) {
+        rev_collision.set(fwd_idx, CollisionT::COLLISION | CollisionT::LEF_LEF_PRIMARY);
+        fwd_collision.set(rev_idx, CollisionT::COLLISION | CollisionT::LEF_LEF_PRIMARY);
+
+      } else if (rev_collision.collision_occurred() && !fwd_collision.collision_occurred()) {
+        assert(rev_collision.collision_occurred(CollisionT::LEF_BAR));
+        const auto barrier_pos = barriers.pos(rev_collision.decode_index());
+        if (MODLE_UNLIKELY(collision_pos_fwd > barrier_pos)) {
+          rev_collision.set(fwd_idx, CollisionT::COLLISION | CollisionT::LEF_LEF_PRIMARY);
+        }
+        fwd_collision.set(rev_idx, CollisionT::COLLISION | CollisionT::LEF_LEF_PRIMARY);
+
+      } else if (!rev_collision.collision_occurred() && fwd_collision.collision_occurred()) {
+        assert(fwd_collision.collision_occurred(CollisionT::LEF_BAR));
+        const auto barrier_pos = barriers.pos(fwd_collision.decode_index());
+        rev_collision.set(fwd_idx, CollisionT::COLLISION | CollisionT::LEF_LEF_PRIMARY);
+        if (MODLE_UNLIKELY(collision_pos_rev < barrier_pos)) {
+          fwd_collision.set(rev_idx, CollisionT::COLLISION | CollisionT::LEF_LEF_PRIMARY);
+        }
+      }
+    }
+  }
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+void Simulation::correct_moves_and_detect_secondary_lef_lef_collisions(
+    const absl::Span<const Lef> lefs, const ExtrusionBarriers& barriers,
+    const absl::Span<const lef_idx_t> rev_lef_ranks,
+    const absl::Span<const lef_idx_t> fwd_lef_ranks,
+    const absl::Span<lef_move_t> rev_moves, const absl::Span<lef_move_t> fwd_moves,
+    const absl::Span<CollisionT> rev_collisions, const absl::Span<CollisionT> fwd_collisions,
+    const UnitPositionBuffers& buffs, random::PRNG_t& rand_eng, usize num_rev_units_at_5prime,
+    usize num_fwd_units_at_3prime) const noexcept(utils::ndebug_defined()) {
+  // This function is equivalent to calling Simulation::correct_moves_for_lef_bar_collisions,
+  // Simulation::correct_moves_for_primary_lef_lef_collisions and
+  // Simulation::process_secondary_lef_lef_collisions one after the other.
+  // This is possible because:
+  //  - Correcting the move of a unit only depends on the moves of units involved in a LEF-BAR or
+  //    primary LEF-LEF collision, which are not updated by the detection of secondary collisions
+  //  - Secondary collisions between the (i-1)-th and i-th units only depend on the moves of these
+  //    two units, which have already been corrected when the i-th unit is visited
+  //  - Random numbers are still drawn for rev units first, then for fwd units, and in the same
+  //    order as Simulation::process_secondary_lef_lef_collisions
+  const auto& rev_pos = buffs.rev_pos;
+  const auto& fwd_pos = buffs.fwd_pos;
+  const auto nunits = lefs.size();
+
+  // Target position of a unit whose move has been corrected for a LEF-BAR collision
+  auto lef_bar_collision_pos = [&](const CollisionT c, const dna::Direction d) {
+    assert(c.collision_occurred(CollisionT::LEF_BAR));
+    const auto barrier_pos = barriers.pos(c.decode_index());
+    return d == dna::REV ? barrier_pos + 1 : barrier_pos - 1;
+  };
+
+  // Loop over rev units in 5'-3' order
+  for (usize j = 0; j < nunits; ++j) {
+    const auto rev_idx = rev_lef_ranks[j];
+    const auto rev_collision = rev_collisions[rev_idx];
+    auto& rev_move = rev_moves[rev_idx];
+
+    if (MODLE_UNLIKELY(rev_collision.collision_occurred(CollisionT::LEF_BAR))) {
+      assert(rev_pos[j] > lef_bar_collision_pos(rev_collision, dna::REV) - 1);
+      rev_move =
+          static_cast<lef_move_t>(rev_pos[j] - lef_bar_collision_pos(rev_collision, dna::REV));
+    } else if (MODLE_UNLIKELY(rev_collision.collision_occurred(CollisionT::LEF_LEF_PRIMARY))) {
+      const auto fwd_idx = rev_collision.decode_index();
+      const auto fwd_collision = fwd_collisions[fwd_idx];
+      if (fwd_collision.collision_occurred(CollisionT::LEF_LEF_PRIMARY)) {
+        const auto& rev_unit = lefs[rev_idx].rev_unit;
+        const auto& fwd_unit = lefs[fwd_idx].fwd_unit;
+        auto& fwd_move = fwd_moves[fwd_idx];
+
+        const auto [p1, p2] = compute_lef_lef_collision_pos(rev_unit, fwd_unit, rev_move, fwd_move);
+        assert(rev_unit.pos() >= p1);
+        assert(fwd_unit.pos() <= p2);
+        rev_move = static_cast<lef_move_t>(rev_unit.pos() - p1);
+        fwd_move = static_cast<lef_move_t>(p2 - fwd_unit.pos());
+      } else if (fwd_collision.collision_occurred(CollisionT::LEF_BAR)) {
+        // The fwd unit will end up 1bp upstream of the barrier that is blocking it
+        const auto fwd_target_pos = lef_bar_collision_pos(fwd_collision, dna::FWD);
+        assert(rev_pos[j] >= fwd_target_pos);
+        rev_move = static_cast<lef_move_t>(rev_pos[j] - fwd_target_pos - 1);
+      }
+    }
+
+    if (j < std::max(usize(1), num_rev_units_at_5prime)) {
+      continue;
+    }
+
+    // Secondary LEF-LEF collisions (see Simulation::process_secondary_lef_lef_collisions)
+    const auto rev_idx1 = rev_lef_ranks[j - 1];
+    if (MODLE_LIKELY(!rev_collisions[rev_idx1].collision_occurred()) ||
+        rev_collisions[rev_idx].collision_occurred()) {
+      continue;
+    }
+
+    const auto rev_pos1 = rev_pos[j - 1];
+    const auto rev_pos2 = rev_pos[j];
+    const auto move1 = rev_moves[rev_idx1];
+    assert(rev_pos2 >= rev_pos1);
+    if (rev_pos2 - rev_move <= rev_pos1 - move1) {
+      if (this->run_lef_lef_collision_trial(rand_eng)) {
+        rev_collisions[rev_idx].set(rev_idx1,
+                                    CollisionT::COLLISION | CollisionT::LEF_LEF_SECONDARY);
+        const auto move = rev_pos2 - (rev_pos1 - move1);
+        rev_move = static_cast<lef_move_t>(std::min(move, move - 1));
+      } else {
+        rev_collisions[rev_idx].set(rev_idx1, CollisionT::LEF_LEF_SECONDARY);
+      }
+    }
+  }
+
+  // Loop over fwd units in 3'-5' order. The move of the (i-1)-th unit is corrected before
+  // processing secondary LEF-LEF collisions between the (i-1)-th and i-th units
+  auto correct_fwd_move = [&](const usize i) {
+    const auto fwd_idx = fwd_lef_ranks[i];
+    const auto fwd_collision = fwd_collisions[fwd_idx];
+    if (MODLE_UNLIKELY(fwd_collision.collision_occurred(CollisionT::LEF_BAR))) {
+      assert(lef_bar_collision_pos(fwd_collision, dna::FWD) + 1 > fwd_pos[i]);
+      fwd_moves[fwd_idx] =
+          static_cast<lef_move_t>(lef_bar_collision_pos(fwd_collision, dna::FWD) - fwd_pos[i]);
+    } else if (MODLE_UNLIKELY(fwd_collision.collision_occurred(CollisionT::LEF_LEF_PRIMARY))) {
+      const auto rev_idx = fwd_collision.decode_index();
+      if (rev_collisions[rev_idx].collision_occurred(CollisionT::LEF_BAR)) {
+        const auto& rev_unit = lefs[rev_idx].rev_unit;
+        const auto rev_move = rev_moves[rev_idx];
+        assert(rev_unit.pos() >= fwd_pos[i] + rev_move);
+        fwd_moves[fwd_idx] = static_cast<lef_move_t>((rev_unit.pos() - rev_move) - fwd_pos[i] - 1);
+      }
+    }
+  };
+
+  const auto last_active_fwd_unit =
+      nunits - std::min(num_fwd_units_at_3prime, num_fwd_units_at_3prime - 1) - 1;
+  assert(last_active_fwd_unit < nunits);
+  correct_fwd_move(nunits - 1);
+  for (auto i = nunits - 1; i > 0; --i) {
+    correct_fwd_move(i - 1);
+    if (i > last_active_fwd_unit) {
+      continue;
+    }
+
+    const auto fwd_idx2 = fwd_lef_ranks[i];
+    if (MODLE_LIKELY(!fwd_collisions[fwd_idx2].collision_occurred())) {
+      continue;
+    }
+
+    const auto fwd_idx1 = fwd_lef_ranks[i - 1];
+    if (fwd_collisions[fwd_idx1].collision_occurred()) {
+      continue;
+    }
+
+    const auto fwd_pos1 = fwd_pos[i - 1];
+    const auto fwd_pos2 = fwd_pos[i];
+    auto& move1 = fwd_moves[fwd_idx1];
+    const auto move2 = fwd_moves[fwd_idx2];
+    assert(fwd_pos2 >= fwd_pos1);
+    if (fwd_pos1 + move1 >= fwd_pos2 + move2) {
+      if (this->run_lef_lef_collision_trial(rand_eng)) {
+        fwd_collisions[fwd_idx1].set(fwd_idx2,
+                                     CollisionT::COLLISION | CollisionT::LEF_LEF_SECONDARY);
+        const auto move = (fwd_pos2 + move2) - fwd_pos1;
+        move1 = static_cast<lef_move_t>(std::min(move, move - 1));
+      } else {
+        fwd_collisions[fwd_idx1].set(fwd_idx2, CollisionT::LEF_LEF_SECONDARY);
+      }
+    }
+  }
+}
+
+}  // namespace modle
@@ -6,13 +6,17 @@
 
 // IWYU pragma: private, include "modle/simulation.hpp"
 
-#include <absl/types/span.h>  // for Span
-#include <fmt/format.h>       // for format_parse_context, format_error
+#include <absl/types/span.h>                  // for Span
+#include <fmt/format.h>                       // for format_parse_context, format_error
+#include <moodycamel/lightweightsemaphore.h>  // for LightweightSemaphore
 
 #include <BS_thread_pool.hpp>  // for BS::thread_pool
 #include <algorithm>           // for min
 #include <cassert>             // for assert
+#include <cstdint>             // for int64_t
+#include <iterator>            // for make_move_iterator
 #include <limits>              // for numeric_limits
+#include <stdexcept>           // for runtime_error
 #include <thread>              // for thread
 #include <type_traits>         // for declval, decay_t
 
@@ -27,8 +31,8 @@ namespace modle {
 
 template <typename MaskT>
 void Simulation::bind_lefs(const bp_t start_pos, const bp_t end_pos, const absl::Span<Lef> lefs,
-                           const absl::Span<usize> rev_lef_ranks,
-                           const absl::Span<usize> fwd_lef_ranks, const MaskT& mask,
+                           const absl::Span<lef_idx_t> rev_lef_ranks,
+                           const absl::Span<lef_idx_t> fwd_lef_ranks, const MaskT& mask,
                            random::PRNG_t& rand_eng,
                            usize current_epoch) noexcept(utils::ndebug_defined()) {
   using T = std::decay_t<decltype(std::declval<MaskT&>().operator[](std::declval<usize>()))>;
@@ -68,8 +72,8 @@ void Simulation::bind_lefs(const bp_t start_pos, const bp_t end_pos, const absl:
 
 template <typename MaskT>
 void Simulation::bind_lefs(const Chromosome& chrom, const absl::Span<Lef> lefs,
-                           const absl::Span<usize> rev_lef_ranks,
-                           const absl::Span<usize> fwd_lef_ranks, const MaskT& mask,
+                           const absl::Span<lef_idx_t> rev_lef_ranks,
+                           const absl::Span<lef_idx_t> fwd_lef_ranks, const MaskT& mask,
                            random::PRNG_t& rand_eng,
                            usize current_epoch) noexcept(utils::ndebug_defined()) {
   Simulation::bind_lefs(chrom.start_pos(), chrom.end_pos(), lefs, rev_lef_ranks, fwd_lef_ranks,
@@ -102,6 +106,7 @@ BS::thread_pool Simulation::instantiate_thread_pool(I nthreads_, bool clamp_nthr
 template <class TaskT>
 usize Simulation::consume_tasks_blocking(moodycamel::BlockingConcurrentQueue<TaskT>& task_queue,
                                          moodycamel::ConsumerToken& ctok,
+                                         moodycamel::LightweightSemaphore& free_slots,
                                          absl::FixedArray<TaskT>& task_buff) {
   while (this->ok()) {
     const auto avail_tasks = task_queue.wait_dequeue_bulk_timed(
@@ -115,11 +120,45 @@ usize Simulation::consume_tasks_blocking(moodycamel::BlockingConcurrentQueue<Tas
       // Keep waiting until one or more tasks become available
       continue;
     }
+    // Wake up the producer in case it is waiting for room in the queue
+    free_slots.signal(static_cast<moodycamel::LightweightSemaphore::ssize_t>(avail_tasks));
     return avail_tasks;
   }
   return 0;
 }
 
+template <class TaskT, class TaskIt>
+void Simulation::enqueue_tasks_blocking(moodycamel::BlockingConcurrentQueue<TaskT>& task_queue,
+                                        moodycamel::ProducerToken& ptok,
+                                        moodycamel::LightweightSemaphore& free_slots,
+                                        TaskIt first_task, const usize ntasks) {
+  using ssize_t = moodycamel::LightweightSemaphore::ssize_t;
+  // Block until consumers have made room for ntasks in the queue. The timeout is only used to
+  // periodically check whether one of the worker threads failed
+  constexpr std::int64_t timeout_us = 10'000;
+  const auto ntasks_ = static_cast<ssize_t>(ntasks);
+  for (ssize_t nslots = 0; nslots != ntasks_;) {
+    if (!this->ok()) {
+      this->handle_exceptions();
+    }
+    nslots += free_slots.waitMany(ntasks_ - nslots, timeout_us);
+  }
+
+  if (!task_queue.enqueue_bulk(ptok, std::make_move_iterator(first_task), ntasks)) {
+    throw std::runtime_error(
+        fmt::format(FMT_STRING("Failed to enqueue {} tasks: unable to allocate memory"), ntasks));
+  }
+}
+
+template <u8f Features>
+auto Simulation::State::epoch_rand_eng() noexcept -> epoch_rand_eng_t<Features>& {
+  if constexpr (has_feature(Features, FAST_SAMPLING)) {
+    return this->batch_rand_eng;
+  } else {
+    return this->rand_eng;
+  }
+}
+
 constexpr bool Simulation::run_lef_lef_collision_trial(random::PRNG_t& rand_eng) const noexcept {
   return this->probability_of_extrusion_unit_bypass == 0.0 ||
          random::bernoulli_trial{1.0 - this->probability_of_extrusion_unit_bypass}(rand_eng);
@@ -0,0 +1,362 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+#include "modle/task_file.hpp"
+
+#include <absl/types/span.h>  // for Span
+#include <fmt/format.h>       // for format, FMT_STRING
+
+#include <algorithm>                                 // for lower_bound, min, minmax_element
+#include <array>                                     // for array
+#include <boost/iostreams/device/array.hpp>          // for array_source
+#include <boost/iostreams/device/back_inserter.hpp>  // for back_inserter
+#include <boost/iostreams/filter/zstd.hpp>           // for zstd_compressor, zstd_decompressor
+#include <boost/iostreams/filtering_stream.hpp>      // for filtering_istream, filtering_ostream
+#include <cassert>                                   // for assert
+#include <filesystem>                                // for path
+#include <fstream>                                   // for ifstream, ofstream
+#include <ios>                                       // for streamsize, streamoff
+#include <stdexcept>                                 // for runtime_error
+#include <string>                                    // for string
+#include <string_view>                               // for string_view
+#include <type_traits>                               // for is_trivially_copyable_v
+#include <utility>                                   // for move
+#include <vector>                                    // for vector
+
+#include "modle/common/common.hpp"       // for u32, u64, usize
+#include "modle/common/fmt_helpers.hpp"  // IWYU pragma: keep
+
+namespace modle::task_file {
+
+static_assert(std::is_trivially_copyable_v<Record>);
+static_assert(std::is_trivially_copyable_v<BlockIndexEntry>);
+
+template <class T>
+static void write_binary(std::ostream& os, const T& value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+[[nodiscard]] static T read_binary(std::istream& is) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  T value{};
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  is.read(reinterpret_cast<char*>(&value), sizeof(T));
+  return value;
+}
+
+[[nodiscard]] static bool read_magic(std::istream& is) {
+  std::array<char, MAGIC.size()> buff{};
+  is.read(buff.data(), static_cast<std::streamsize>(buff.size()));
+  return is && std::string_view{buff.data(), buff.size()} == MAGIC;
+}
+
+bool is_task_file(const std::filesystem::path& path) {
+  std::ifstream fs(path, std::ios::binary);
+  return fs && read_magic(fs);
+}
+
+Writer::Writer(const std::filesystem::path& path, absl::Span<const ChromInfo> chroms,
+               usize block_size, u32 compression_lvl)
+    : _path(path),
+      _fs(path, std::ios::binary | std::ios::trunc),
+      _block_size(block_size),
+      _compression_lvl(compression_lvl) {
+  assert(block_size != 0);
+  if (!this->_fs) {
+    throw std::runtime_error(
+        fmt::format(FMT_STRING("Unable to open file {} for writing"), this->_path));
+  }
+  this->_block.reserve(this->_block_size);
+  this->write_header(chroms);
+}
+
+Writer::~Writer() noexcept {
+  try {
+    this->close();
+  } catch (...) {  // NOLINT(bugprone-empty-catch)
+  }
+}
+
+Writer& Writer::operator=(Writer&& other) {
+  if (this == &other) {
+    return *this;
+  }
+
+  this->close();
+  this->_path = std::move(other._path);
+  this->_fs = std::move(other._fs);
+  this->_block = std::move(other._block);
+  this->_index = std::move(other._index);
+  this->_compression_buff = std::move(other._compression_buff);
+  this->_block_size = other._block_size;
+  this->_compression_lvl = other._compression_lvl;
+
+  return *this;
+}
+
+bool Writer::is_open() const noexcept { return this->_fs.is_open(); }
+Writer::operator bool() const noexcept { return this->is_open(); }
+const std::filesystem::path& Writer::path() const noexcept { return this->_path; }
+
+void Writer::write(const Record& record) {
+  assert(this->is_open());
+  this->_block.push_back(record);
+  if (this->_block.size() == this->_block_size) {
+    this->write_block();
+  }
+}
+
+void Writer::write(absl::Span<const Record> records) {
+  for (const auto& record : records) {
+    this->write(record);
+  }
+}
+
+void Writer::close() {
+  if (!this->is_open()) {
+    return;
+  }
+  try {
+    this->write_block();
+    this->write_index();
+  } catch (...) {
+    // Files that could not be finalized are rejected by Reader, as their footer is missing
+    this->_fs.close();
+    throw;
+  }
+  this->_fs.close();
+}
+
+void Writer::write_header(absl::Span<const ChromInfo> chroms) {
+  this->_fs.write(MAGIC.data(), static_cast<std::streamsize>(MAGIC.size()));
+  write_binary(this->_fs, VERSION);
+  write_binary(this->_fs, static_cast<u32>(sizeof(Record)));
+  write_binary(this->_fs, static_cast<u64>(chroms.size()));
+  for (const auto& chrom : chroms) {
+    write_binary(this->_fs, chrom.id);
+    write_binary(this->_fs, static_cast<u64>(chrom.name.size()));
+    this->_fs.write(chrom.name.data(), static_cast<std::streamsize>(chrom.name.size()));
+  }
+}
+
+void Writer::write_block() {
+  namespace bio = boost::iostreams;
+  if (this->_block.empty()) {
+    return;
+  }
+
+  this->_compression_buff.clear();
+  bio::filtering_ostream fos{};
+  fos.push(bio::zstd_compressor(bio::zstd_params(this->_compression_lvl)));
+  fos.push(bio::back_inserter(this->_compression_buff));
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  fos.write(reinterpret_cast<const char*>(this->_block.data()),
+            static_cast<std::streamsize>(this->_block.size() * sizeof(Record)));
+  fos.reset();  // Flush and close the zstd frame
+
+  const auto [first, last] = std::minmax_element(
+      this->_block.begin(), this->_block.end(),
+      [](const auto& r1, const auto& r2) { return r1.id < r2.id; });
+
+  this->_index.push_back(BlockIndexEntry{static_cast<u64>(this->_fs.tellp()),
+                                         static_cast<u64>(this->_compression_buff.size()),
+                                         static_cast<u64>(this->_block.size()), first->id,
+                                         last->id});
+  this->_fs.write(this->_compression_buff.data(),
+                  static_cast<std::streamsize>(this->_compression_buff.size()));
+  this->_block.clear();
+
+  if (!this->_fs) {
+    throw std::runtime_error(
+        fmt::format(FMT_STRING("An error occurred while writing tasks to file {}"), this->_path));
+  }
+}
+
+void Writer::write_index() {
+  const auto index_offset = static_cast<u64>(this->_fs.tellp());
+  for (const auto& entry : this->_index) {
+    write_binary(this->_fs, entry);
+  }
+  write_binary(this->_fs, index_offset);
+  write_binary(this->_fs, static_cast<u64>(this->_index.size()));
+  this->_fs.write(MAGIC.data(), static_cast<std::streamsize>(MAGIC.size()));
+
+  if (!this->_fs) {
+    throw std::runtime_error(fmt::format(
+        FMT_STRING("An error occurred while writing the task index to file {}"), this->_path));
+  }
+}
+
+Reader::Reader(const std::filesystem::path& path) : _path(path), _fs(path, std::ios::binary) {
+  if (!this->_fs) {
+    throw std::runtime_error(
+        fmt::format(FMT_STRING("Unable to open file {} for reading"), this->_path));
+  }
+  this->_fs.seekg(0, std::ios::end);
+  this->_file_size = static_cast<u64>(this->_fs.tellg());
+  this->_fs.seekg(0);
+  try {
+    this->read_header();
+    this->read_index();
+  } catch (const std::runtime_error& e) {
+    throw std::runtime_error(fmt::format(
+        FMT_STRING("File {} is not a valid task file: {}"), this->_path, e.what()));
+  }
+}
+
+const std::filesystem::path& Reader::path() const noexcept { return this->_path; }
+absl::Span<const ChromInfo> Reader::chromosomes() const noexcept { return this->_chroms; }
+usize Reader::num_blocks() const noexcept { return this->_index.size(); }
+
+usize Reader::num_records() const noexcept {
+  usize n = 0;
+  for (const auto& entry : this->_index) {
+    n += static_cast<usize>(entry.num_records);
+  }
+  return n;
+}
+
+std::vector<usize> Reader::find_blocks(absl::Span<const u64> task_ids) const {
+  assert(std::is_sorted(task_ids.begin(), task_ids.end()));
+  std::vector<usize> blocks{};
+  for (usize i = 0; i < this->_index.size(); ++i) {
+    const auto& entry = this->_index[i];
+    const auto it = std::lower_bound(task_ids.begin(), task_ids.end(), entry.first_id);
+    if (it != task_ids.end() && *it <= entry.last_id) {
+      blocks.push_back(i);
+    }
+  }
+  return blocks;
+}
+
+void Reader::read_block(usize i, std::vector<Record>& buff) {
+  namespace bio = boost::iostreams;
+  const auto& entry = this->_index.at(i);
+
+  this->_compression_buff.resize(static_cast<usize>(entry.compressed_size));
+  this->_fs.seekg(static_cast<std::streamoff>(entry.offset));
+  this->_fs.read(this->_compression_buff.data(),
+                 static_cast<std::streamsize>(this->_compression_buff.size()));
+  if (!this->_fs) {
+    throw std::runtime_error(fmt::format(
+        FMT_STRING("Unable to read task block #{} from file {}"), i, this->_path));
+  }
+
+  bio::filtering_istream fis{};
+  fis.push(bio::zstd_decompressor());
+  fis.push(bio::array_source(this->_compression_buff.data(), this->_compression_buff.size()));
+
+  // The number of records comes from the file: grow buff as records are decompressed, so that a
+  // corrupted index entry cannot trigger huge allocations
+  constexpr usize max_records_per_read = 4096;
+  const auto num_records = static_cast<usize>(entry.num_records);
+  buff.clear();
+  while (buff.size() < num_records) {
+    const auto offset = buff.size();
+    buff.resize(offset + std::min(max_records_per_read, num_records - offset));
+    const auto num_bytes = static_cast<std::streamsize>((buff.size() - offset) * sizeof(Record));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    fis.read(reinterpret_cast<char*>(buff.data() + offset), num_bytes);
+    if (fis.gcount() != num_bytes) {
+      throw std::runtime_error(
+          fmt::format(FMT_STRING("Task block #{} from file {} is truncated: expected {} records, "
+                                 "found {}"),
+                      i, this->_path, num_records,
+                      offset + (static_cast<usize>(fis.gcount()) / sizeof(Record))));
+    }
+  }
+}
+
+void Reader::read_header() {
+  if (!read_magic(this->_fs)) {
+    throw std::runtime_error("invalid magic string");
+  }
+  const auto version = read_binary<u32>(this->_fs);
+  if (version != VERSION) {
+    throw std::runtime_error(
+        fmt::format(FMT_STRING("unsupported version: expected {}, found {}"), VERSION, version));
+  }
+  const auto record_size = read_binary<u32>(this->_fs);
+  if (record_size != sizeof(Record)) {
+    throw std::runtime_error(fmt::format(FMT_STRING("expected records of {} bytes, found {}"),
+                                         sizeof(Record), record_size));
+  }
+
+  // Sizes read from the file are checked against the number of bytes left before using them to
+  // allocate memory. Each chromosome takes at least 16 bytes (ID and name length)
+  const auto num_chroms = read_binary<u64>(this->_fs);
+  if (num_chroms > this->remaining_bytes() / (2 * sizeof(u64))) {
+    throw std::runtime_error(fmt::format(
+        FMT_STRING("header is truncated or corrupted: unable to read {} chromosomes"), num_chroms));
+  }
+  this->_chroms.resize(static_cast<usize>(num_chroms));
+  for (auto& chrom : this->_chroms) {
+    chrom.id = read_binary<u64>(this->_fs);
+    const auto name_size = read_binary<u64>(this->_fs);
+    if (name_size > this->remaining_bytes()) {
+      throw std::runtime_error(fmt::format(
+          FMT_STRING("header is truncated or corrupted: unable to read the name of chromosome #{} "
+                     "({} bytes)"),
+          chrom.id, name_size));
+    }
+    chrom.name.resize(static_cast<usize>(name_size));
+    this->_fs.read(chrom.name.data(), static_cast<std::streamsize>(chrom.name.size()));
+  }
+  if (!this->_fs) {
+    throw std::runtime_error("header is truncated");
+  }
+}
+
+void Reader::read_index() {
+  constexpr auto footer_size = static_cast<std::streamoff>(2 * sizeof(u64) + MAGIC.size());
+  this->_fs.seekg(-footer_size, std::ios::end);
+  const auto index_offset = read_binary<u64>(this->_fs);
+  const auto num_blocks = read_binary<u64>(this->_fs);
+  if (!read_magic(this->_fs)) {
+    throw std::runtime_error("footer is missing or corrupted. Was the file closed properly?");
+  }
+
+  // The index is written right before the footer: check that the offset and number of blocks
+  // read from the footer agree with this before allocating memory for the index
+  const auto index_end = this->_file_size - static_cast<u64>(footer_size);
+  if (index_offset > index_end || (index_end - index_offset) % sizeof(BlockIndexEntry) != 0 ||
+      num_blocks != (index_end - index_offset) / sizeof(BlockIndexEntry)) {
+    throw std::runtime_error(fmt::format(
+        FMT_STRING("block index is corrupted: unable to read {} blocks starting at offset {}"),
+        num_blocks, index_offset));
+  }
+
+  this->_index.resize(static_cast<usize>(num_blocks));
+  this->_fs.seekg(static_cast<std::streamoff>(index_offset));
+  for (auto& entry : this->_index) {
+    entry = read_binary<BlockIndexEntry>(this->_fs);
+  }
+  if (!this->_fs) {
+    throw std::runtime_error("block index is truncated");
+  }
+
+  // Blocks are stored between the header and the index
+  for (usize i = 0; i < this->_index.size(); ++i) {
+    const auto& entry = this->_index[i];
+    if (entry.offset > index_offset || entry.compressed_size > index_offset - entry.offset) {
+      throw std::runtime_error(fmt::format(
+          FMT_STRING("block index is corrupted: block #{} ({} bytes at offset {}) overlaps with "
+                     "the index"),
+          i, entry.compressed_size, entry.offset));
+    }
+  }
+}
+
+u64 Reader::remaining_bytes() {
+  const auto pos = this->_fs.tellg();
+  if (!this->_fs || pos < 0) {
+    return 0;
+  }
+  return this->_file_size - std::min(this->_file_size, static_cast<u64>(pos));
+}
+
+}  // namespace modle::task_file
@@ -6,22 +6,76 @@
 
 #include <cpp-sort/sorters/pdq_sorter.h>  // for pdq_sort
 
-#include <algorithm>  // for clamp
+#include <algorithm>  // for clamp, is_sorted, make_heap, pop_heap, push_heap
+#include <atomic>     // for memory_order_relaxed
 #include <cassert>    // for assert
 #include <limits>     // for numeric_limits
+#include <memory>     // for make_shared
+#include <utility>    // for move
 #include <vector>     // for vector
 
 #include "modle/common/common.hpp"  // for bp_t, Direction, fwd, none
 #include "modle/common/dna.hpp"     // for dna::Direction, dna::NONE
-#include "modle/common/random.hpp"  // for PRNG_t
+#include "modle/common/random.hpp"  // for PRNG_t, geometric_trials
 
 namespace modle {
 
+ExtrusionBarriers::ExtrusionBarriers(const ExtrusionBarriers& other)
+    : _table(other._table),
+      _table_is_shared(true),
+      _state(other._state),
+      _disabled(other._disabled),
+      _transitions(other._transitions),
+      _epoch(other._epoch),
+      _transitions_are_stale(other._transitions_are_stale) {
+  other._table_is_shared.store(true, std::memory_order_relaxed);
+}
+
+ExtrusionBarriers::ExtrusionBarriers(ExtrusionBarriers&& other) noexcept
+    : _table(std::move(other._table)),
+      _table_is_shared(other._table_is_shared.load(std::memory_order_relaxed)),
+      _state(std::move(other._state)),
+      _disabled(std::move(other._disabled)),
+      _transitions(std::move(other._transitions)),
+      _epoch(other._epoch),
+      _transitions_are_stale(other._transitions_are_stale) {}
+
+ExtrusionBarriers& ExtrusionBarriers::operator=(const ExtrusionBarriers& other) {
+  if (this == &other) {
+    return *this;
+  }
+
+  this->_table = other._table;
+  this->_table_is_shared.store(true, std::memory_order_relaxed);
+  other._table_is_shared.store(true, std::memory_order_relaxed);
+  this->_state = other._state;
+  this->_disabled = other._disabled;
+  this->_transitions = other._transitions;
+  this->_epoch = other._epoch;
+  this->_transitions_are_stale = other._transitions_are_stale;
+  return *this;
+}
+
+ExtrusionBarriers& ExtrusionBarriers::operator=(ExtrusionBarriers&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+
+  this->_table = std::move(other._table);
+  this->_table_is_shared.store(other._table_is_shared.load(std::memory_order_relaxed),
+                               std::memory_order_relaxed);
+  this->_state = std::move(other._state);
+  this->_disabled = std::move(other._disabled);
+  this->_transitions = std::move(other._transitions);
+  this->_epoch = other._epoch;
+  this->_transitions_are_stale = other._transitions_are_stale;
+  return *this;
+}
+
 ExtrusionBarriers::ExtrusionBarriers(usize size)
-    : _pos(size),
-      _direction(size, dna::NONE),
-      _stp_active(size),
-      _stp_inactive(size),
+    : _table(std::make_shared<Table>(
+          Table{std::vector<bp_t>(size), std::vector<dna::Direction>(size, dna::NONE),
+                std::vector<TP>(size), std::vector<TP>(size)})),
       _state(size) {}
 
 ExtrusionBarriers::ExtrusionBarriers(std::initializer_list<bp_t> pos,
@@ -29,13 +83,11 @@ ExtrusionBarriers::ExtrusionBarriers(std::initializer_list<bp_t> pos,
                                      std::initializer_list<TP> stp_active,    // NOLINT
                                      std::initializer_list<TP> stp_inactive,  // NOLINT
                                      std::initializer_list<State> state, bool sort)
-    : _pos(pos),
-      _direction(direction),
-      _stp_active(stp_active),
-      _stp_inactive(stp_inactive),
+    : _table(std::make_shared<Table>(Table{pos, direction, stp_active, stp_inactive})),
       _state(state) {
   this->assert_buffer_sizes_are_equal();
-  assert(std::all_of(this->_direction.begin(), this->_direction.end(),
+  this->invalidate_transitions();
+  assert(std::all_of(this->_table->direction.begin(), this->_table->direction.end(),
                      [](const auto d) { return d != dna::NONE; }));
 
   if (sort) {
@@ -49,14 +101,15 @@ ExtrusionBarriers::ExtrusionBarriers(std::initializer_list<ExtrusionBarrier> bar
   assert(this->size() == states.size());
   this->_state = states;
 
+  auto& table = this->mutable_table();
   for (usize i = 0; i < barriers.size(); ++i) {
     // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
     const auto& b = *(std::begin(barriers) + static_cast<isize>(i));
 
-    this->_pos[i] = b.pos;
-    this->_direction[i] = b.blocking_direction;
-    this->_stp_active[i] = b.stp_active;
-    this->_stp_inactive[i] = b.stp_inactive;
+    table.pos[i] = b.pos;
+    table.direction[i] = b.blocking_direction;
+    table.stp_active[i] = b.stp_active;
+    table.stp_inactive[i] = b.stp_inactive;
   }
 
   if (sort) {
@@ -66,59 +119,67 @@ ExtrusionBarriers::ExtrusionBarriers(std::initializer_list<ExtrusionBarrier> bar
 
 usize ExtrusionBarriers::size() const noexcept {
   this->assert_buffer_sizes_are_equal();
-  return this->_pos.size();
+  return this->_state.size();
 }
 
 bool ExtrusionBarriers::empty() const noexcept { return this->size() == 0; }
 
 void ExtrusionBarriers::resize(usize new_size) {
-  this->_pos.resize(new_size);
-  this->_direction.resize(new_size, dna::NONE);
-  this->_stp_active.resize(new_size);
-  this->_stp_inactive.resize(new_size);
+  auto& table = this->mutable_table();
+  table.pos.resize(new_size);
+  table.direction.resize(new_size, dna::NONE);
+  table.stp_active.resize(new_size);
+  table.stp_inactive.resize(new_size);
   this->_state.resize(new_size);
+  if (!this->_disabled.empty()) {
+    this->_disabled.resize(new_size, false);
+  }
 
   this->assert_buffer_sizes_are_equal();
+  this->invalidate_transitions();
 }
 
-void ExtrusionBarriers::clear() noexcept {
-  this->_pos.clear();
-  this->_direction.clear();
-  this->_stp_active.clear();
-  this->_stp_inactive.clear();
+void ExtrusionBarriers::clear() {
+  auto& table = this->mutable_table();
+  table.pos.clear();
+  table.direction.clear();
+  table.stp_active.clear();
+  table.stp_inactive.clear();
   this->_state.clear();
+  this->_disabled.clear();
 
   this->assert_buffer_sizes_are_equal();
+  this->invalidate_transitions();
 }
 
 bp_t ExtrusionBarriers::pos(usize i) const noexcept {
   this->assert_index_within_bounds(i);
-  return this->_pos[i];
+  return this->_table->pos[i];
 }
-const std::vector<bp_t>& ExtrusionBarriers::pos() const noexcept { return this->_pos; }
+const std::vector<bp_t>& ExtrusionBarriers::pos() const noexcept { return this->_table->pos; }
 
 dna::Direction ExtrusionBarriers::direction(usize i) const noexcept {
   this->assert_index_within_bounds(i);
-  return this->_direction[i];
+  return this->_table->direction[i];
 }
 const std::vector<dna::Direction>& ExtrusionBarriers::direction() const noexcept {
-  return this->_direction;
+  return this->_table->direction;
 }
 
 double ExtrusionBarriers::stp_active(usize i) const noexcept {
   this->assert_index_within_bounds(i);
-  return this->_stp_active[i]();
+  return MODLE_UNLIKELY(this->is_disabled(i)) ? 0.0 : this->_table->stp_active[i]();
 }
 auto ExtrusionBarriers::stp_active() const noexcept -> const std::vector<TP>& {
-  return this->_stp_active;
+  return this->_table->stp_active;
 }
 
 double ExtrusionBarriers::stp_inactive(usize i) const noexcept {
   this->assert_index_within_bounds(i);
-  return this->_stp_inactive[i]();
+  return MODLE_UNLIKELY(this->is_disabled(i)) ? 1.0 : this->_table->stp_inactive[i]();
 }
 auto ExtrusionBarriers::stp_inactive() const noexcept -> const std::vector<TP>& {
-  return this->_stp_inactive;
+  return this->_table->stp_inactive;
 }
 
 auto ExtrusionBarriers::state(usize i) const noexcept -> State {
@@ -151,6 +212,7 @@ auto ExtrusionBarriers::next_state(usize i, random::PRNG_t& rand_eng) noexcept -
     this->_state[i] = State::INACTIVE;
   }
 
+  this->invalidate_transitions();
   return this->_state[i];
 }
 
@@ -160,6 +222,50 @@ void ExtrusionBarriers::next_state(random::PRNG_t& rand_eng) noexcept {
   }
 }
 
+void ExtrusionBarriers::next_state_scheduled(random::PRNG_t& rand_eng) {
+  if (MODLE_UNLIKELY(this->_transitions_are_stale)) {
+    this->rebuild_transitions(rand_eng);
+  }
+
+  constexpr auto cmp = [](const auto& t1, const auto& t2) { return t1.epoch > t2.epoch; };
+  ++this->_epoch;
+  while (!this->_transitions.empty() && this->_transitions.front().epoch == this->_epoch) {
+    std::pop_heap(this->_transitions.begin(), this->_transitions.end(), cmp);
+    const auto i = this->_transitions.back().idx;
+    this->_transitions.pop_back();
+
+    this->_state[i] = this->is_active(i) ? State::INACTIVE : State::ACTIVE;
+    this->schedule_next_transition(i, rand_eng);
+  }
+  assert(this->_transitions.empty() || this->_transitions.front().epoch > this->_epoch);
+}
+
+void ExtrusionBarriers::schedule_next_transition(usize i, random::PRNG_t& rand_eng) {
+  // The number of epochs spent by a barrier in its current state is geometrically distributed,
+  // with probability of success (i.e. of changing state) equal to 1 - stp
+  const auto stp = this->is_active(i) ? this->stp_active(i) : this->stp_inactive(i);
+  const auto dwell_time = random::geometric_trials(1.0 - stp, rand_eng);
+  if (dwell_time == (std::numeric_limits<u64>::max)()) {
+    return;
+  }
+
+  constexpr auto cmp = [](const auto& t1, const auto& t2) { return t1.epoch > t2.epoch; };
+  this->_transitions.push_back(Transition{this->_epoch + dwell_time, i});
+  std::push_heap(this->_transitions.begin(), this->_transitions.end(), cmp);
+}
+
+void ExtrusionBarriers::rebuild_transitions(random::PRNG_t& rand_eng) {
+  this->_epoch = 0;
+  this->_transitions.clear();
+  this->_transitions.reserve(this->size());
+  for (usize i = 0; i < this->size(); ++i) {
+    this->schedule_next_transition(i, rand_eng);
+  }
+  this->_transitions_are_stale = false;
+}
+
+void ExtrusionBarriers::invalidate_transitions() noexcept { this->_transitions_are_stale = true; }
+
 usize ExtrusionBarriers::count_active() const noexcept {
   return static_cast<usize>(std::count(this->_state.begin(), this->_state.end(), State::ACTIVE));
 }
@@ -171,10 +277,26 @@ usize ExtrusionBarriers::count_inactive() const noexcept {
 }
 
 void ExtrusionBarriers::assert_buffer_sizes_are_equal() const noexcept {
-  assert(this->_pos.size() == this->_direction.size());
-  assert(this->_pos.size() == this->_stp_active.size());
-  assert(this->_pos.size() == this->_stp_inactive.size());
-  assert(this->_pos.size() == this->_state.size());
+  assert(this->_table);
+  assert(this->_table->pos.size() == this->_table->direction.size());
+  assert(this->_table->pos.size() == this->_table->stp_active.size());
+  assert(this->_table->pos.size() == this->_table->stp_inactive.size());
+  assert(this->_table->pos.size() == this->_state.size());
+  assert(this->_disabled.empty() || this->_disabled.size() == this->_state.size());
+}
+
+auto ExtrusionBarriers::mutable_table() -> Table& {
+  // Copy the table before modifying it when it has been shared with other ExtrusionBarriers.
+  // Relaxed ordering is enough: the flag is only set while copying from this object, which has to
+  // be synchronized with calls to non-const member functions anyway
+  if (!this->_table) {
+    this->_table = std::make_shared<Table>();
+    this->_table_is_shared.store(false, std::memory_order_relaxed);
+  } else if (this->_table_is_shared.load(std::memory_order_relaxed)) {
+    this->_table = std::make_shared<Table>(*this->_table);
+    this->_table_is_shared.store(false, std::memory_order_relaxed);
+  }
+  return *this->_table;
 }
 
 void ExtrusionBarriers::assert_index_within_bounds([[maybe_unused]] usize i) const noexcept {
@@ -182,27 +304,37 @@ void ExtrusionBarriers::assert_index_within_bounds([[maybe_unused]] usize i) con
 }
 
 void ExtrusionBarriers::set(usize i, bp_t pos, dna::Direction direction, TP stp_active,
-                            TP stp_inactive, State state) noexcept {
+                            TP stp_inactive, State state) {
   this->assert_index_within_bounds(i);
   assert(direction != dna::NONE);
-  this->_pos[i] = pos;
-  this->_direction[i] = direction;
-  this->_stp_active[i] = stp_active;
-  this->_stp_inactive[i] = stp_inactive;
+  auto& table = this->mutable_table();
+  table.pos[i] = pos;
+  table.direction[i] = direction;
+  table.stp_active[i] = stp_active;
+  table.stp_inactive[i] = stp_inactive;
   this->_state[i] = state;
+  if (!this->_disabled.empty()) {
+    this->_disabled[i] = false;
+  }
+  this->invalidate_transitions();
 }
 
 void ExtrusionBarriers::push_back(bp_t pos, dna::Direction direction, TP stp_active,
                                   TP stp_inactive, State state) {
   assert(direction != dna::NONE);
-  this->_pos.push_back(pos);
-  this->_direction.push_back(direction);
-  this->_stp_active.push_back(stp_active);
-  this->_stp_inactive.push_back(stp_inactive);
+  auto& table = this->mutable_table();
+  table.pos.push_back(pos);
+  table.direction.push_back(direction);
+  table.stp_active.push_back(stp_active);
+  table.stp_inactive.push_back(stp_inactive);
   this->_state.push_back(state);
+  if (!this->_disabled.empty()) {
+    this->_disabled.push_back(false);
+  }
+  this->invalidate_transitions();
 }
 
-void ExtrusionBarriers::set(usize i, const ExtrusionBarrier& barrier, State state) noexcept {
+void ExtrusionBarriers::set(usize i, const ExtrusionBarrier& barrier, State state) {
   this->set(i, barrier.pos, barrier.blocking_direction, barrier.stp_active, barrier.stp_inactive,
             state);
 }
@@ -215,12 +347,43 @@ void ExtrusionBarriers::push_back(const ExtrusionBarrier& barrier, State state)
 void ExtrusionBarriers::set(usize i, State state) noexcept {
   this->assert_index_within_bounds(i);
   this->_state[i] = state;
+  this->invalidate_transitions();
+}
+
+void ExtrusionBarriers::assign(const ExtrusionBarriers& other, State state) {
+  other.assert_buffer_sizes_are_equal();
+  this->_table = other._table;
+  this->_table_is_shared.store(true, std::memory_order_relaxed);
+  other._table_is_shared.store(true, std::memory_order_relaxed);
+  this->_state.assign(other.size(), state);
+  this->_disabled.clear();
+  this->invalidate_transitions();
+}
+
+bool ExtrusionBarriers::shares_table_with(const ExtrusionBarriers& other) const noexcept {
+  return this->_table == other._table;
+}
+
+void ExtrusionBarriers::disable(usize i) {
+  this->assert_index_within_bounds(i);
+  if (this->_disabled.empty()) {
+    this->_disabled.resize(this->size(), false);
+  }
+  this->_disabled[i] = true;
+  this->_state[i] = State::INACTIVE;
+  this->invalidate_transitions();
+}
+
+bool ExtrusionBarriers::is_disabled(usize i) const noexcept {
+  this->assert_index_within_bounds(i);
+  return !this->_disabled.empty() && this->_disabled[i];
 }
 
 auto ExtrusionBarriers::init_state(usize i, random::PRNG_t& rand_eng) noexcept -> State {
   this->assert_index_within_bounds(i);
   this->_state[i] =
       random::bernoulli_trial{this->occupancy(i)}(rand_eng) ? State::ACTIVE : State::INACTIVE;
+  this->invalidate_transitions();
 
   return this->_state[i];
 }
@@ -242,20 +405,31 @@ void ExtrusionBarriers::sort(std::vector<usize>& idx_buff) {
 
   cppsort::pdq_sort(idx_buff.begin(), idx_buff.end(),
                     [&](const auto i1, const auto i2) { return this->pos(i1) < this->pos(i2); });
+  if (std::is_sorted(idx_buff.begin(), idx_buff.end())) {
+    // Avoid copying a shared table when barriers are already sorted
+    this->invalidate_transitions();
+    return;
+  }
+
+  auto& table = this->mutable_table();
   for (usize i = 0; i < this->size(); ++i) {
     // https://stackoverflow.com/a/22218699
     while (idx_buff[i] != i) {
       const auto j = idx_buff[i];
       const auto k = idx_buff[j];
 
-      std::swap(this->_pos[j], this->_pos[k]);
-      std::swap(this->_direction[j], this->_direction[k]);
-      std::swap(this->_stp_active[j], this->_stp_active[k]);
-      std::swap(this->_stp_inactive[j], this->_stp_inactive[k]);
+      std::swap(table.pos[j], table.pos[k]);
+      std::swap(table.direction[j], table.direction[k]);
+      std::swap(table.stp_active[j], table.stp_active[k]);
+      std::swap(table.stp_inactive[j], table.stp_inactive[k]);
       std::swap(this->_state[j], this->_state[k]);
+      if (!this->_disabled.empty()) {
+        std::vector<bool>::swap(this->_disabled[j], this->_disabled[k]);
+      }
       std::swap(idx_buff[i], idx_buff[j]);
     }
   }
+  this->invalidate_transitions();
 }
 
 }  // namespace modle
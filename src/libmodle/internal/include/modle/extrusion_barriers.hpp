@@ -6,8 +6,10 @@
 
 #include <fmt/format.h>
 
+#include <atomic>   // for atomic
 #include <cassert>  // for assert
 #include <initializer_list>
+#include <memory>  // for shared_ptr, make_shared
 #include <vector>  // for vector
 
 #include "modle/common/common.hpp"  // for bp_t
@@ -34,15 +36,41 @@ class ExtrusionBarriers {
   enum class State : u8f { INACTIVE = 0, ACTIVE = 1 };
   using TP = internal::TransitionProbability;
 
+  /// Barrier properties that do not change over the course of a simulation.
+
+  //! Tables are shared between copies of the same ExtrusionBarriers object (copy-on-write):
+  //! copying an ExtrusionBarriers only copies the barrier states, while member functions modifying
+  //! the table (e.g. set, push_back or sort) first make a private copy of the table if it was ever
+  //! shared with another object.
+  struct Table {
+    std::vector<bp_t> pos{};
+    std::vector<dna::Direction> direction{};
+    std::vector<TP> stp_active{};
+    std::vector<TP> stp_inactive{};
+  };
+
  private:
-  std::vector<bp_t> _pos{};
-  std::vector<dna::Direction> _direction{};
-  std::vector<TP> _stp_active{};
-  std::vector<TP> _stp_inactive{};
+  std::shared_ptr<Table> _table{std::make_shared<Table>()};
+  // Set on both objects whenever _table is shared through a copy or assign(). Tables that have been
+  // shared are never modified in place, as shared_ptr::use_count() is not reliable across threads
+  mutable std::atomic<bool> _table_is_shared{false};
   std::vector<State> _state{};
+  // Barriers disabled through ExtrusionBarriers::disable. Empty when no barrier is disabled
+  std::vector<bool> _disabled{};
+
+  // Pending state transitions. Entries are stored as a binary min-heap ordered by epoch
+  struct Transition {
+    u64 epoch;
+    usize idx;
+  };
+  std::vector<Transition> _transitions{};
+  u64 _epoch{};
+  bool _transitions_are_stale{true};
 
  public:
   ExtrusionBarriers() = default;
+  ExtrusionBarriers(const ExtrusionBarriers& other);
+  ExtrusionBarriers(ExtrusionBarriers&& other) noexcept;
   explicit ExtrusionBarriers(usize size);
   template <class BarrierIt, class StateIt>
   ExtrusionBarriers(BarrierIt first_barrier, BarrierIt last_barrier, StateIt first_state,
@@ -56,21 +84,36 @@ class ExtrusionBarriers {
                     std::initializer_list<State> state, bool sort = true);
   ExtrusionBarriers(std::initializer_list<ExtrusionBarrier> barriers,
                     std::initializer_list<State> states, bool sort = true);
+  ~ExtrusionBarriers() = default;
+
+  ExtrusionBarriers& operator=(const ExtrusionBarriers& other);
+  ExtrusionBarriers& operator=(ExtrusionBarriers&& other) noexcept;
 
   void set(usize i, bp_t pos, dna::Direction direction, TP stp_active, TP stp_inactive,
-           State state = State::INACTIVE) noexcept;
+           State state = State::INACTIVE);
   void push_back(bp_t pos, dna::Direction direction, TP stp_active, TP stp_inactive,
                  State state = State::INACTIVE);
-  void set(usize i, const ExtrusionBarrier& barrier, State state = State::INACTIVE) noexcept;
+  void set(usize i, const ExtrusionBarrier& barrier, State state = State::INACTIVE);
   void push_back(const ExtrusionBarrier& barrier, State state = State::INACTIVE);
   void set(usize i, State state) noexcept;
+  /// Share the barrier table of \p other and set the state of all barriers to \p state.
+
+  //! This does not allocate as long as the buffer used to store barrier states is large enough.
+  void assign(const ExtrusionBarriers& other, State state = State::INACTIVE);
+  [[nodiscard]] bool shares_table_with(const ExtrusionBarriers& other) const noexcept;
+  /// Permanently deactivate barrier \p i without modifying the (possibly shared) barrier table.
+
+  //! Disabled barriers are set to INACTIVE, and behave as if their stp_active and stp_inactive were
+  //! 0 and 1 respectively. Barriers are re-enabled by assign, or by overwriting them with set.
+  void disable(usize i);
+  [[nodiscard]] bool is_disabled(usize i) const noexcept;
   auto init_state(usize i, random::PRNG_t& rand_eng) noexcept -> State;
   void init_states(random::PRNG_t& rand_eng) noexcept;
 
   [[nodiscard]] usize size() const noexcept;
   [[nodiscard]] bool empty() const noexcept;
   void resize(usize new_size);
-  void clear() noexcept;
+  void clear();
 
   [[nodiscard]] bp_t pos(usize i) const noexcept;
   [[nodiscard]] dna::Direction direction(usize i) const noexcept;
@@ -81,6 +124,11 @@ class ExtrusionBarriers {
   [[nodiscard]] bool is_not_active(usize i) const noexcept;
   [[nodiscard]] double occupancy(usize i) const noexcept;
 
+  // Raw accessors to the (possibly shared) barrier table and to the barrier states.
+  // Unlike stp_active(i) and stp_inactive(i), stp_active() and stp_inactive() return the transition
+  // probabilities stored in the barrier table and do not take disabled barriers into account:
+  // callers iterating over these vectors should skip barriers for which is_disabled(i) is true.
+  // The simulation kernels only access transition probabilities through the per-index accessors
   [[nodiscard]] const std::vector<bp_t>& pos() const noexcept;
   [[nodiscard]] const std::vector<dna::Direction>& direction() const noexcept;
   [[nodiscard]] auto stp_active() const noexcept -> const std::vector<TP>&;
@@ -88,7 +136,19 @@ class ExtrusionBarriers {
   [[nodiscard]] auto state() const noexcept -> const std::vector<State>&;
 
   auto next_state(usize i, random::PRNG_t& rand_eng) noexcept -> State;
+  /// Advance the state of all barriers by one epoch, running one Bernoulli trial per barrier
   void next_state(random::PRNG_t& rand_eng) noexcept;
+  /// Advance the state of all barriers by one epoch (used when Config::fast_sampling is set).
+
+  //! Instead of running one Bernoulli trial per barrier per epoch, the time spent by each barrier
+  //! in its current state is drawn from the geometric distribution implied by its self-transition
+  //! probability, and only barriers whose timer expires during the current epoch are updated.
+  //! The resulting process is identical in distribution to running one trial per epoch, but its
+  //! cost scales with the number of state transitions rather than with the number of barriers.
+  //! Modifying barriers through any other member function invalidates pending transitions, which
+  //! are then re-drawn from the current states on the next call (this is exact, as geometric
+  //! dwell times are memoryless).
+  void next_state_scheduled(random::PRNG_t& rand_eng);
 
   [[nodiscard]] usize count_active() const noexcept;
   [[nodiscard]] usize count_inactive() const noexcept;
@@ -99,6 +159,12 @@ class ExtrusionBarriers {
  private:
   void assert_buffer_sizes_are_equal() const noexcept;
   void assert_index_within_bounds(usize i) const noexcept;
+
+  [[nodiscard]] Table& mutable_table();
+
+  void schedule_next_transition(usize i, random::PRNG_t& rand_eng);
+  void rebuild_transitions(random::PRNG_t& rand_eng);
+  void invalidate_transitions() noexcept;
 };
 
 struct ExtrusionBarrier {
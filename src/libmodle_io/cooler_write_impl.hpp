@@ -30,9 +30,17 @@
 #include <absl/time/time.h>   // for FormatTime, UTCTimeZone
 #include <fmt/format.h>       // for format
 
-#include <string>       // for string
-#include <string_view>  // for string_view
-#include <tuple>        // for ignore
+#include <BS_thread_pool.hpp>  // for BS::thread_pool
+#include <algorithm>           // for max, min
+#include <cstddef>             // for ptrdiff_t
+#include <deque>               // for deque
+#include <future>              // for future
+#include <memory>              // for make_unique, make_shared
+#include <string>              // for string
+#include <string_view>         // for string_view
+#include <tuple>               // for ignore
+#include <type_traits>         // for decay_t
+#include <vector>              // for vector
 
 #include "modle/config/version.hpp"
 #include "modle/hdf5/hdf5.hpp"  // for read_attribute, read_numbers, wri...
@@ -131,16 +139,16 @@ template <class N>
 template <class M, class I, class>
 void Cooler<N>::write_or_append_cmatrix_to_file(const ContactMatrixDense<M> &cmatrix,
                                                 std::string_view chrom_name, I chrom_start,
-                                                I chrom_end, I chrom_length) {
+                                                I chrom_end, I chrom_length, usize nthreads) {
   Cooler::write_or_append_cmatrix_to_file(&cmatrix, chrom_name, chrom_start, chrom_end,
-                                          chrom_length);
+                                          chrom_length, nthreads);
 }
 
 template <class N>
 template <class M, class I, class>
 void Cooler<N>::write_or_append_cmatrix_to_file(const ContactMatrixDense<M> *cmatrix,
                                                 std::string_view chrom_name, I chrom_start_,
-                                                I chrom_end_, I chrom_length_) {
+                                                I chrom_end_, I chrom_length_, usize nthreads) {
   static_assert(std::is_floating_point_v<N> == std::is_floating_point_v<M>,
                 "Cooler<N> and ContactMatrixDense<M> template arguments should both be integral or "
                 "floating point types.");
@@ -199,6 +207,41 @@ void Cooler<N>::write_or_append_cmatrix_to_file(const ContactMatrixDense<M> *cma
                                  ? hdf5::read_attribute_int(*this->_fp, "nchroms", this->_root_path)
                                  : 0);
 
+    // Pixels are compressed on the thread pool and written to file one HDF5 chunk at a time when
+    // the pixel datasets only use the deflate filter (see hdf5::write_chunk). Otherwise pixels go
+    // through the HDF5 filter pipeline, which compresses chunks on the calling thread
+    auto *tpool = nthreads < 2 ? nullptr : &this->get_or_init_thread_pool(nthreads);
+    const auto pxl_layout = tpool ? this->get_pixel_chunk_layout() : hdf5::DeflateChunkLayout{};
+    const auto write_chunks = pxl_layout.chunk_size != 0;
+    if (write_chunks) {
+      this->load_pixel_chunk_tail(pxl_layout.chunk_size);
+    } else {
+      // Pixels buffered by previous calls (if any) have already been written to file
+      b.pixel_b1_idx_buff.clear();
+      b.pixel_b2_idx_buff.clear();
+      b.pixel_count_buff.clear();
+    }
+
+    // Tasks submitted to the pool only access data they own and *cmatrix. Pending tasks are
+    // waited for before returning, including when an exception is thrown, so that they never
+    // outlive *cmatrix
+    std::deque<std::future<PixelStripe>> pending_stripes;
+    std::deque<PendingChunk> pending_chunks;
+    auto wait_for_pending_tasks = [&]() {
+      for (const auto &stripe : pending_stripes) {
+        if (stripe.valid()) {
+          stripe.wait();
+        }
+      }
+      for (const auto &chunk : pending_chunks) {
+        if (chunk.data.valid()) {
+          chunk.data.wait();
+        }
+      }
+      pending_stripes.clear();
+      pending_chunks.clear();
+    };
+
     auto write_pixels_to_file =
         [&]() {  // Lambda used to write pixel data to file. Mostly useful to reduce code bloat
           pixel_b1_id_h5_foffset =
@@ -213,139 +256,213 @@ void Cooler<N>::write_or_append_cmatrix_to_file(const ContactMatrixDense<M> *cma
           b.pixel_count_buff.clear();
         };
 
-    for (usize chrom_idx = 0; chrom_offset + chrom_idx < static_cast<usize>(this->_nchroms);
-         ++chrom_idx) {
-      if (cmatrix && cmatrix->get_n_of_missed_updates() != 0) {
-        const auto &n = cmatrix->get_n_of_missed_updates();
-        const auto pct = 100.0 * cmatrix->unsafe_get_fraction_of_missed_updates();
-        if (pct >= 0.01) {
-          spdlog::warn(FMT_STRING("Detected {} missed update(s) for \"{}\" ({:.4f}% of the total "
-                                  "number of contacts)."),
-                       n, chrom_name, 100.0 * cmatrix->unsafe_get_fraction_of_missed_updates(),
-                       chrom_name);
-        } else {
-          spdlog::warn(
-              FMT_STRING("Detected {} missed update(s) for \"{}\" (less than {:.2f}% of the "
-                         "total number of contacts)."),
-              n, chrom_name, 0.01, chrom_name);
-        }
+    // Write the oldest pending chunk to file
+    auto write_pending_chunk = [&]() {
+      assert(!pending_chunks.empty());
+      auto &c = pending_chunks.front();
+      const auto chunk = c.data.get();
+      this->_dataset_file_offsets[c.dataset] =
+          hdf5::write_chunk(chunk, d[c.dataset], c.file_offset, c.num_items);
+      pending_chunks.pop_front();
+    };
+
+    // Move the first chunk worth of items from buff to a compression task
+    auto compress_chunk = [&](const Datasets dataset, auto &buff) {
+      using T = typename std::decay_t<decltype(buff)>::value_type;
+      const auto first = buff.begin();
+      const auto last = first + static_cast<std::ptrdiff_t>(pxl_layout.chunk_size);
+      assert(buff.size() >= pxl_layout.chunk_size);
+      // Items are shared with the task, as BS::thread_pool makes copies of the tasks it is given
+      auto items = std::make_shared<const std::vector<T>>(first, last);
+      buff.erase(first, last);
+      pending_chunks.push_back(PendingChunk{
+          dataset, this->_pixel_buff_file_offset, pxl_layout.chunk_size,
+          tpool->submit([items, lvl = pxl_layout.compression_lvl]() {
+            return hdf5::deflate_chunk(items->data(), items->size() * sizeof(T), lvl);
+          })});
+    };
+
+    // Compress all buffered chunks that are full. Compressed chunks are written to file in order
+    // as soon as too many chunks are pending
+    auto compress_full_chunks = [&]() {
+      assert(write_chunks);
+      while (b.pixel_b1_idx_buff.size() >= pxl_layout.chunk_size) {
+        compress_chunk(PXL_B1, b.pixel_b1_idx_buff);
+        compress_chunk(PXL_B2, b.pixel_b2_idx_buff);
+        compress_chunk(PXL_COUNT, b.pixel_count_buff);
+        this->_pixel_buff_file_offset += pxl_layout.chunk_size;
       }
-      // Write chrom name and size
-      chrom_name_h5_foffset =
-          hdf5::write_str(chrom_name, d[CHROM_NAME], STR_TYPE, chrom_name_h5_foffset);
-      chrom_length_h5_foffset =
-          hdf5::write_number(chrom_length, d[CHROM_LEN], chrom_length_h5_foffset);
-      // Add idx of the first bin belonging to the chromosome that is being processed
-      b.idx_chrom_offset_buff.emplace_back(this->_nbins);
-
-      // Write all fixed-size bins for the current chromosome. Maybe in the future we can switch to
-      // use variable-size bins
-      this->_nbins = this->write_bins(chrom_offset + chrom_idx, chrom_length, this->_bin_size,
-                                      b.bin_chrom_buff, b.bin_pos_buff, this->_nbins);
-      // Update file offsets of bin_* datasets
-      bin_chrom_name_h5_foffset = this->_nbins;
-      bin_start_h5_foffset = this->_nbins;
-      bin_end_h5_foffset = this->_nbins;
-
-      // In case we are simulating a subset of a chromosome (i.e. end - start != chrom size), write
-      // the index for all the bins corresponding to genomic coordinates before the start position
-      // Example: suppose we are writing contacts for a chromosome "C" of size 10 Mbp. Suppose we
-      // also know that there are no contacts in the first and last 2 Mbps. In this case chrom_start
-      // will be 2 Mbp and chrom_end will be 8 Mbp. This for loop writes the index for all the bins
-      // corresponding to the genomic region 0-2 Mbp. A more elegant solution would be to use
-      // variable bin-size and write a single 2 Mbp bin.
-      {
-        const auto new_size =
-            b.idx_bin1_offset_buff.size() + ((chrom_start + this->_bin_size - 1) / this->_bin_size);
-        b.idx_bin1_offset_buff.resize(new_size, this->_nnz);
+      const auto max_pending_chunks = 3 * nthreads;
+      while (pending_chunks.size() > max_pending_chunks) {
+        write_pending_chunk();
       }
-      idx_bin1_offset_h5_foffset =
-          hdf5::write_numbers(b.idx_bin1_offset_buff, d[IDX_BIN1], idx_bin1_offset_h5_foffset);
-      b.idx_bin1_offset_buff.clear();
-
-      if (!cmatrix || cmatrix->ncols() == 0) {
-        DISABLE_WARNING_PUSH
-        DISABLE_WARNING_SIGN_CONVERSION
-        b.idx_bin1_offset_buff.resize((chrom_length + this->_bin_size - 1) / this->_bin_size,
-                                      this->_nnz);
-        DISABLE_WARNING_POP
+    };
+
+    try {
+      for (usize chrom_idx = 0; chrom_offset + chrom_idx < static_cast<usize>(this->_nchroms);
+           ++chrom_idx) {
+        if (cmatrix && cmatrix->get_n_of_missed_updates() != 0) {
+          const auto &n = cmatrix->get_n_of_missed_updates();
+          const auto pct = 100.0 * cmatrix->unsafe_get_fraction_of_missed_updates();
+          if (pct >= 0.01) {
+            spdlog::warn(FMT_STRING("Detected {} missed update(s) for \"{}\" ({:.4f}% of the total "
+                                    "number of contacts)."),
+                         n, chrom_name, 100.0 * cmatrix->unsafe_get_fraction_of_missed_updates(),
+                         chrom_name);
+          } else {
+            spdlog::warn(
+                FMT_STRING("Detected {} missed update(s) for \"{}\" (less than {:.2f}% of the "
+                           "total number of contacts)."),
+                n, chrom_name, 0.01, chrom_name);
+          }
+        }
+        // Write chrom name and size
+        chrom_name_h5_foffset =
+            hdf5::write_str(chrom_name, d[CHROM_NAME], STR_TYPE, chrom_name_h5_foffset);
+        chrom_length_h5_foffset =
+            hdf5::write_number(chrom_length, d[CHROM_LEN], chrom_length_h5_foffset);
+        // Add idx of the first bin belonging to the chromosome that is being processed
+        b.idx_chrom_offset_buff.emplace_back(this->_nbins);
+
+        // Write all fixed-size bins for the current chromosome. Maybe in the future we can switch
+        // to use variable-size bins
+        this->_nbins = this->write_bins(chrom_offset + chrom_idx, chrom_length, this->_bin_size,
+                                        b.bin_chrom_buff, b.bin_pos_buff, this->_nbins);
+        // Update file offsets of bin_* datasets
+        bin_chrom_name_h5_foffset = this->_nbins;
+        bin_start_h5_foffset = this->_nbins;
+        bin_end_h5_foffset = this->_nbins;
+
+        // In case we are simulating a subset of a chromosome (i.e. end - start != chrom size),
+        // write the index for all the bins corresponding to genomic coordinates before the start
+        // position.
+        // Example: suppose we are writing contacts for a chromosome "C" of size 10 Mbp. Suppose we
+        // also know that there are no contacts in the first and last 2 Mbps. In this case
+        // chrom_start will be 2 Mbp and chrom_end will be 8 Mbp. This for loop writes the index for
+        // all the bins corresponding to the genomic region 0-2 Mbp. A more elegant solution would
+        // be to use variable bin-size and write a single 2 Mbp bin.
+        {
+          const auto new_size = b.idx_bin1_offset_buff.size() +
+                                ((chrom_start + this->_bin_size - 1) / this->_bin_size);
+          b.idx_bin1_offset_buff.resize(new_size, this->_nnz);
+        }
         idx_bin1_offset_h5_foffset =
             hdf5::write_numbers(b.idx_bin1_offset_buff, d[IDX_BIN1], idx_bin1_offset_h5_foffset);
         b.idx_bin1_offset_buff.clear();
-      }
 
-      pxl_offset += (chrom_start + this->_bin_size - 1) / this->_bin_size;
-      if (cmatrix) {  // when cmatrix == nullptr we only write chrom/bins/indexes (no pixels)
-        for (usize i = 0; i < cmatrix->ncols(); ++i) {  // Iterate over columns in the cmatrix
-          // Write the first pixel that refers to a given bin1 to the index
-          b.idx_bin1_offset_buff.push_back(this->_nnz);
-
-          // Iterate over rows of the cmatrix. The first condition serves the purpose to avoid
-          // reading data from regions that are full of zeros by design (because cmatrix only stores
-          // contacts for a certain width along the diagonal). The second condition makes sure we
-          // are not reading past the array end
-          for (auto j = i; j < i + cmatrix->nrows() && j < cmatrix->ncols(); ++j) {
-            const auto m = [&]() {
-              if constexpr (std::is_floating_point_v<M> && !std::is_floating_point_v<value_type>) {
-                return utils::conditional_static_cast<value_type>(
-                    std::round(cmatrix->unsafe_get(i, j)));
-              } else {
-                return utils::conditional_static_cast<value_type>(cmatrix->unsafe_get(i, j));
-              }
-            }();
-            if (m != value_type(0)) {  // Only write non-zero pixels
-              if constexpr (utils::ndebug_not_defined()) {
-                // Make sure we are always reading from the upper-triangle of the underlying square
-                // contact matrix
-                if (pxl_offset + i > pxl_offset + j) {
-                  throw std::runtime_error(fmt::format(
-                      FMT_STRING("Cooler::write_or_append_cmatrix_to_file(): b1 > b2: b1={}; "
-                                 "b2={}; offset={}; m={}\n"),
-                      b.pixel_b1_idx_buff.back(), b.pixel_b2_idx_buff.back(), pxl_offset, m));
-                }
-              }
-              b.pixel_b1_idx_buff.push_back(static_cast<i64>(pxl_offset + i));
-              b.pixel_b2_idx_buff.push_back(static_cast<i64>(pxl_offset + j));
+        if (!cmatrix || cmatrix->ncols() == 0) {
+          DISABLE_WARNING_PUSH
+          DISABLE_WARNING_SIGN_CONVERSION
+          b.idx_bin1_offset_buff.resize((chrom_length + this->_bin_size - 1) / this->_bin_size,
+                                        this->_nnz);
+          DISABLE_WARNING_POP
+          idx_bin1_offset_h5_foffset =
+              hdf5::write_numbers(b.idx_bin1_offset_buff, d[IDX_BIN1], idx_bin1_offset_h5_foffset);
+          b.idx_bin1_offset_buff.clear();
+        }
 
-              b.pixel_count_buff.push_back(m);
+        pxl_offset += (chrom_start + this->_bin_size - 1) / this->_bin_size;
+        if (cmatrix) {  // when cmatrix == nullptr we only write chrom/bins/indexes (no pixels)
+          // Columns are split into stripes such that each stripe holds at most one buffer worth of
+          // pixels. Stripes are processed by a pool of worker threads, while this thread writes
+          // stripes to disk in the same order they appear in the cmatrix
+          const auto stripe_width =
+              std::max(usize(1), b.capacity() / std::max(usize(1), cmatrix->nrows()));
+          const auto num_stripes = (cmatrix->ncols() + stripe_width - 1) / stripe_width;
+
+          auto extract_stripe = [cmatrix, stripe_width, pxl_offset](usize stripe_idx) {
+            const auto first_col = stripe_idx * stripe_width;
+            const auto last_col = std::min(first_col + stripe_width, cmatrix->ncols());
+            return Cooler::extract_pixel_stripe(*cmatrix, first_col, last_col, pxl_offset);
+          };
+
+          auto write_stripe = [&](const PixelStripe &stripe) {
+            for (const auto nnz : stripe.nnz_per_col) {
+              // Write the first pixel that refers to a given bin1 to the index
+              b.idx_bin1_offset_buff.push_back(this->_nnz);
+              this->_nnz += static_cast<i64>(nnz);
+              // Write bin idx when buffer is full
+              if (b.idx_bin1_offset_buff.size() == b.capacity()) {
+                idx_bin1_offset_h5_foffset = hdf5::write_numbers(
+                    b.idx_bin1_offset_buff, d[IDX_BIN1], idx_bin1_offset_h5_foffset);
+                b.idx_bin1_offset_buff.clear();
+              }
+            }
 
-              ++this->_nnz;
+            // Write buffered pixels to disk when appending the current stripe would overflow the
+            // buffer. Stripes are at most one buffer worth of pixels wide, unless a single column
+            // holds more pixels than the buffer can fit
+            if (!write_chunks && !b.pixel_b1_idx_buff.empty() &&
+                b.pixel_b1_idx_buff.size() + stripe.counts.size() > b.capacity()) {
+              write_pixels_to_file();
+            }
+            b.pixel_b1_idx_buff.insert(b.pixel_b1_idx_buff.end(), stripe.bin1_ids.begin(),
+                                       stripe.bin1_ids.end());
+            b.pixel_b2_idx_buff.insert(b.pixel_b2_idx_buff.end(), stripe.bin2_ids.begin(),
+                                       stripe.bin2_ids.end());
+            b.pixel_count_buff.insert(b.pixel_count_buff.end(), stripe.counts.begin(),
+                                      stripe.counts.end());
+            if (write_chunks) {
+              compress_full_chunks();
+            } else if (b.pixel_b1_idx_buff.size() >= b.capacity()) {  // Write pixels when full
+              write_pixels_to_file();
+            }
+          };
 
-              if (b.pixel_b1_idx_buff.size() ==
-                  b.capacity()) {  // Write pixels to disk when buffer is full
-                write_pixels_to_file();
+          if (!tpool || num_stripes < 2) {
+            for (usize i = 0; i < num_stripes; ++i) {
+              write_stripe(extract_stripe(i));
+            }
+          } else {
+            // The number of stripes in flight is bounded to limit memory usage
+            const auto max_pending_stripes = 2 * nthreads;
+            usize next_stripe = 0;
+            while (next_stripe < num_stripes || !pending_stripes.empty()) {
+              while (next_stripe < num_stripes && pending_stripes.size() < max_pending_stripes) {
+                pending_stripes.emplace_back(tpool->submit(extract_stripe, next_stripe++));
               }
+              write_stripe(pending_stripes.front().get());
+              pending_stripes.pop_front();
             }
           }
+        }
 
-          if (b.idx_bin1_offset_buff.size() == b.capacity()) {  // Write bin idx when buffer is full
-            idx_bin1_offset_h5_foffset = hdf5::write_numbers(b.idx_bin1_offset_buff, d[IDX_BIN1],
-                                                             idx_bin1_offset_h5_foffset);
-            b.idx_bin1_offset_buff.clear();
-          }
+        // In case we are simulating a subset of a chromosome (i.e. end - start != chrom size),
+        // write the index for all the bins corresponding to genomic coordinates after the end
+        // position. See previous comment for an example
+        {
+          const auto new_size =
+              b.idx_bin1_offset_buff.size() +
+              ((static_cast<usize>(chrom_length) - chrom_end + this->_bin_size - 1) /
+               this->_bin_size);
+          b.idx_bin1_offset_buff.resize(new_size, this->_nnz);
         }
-      }
+        idx_bin1_offset_h5_foffset =
+            hdf5::write_numbers(b.idx_bin1_offset_buff, d[IDX_BIN1], idx_bin1_offset_h5_foffset);
+        b.idx_bin1_offset_buff.clear();
 
-      // In case we are simulating a subset of a chromosome (i.e. end - start != chrom size), write
-      // the index for all the bins corresponding to genomic coordinates after the end position. See
-      // previous comment for an example
-      {
-        const auto new_size =
-            b.idx_bin1_offset_buff.size() +
-            ((static_cast<usize>(chrom_length) - chrom_end + this->_bin_size - 1) /
-             this->_bin_size);
-        b.idx_bin1_offset_buff.resize(new_size, this->_nnz);
+        pxl_offset = this->_nbins;
       }
-      idx_bin1_offset_h5_foffset =
-          hdf5::write_numbers(b.idx_bin1_offset_buff, d[IDX_BIN1], idx_bin1_offset_h5_foffset);
-      b.idx_bin1_offset_buff.clear();
-
-      pxl_offset = this->_nbins;
-    }
 
-    // Write all non-empty buffers to disk
-    if (!b.pixel_b1_idx_buff.empty()) {
-      write_pixels_to_file();
+      // Write all non-empty buffers to disk
+      if (write_chunks) {
+        while (!pending_chunks.empty()) {
+          write_pending_chunk();
+        }
+        // The last chunk is usually incomplete: write it through the HDF5 filter pipeline, and
+        // keep its pixels buffered, so that the chunk can be completed by the next call
+        pixel_b1_id_h5_foffset = hdf5::write_numbers(b.pixel_b1_idx_buff, d[PXL_B1],
+                                                     this->_pixel_buff_file_offset);
+        pixel_b2_id_h5_foffset = hdf5::write_numbers(b.pixel_b2_idx_buff, d[PXL_B2],
+                                                     this->_pixel_buff_file_offset);
+        pixel_count_h5_foffset = hdf5::write_numbers(b.pixel_count_buff, d[PXL_COUNT],
+                                                     this->_pixel_buff_file_offset);
+      } else if (!b.pixel_b1_idx_buff.empty()) {
+        write_pixels_to_file();
+      }
+    } catch (...) {
+      wait_for_pending_tasks();
+      throw;
     }
 
     // Writing the chrom_index only at the end should be ok, given that most of the time we are
@@ -371,6 +488,107 @@ void Cooler<N>::write_or_append_cmatrix_to_file(const ContactMatrixDense<M> *cma
   }
 }
 
+template <class N>
+BS::thread_pool &Cooler<N>::get_or_init_thread_pool(const usize nthreads) {
+  const auto nthreads_ = utils::conditional_static_cast<BS::concurrency_t>(nthreads);
+  if (!this->_tpool) {
+    this->_tpool = std::make_unique<BS::thread_pool>(nthreads_);
+  } else if (this->_tpool->get_thread_count() != nthreads_) {
+    this->_tpool->reset(nthreads_);
+  }
+  return *this->_tpool;
+}
+
+template <class N>
+hdf5::DeflateChunkLayout Cooler<N>::get_pixel_chunk_layout() const {
+  const auto layout = hdf5::get_deflate_chunk_layout(this->_datasets[PXL_B1]);
+  for (const auto i : {PXL_B2, PXL_COUNT}) {
+    const auto layout_ = hdf5::get_deflate_chunk_layout(this->_datasets[i]);
+    if (layout_.chunk_size != layout.chunk_size ||
+        layout_.compression_lvl != layout.compression_lvl) {
+      return {};
+    }
+  }
+  return layout;
+}
+
+template <class N>
+void Cooler<N>::load_pixel_chunk_tail(const hsize_t chunk_size) {
+  assert(chunk_size != 0);
+  assert(this->_buff);
+  auto &b = *this->_buff;
+  const auto file_offset = this->_dataset_file_offsets[PXL_B1];
+  assert(file_offset == this->_dataset_file_offsets[PXL_B2]);
+  assert(file_offset == this->_dataset_file_offsets[PXL_COUNT]);
+  assert(b.pixel_b1_idx_buff.size() == b.pixel_b2_idx_buff.size());
+  assert(b.pixel_b1_idx_buff.size() == b.pixel_count_buff.size());
+
+  if (this->_pixel_buff_file_offset % chunk_size == 0 &&
+      this->_pixel_buff_file_offset + b.pixel_b1_idx_buff.size() == file_offset) {
+    return;  // Buffers already hold the pixels stored in the last chunk
+  }
+
+  this->_pixel_buff_file_offset = file_offset - (file_offset % chunk_size);
+  const auto num_pixels = static_cast<usize>(file_offset - this->_pixel_buff_file_offset);
+  b.pixel_b1_idx_buff.resize(num_pixels);
+  b.pixel_b2_idx_buff.resize(num_pixels);
+  b.pixel_count_buff.resize(num_pixels);
+  if (num_pixels != 0) {
+    const auto &d = this->_datasets;
+    std::ignore =
+        hdf5::read_numbers(d[PXL_B1], b.pixel_b1_idx_buff, this->_pixel_buff_file_offset);
+    std::ignore =
+        hdf5::read_numbers(d[PXL_B2], b.pixel_b2_idx_buff, this->_pixel_buff_file_offset);
+    std::ignore =
+        hdf5::read_numbers(d[PXL_COUNT], b.pixel_count_buff, this->_pixel_buff_file_offset);
+  }
+}
+
+template <class N>
+template <class M>
+auto Cooler<N>::extract_pixel_stripe(const ContactMatrixDense<M> &cmatrix, const usize first_col,
+                                     const usize last_col, const hsize_t pxl_offset)
+    -> PixelStripe {
+  assert(first_col <= last_col);
+  assert(last_col <= cmatrix.ncols());
+  PixelStripe stripe{};
+  stripe.nnz_per_col.reserve(last_col - first_col);
+
+  for (auto i = first_col; i < last_col; ++i) {  // Iterate over columns in the cmatrix
+    const auto nnz = stripe.counts.size();
+    // Iterate over rows of the cmatrix. The first condition serves the purpose to avoid
+    // reading data from regions that are full of zeros by design (because cmatrix only stores
+    // contacts for a certain width along the diagonal). The second condition makes sure we
+    // are not reading past the array end
+    for (auto j = i; j < i + cmatrix.nrows() && j < cmatrix.ncols(); ++j) {
+      const auto m = [&]() {
+        if constexpr (std::is_floating_point_v<M> && !std::is_floating_point_v<value_type>) {
+          return utils::conditional_static_cast<value_type>(std::round(cmatrix.unsafe_get(i, j)));
+        } else {
+          return utils::conditional_static_cast<value_type>(cmatrix.unsafe_get(i, j));
+        }
+      }();
+      if (m != value_type(0)) {  // Only write non-zero pixels
+        if constexpr (utils::ndebug_not_defined()) {
+          // Make sure we are always reading from the upper-triangle of the underlying square
+          // contact matrix
+          if (pxl_offset + i > pxl_offset + j) {
+            throw std::runtime_error(fmt::format(
+                FMT_STRING("Cooler::write_or_append_cmatrix_to_file(): b1 > b2: b1={}; "
+                           "b2={}; offset={}; m={}\n"),
+                pxl_offset + i, pxl_offset + j, pxl_offset, m));
+          }
+        }
+        stripe.bin1_ids.push_back(static_cast<i64>(pxl_offset + i));
+        stripe.bin2_ids.push_back(static_cast<i64>(pxl_offset + j));
+        stripe.counts.push_back(m);
+      }
+    }
+    stripe.nnz_per_col.push_back(stripe.counts.size() - nnz);
+  }
+  return stripe;
+}
+
 template <class N>
 template <class I1, class I2, class I3>
 hsize_t Cooler<N>::write_bins(I1 chrom_, I2 length_, I3 bin_size_, std::vector<i32> &buff32,
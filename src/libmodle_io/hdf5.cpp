@@ -24,8 +24,10 @@
 #include <absl/strings/strip.h>    // for ConsumePrefix, StripPrefix, StripSuffix
 #include <fcntl.h>                 // for SEEK_END, SEEK_SET
 #include <fmt/format.h>            // for format, FMT_STRING
+#include <zlib.h>                  // for compress2, compressBound, zError, Z_OK
 
 #include <algorithm>    // for max
+#include <array>        // for array
 #include <cassert>      // for assert
 #include <cstdio>       // for fclose, fseek, tmpfile, ferror, fread, ftell, FILE
 #include <filesystem>   // for path
@@ -299,4 +301,78 @@ std::string get_file_name(H5::H5File &f) {
   const auto lck = internal::lock();
   return f.getFileName();
 }
+
+DeflateChunkLayout get_deflate_chunk_layout(const H5::DataSet &dataset) {
+  const auto lck = internal::lock();
+  H5::Exception::dontPrint();
+  try {
+    const auto cprop = dataset.getCreatePlist();
+    if (cprop.getLayout() != H5D_CHUNKED || dataset.getSpace().getSimpleExtentNdims() != 1 ||
+        cprop.getNfilters() != 1) {
+      return {};
+    }
+
+    hsize_t chunk_size{};
+    std::ignore = cprop.getChunk(1, &chunk_size);
+
+    u32 flags{};
+    usize cd_nelmts{1};
+    std::array<u32, 1> cd_values{};
+    std::array<char, 32> name{};
+    u32 filter_config{};
+    const auto filter = cprop.getFilter(0, flags, cd_nelmts, cd_values.data(), name.size(),
+                                        name.data(), filter_config);
+    if (filter != H5Z_FILTER_DEFLATE || cd_nelmts < 1) {
+      return {};
+    }
+    return {chunk_size, static_cast<u8>(cd_values.front())};
+  } catch (const H5::Exception &e) {
+    throw std::runtime_error(
+        fmt::format(FMT_STRING("Failed to read the chunk layout of dataset \"{}\": {}"),
+                    dataset.getObjName(), construct_error_stack(e)));
+  }
+}
+
+std::vector<char> deflate_chunk(const void *data, const usize size, const u8 compression_lvl) {
+  auto buff_size = compressBound(static_cast<uLong>(size));
+  std::vector<char> buff(static_cast<usize>(buff_size));
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto status = compress2(reinterpret_cast<Bytef *>(buff.data()), &buff_size,
+                                static_cast<const Bytef *>(data), static_cast<uLong>(size),
+                                static_cast<int>(compression_lvl));
+  if (status != Z_OK) {
+    throw std::runtime_error(fmt::format(FMT_STRING("Failed to compress a chunk of {} bytes: {}"),
+                                         size, zError(status)));
+  }
+  buff.resize(static_cast<usize>(buff_size));
+  return buff;
+}
+
+hsize_t write_chunk(const std::vector<char> &chunk, const H5::DataSet &dataset,
+                    hsize_t file_offset, const hsize_t num_items) {
+  const auto lck = internal::lock();
+  H5::Exception::dontPrint();
+  try {
+    const hsize_t file_size{file_offset + num_items};
+    if (static_cast<hsize_t>(dataset.getSpace().getSimpleExtentNpoints()) < file_size) {
+      dataset.extend(&file_size);
+    }
+
+    // A filter mask of 0 means that the chunk went through all the filters in the pipeline
+    constexpr u32 filter_mask = 0;
+    if (H5Dwrite_chunk(dataset.getId(), H5P_DEFAULT, filter_mask, &file_offset, chunk.size(),
+                       chunk.data()) < 0) {
+      throw std::runtime_error(fmt::format(
+          FMT_STRING("Failed to write a chunk of {} bytes to dataset \"{}\" at offset {}: {}"),
+          chunk.size(), dataset.getObjName(), file_offset,
+          construct_error_stack("H5Dwrite_chunk", "direct chunk write failed")));
+    }
+    return file_size;
+  } catch (const H5::Exception &e) {
+    throw std::runtime_error(fmt::format(
+        FMT_STRING("Failed to write a chunk of {} bytes to dataset \"{}\" at offset {}: {}"),
+        chunk.size(), dataset.getObjName(), file_offset, construct_error_stack(e)));
+  }
+}
+
 }  // namespace modle::hdf5
@@ -20,7 +20,10 @@
 #include <absl/types/variant.h>                   // for variant, monostate
 #include <readerwriterqueue/readerwriterqueue.h>  // for BlockingReaderWriterQueue
 
+#include <BS_thread_pool.hpp>  // for BS::thread_pool
+
 #include <filesystem>   // for path
+#include <future>       // for future
 #include <memory>       // for unique_ptr, allocator
 #include <string>       // for string
 #include <string_view>  // for string_view
@@ -29,6 +32,7 @@
 
 #include "modle/common/common.hpp"         // for i64, i32, u8f, u32
 #include "modle/contact_matrix_dense.hpp"  // for ContactMatrixDense
+#include "modle/hdf5/hdf5.hpp"             // for DeflateChunkLayout
 
 namespace modle {
 template <class N>
@@ -89,6 +93,12 @@ class Cooler {
   std::unique_ptr<H5::DSetAccPropList> _aprop_float64{nullptr};
 
   std::unique_ptr<InternalBuffers> _buff{nullptr};
+  // File offset of the first pixel held by the pixel buffers when pixels are written one chunk at
+  // a time (see write_or_append_cmatrix_to_file)
+  hsize_t _pixel_buff_file_offset{0};
+  // Pool used to extract and compress pixels (see write_or_append_cmatrix_to_file). The pool is
+  // created the first time it is needed, and is reused by subsequent calls
+  std::unique_ptr<BS::thread_pool> _tpool{nullptr};
 
   std::vector<i64> _idx_chrom_offset{};
   std::vector<i64> _idx_bin1_offset{};
@@ -129,6 +139,22 @@ class Cooler {
     [[nodiscard]] inline usize capacity() const;
   };
 
+  // Non-zero pixels extracted from a stripe of consecutive columns of a ContactMatrixDense
+  struct PixelStripe {
+    std::vector<i64> bin1_ids{};
+    std::vector<i64> bin2_ids{};
+    std::vector<value_type> counts{};
+    std::vector<usize> nnz_per_col{};
+  };
+
+  // Chunk of one of the pixel datasets that is being compressed by the thread pool
+  struct PendingChunk {
+    Datasets dataset{};
+    hsize_t file_offset{};
+    hsize_t num_items{};
+    std::future<std::vector<char>> data{};
+  };
+
  public:
   static constexpr u8f DEFAULT_COMPRESSION_LEVEL = 6;
   static constexpr usize DEFAULT_HDF5_BUFFER_SIZE = 1024 * 1024ULL;      // 1MB
@@ -188,17 +214,21 @@ class Cooler {
   inline void write_or_append_empty_cmatrix_to_file(std::string_view chrom_name, I chrom_start,
                                                     I chrom_end, I chrom_length);
 
+  // Pixels are extracted from stripes of columns using a pool of nthreads threads, while the
+  // calling thread writes stripes to disk in order. When nthreads > 1, pixel datasets are also
+  // compressed one HDF5 chunk at a time on the pool, and the calling thread only writes compressed
+  // chunks to disk in order. The pool is owned by the Cooler object, and is reused across calls
   template <class M, class I,
             class = std::enable_if_t<std::is_arithmetic_v<N> && std::is_integral_v<I>>>
   inline void write_or_append_cmatrix_to_file(const ContactMatrixDense<M> &cmatrix,
                                               std::string_view chrom_name, I chrom_start,
-                                              I chrom_end, I chrom_length);
+                                              I chrom_end, I chrom_length, usize nthreads = 1);
 
   template <class M, class I,
             class = std::enable_if_t<std::is_arithmetic_v<N> && std::is_integral_v<I>>>
   inline void write_or_append_cmatrix_to_file(const ContactMatrixDense<M> *cmatrix,
                                               std::string_view chrom_name, I chrom_start,
-                                              I chrom_end, I chrom_length);
+                                              I chrom_end, I chrom_length, usize nthreads = 1);
   // Read from file
   [[nodiscard]] inline ContactMatrixDense<N> cooler_to_cmatrix(
       std::string_view chrom_name, usize nrows, std::pair<usize, usize> chrom_boundaries = {0, -1},
@@ -250,6 +280,22 @@ class Cooler {
                                           hsize_t buff_size = DEFAULT_HDF5_BUFFER_SIZE /
                                                               sizeof(i64));
 
+  /// Return the pool used to extract and compress pixels, (re)sizing it to \p nthreads threads if
+  /// needed
+  [[nodiscard]] inline BS::thread_pool &get_or_init_thread_pool(usize nthreads);
+  /// Return the chunk layout shared by all pixel datasets. chunk_size is 0 when pixel datasets
+  /// cannot be written using hdf5::write_chunk
+  [[nodiscard]] inline hdf5::DeflateChunkLayout get_pixel_chunk_layout() const;
+  /// Make sure that pixel buffers hold the pixels stored in the last (incomplete) chunk of the
+  /// pixel datasets, reading them from file if necessary
+  inline void load_pixel_chunk_tail(hsize_t chunk_size);
+
+  /// Extract non-zero pixels overlapping columns [first_col, last_col) of \p cmatrix
+  template <class M>
+  [[nodiscard]] static inline PixelStripe extract_pixel_stripe(const ContactMatrixDense<M> &cmatrix,
+                                                               usize first_col, usize last_col,
+                                                               hsize_t pxl_offset);
+
   inline usize read_chrom_offset_idx();
   inline usize read_bin1_offset_idx();
 
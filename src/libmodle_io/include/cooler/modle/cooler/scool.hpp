@@ -0,0 +1,130 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// IWYU pragma: no_include <H5DaccProp.h>
+// IWYU pragma: no_include <H5DcreatProp.h>
+// IWYU pragma: no_include <H5File.h>
+// IWYU pragma: no_include <H5StrType.h>
+// IWYU pragma: no_include "modle/src/libio/scool_impl.hpp"
+
+#include <H5Cpp.h>            // IWYU pragma: keep
+#include <absl/types/span.h>  // for Span
+
+#include <filesystem>   // for path
+#include <memory>       // for unique_ptr
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <type_traits>  // for conditional_t
+#include <utility>      // for pair
+#include <vector>       // for vector
+
+#include "modle/common/common.hpp"         // for i64, u8f, usize, contacts_t
+#include "modle/contact_matrix_dense.hpp"  // for ContactMatrixDense
+#include "modle/cooler/cooler.hpp"         // for Cooler
+
+namespace modle::cooler {
+
+/// Write the contact matrices of many cells (e.g. modle replay tasks) to a single .scool file
+
+//! The file follows the layout of single-cell coolers: chromosomes and bins are written once under
+//! the root group, while each cell gets its own group under /cells/ storing pixels and indexes.
+//! The chroms and bins groups of each cell are hard links to the root groups.
+//! Extracting and compressing pixels from a ContactMatrixDense (SCoolWriter::make_cell) does not
+//! access the file, and can be done concurrently by several threads. Appending cells to the file
+//! is not thread-safe, and should be done by a single writer thread.
+template <class N = contacts_t>
+class SCoolWriter {
+ public:
+  using value_type = typename Cooler<N>::value_type;
+  using SumT = std::conditional_t<Cooler<N>::IS_FP, double, i64>;
+
+  /// Non-zero pixels of a single cell. Pixels are stored as deflate-compressed HDF5 chunks, which
+  /// are written to file as they are by append_cell
+  struct Cell {  // NOLINT(altera-struct-pack-align)
+    using Chunks = std::vector<std::vector<char>>;
+
+    std::string name{};
+    usize first_bin{};                // Index of the bin corresponding to the first matrix column
+    std::vector<i64> bin1_offsets{};  // Offset of the first pixel of each column
+    Chunks bin1_id_chunks{};
+    Chunks bin2_id_chunks{};
+    Chunks count_chunks{};
+    usize num_pixels{};
+    SumT sum{};
+
+    [[nodiscard]] i64 nnz() const noexcept;
+  };
+
+ private:
+  std::filesystem::path _path_to_file{};
+  usize _bin_size{};
+  H5::StrType _str_type{};
+  std::unique_ptr<H5::H5File> _fp{nullptr};
+
+  std::vector<std::string> _chrom_names{};
+  std::vector<i64> _chrom_offsets{};  // Index of the first bin of each chromosome + nbins
+  usize _ncells{};
+
+  u8f _compression_lvl{};
+  hsize_t _chunk_size{};
+  hsize_t _cache_size{};
+
+  std::vector<i64> _idx_buff{};  // Buffer used to write bin1_offset indexes
+
+ public:
+  SCoolWriter() = delete;
+  SCoolWriter(std::filesystem::path path_to_file,
+              absl::Span<const std::pair<std::string, usize>> chroms, usize bin_size,
+              u8f compression_lvl = Cooler<N>::DEFAULT_COMPRESSION_LEVEL,
+              usize chunk_size = Cooler<N>::DEFAULT_HDF5_CHUNK_SIZE,
+              usize cache_size = Cooler<N>::DEFAULT_HDF5_CACHE_SIZE);
+
+  [[nodiscard]] const std::filesystem::path &get_path() const noexcept;
+  [[nodiscard]] usize get_bin_size() const noexcept;
+  [[nodiscard]] usize get_nbins() const noexcept;
+  [[nodiscard]] usize get_nchroms() const noexcept;
+  [[nodiscard]] usize get_ncells() const noexcept;
+
+  /// Extract the non-zero pixels of \p cmatrix, which stores the contacts for the region of
+  /// chromosome \p chrom_name starting at \p chrom_start
+
+  //! Pixels are compressed using the chunk size and compression level of the pixel datasets
+  //! created by append_cell. This function does not access the underlying file, and can be called
+  //! concurrently from multiple threads.
+  template <class M>
+  [[nodiscard]] Cell make_cell(std::string cell_name, const ContactMatrixDense<M> &cmatrix,
+                               std::string_view chrom_name, usize chrom_start) const;
+
+  /// Write the pixels and indexes of \p cell to a new group under /cells/. Pixel chunks are
+  /// written using direct chunk writes, bypassing the HDF5 filter pipeline
+  void append_cell(Cell &cell);
+
+ private:
+  [[nodiscard]] usize get_chrom_idx(std::string_view chrom_name) const;
+  [[nodiscard]] hsize_t compute_chunk_size(usize dataset_size) const noexcept;
+
+  /// Split \p pixels in chunks of compute_chunk_size(pixels.size()) items and compress them
+  template <class T>
+  [[nodiscard]] typename Cell::Chunks compress_pixels(const std::vector<T> &pixels) const;
+  /// Create dataset \p name and fill it with \p num_pixels items compressed by compress_pixels
+  template <class T>
+  void write_pixel_chunks(const std::string &name, const typename Cell::Chunks &chunks,
+                          usize num_pixels);
+
+  void write_chroms_and_bins(absl::Span<const std::pair<std::string, usize>> chroms);
+  void write_metadata(const std::string &root_path, bool is_cell);
+
+  /// Create an empty, chunked and compressed dataset that will hold \p size elements of type T
+
+  //! Chunks are never larger than the dataset itself: cells are usually small, and compressing
+  //! chunks that are mostly made up of fill values is a waste of time.
+  template <class T>
+  [[nodiscard]] H5::DataSet create_dataset(const std::string &name, usize size);
+};
+
+}  // namespace modle::cooler
+
+#include "../../../../scool_impl.hpp"  // IWYU pragma: export
@@ -151,6 +151,25 @@ template <class T>
 
 [[nodiscard]] std::string get_file_name(H5::H5File &f);
 
+/// Chunk size and compression level of a dataset that can be written using write_chunk.
+/// chunk_size is 0 for datasets that are not 1D, not chunked, or whose filter pipeline is not
+/// made up of the deflate filter only
+struct DeflateChunkLayout {
+  hsize_t chunk_size{0};
+  u8 compression_lvl{0};
+};
+[[nodiscard]] DeflateChunkLayout get_deflate_chunk_layout(const H5::DataSet &dataset);
+
+/// Compress \p size bytes starting at \p data the same way HDF5's deflate filter does.
+/// This function does not call into HDF5, and can thus be called from multiple threads
+[[nodiscard]] std::vector<char> deflate_chunk(const void *data, usize size, u8 compression_lvl);
+/// Write a chunk compressed by deflate_chunk to \p dataset, bypassing the filter pipeline.
+/// \p file_offset should be aligned to a chunk boundary. The dataset is extended to hold at
+/// least \p num_items items starting from \p file_offset. Return the file offset past the
+/// last item in the chunk
+[[nodiscard]] hsize_t write_chunk(const std::vector<char> &chunk, const H5::DataSet &dataset,
+                                  hsize_t file_offset, hsize_t num_items);
+
 }  // namespace modle::hdf5
 
 #include "../../../../hdf5_impl.hpp"  // IWYU pragma: export
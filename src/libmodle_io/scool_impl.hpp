@@ -0,0 +1,426 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+// IWYU pragma: private, include "modle/cooler/scool.hpp"
+// IWYU pragma: no_include <H5DaccProp.h>
+// IWYU pragma: no_include <H5DataSet.h>
+// IWYU pragma: no_include <H5DcreatProp.h>
+// IWYU pragma: no_include <H5Exception.h>
+// IWYU pragma: no_include <H5File.h>
+// IWYU pragma: no_include <H5Lpublic.h>
+// IWYU pragma: no_include <H5PredType.h>
+// IWYU pragma: no_include <H5StrType.h>
+// IWYU pragma: no_include "hdf5_impl.hpp"
+
+#include <H5Cpp.h>                 // IWYU pragma: keep
+#include <absl/strings/str_cat.h>  // for StrCat
+#include <absl/time/clock.h>       // for Now
+#include <absl/time/time.h>        // for FormatTime, UTCTimeZone
+#include <absl/types/span.h>       // for Span
+#include <fmt/format.h>            // for format, FMT_STRING
+
+#include <algorithm>    // for clamp, copy, find, max, min, transform
+#include <cassert>      // for assert
+#include <cmath>        // for round
+#include <filesystem>   // for path
+#include <iterator>     // for distance
+#include <memory>       // for make_unique
+#include <stdexcept>    // for runtime_error
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <tuple>        // for ignore
+#include <utility>      // for move, pair
+#include <vector>       // for vector
+
+#include "modle/common/common.hpp"         // for i64, u8f, usize
+#include "modle/common/fmt_helpers.hpp"    // IWYU pragma: keep
+#include "modle/common/utils.hpp"          // for conditional_static_cast
+#include "modle/config/version.hpp"        // for str_long
+#include "modle/contact_matrix_dense.hpp"  // for ContactMatrixDense
+#include "modle/hdf5/hdf5.hpp"             // for create_group, write_numbers, write_strings...
+
+namespace modle::cooler {
+
+template <class N>
+i64 SCoolWriter<N>::Cell::nnz() const noexcept {
+  return static_cast<i64>(this->num_pixels);
+}
+
+template <class N>
+SCoolWriter<N>::SCoolWriter(std::filesystem::path path_to_file,
+                            absl::Span<const std::pair<std::string, usize>> chroms,
+                            usize bin_size, u8f compression_lvl, usize chunk_size,
+                            usize cache_size)
+    : _path_to_file(std::move(path_to_file)),
+      _bin_size(bin_size),
+      _compression_lvl(compression_lvl),
+      _chunk_size(static_cast<hsize_t>(chunk_size)),
+      _cache_size(static_cast<hsize_t>(cache_size)) {
+  assert(this->_bin_size != 0);
+  assert(this->_chunk_size != 0);
+  if (chroms.empty()) {
+    throw std::runtime_error(
+        fmt::format(FMT_STRING("Unable to create file {}: chromosome list is empty"),
+                    this->_path_to_file));
+  }
+
+  usize max_str_length = 0;
+  this->_chrom_offsets.push_back(0);
+  for (const auto &[name, size] : chroms) {
+    max_str_length = std::max(max_str_length, name.size());
+    this->_chrom_names.push_back(name);
+    this->_chrom_offsets.push_back(this->_chrom_offsets.back() +
+                                   static_cast<i64>((size + bin_size - 1) / bin_size));
+  }
+  // Cooltools doesn't seem to properly handle variable length strings (H5T_VARIABLE)
+  this->_str_type = H5::StrType(H5::PredType::C_S1, std::max(usize(1), max_str_length));
+  this->_str_type.setStrpad(H5T_STR_NULLPAD);
+  this->_str_type.setCset(H5T_CSET_ASCII);
+
+  this->_fp = std::make_unique<H5::H5File>(hdf5::open_file_for_writing(this->_path_to_file));
+  this->write_chroms_and_bins(chroms);
+  this->write_metadata("/", false);
+}
+
+template <class N>
+const std::filesystem::path &SCoolWriter<N>::get_path() const noexcept {
+  return this->_path_to_file;
+}
+
+template <class N>
+usize SCoolWriter<N>::get_bin_size() const noexcept {
+  return this->_bin_size;
+}
+
+template <class N>
+usize SCoolWriter<N>::get_nbins() const noexcept {
+  return static_cast<usize>(this->_chrom_offsets.back());
+}
+
+template <class N>
+usize SCoolWriter<N>::get_nchroms() const noexcept {
+  return this->_chrom_names.size();
+}
+
+template <class N>
+usize SCoolWriter<N>::get_ncells() const noexcept {
+  return this->_ncells;
+}
+
+template <class N>
+usize SCoolWriter<N>::get_chrom_idx(std::string_view chrom_name) const {
+  const auto it = std::find(this->_chrom_names.begin(), this->_chrom_names.end(), chrom_name);
+  if (it == this->_chrom_names.end()) {
+    throw std::runtime_error(fmt::format(FMT_STRING("Unable to find chromosome \"{}\" in file {}"),
+                                         chrom_name, this->_path_to_file));
+  }
+  return static_cast<usize>(std::distance(this->_chrom_names.begin(), it));
+}
+
+template <class N>
+hsize_t SCoolWriter<N>::compute_chunk_size(usize dataset_size) const noexcept {
+  return std::clamp(static_cast<hsize_t>(dataset_size), hsize_t(1), this->_chunk_size);
+}
+
+template <class N>
+template <class M>
+auto SCoolWriter<N>::make_cell(std::string cell_name, const ContactMatrixDense<M> &cmatrix,
+                               std::string_view chrom_name, usize chrom_start) const -> Cell {
+  static_assert(std::is_floating_point_v<N> == std::is_floating_point_v<M>,
+                "SCoolWriter<N> and ContactMatrixDense<M> template arguments should both be "
+                "integral or floating point types.");
+  const auto chrom_idx = this->get_chrom_idx(chrom_name);
+  const auto chrom_first_bin = static_cast<usize>(this->_chrom_offsets[chrom_idx]);
+  const auto chrom_nbins =
+      static_cast<usize>(this->_chrom_offsets[chrom_idx + 1]) - chrom_first_bin;
+
+  // See Cooler::write_or_append_cmatrix_to_file() for how pixels are mapped to bins
+  const auto first_bin = (chrom_start + this->_bin_size - 1) / this->_bin_size;
+  if (first_bin > chrom_nbins) {
+    throw std::runtime_error(fmt::format(
+        FMT_STRING("Unable to add cell \"{}\" to file {}: start position {} is past the end of "
+                   "chromosome \"{}\""),
+        cell_name, this->_path_to_file, chrom_start, chrom_name));
+  }
+  const auto ncols = std::min(cmatrix.ncols(), chrom_nbins - first_bin);
+  const auto pxl_offset = chrom_first_bin + first_bin;
+
+  Cell cell{std::move(cell_name), pxl_offset};
+  std::vector<i64> bin1_ids{};
+  std::vector<i64> bin2_ids{};
+  std::vector<value_type> counts{};
+  cell.bin1_offsets.reserve(ncols);
+  for (usize i = 0; i < ncols; ++i) {  // Iterate over columns in the cmatrix
+    cell.bin1_offsets.push_back(static_cast<i64>(counts.size()));
+    // Only visit pixels within nrows() bins from the diagonal, as pixels outside this band are
+    // always zero
+    for (auto j = i; j < i + cmatrix.nrows() && j < ncols; ++j) {
+      const auto m = [&]() {
+        if constexpr (std::is_floating_point_v<M> && !std::is_floating_point_v<value_type>) {
+          return utils::conditional_static_cast<value_type>(std::round(cmatrix.unsafe_get(i, j)));
+        } else {
+          return utils::conditional_static_cast<value_type>(cmatrix.unsafe_get(i, j));
+        }
+      }();
+      if (m != value_type(0)) {
+        bin1_ids.push_back(static_cast<i64>(pxl_offset + i));
+        bin2_ids.push_back(static_cast<i64>(pxl_offset + j));
+        counts.push_back(m);
+        cell.sum += utils::conditional_static_cast<SumT>(m);
+      }
+    }
+  }
+
+  // Compressing pixels here rather than in append_cell moves most of the work required to write a
+  // cell away from the writer thread
+  cell.num_pixels = counts.size();
+  cell.bin1_id_chunks = this->compress_pixels(bin1_ids);
+  cell.bin2_id_chunks = this->compress_pixels(bin2_ids);
+  cell.count_chunks = this->compress_pixels(counts);
+  return cell;
+}
+
+template <class N>
+template <class T>
+auto SCoolWriter<N>::compress_pixels(const std::vector<T> &pixels) const -> typename Cell::Chunks {
+  const auto chunk_size = static_cast<usize>(this->compute_chunk_size(pixels.size()));
+  const auto compression_lvl = static_cast<u8>(this->_compression_lvl);
+  typename Cell::Chunks chunks{};
+  chunks.reserve((pixels.size() + chunk_size - 1) / chunk_size);
+  for (usize i = 0; i + chunk_size <= pixels.size(); i += chunk_size) {
+    chunks.push_back(
+        hdf5::deflate_chunk(pixels.data() + i, chunk_size * sizeof(T), compression_lvl));
+  }
+
+  // HDF5 stores partial edge chunks as full chunks: pad the last chunk with the fill value
+  if (const auto tail = pixels.size() % chunk_size; tail != 0) {
+    std::vector<T> buff(chunk_size, T(0));
+    std::copy(pixels.end() - static_cast<std::ptrdiff_t>(tail), pixels.end(), buff.begin());
+    chunks.push_back(hdf5::deflate_chunk(buff.data(), chunk_size * sizeof(T), compression_lvl));
+  }
+  return chunks;
+}
+
+template <class N>
+template <class T>
+void SCoolWriter<N>::write_pixel_chunks(const std::string &name,
+                                        const typename Cell::Chunks &chunks,
+                                        const usize num_pixels) {
+  const auto dset = this->create_dataset<T>(name, num_pixels);
+  const auto chunk_size = this->compute_chunk_size(num_pixels);
+  const auto dset_size = static_cast<hsize_t>(num_pixels);
+  hsize_t file_offset{0};
+  for (const auto &chunk : chunks) {
+    file_offset =
+        hdf5::write_chunk(chunk, dset, file_offset, std::min(chunk_size, dset_size - file_offset));
+  }
+  assert(file_offset == dset_size);
+}
+
+template <class N>
+void SCoolWriter<N>::append_cell(Cell &cell) {
+  assert(this->_fp);
+  assert(cell.first_bin + cell.bin1_offsets.size() <= this->get_nbins());
+  const auto nbins = this->get_nbins();
+  const auto nnz = cell.nnz();
+  const auto root = absl::StrCat("/cells/", cell.name);
+
+  // Hold the HDF5 lock for the whole function, so that other threads using the hdf5 helpers never
+  // observe a partially written cell
+  const auto lck = hdf5::internal::lock();
+  try {
+    if (hdf5::has_group(*this->_fp, root)) {
+      throw std::runtime_error(
+          fmt::format(FMT_STRING("Unable to add cell \"{}\" to file {}: cell already exists"),
+                      cell.name, this->_path_to_file));
+    }
+    std::ignore = hdf5::create_group(*this->_fp, root);
+    std::ignore = hdf5::create_group(*this->_fp, absl::StrCat(root, "/pixels"));
+    std::ignore = hdf5::create_group(*this->_fp, absl::StrCat(root, "/indexes"));
+
+    // Chromosomes and bins are shared by all cells
+    for (const std::string_view grp : {"chroms", "bins"}) {
+      const auto src = absl::StrCat("/", grp);
+      const auto dest = absl::StrCat(root, "/", grp);
+      if (H5Lcreate_hard(this->_fp->getId(), src.c_str(), this->_fp->getId(), dest.c_str(),
+                         H5P_DEFAULT, H5P_DEFAULT) < 0) {
+        throw std::runtime_error(hdf5::construct_error_stack());
+      }
+    }
+
+    this->write_pixel_chunks<i64>(absl::StrCat(root, "/pixels/bin1_id"), cell.bin1_id_chunks,
+                                  cell.num_pixels);
+    this->write_pixel_chunks<i64>(absl::StrCat(root, "/pixels/bin2_id"), cell.bin2_id_chunks,
+                                  cell.num_pixels);
+    this->write_pixel_chunks<value_type>(absl::StrCat(root, "/pixels/count"), cell.count_chunks,
+                                         cell.num_pixels);
+
+    // bin1_offset has nbins + 1 entries: bins without pixels point to the next non-empty bin
+    auto &idx = this->_idx_buff;
+    idx.assign(cell.first_bin, 0);
+    idx.insert(idx.end(), cell.bin1_offsets.begin(), cell.bin1_offsets.end());
+    idx.resize(nbins + 1, nnz);
+    std::ignore = hdf5::write_numbers(
+        idx, this->create_dataset<i64>(absl::StrCat(root, "/indexes/bin1_offset"), idx.size()), 0);
+    std::ignore = hdf5::write_numbers(
+        this->_chrom_offsets,
+        this->create_dataset<i64>(absl::StrCat(root, "/indexes/chrom_offset"),
+                                  this->_chrom_offsets.size()),
+        0);
+
+    this->write_metadata(root, true);
+    auto nnz_ = nnz;
+    hdf5::write_or_create_attribute(*this->_fp, "nnz", nnz_, root);
+    hdf5::write_or_create_attribute(*this->_fp, "sum", cell.sum, root);
+
+    auto ncells = static_cast<i64>(++this->_ncells);
+    hdf5::write_or_create_attribute(*this->_fp, "ncells", ncells);
+  } catch ([[maybe_unused]] const H5::Exception &e) {
+    throw std::runtime_error(
+        fmt::format(FMT_STRING("The following error occurred while adding cell \"{}\" to file "
+                               "{}:\n{}"),
+                    cell.name, this->_path_to_file, hdf5::construct_error_stack()));
+  }
+}
+
+template <class N>
+void SCoolWriter<N>::write_chroms_and_bins(
+    absl::Span<const std::pair<std::string, usize>> chroms) {
+  const auto nbins = this->get_nbins();
+  try {
+    std::ignore = hdf5::create_group(*this->_fp, "/chroms");
+    std::ignore = hdf5::create_group(*this->_fp, "/bins");
+    std::ignore = hdf5::create_group(*this->_fp, "/cells");
+
+    std::vector<i64> buff(chroms.size());
+    std::transform(chroms.begin(), chroms.end(), buff.begin(),
+                   [](const auto &chrom) { return static_cast<i64>(chrom.second); });
+    std::ignore = hdf5::write_strings(
+        this->_chrom_names, this->create_dataset<std::string>("/chroms/name", chroms.size()),
+        this->_str_type, 0);
+    std::ignore =
+        hdf5::write_numbers(buff, this->create_dataset<i64>("/chroms/length", chroms.size()), 0);
+
+    std::vector<i64> chrom_buff{};
+    std::vector<i64> start_buff{};
+    std::vector<i64> end_buff{};
+    chrom_buff.reserve(nbins);
+    start_buff.reserve(nbins);
+    end_buff.reserve(nbins);
+    for (usize i = 0; i < chroms.size(); ++i) {
+      const auto chrom_size = static_cast<i64>(chroms[i].second);
+      for (i64 pos = 0; pos < chrom_size; pos += static_cast<i64>(this->_bin_size)) {
+        chrom_buff.push_back(static_cast<i64>(i));
+        start_buff.push_back(pos);
+        end_buff.push_back(std::min(pos + static_cast<i64>(this->_bin_size), chrom_size));
+      }
+    }
+    assert(chrom_buff.size() == nbins);
+    std::ignore =
+        hdf5::write_numbers(chrom_buff, this->create_dataset<i64>("/bins/chrom", nbins), 0);
+    std::ignore =
+        hdf5::write_numbers(start_buff, this->create_dataset<i64>("/bins/start", nbins), 0);
+    std::ignore = hdf5::write_numbers(end_buff, this->create_dataset<i64>("/bins/end", nbins), 0);
+  } catch ([[maybe_unused]] const H5::Exception &e) {
+    throw std::runtime_error(fmt::format(
+        FMT_STRING("An error occurred while writing chromosomes and bins to file {}:\n{}"),
+        this->_path_to_file, hdf5::construct_error_stack()));
+  }
+}
+
+template <class N>
+void SCoolWriter<N>::write_metadata(const std::string &root_path, bool is_cell) {
+  i64 int_buff{};
+  std::string str_buff{};
+  std::string name{};
+  auto &f = *this->_fp;
+
+  try {
+    name = "format";
+    str_buff = is_cell ? "HDF5::Cooler" : "HDF5::SCOOL";
+    hdf5::write_or_create_attribute(f, name, str_buff, root_path);
+
+    name = "format-version";
+    int_buff = is_cell ? 3 : 1;
+    hdf5::write_or_create_attribute(f, name, int_buff, root_path);
+
+    name = "bin-type";
+    str_buff = "fixed";
+    hdf5::write_or_create_attribute(f, name, str_buff, root_path);
+
+    name = "bin-size";
+    int_buff = static_cast<i64>(this->_bin_size);
+    hdf5::write_or_create_attribute(f, name, int_buff, root_path);
+
+    name = "nbins";
+    int_buff = static_cast<i64>(this->get_nbins());
+    hdf5::write_or_create_attribute(f, name, int_buff, root_path);
+
+    name = "nchroms";
+    int_buff = static_cast<i64>(this->get_nchroms());
+    hdf5::write_or_create_attribute(f, name, int_buff, root_path);
+
+    if (is_cell) {
+      name = "storage-mode";
+      str_buff = "symmetric-upper";
+      hdf5::write_or_create_attribute(f, name, str_buff, root_path);
+    } else {
+      name = "ncells";
+      int_buff = static_cast<i64>(this->_ncells);
+      hdf5::write_or_create_attribute(f, name, int_buff, root_path);
+    }
+
+    name = "generated-by";
+    str_buff = modle::config::version::str_long();
+    hdf5::write_or_create_attribute(f, name, str_buff, root_path);
+
+    name = "creation-date";
+    str_buff = absl::FormatTime(absl::Now(), absl::UTCTimeZone());
+    hdf5::write_or_create_attribute(f, name, str_buff, root_path);
+  } catch ([[maybe_unused]] const H5::Exception &e) {
+    throw std::runtime_error(
+        fmt::format(FMT_STRING("The following error occurred while writing metadata to file {}: "
+                               "error while writing attribute \"{}\":\n{}"),
+                    this->_path_to_file, name, hdf5::construct_error_stack()));
+  }
+}
+
+template <class N>
+template <class T>
+H5::DataSet SCoolWriter<N>::create_dataset(const std::string &name, usize size) {
+  const auto chunk_size = this->compute_chunk_size(size);
+  const auto cprop = [&]() {
+    if constexpr (std::is_same_v<T, std::string>) {
+      return hdf5::generate_creat_prop_list(chunk_size, this->_compression_lvl, this->_str_type,
+                                            std::string{});
+    } else {
+      return hdf5::generate_creat_prop_list(chunk_size, this->_compression_lvl,
+                                            hdf5::getH5_type<T>(), T(0));
+    }
+  }();
+  // The number of slots in the chunk cache is computed from the nominal chunk size: using the
+  // clamped chunk size here would lead to absurdly large caches for small datasets
+  constexpr double rdcc_w0_streaming{0.99};
+  const auto aprop = hdf5::generate_acc_prop_list(H5::PredType::NATIVE_INT64, this->_chunk_size,
+                                                  this->_cache_size, rdcc_w0_streaming);
+
+  auto dset = [&]() {
+    if constexpr (std::is_same_v<T, std::string>) {
+      return hdf5::create_dataset(*this->_fp, name, this->_str_type, cprop, aprop);
+    } else {
+      return hdf5::create_dataset(*this->_fp, name, hdf5::getH5_type<T>(), cprop, aprop);
+    }
+  }();
+
+  // hdf5::create_dataset() returns datasets with one element. Shrink them, so that empty cells
+  // do not end up with a spurious pixel
+  const auto lck = hdf5::internal::lock();
+  const hsize_t empty_size{0};
+  dset.extend(&empty_size);
+  return dset;
+}
+
+}  // namespace modle::cooler
@@ -25,6 +25,7 @@
 #include <stdexcept>    // for invalid_argument, out_of_range, runtime_error
 #include <string>       // for allocator, string, basic_string
 #include <thread>       // for hardware_concurrency
+#include <tuple>        // for make_tuple
 #include <vector>       // for vector
 
 #include "modle/common/cli_utils.hpp"
@@ -34,6 +35,7 @@
 #include "modle/common/utils.hpp"              // for parse_numeric_or_throw
 #include "modle/config/version.hpp"            // modle_version_long
 #include "modle/cooler/cooler.hpp"             // for Cooler
+#include "modle/simulation.hpp"                // for Simulation::lef_move_t
 
 namespace modle {
 
@@ -56,6 +58,11 @@ std::ostream& operator<<(std::ostream& os, const Config::StoppingCriterion& crit
   return os;
 }
 
+std::ostream& operator<<(std::ostream& os, const Config::TaskFileFormat& format) {
+  os << Cli::task_file_format_map.at(format);
+  return os;
+}
+
 std::ostream& operator<<(std::ostream& os, const Config::ContactSamplingStrategy strategy) {
   os << Cli::contact_sampling_strategy_map.at(strategy);
   return os;
@@ -162,6 +169,19 @@ static std::vector<CLI::App*> add_common_options(CLI::App& subcommand, modle::Co
                   fmt::join(absl::StrSplit(Config::model_internal_state_log_header, '\t'), "\n - ")))
       ->capture_default_str();
 
+  io_adv.add_flag(
+      "--profile-report",
+      c.write_profile_report,
+      "Collect timers and counters for the hot-path of the simulation (e.g. time spent\n"
+      "simulating, registering contacts and writing them to disk, number of collisions by type\n"
+      "etc.).\n"
+      "Counters are aggregated per thread and per chromosome and are written to a TSV file\n"
+      "under the prefix specified through the --output-prefix option.\n"
+      "Example: modle sim --output-prefix=/tmp/myprefix\n"
+      "         the report will be written to file /tmp/myprefix_profile_report.tsv.\n"
+      "This option requires MoDLE to be compiled with -DMODLE_ENABLE_PROFILING=ON.")
+      ->capture_default_str();
+
   io_adv.add_flag(
       "--simulate-chromosomes-wo-barriers,!--skip-chromosomes-wo-barriers",
       c.simulate_chromosomes_wo_barriers,
@@ -410,6 +430,15 @@ static std::vector<CLI::App*> add_common_options(CLI::App& subcommand, modle::Co
       ->check(CLI::NonNegativeNumber)
       ->capture_default_str();
 
+  cgen_adv.add_flag(
+      "--tabulate-noise",
+      c.tabulate_contact_noise,
+      "Draw the noise added to molecular contacts from a precomputed table approximating the\n"
+      "inverse CDF of the generalized extreme value distribution.\n"
+      "This is faster than evaluating the inverse CDF for every contact, and introduces an error\n"
+      "that is well below 1 bp for typical values of --mu, --sigma and --xi.")
+      ->capture_default_str();
+
   stopping.add_option(
       "-s,--stopping-criterion",
       c.stopping_criterion,
@@ -472,6 +501,17 @@ static std::vector<CLI::App*> add_common_options(CLI::App& subcommand, modle::Co
       ->transform(utils::cli::TrimTrailingZerosFromDecimalDigit)
       ->capture_default_str();
 
+  misc.add_option(
+      "--max-memory",
+      c.max_memory,
+      "Upper bound for the amount of memory used to store contact matrices, LEF occupancy buffers\n"
+      "and the buffers used by worker threads (e.g. 8G, 512MB).\n"
+      "Chromosomes are admitted for simulation only when their buffers fit within this budget.\n"
+      "Note that the budget is exceeded when a single chromosome does not fit in it.\n"
+      "By default the budget is large enough to store the two largest contact matrices.")
+      ->transform(CLI::AsSizeValue(false))
+      ->default_str("auto");
+
   burnin_adv.add_flag(
       "--skip-burnin",
       c.skip_burnin,
@@ -571,6 +611,22 @@ static std::vector<CLI::App*> add_common_options(CLI::App& subcommand, modle::Co
       "Toggle on/off normalization of transition and collision probabilities using --probability-normalization-factor.")
       ->capture_default_str();
 
+  misc_adv.add_flag(
+      "--fused-collision-pipeline",
+      c.fused_collision_pipeline,
+      "Detect and process LEF collisions using fewer passes over the LEFs.\n"
+      "Simulation results are identical to those obtained without this flag.")
+      ->capture_default_str();
+
+  misc_adv.add_flag(
+      "--fast-sampling",
+      c.fast_sampling,
+      "Batch the random draws performed at every epoch, and schedule LEF releases and barrier\n"
+      "state transitions ahead of time instead of running one trial per epoch.\n"
+      "This is faster, but simulation results are not identical to those obtained without this\n"
+      "flag (results are still reproducible for a given --seed).")
+      ->capture_default_str();
+
   // Address option dependencies/incompatibilities
   io_adv.get_option("--skip-output")->excludes(io_adv.get_option("--log-model-internal-state"));
   stopping.get_option("--target-contact-density")->excludes(stopping.get_option("--target-number-of-epochs"));
@@ -621,10 +677,13 @@ void Cli::make_perturbate_subcommand() {
   auto& misc = *s.get_option_group("Miscellaneous");
 
   auto& io_adv = *s.get_option_group("Advanced")->get_option_group("IO");
+  auto& burnin_adv = *s.get_option_group("Advanced")->get_option_group("Burn-in");
 
   // Remove unused flags/options
   io_adv.remove_option(io_adv.get_option("--simulate-chromosomes-wo-barriers"));
+  io_adv.remove_option(io_adv.get_option("--profile-report"));
   misc.remove_option(misc.get_option("--ncells"));
+  misc.remove_option(misc.get_option("--max-memory"));
 
   // Update flag/option descriptions
   // clang-format off
@@ -664,6 +723,20 @@ void Cli::make_perturbate_subcommand() {
       "This is equivalent to running modle simulate followed by modle perturbate without changing parameters.")
       ->capture_default_str();
 
+  io_adv.add_option(
+      "--task-file-format",
+      c.task_file_format,
+      fmt::format(
+          FMT_STRING("Format of the file listing the tasks that were simulated.\n"
+                     "Should be one of {}.\n"
+                     "TSV task files can be inspected or processed by other tools.\n"
+                     "Binary task files are indexed by task ID, making them much faster to\n"
+                     "replay."),
+          utils::format_collection_to_english_list(Cli::task_file_format_map.keys_view(), ", ",
+                                                   " or ")))
+      ->transform(CLI::CheckedTransformer(Cli::task_file_format_map))
+      ->capture_default_str();
+
   misc.add_option(
       "--block-size",
       c.block_size,
@@ -687,9 +760,27 @@ void Cli::make_perturbate_subcommand() {
       c.path_to_deletion_bed,
       "Path to a BED file containing the list deletions to perform when perturbating extrusion barriers.")
       ->check(CLI::ExistingFile);
+
+  burnin_adv.add_flag(
+      "--warm-start",
+      c.warm_start,
+      "Run the burn-in phase once per window, and start the simulation of each deletion from the\n"
+      "state reached at the end of the burn-in phase (after disabling the barriers overlapping\n"
+      "the deletion).")
+      ->capture_default_str();
+
+  burnin_adv.add_option(
+      "--warm-start-epochs",
+      c.warm_start_epochs,
+      "Number of burn-in epochs used to re-equilibrate warm-started simulations after disabling\n"
+      "the barriers overlapping a deletion.")
+      ->check(CLI::NonNegativeNumber)
+      ->capture_default_str();
   // clang-format on
 
   misc.get_option("--deletion-size")->excludes("--deletion-list");
+  burnin_adv.get_option("--warm-start")->excludes(burnin_adv.get_option("--skip-burnin"));
+  burnin_adv.get_option("--warm-start-epochs")->needs(burnin_adv.get_option("--warm-start"));
 
   auto option_group_ptrs = add_common_options(s, this->_config);
   for (auto* og : option_group_ptrs) {
@@ -723,7 +814,7 @@ void Cli::make_replay_subcommand() {
   io.add_option(
       "--task-file",
       c.path_to_task_file,
-      "Path to the task file produced by modle perturbate.")
+      "Path to the task file produced by modle perturbate (either in binary or TSV format).")
       ->check(CLI::ExistingFile)
       ->required();
 
@@ -737,7 +828,8 @@ void Cli::make_replay_subcommand() {
       "-o,--output-prefix",
       c.path_to_output_prefix,
       "Output prefix.\n"
-      "Can be a full or relative path including the file name but without extension.")
+      "Can be a full or relative path including the file name but without extension.\n"
+      "Contacts for all tasks are written to a single <prefix>.scool file, with one cell per task.")
       ->required();
 
   io.add_flag(
@@ -878,11 +970,15 @@ std::string Cli::detect_path_collisions(modle::Config& c) const {
       std::filesystem::exists(c.path_to_model_state_log_file)) {
     absl::StrAppend(&collisions, check_for_path_collisions(c.path_to_model_state_log_file));
   }
+  if (c.write_profile_report && std::filesystem::exists(c.path_to_profile_report)) {
+    absl::StrAppend(&collisions, check_for_path_collisions(c.path_to_profile_report));
+  }
   if (this->get_subcommand() != subcommand::replay &&
       std::filesystem::exists(c.path_to_config_file)) {
     absl::StrAppend(&collisions, check_for_path_collisions(c.path_to_config_file));
   }
   if ((this->get_subcommand() == subcommand::simulate ||
+       this->get_subcommand() == subcommand::replay ||
        (this->get_subcommand() == subcommand::perturbate &&
         this->_config.compute_reference_matrix)) &&
       std::filesystem::exists(c.path_to_output_file_cool)) {
@@ -997,12 +1093,37 @@ void Cli::validate_args() const {
                                "CLI option --no-normalize-probabilities was passed by the user.")));
   }
 
+  if constexpr (!utils::profiling_enabled()) {
+    if (c.write_profile_report) {
+      errors.emplace_back(
+          "--profile-report requires MoDLE to be compiled with -DMODLE_ENABLE_PROFILING=ON.");
+    }
+  }
+
   if (c.min_burnin_epochs > c.max_burnin_epochs) {
     errors.emplace_back(fmt::format(
         FMT_STRING("--min-burnin-epochs={} cannot be greater than --max-burnin-epochs={}."),
         c.min_burnin_epochs, c.max_burnin_epochs));
   }
 
+  // Candidate moves are stored as Simulation::lef_move_t: reject extrusion speeds for which moves
+  // up to 10 standard deviations above the average (burn-in) speed would not fit in a lef_move_t
+  constexpr auto max_move = std::numeric_limits<Simulation::lef_move_t>::max();
+  for (const auto& [label, speed, speed_std] :
+       {std::make_tuple("--rev-extrusion-speed", c.rev_extrusion_speed, c.rev_extrusion_speed_std),
+        std::make_tuple("--fwd-extrusion-speed", c.fwd_extrusion_speed,
+                        c.fwd_extrusion_speed_std)}) {
+    const auto avg_speed = static_cast<double>(speed) * std::max(1.0, c.burnin_speed_coefficient);
+    // Standard deviations between 0 and 1 are relative to the average speed (see transform_args())
+    const auto stddev = speed_std < 1 ? speed_std * static_cast<double>(speed) : speed_std;
+    if (avg_speed + (10 * stddev) > static_cast<double>(max_move)) {
+      errors.emplace_back(fmt::format(
+          FMT_STRING("{}={} is too large: with {}-std={} and --burnin-extr-speed-coefficient={} "
+                     "extrusion units could be assigned moves longer than {} bp."),
+          label, speed, label, speed_std, c.burnin_speed_coefficient, max_move));
+    }
+  }
+
   if (!errors.empty()) {
     throw std::runtime_error(fmt::format(
         FMT_STRING(
@@ -1029,31 +1150,6 @@ const CLI::App* Cli::get_subcommand_ptr() const {
   MODLE_UNREACHABLE_CODE;
 }
 
-// The following two functions have been copied from the ExtrusionBarrier class.
-// This is not ideal, but I think it is better than make the CLI interface depend on the
-// ExtrusionBarrier class (which is part of libmodle_internal)
-constexpr double compute_stp_active_from_occupancy(double stp_inactive, double occupancy) noexcept {
-  if (MODLE_UNLIKELY(occupancy == 0)) {
-    return 0.0;
-  }
-
-  const auto tp_inactive_to_active = 1.0 - stp_inactive;
-  const auto tp_active_to_inactive =
-      (tp_inactive_to_active - (occupancy * tp_inactive_to_active)) / occupancy;
-  return std::clamp(1.0 - tp_active_to_inactive, 0.0, 1.0);
-}
-
-constexpr double compute_occupancy_from_stp(double stp_active, double stp_inactive) noexcept {
-  if (MODLE_UNLIKELY(stp_active + stp_inactive == 0)) {
-    return 0.0;
-  }
-
-  const auto tp_inactive_to_active = 1.0 - stp_inactive;
-  const auto tp_active_to_inactive = 1.0 - stp_active;
-  const auto occupancy = tp_inactive_to_active / (tp_inactive_to_active + tp_active_to_inactive);
-  return std::clamp(occupancy, 0.0, 1.0);
-}
-
 /// Generate output file paths from output prefix
 static void cli_update_paths(Cli::subcommand subcommand, Config& c) {
   c.path_to_output_file_cool = c.path_to_output_prefix;
@@ -1063,11 +1159,16 @@ static void cli_update_paths(Cli::subcommand subcommand, Config& c) {
   c.path_to_config_file = c.path_to_output_prefix;
   if (subcommand == Cli::subcommand::perturbate) {
     c.path_to_task_file = c.path_to_output_prefix;
-    c.path_to_task_file += "_tasks.tsv.gz";
+    c.path_to_task_file += c.task_file_format == Config::TaskFileFormat::tsv ? "_tasks.tsv.gz"
+                                                                            : "_tasks.bin";
   }
   if (subcommand == Cli::subcommand::simulate) {
     c.path_to_model_state_log_file = c.path_to_output_prefix;
     c.path_to_model_state_log_file += "_internal_state.log.gz";
+    if (c.write_profile_report) {
+      c.path_to_profile_report = c.path_to_output_prefix;
+      c.path_to_profile_report += "_profile_report.tsv";
+    }
   }
 
   if (c.track_1d_lef_position) {
@@ -1075,7 +1176,8 @@ static void cli_update_paths(Cli::subcommand subcommand, Config& c) {
     c.path_to_lef_1d_occupancy_bw_file += "_lef_1d_occupancy.bw";
   }
 
-  c.path_to_output_file_cool += ".cool";
+  // modle replay writes the contacts produced by all tasks to a single .scool file
+  c.path_to_output_file_cool += subcommand == Cli::subcommand::replay ? ".scool" : ".cool";
   c.path_to_output_file_bedpe += !c.path_to_output_file_bedpe.empty() ? ".bedpe.gz" : "";
   c.path_to_log_file += ".log";
   c.path_to_config_file += "_config.toml";
@@ -1126,11 +1228,11 @@ static void cli_update_barrier_stp_and_occupancy(const CLI::App& cli, Config& c)
       !grp->get_option("--extrusion-barrier-occupancy")->empty();
 
   if (extrusion_barrier_occupancy_parsed) {
-    c.barrier_occupied_stp = compute_stp_active_from_occupancy(c.barrier_not_occupied_stp,
-                                                               c.extrusion_barrier_occupancy);
+    c.barrier_occupied_stp = Config::compute_stp_active_from_occupancy(
+        c.barrier_not_occupied_stp, c.extrusion_barrier_occupancy);
   } else {
     c.extrusion_barrier_occupancy =
-        compute_occupancy_from_stp(c.barrier_occupied_stp, c.barrier_not_occupied_stp);
+        Config::compute_occupancy_from_stp(c.barrier_occupied_stp, c.barrier_not_occupied_stp);
   }
 }
 
@@ -1154,8 +1256,8 @@ static void cli_normalize_probabilities(Config& c) {
     // It is important that we recompute the barrier_occupued_stp after correcting
     // barrier_not_occupied_stp!
     c.barrier_not_occupied_stp = stable_pow(c.barrier_not_occupied_stp, ratio);
-    c.barrier_occupied_stp = compute_stp_active_from_occupancy(c.barrier_not_occupied_stp,
-                                                               c.extrusion_barrier_occupancy);
+    c.barrier_occupied_stp = Config::compute_stp_active_from_occupancy(
+        c.barrier_not_occupied_stp, c.extrusion_barrier_occupancy);
 
     if (const auto p = c.probability_of_extrusion_unit_bypass; p != 0.0 && p != 1.0) {
       c.probability_of_extrusion_unit_bypass = std::min(p * ratio, 1.0);
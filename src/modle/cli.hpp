@@ -65,6 +65,11 @@ class Cli {
       std::make_pair("contact-density", Config::StoppingCriterion::contact_density),
       std::make_pair("simulation-epochs", Config::StoppingCriterion::simulation_epochs)};
 
+  using TaskFileFormatMappings = utils::CliEnumMappings<Config::TaskFileFormat>;
+  inline static const TaskFileFormatMappings task_file_format_map{
+      std::make_pair("tsv", Config::TaskFileFormat::tsv),
+      std::make_pair("binary", Config::TaskFileFormat::binary)};
+
   using CS_ = Config::ContactSamplingStrategy;
   using CS_ut_ = CS_::underlying_type;
   // It is important that we use the underlying type in this map
@@ -0,0 +1,317 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+// modle_bench: micro-benchmark suite for the hot path of modle sim.
+// Each benchmark runs Simulation::simulate_one_cell step-by-step on a synthetic workload and times
+// each step separately. Results are printed (or written to a file) in JSON format, so that they
+// can be easily compared across releases.
+
+#include <absl/types/span.h>  // for MakeConstSpan
+#include <fmt/format.h>       // for format, join, print, FMT_STRING
+#include <fmt/os.h>           // for output_file
+
+#include <CLI/CLI.hpp>  // for App, ParseError
+#include <algorithm>    // for copy, min
+#include <array>        // for array
+#include <chrono>       // for steady_clock, nanoseconds, duration
+#include <cstddef>      // for ptrdiff_t
+#include <cstdio>       // for stderr
+#include <exception>    // for exception
+#include <filesystem>   // for path
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include "modle/common/common.hpp"             // for bp_t, usize, u64
+#include "modle/common/dna.hpp"                // for REV, FWD
+#include "modle/common/random.hpp"             // for PRNG, BatchPRNG, uniform_int_distribution
+#include "modle/common/simulation_config.hpp"  // for Config
+#include "modle/config/version.hpp"            // for str
+#include "modle/extrusion_barriers.hpp"        // for ExtrusionBarrier
+#include "modle/genome.hpp"                    // for Chromosome
+#include "modle/simulation.hpp"                // for Simulation
+
+namespace modle::bench {
+
+struct BenchConfig {
+  bp_t genome_size{100'000'000};
+  double number_of_lefs_per_mbp{20};
+  usize num_barriers{5'000};
+  double extrusion_barrier_occupancy{0.825};
+  usize num_warmup_epochs{1'000};
+  usize num_epochs{5'000};
+  u64 seed{0};
+  bool fast_sampling{false};
+  std::filesystem::path path_to_output{};
+};
+
+enum Stage : usize {
+  BIND = 0,
+  RANK,
+  REGISTER_CONTACTS,
+  GENERATE_MOVES,
+  UPDATE_BARRIERS,
+  RESET_COLLISIONS,
+  DETECT_UNITS_AT_CHROM_BOUNDARIES,
+  DETECT_LEF_BAR_COLLISIONS,
+  DETECT_PRIMARY_LEF_LEF_COLLISIONS,
+  CORRECT_MOVES,
+  PROCESS_SECONDARY_LEF_LEF_COLLISIONS,
+  EXTRUDE,
+  RELEASE,
+  NUM_STAGES
+};
+
+constexpr std::array<std::string_view, NUM_STAGES> stage_names{
+    "bind",
+    "rank",
+    "register_contacts",
+    "generate_moves",
+    "update_barriers",
+    "reset_collisions",
+    "detect_units_at_chrom_boundaries",
+    "detect_lef_bar_collisions",
+    "detect_primary_lef_lef_collisions",
+    "correct_moves",
+    "process_secondary_lef_lef_collisions",
+    "extrude",
+    "release"};
+
+using clock = std::chrono::steady_clock;
+using StageTimes = std::array<std::chrono::nanoseconds, NUM_STAGES>;
+
+[[nodiscard]] static Config generate_config(const BenchConfig& bc) {
+  Config c{};
+  c.seed = bc.seed;
+  c.nthreads = 1;
+  c.skip_burnin = true;
+  c.target_simulation_epochs = bc.num_epochs;
+  c.target_contact_density = -1;
+  c.stopping_criterion = Config::StoppingCriterion::simulation_epochs;
+  c.number_of_lefs_per_mbp = bc.number_of_lefs_per_mbp;
+  c.fast_sampling = bc.fast_sampling;
+
+  // Mirror what is done by modle's CLI when using default parameters
+  c.fwd_extrusion_speed_std *= static_cast<double>(c.fwd_extrusion_speed);
+  c.rev_extrusion_speed_std *= static_cast<double>(c.rev_extrusion_speed);
+  c.prob_of_lef_release = static_cast<double>(c.rev_extrusion_speed + c.fwd_extrusion_speed) /
+                          static_cast<double>(c.avg_lef_processivity);
+  c.prob_of_lef_release_burnin = c.prob_of_lef_release;
+  c.extrusion_barrier_occupancy = bc.extrusion_barrier_occupancy;
+  c.barrier_occupied_stp = Config::compute_stp_active_from_occupancy(c.barrier_not_occupied_stp,
+                                                                     c.extrusion_barrier_occupancy);
+  return c;
+}
+
+[[nodiscard]] static std::vector<ExtrusionBarrier> generate_barriers(const BenchConfig& bc,
+                                                                     const Config& c) {
+  auto rand_eng = random::PRNG(bc.seed);
+  random::uniform_int_distribution<bp_t> pos_gen{0, bc.genome_size - 1};
+  random::bernoulli_trial dir_gen{0.5};
+
+  std::vector<ExtrusionBarrier> barriers;
+  barriers.reserve(bc.num_barriers);
+  for (usize i = 0; i < bc.num_barriers; ++i) {
+    barriers.emplace_back(pos_gen(rand_eng), c.barrier_occupied_stp, c.barrier_not_occupied_stp,
+                          dir_gen(rand_eng) ? dna::REV : dna::FWD);
+  }
+  return barriers;
+}
+
+template <typename Fx>
+static void time_stage(StageTimes& times, Stage stage, Fx&& fx) {
+  const auto t0 = clock::now();
+  fx();
+  times[stage] += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - t0);
+}
+
+// Simulate one epoch following the same sequence of steps used by Simulation::simulate_one_cell
+static void run_epoch(const Simulation& sim, Simulation::State& s, StageTimes& times,
+                      std::vector<usize>& rank_buff) {
+  // Binding a LEF implies ranking LEFs. In order to time the two steps separately, we take a
+  // snapshot of the ranks before binding LEFs, then rank LEFs a second time starting from the
+  // snapshot, and subtract the time spent ranking from the time spent binding
+  const auto rev_ranks = s.get_rev_ranks();
+  const auto fwd_ranks = s.get_fwd_ranks();
+  std::copy(rev_ranks.begin(), rev_ranks.end(), rank_buff.begin());
+  std::copy(fwd_ranks.begin(), fwd_ranks.end(), rank_buff.begin() + std::ptrdiff_t(s.num_lefs));
+
+  time_stage(times, BIND, [&]() { Simulation::bench_bind_lefs(s); });
+  std::copy(rank_buff.begin(), rank_buff.begin() + std::ptrdiff_t(s.num_lefs), rev_ranks.begin());
+  std::copy(rank_buff.begin() + std::ptrdiff_t(s.num_lefs), rank_buff.end(), fwd_ranks.begin());
+  const auto t_bind = times[BIND];
+  const auto t_rank = times[RANK];
+  time_stage(times, RANK, [&]() { Simulation::bench_rank_lefs(s); });
+  times[BIND] = t_bind - std::min(t_bind, times[RANK] - t_rank);
+
+  time_stage(times, REGISTER_CONTACTS, [&]() { sim.bench_register_contacts(s); });
+  time_stage(times, GENERATE_MOVES, [&]() { sim.bench_generate_moves(s); });
+  time_stage(times, UPDATE_BARRIERS, [&]() { sim.bench_update_barriers(s); });
+  time_stage(times, RESET_COLLISIONS, [&]() { Simulation::bench_reset_collisions(s); });
+
+  Simulation::BenchCollisionCounts n{};
+  time_stage(times, DETECT_UNITS_AT_CHROM_BOUNDARIES,
+             [&]() { n = Simulation::bench_detect_units_at_chrom_boundaries(s); });
+  time_stage(times, DETECT_LEF_BAR_COLLISIONS,
+             [&]() { sim.bench_detect_lef_bar_collisions(s, n); });
+  time_stage(times, DETECT_PRIMARY_LEF_LEF_COLLISIONS,
+             [&]() { sim.bench_detect_primary_lef_lef_collisions(s, n); });
+  time_stage(times, CORRECT_MOVES, [&]() { Simulation::bench_correct_moves(s); });
+  time_stage(times, PROCESS_SECONDARY_LEF_LEF_COLLISIONS,
+             [&]() { sim.bench_process_secondary_lef_lef_collisions(s, n); });
+
+  time_stage(times, EXTRUDE, [&]() { Simulation::bench_extrude(s); });
+  time_stage(times, RELEASE, [&]() { sim.bench_release_lefs(s); });
+  ++s.epoch;
+}
+
+[[nodiscard]] static std::string run_benchmark(const BenchConfig& bc) {
+  const auto c = generate_config(bc);
+  const Simulation sim(c, false);
+
+  Chromosome chrom(0, "chr_bench", 0, bc.genome_size, bc.genome_size);
+  chrom.allocate_contact_matrix(c.bin_size, c.diagonal_width);
+  const auto barriers = generate_barriers(bc, c);
+
+  Simulation::Task task{};
+  task.chrom = &chrom;
+  task.num_target_epochs = bc.num_epochs;
+  task.num_lefs = chrom.num_lefs(c.number_of_lefs_per_mbp);
+  task.barriers = absl::MakeConstSpan(barriers);
+
+  Simulation::State s{};
+  s = task;
+  s.resize_buffers();
+  s.reset_buffers();
+  s.seed = chrom.hash(s.xxh_state.get(), c.seed, s.cell_id);
+  s.rand_eng = random::PRNG(s.seed);
+  if (c.fast_sampling) {
+    s.batch_rand_eng = random::BatchPRNG(s.rand_eng());
+  }
+  s.barriers.init_states(s.rand_eng);
+  s.num_active_lefs = s.num_lefs;
+  s.burnin_completed = true;
+
+  std::vector<usize> rank_buff(2 * s.num_lefs);
+  StageTimes times{};
+
+  // Warm-up epochs are used to let the simulation reach a steady state (i.e. loops with a size
+  // close to the average LEF processivity)
+  for (usize i = 0; i < bc.num_warmup_epochs; ++i) {
+    run_epoch(sim, s, times, rank_buff);
+  }
+  Simulation::bench_flush_contact_buffer(s);
+  times = StageTimes{};
+  const auto num_warmup_contacts = s.num_contacts;
+
+  const auto t0 = clock::now();
+  for (usize i = 0; i < bc.num_epochs; ++i) {
+    run_epoch(sim, s, times, rank_buff);
+  }
+  time_stage(times, REGISTER_CONTACTS, [&]() { Simulation::bench_flush_contact_buffer(s); });
+  const std::chrono::duration<double> wall_time = clock::now() - t0;
+  const auto num_contacts = s.num_contacts - num_warmup_contacts;
+
+  // Throughput is computed using the time spent in the simulation steps, as wall time also
+  // includes the overhead introduced by timing bind and rank separately
+  std::chrono::nanoseconds tot_stage_time{};
+  for (const auto& t : times) {
+    tot_stage_time += t;
+  }
+  const std::chrono::duration<double> sim_time = tot_stage_time;
+
+  std::vector<std::string> stages(NUM_STAGES);
+  for (usize i = 0; i < NUM_STAGES; ++i) {
+    const std::chrono::duration<double> t = times[i];
+    stages[i] = fmt::format(
+        FMT_STRING("    {{\"name\": \"{}\", \"time_s\": {:.6f}, \"ns_per_epoch\": {:.1f}, "
+                   "\"fraction\": {:.4f}}}"),
+        stage_names[i], t.count(),
+        static_cast<double>(times[i].count()) / static_cast<double>(bc.num_epochs),
+        static_cast<double>(times[i].count()) / static_cast<double>(tot_stage_time.count()));
+  }
+
+  return fmt::format(FMT_STRING("{{\n"
+                                "  \"modle_version\": \"{}\",\n"
+                                "  \"workload\": {{\n"
+                                "    \"genome_size\": {},\n"
+                                "    \"num_lefs\": {},\n"
+                                "    \"num_barriers\": {},\n"
+                                "    \"extrusion_barrier_occupancy\": {},\n"
+                                "    \"num_warmup_epochs\": {},\n"
+                                "    \"num_epochs\": {},\n"
+                                "    \"seed\": {},\n"
+                                "    \"fast_sampling\": {}\n"
+                                "  }},\n"
+                                "  \"wall_time_s\": {:.6f},\n"
+                                "  \"simulation_time_s\": {:.6f},\n"
+                                "  \"epochs_per_second\": {:.2f},\n"
+                                "  \"contacts\": {},\n"
+                                "  \"contacts_per_second\": {:.2f},\n"
+                                "  \"stages\": [\n{}\n  ]\n"
+                                "}}\n"),
+                     config::version::str(), bc.genome_size, s.num_lefs, bc.num_barriers,
+                     bc.extrusion_barrier_occupancy, bc.num_warmup_epochs, bc.num_epochs, bc.seed,
+                     bc.fast_sampling, wall_time.count(), sim_time.count(),
+                     static_cast<double>(bc.num_epochs) / sim_time.count(), num_contacts,
+                     static_cast<double>(num_contacts) / sim_time.count(),
+                     fmt::join(stages, ",\n"));
+}
+
+}  // namespace modle::bench
+
+int main(int argc, char** argv) noexcept {
+  using namespace modle::bench;
+  BenchConfig bc{};
+
+  CLI::App cli{"modle_bench: micro-benchmarks for the simulation hot path of MoDLE."};
+  // clang-format off
+  cli.add_option("--genome-size", bc.genome_size, "Size of the synthetic chromosome (bp).")
+      ->check(CLI::PositiveNumber)
+      ->capture_default_str();
+  cli.add_option("--lefs-per-mbp", bc.number_of_lefs_per_mbp, "Number of LEFs per Mbp of DNA.")
+      ->check(CLI::PositiveNumber)
+      ->capture_default_str();
+  cli.add_option("--num-barriers", bc.num_barriers, "Number of extrusion barriers.")
+      ->check(CLI::NonNegativeNumber)
+      ->capture_default_str();
+  cli.add_option("--extrusion-barrier-occupancy", bc.extrusion_barrier_occupancy,
+                 "Probability that an extrusion barrier is occupied at any given time.")
+      ->check(CLI::Bound(0.0, 1.0))
+      ->capture_default_str();
+  cli.add_option("--warmup-epochs", bc.num_warmup_epochs,
+                 "Number of epochs to simulate before starting timers.")
+      ->check(CLI::NonNegativeNumber)
+      ->capture_default_str();
+  cli.add_option("--epochs", bc.num_epochs, "Number of epochs to benchmark.")
+      ->check(CLI::PositiveNumber)
+      ->capture_default_str();
+  cli.add_option("--seed", bc.seed, "Seed used to generate the synthetic workload.")
+      ->capture_default_str();
+  cli.add_flag("--fast-sampling", bc.fast_sampling,
+               "Benchmark the sampling scheme enabled by modle's --fast-sampling flag.")
+      ->capture_default_str();
+  cli.add_option("-o,--output", bc.path_to_output,
+                 "Path where to write results in JSON format.\n"
+                 "Results are printed to stdout when no path is specified.");
+  // clang-format on
+
+  try {
+    cli.parse(argc, argv);
+    const auto report = run_benchmark(bc);
+    if (bc.path_to_output.empty()) {
+      fmt::print(FMT_STRING("{}"), report);
+    } else {
+      auto f = fmt::output_file(bc.path_to_output.string());
+      f.print(FMT_STRING("{}"), report);
+    }
+  } catch (const CLI::ParseError& e) {
+    return cli.exit(e);
+  } catch (const std::exception& e) {
+    fmt::print(stderr, FMT_STRING("FAILURE! modle_bench encountered the following error: {}.\n"),
+               e.what());
+    return 1;
+  }
+  return 0;
+}
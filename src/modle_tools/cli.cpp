@@ -349,6 +349,14 @@ void Cli::make_noisify_subcommand() {
      ->check(CLI::NonNegativeNumber)
      ->capture_default_str();
 
+  noise.add_flag(
+     "--tabulate",
+     c.tabulate_noise,
+     "Draw noise from a precomputed table approximating the inverse CDF of the generalized\n"
+     "extreme value distribution. This is faster and introduces an error well below 1 bp for\n"
+     "typical parameters.")
+     ->capture_default_str();
+
   noise.add_option(
      "--seed",
      c.seed,
@@ -84,6 +84,7 @@ struct noisify_config {
   double genextreme_mu{0};
   double genextreme_sigma{7'500};
   double genextreme_xi{0.001};
+  bool tabulate_noise{false};
   u64 seed{0};
 };
 
@@ -25,7 +25,7 @@
 #include <vector>       // for vector
 
 #include "modle/common/fmt_helpers.hpp"
-#include "modle/common/genextreme_value_distribution.hpp"  // for genextreme_value_distribution
+#include "modle/common/genextreme_value_distribution.hpp"  // for genextreme_value_distrib...
 #include "modle/common/random.hpp"                         // for PRNG
 #include "modle/contact_matrix_dense.hpp"                  // for ContactMatrixDense
 #include "modle/cooler/cooler.hpp"                         // for Cooler::Pixel, Cooler, Cooler:...
@@ -58,6 +58,13 @@ void noisify_contacts(const noisify_config& c) {
     return it->size();
   }();
 
+  // The table only depends on the distribution parameters: build it once for all chromosomes
+  const auto genextreme_table =
+      c.tabulate_noise ? modle::tabulated_genextreme_value_distribution<double>{c.genextreme_mu,
+                                                                                c.genextreme_sigma,
+                                                                                c.genextreme_xi}
+                       : modle::tabulated_genextreme_value_distribution<double>{};
+
   modle::cooler::Cooler output_cool(c.path_to_output_matrix, cooler::Cooler<>::IO_MODE::WRITE_ONLY,
                                     input_cool.get_bin_size(), max_chrom_name_size);
 
@@ -85,6 +92,12 @@ void noisify_contacts(const noisify_config& c) {
     auto rang_eng = random::PRNG(seed);
     auto genextreme = modle::genextreme_value_distribution<double>{
         c.genextreme_mu, c.genextreme_sigma, c.genextreme_xi};
+    auto draw_noise = [&]() {
+      if (c.tabulate_noise) {
+        return genextreme_table(rang_eng);
+      }
+      return genextreme(rang_eng);
+    };
     while (true) {
       pixel_queue.wait_dequeue(pixel);
       if (pixel == END_OF_PIXEL_QUEUE) {
@@ -92,8 +105,8 @@ void noisify_contacts(const noisify_config& c) {
       }
       assert(pixel.row() <= pixel.col());
       for (usize i = 0; i < pixel.count; ++i) {
-        const auto pos1 = static_cast<double>(pixel.row() * bin_size) + genextreme(rang_eng);
-        const auto pos2 = static_cast<double>(pixel.col() * bin_size) - genextreme(rang_eng);
+        const auto pos1 = static_cast<double>(pixel.row() * bin_size) + draw_noise();
+        const auto pos2 = static_cast<double>(pixel.col() * bin_size) - draw_noise();
         const auto bin1 = std::clamp(
             static_cast<usize>(std::round(pos1 / static_cast<double>(bin_size))), 0UL, ncols - 1);
         const auto bin2 = std::clamp(
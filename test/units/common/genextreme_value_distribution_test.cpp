@@ -0,0 +1,71 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+#include "modle/common/genextreme_value_distribution.hpp"
+
+#include <algorithm>  // for max, sort
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>   // for abs, exp, pow, sqrt
+#include <vector>  // for vector
+
+#include "modle/common/common.hpp"  // for usize
+#include "modle/common/random.hpp"  // for PRNG
+
+namespace modle::test::random {
+
+struct GenextremeParams {
+  double mu;
+  double sigma;
+  double xi;
+};
+
+[[nodiscard]] static double genextreme_cdf(const double x, const GenextremeParams& p) {
+  return std::exp(-std::pow(1.0 - (p.xi * (x - p.mu) / p.sigma), 1.0 / p.xi));
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("Tabulated genextreme - inverse CDF", "[random][common][short]") {
+  for (const auto& p : {GenextremeParams{0, 5'000, 0.001}, GenextremeParams{0, 7'500, 0.001},
+                        GenextremeParams{100, 1'000, 0.1}}) {
+    const auto dist = genextreme_value_distribution<double>{p.mu, p.sigma, p.xi};
+    const auto table = tabulated_genextreme_value_distribution<double>{p.mu, p.sigma, p.xi};
+    REQUIRE(table.table_size() ==
+            tabulated_genextreme_value_distribution<>::default_table_size + 1);
+
+    // Interpolation error should be well below 1 bp
+    double max_error = 0;
+    constexpr usize num_points = 1'000'000;
+    for (usize i = 0; i < num_points; ++i) {
+      const auto u = static_cast<double>(i) / static_cast<double>(num_points);
+      max_error = std::max(max_error, std::abs(dist.from_canonical(u) - table.from_canonical(u)));
+    }
+    CHECK(max_error < 0.5);
+  }
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("Tabulated genextreme - KS test", "[random][common][short]") {
+  const auto p = GenextremeParams{0, 5'000, 0.001};
+  const auto table = tabulated_genextreme_value_distribution<double>{p.mu, p.sigma, p.xi};
+  auto rand_eng = modle::random::PRNG(10556020843759504871ULL);
+
+  constexpr usize num_samples = 100'000;
+  std::vector<double> samples(num_samples);
+  for (auto& n : samples) {
+    n = table(rand_eng);
+  }
+  std::sort(samples.begin(), samples.end());
+
+  // Kolmogorov-Smirnov statistic. The critical value for alpha = 0.01 is ~1.63 / sqrt(n)
+  const auto n = static_cast<double>(num_samples);
+  double d = 0;
+  for (usize i = 0; i < num_samples; ++i) {
+    const auto cdf = genextreme_cdf(samples[i], p);
+    d = std::max({d, std::abs(cdf - (static_cast<double>(i) / n)),
+                  std::abs((static_cast<double>(i + 1) / n) - cdf)});
+  }
+  CHECK(d < 1.63 / std::sqrt(n));
+}
+
+}  // namespace modle::test::random
@@ -0,0 +1,83 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+#include "modle/common/random.hpp"
+
+#include <absl/types/span.h>  // for MakeSpan
+
+#include <algorithm>  // for all_of, count
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>    // for abs, sqrt
+#include <numeric>  // for accumulate
+#include <vector>   // for vector
+
+#include "modle/common/common.hpp"  // for u64, usize
+
+namespace modle::test::random {
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("BatchPRNG determinism", "[random][common][short]") {
+  using modle::random::BatchPRNG;
+  constexpr usize num_samples = 1001;  // Not a multiple of BatchPRNG::num_lanes
+
+  std::vector<u64> v1(num_samples);
+  std::vector<u64> v2(num_samples);
+
+  BatchPRNG rand_eng1(123456789);
+  BatchPRNG rand_eng2(123456789);
+  rand_eng1.fill(absl::MakeSpan(v1));
+  rand_eng2.fill(absl::MakeSpan(v2));
+  CHECK(v1 == v2);
+  CHECK(rand_eng1() == rand_eng2());
+
+  BatchPRNG rand_eng3(987654321);
+  rand_eng3.fill(absl::MakeSpan(v2));
+  CHECK(v1 != v2);
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("BatchPRNG ranges", "[random][common][short]") {
+  using modle::random::BatchPRNG;
+  constexpr usize num_samples = 10'003;
+  BatchPRNG rand_eng(42);
+
+  std::vector<double> canonical(num_samples);
+  rand_eng.fill_canonical(absl::MakeSpan(canonical));
+  CHECK(std::all_of(canonical.begin(), canonical.end(),
+                    [](const auto n) { return n >= 0.0 && n < 1.0; }));
+
+  constexpr u64 lb = 3;
+  constexpr u64 ub = 9;
+  std::vector<u64> ints(num_samples);
+  rand_eng.fill_uniform_int(absl::MakeSpan(ints), lb, ub);
+  CHECK(std::all_of(ints.begin(), ints.end(), [&](const auto n) { return n >= lb && n <= ub; }));
+  for (auto n = lb; n <= ub; ++n) {
+    CHECK(std::count(ints.begin(), ints.end(), n) != 0);
+  }
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("BatchPRNG normal", "[random][common][short]") {
+  using modle::random::BatchPRNG;
+  constexpr usize num_samples = 100'001;
+  constexpr double mean = 5.0;
+  constexpr double stddev = 2.0;
+  BatchPRNG rand_eng(42);
+
+  std::vector<double> v(num_samples);
+  rand_eng.fill_normal(absl::MakeSpan(v), mean, stddev);
+
+  const auto n = static_cast<double>(num_samples);
+  const auto avg = std::accumulate(v.begin(), v.end(), 0.0) / n;
+  const auto var = std::accumulate(v.begin(), v.end(), 0.0,
+                                   [&](const auto accumulator, const auto x) {
+                                     return accumulator + (x - avg) * (x - avg);
+                                   }) /
+                   (n - 1);
+
+  CHECK(std::abs(avg - mean) < 0.05);
+  CHECK(std::abs(std::sqrt(var) - stddev) < 0.05);
+}
+
+}  // namespace modle::test::random
@@ -24,6 +24,7 @@
 
 #include "./common.hpp"
 #include "modle/common/common.hpp"  // for u32
+#include "modle/common/pixel.hpp"   // for Pixel
 
 namespace modle::test::cmatrix {
 
@@ -132,6 +133,57 @@ TEST_CASE("CMatrix in/decrement", "[cmatrix][short]") {
   }
 }
 
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("CMatrix add pixels", "[cmatrix][short]") {
+  ContactMatrixDense<> m1(10, 20);
+  ContactMatrixDense<> m2(10, 20);
+
+  const std::vector<Pixel<contacts_t>> pixels{
+      {0, 0, 1}, {0, 5, 3}, {5, 0, 2}, {7, 12, 4}, {15, 15, 1}, {0, 15, 5}};
+
+  for (const auto& p : pixels) {
+    m1.add(p.row(), p.col(), p.count);
+  }
+  m2.add(absl::MakeConstSpan(pixels));
+
+  CHECK(m2.get(0, 0) == 1);
+  CHECK(m2.get(0, 5) == 5);
+  CHECK(m2.get(7, 12) == 4);
+  CHECK(m2.get_tot_contacts() == m1.get_tot_contacts());
+  CHECK(m2.get_n_of_missed_updates() == 5);
+
+  for (usize i = 0; i < m1.ncols(); ++i) {
+    for (usize j = i; j < m1.ncols(); ++j) {
+      CHECK(m1.get(i, j) == m2.get(i, j));
+    }
+  }
+}
+
+TEST_CASE("CMatrix size in bytes", "[cmatrix][short]") {
+  for (const auto& [nrows, ncols] : {std::make_pair(usize(10), usize(20)),
+                                     std::make_pair(usize(30), usize(20)),
+                                     std::make_pair(usize(100), usize(5000))}) {
+    const ContactMatrixDense<> m(nrows, ncols);
+    CHECK(ContactMatrixDense<>::compute_matrix_size_in_bytes(nrows, ncols) ==
+          m.get_matrix_size_in_bytes());
+  }
+}
+
+TEST_CASE("CMatrix add pixels out of band", "[cmatrix][short]") {
+  ContactMatrixDense<> m(10, 20);
+  m.add(0, 0, 1);
+  REQUIRE(m.get_tot_contacts() == 1);
+
+  // The out-of-band count matches the number of pixels, which should not prevent the in-band
+  // pixel from invalidating the global stats
+  const std::vector<Pixel<contacts_t>> pixels{{1, 1, 3}, {0, 15, 2}};
+  m.add(absl::MakeConstSpan(pixels));
+
+  CHECK(m.get(1, 1) == 3);
+  CHECK(m.get_tot_contacts() == 4);
+  CHECK(m.get_n_of_missed_updates() == 2);
+}
+
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 TEST_CASE("CMatrix get w/ block", "[cmatrix][short]") {
   ContactMatrixDense<u32> m1(100, 100);
@@ -192,6 +244,48 @@ TEST_CASE("CMatrix get w/ block small", "[cmatrix][short]") {
   }
 }
 
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("CMatrix get w/ block summed-area table", "[cmatrix][short]") {
+  for (const auto& [nrows, ncols] : {std::make_pair(usize(25), usize(100)),
+                                     std::make_pair(usize(8), usize(8)),
+                                     std::make_pair(usize(2), usize(50))}) {
+    ContactMatrixDense<u32> m(nrows, ncols);
+    create_random_matrix(m, m.npixels() / 3);
+
+    const auto sat = m.unsafe_compute_summed_area_table();
+    REQUIRE(sat.nrows() == m.nrows());
+    REQUIRE(sat.ncols() == m.ncols());
+
+    for (usize block_size = 1; block_size < nrows; block_size += 2) {
+      for (usize i = 0; i < ncols; ++i) {
+        for (usize j = 0; j < ncols; ++j) {
+          CHECK(sat.unsafe_get_block(i, j, block_size) == m.unsafe_get_block(i, j, block_size));
+        }
+      }
+    }
+  }
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("CMatrix slice", "[cmatrix][short]") {
+  ContactMatrixDense<u32> m(25, 100);
+  create_random_matrix(m, m.npixels() / 3);
+
+  for (const auto& [first_bin, last_bin] :
+       {std::make_pair(usize(0), usize(100)), std::make_pair(usize(0), usize(40)),
+        std::make_pair(usize(30), usize(100)), std::make_pair(usize(42), usize(52))}) {
+    const auto m1 = m.unsafe_slice(first_bin, last_bin);
+    REQUIRE(m1.ncols() == last_bin - first_bin);
+    REQUIRE(m1.nrows() == std::min(m.nrows(), m1.ncols()));
+    for (usize i = 0; i < m1.ncols(); ++i) {
+      for (usize j = i; j < m1.ncols(); ++j) {
+        const auto expected = j - i < m1.nrows() ? m.unsafe_get(first_bin + i, first_bin + j) : 0;
+        CHECK(m1.unsafe_get(i, j) == expected);
+      }
+    }
+  }
+}
+
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 TEST_CASE("CMatrix get column", "[cmatrix][short]") {
   ContactMatrixDense<> c(10, 100);
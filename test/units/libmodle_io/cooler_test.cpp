@@ -11,19 +11,24 @@
 #include <spdlog/sinks/null_sink.h>  // for null_sink_mt
 #include <spdlog/spdlog.h>           // for set_default_logger
 
-#include <algorithm>  // for max, max_element, transform
+#include <algorithm>  // for equal, max, max_element, transform
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_string.hpp>
 #include <exception>    // for exception
 #include <filesystem>   // for operator/, path
 #include <memory>       // for make_shared, allocator_traits<>::value_type
 #include <stdexcept>    // for runtime_error
+#include <string>       // for string
 #include <string_view>  // for string_view
+#include <tuple>        // for ignore, make_tuple
+#include <vector>       // for vector
 
 #include "modle/common/common.hpp"                // for u64, u32, usize, i64, u8
 #include "modle/common/utils.hpp"                 // for parse_numeric_or_throw
 #include "modle/compressed_io/compressed_io.hpp"  // for Reader
 #include "modle/contact_matrix_dense.hpp"         // for ContactMatrixDense
+#include "modle/cooler/scool.hpp"                 // for SCoolWriter
+#include "modle/hdf5/hdf5.hpp"                    // for open_dataset, read_numbers
 #include "modle/test/self_deleting_folder.hpp"    // for SelfDeletingFolder
 
 namespace modle::test {
@@ -128,6 +133,62 @@ TEST_CASE("CMatrix to cooler - multiple chromosomes", "[io][cooler][short]") {
   std::filesystem::remove(output_file);
 }
 
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("CMatrix to cooler - multiple threads", "[io][cooler][short]") {
+  const auto output_file1 = testdir() / "cmatrix_to_cooler_st.cool";
+  const auto output_file2 = testdir() / "cmatrix_to_cooler_mt.cool";
+  const auto output_file3 = testdir() / "cmatrix_to_cooler_mt_small_chunks.cool";
+  std::filesystem::create_directories(testdir());
+  spdlog::set_default_logger(
+      std::make_shared<spdlog::logger>("main_logger", std::make_shared<default_sink_t>()));
+
+  constexpr std::string_view chrom1 = "chr1";
+  constexpr std::string_view chrom2 = "chr2";
+  const u64 start = 0;
+  const u64 end = 50'000'000;
+  const u64 bin_size = 1'000;
+  const u64 nrows = 100;
+  const u64 ncols = (end + bin_size - 1) / bin_size;
+
+  // The matrix is large enough to be split in several stripes of columns
+  ContactMatrixDense<> cmatrix1(nrows, ncols);
+  for (usize i = 0; i < ncols; ++i) {
+    for (auto j = i; j < i + nrows && j < ncols; ++j) {
+      if ((i * 31 + j * 17) % 5 != 0) {
+        cmatrix1.unsafe_set(i, j, static_cast<contacts_t>((i + j) % 97));
+      }
+    }
+  }
+
+  // With multiple threads, pixels are compressed one chunk at a time. Using small chunks makes sure
+  // that many chunks are written, and that the last chunk of chr1 is completed when writing chr2
+  constexpr usize small_chunk_size = 10'000;
+  for (const auto& [output_file, nthreads, chunk_size] :
+       {std::make_tuple(output_file1, usize(1), Cooler::DEFAULT_HDF5_CHUNK_SIZE),
+        std::make_tuple(output_file2, usize(4), Cooler::DEFAULT_HDF5_CHUNK_SIZE),
+        std::make_tuple(output_file3, usize(4), small_chunk_size)}) {
+    auto c = Cooler(output_file, Cooler::IO_MODE::WRITE_ONLY, bin_size, chrom1.size(), "",
+                    Cooler::FLAVOR::COOL, true, Cooler::DEFAULT_COMPRESSION_LEVEL, chunk_size);
+    c.write_or_append_cmatrix_to_file(cmatrix1, chrom1, start, end, end, nthreads);
+    c.write_or_append_cmatrix_to_file(cmatrix1, chrom2, start, end, end, nthreads);
+  }
+
+  const auto v1 = cmatrix1.get_raw_count_vector();
+  for (const auto& chrom : {chrom1, chrom2}) {
+    for (const auto& output_file : {output_file1, output_file2, output_file3}) {
+      const auto cmatrix2 =
+          Cooler(output_file, Cooler::IO_MODE::READ_ONLY).cooler_to_cmatrix(chrom, nrows);
+      const auto v2 = cmatrix2.get_raw_count_vector();
+      REQUIRE(v1.size() == v2.size());
+      CHECK(std::equal(v1.begin(), v1.end(), v2.begin()));
+    }
+  }
+
+  std::filesystem::remove(output_file1);
+  std::filesystem::remove(output_file2);
+  std::filesystem::remove(output_file3);
+}
+
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 TEST_CASE("Cooler to CMatrix", "[io][cooler][short]") {
   const auto test_file = data_dir / "Dixon2012-H1hESC-HindIII-allreps-filtered.1000kb.cool";
@@ -355,4 +416,105 @@ TEST_CASE("Cooler to CMatrix subrange", "[io][cooler][short]") {
   }
 }
 
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("CMatrix to scool", "[io][cooler][short]") {
+  const auto output_file = testdir() / "cmatrix_to_scool.scool";
+  std::filesystem::create_directories(testdir());
+
+  const std::vector<std::pair<std::string, usize>> chroms{{"chr1", 1000}, {"chr2", 550}};
+  const usize bin_size = 100;
+  const usize nbins = 16;
+
+  ContactMatrixDense<> cmatrix(3, 4);
+  cmatrix.unsafe_set(0, 0, 1);
+  cmatrix.unsafe_set(0, 2, 2);
+  cmatrix.unsafe_set(1, 2, 3);
+  cmatrix.unsafe_set(3, 3, 4);
+
+  {
+    SCoolWriter<> w(output_file, chroms, bin_size);
+    auto cell1 = w.make_cell("cell1", cmatrix, "chr2", 200);
+    auto cell2 = w.make_cell("cell2", ContactMatrixDense<>(3, 4), "chr1", 0);
+    CHECK(cell1.nnz() == 4);
+    CHECK(cell1.sum == 10);
+    CHECK(cell2.nnz() == 0);
+    w.append_cell(cell1);
+    w.append_cell(cell2);
+    CHECK(w.get_ncells() == 2);
+    CHECK_THROWS(w.append_cell(cell1));
+  }
+
+  H5::H5File f(output_file.string(), H5F_ACC_RDONLY);
+  CHECK(hdf5::read_attribute_str(f, "format") == "HDF5::SCOOL");
+  CHECK(hdf5::read_attribute_int(f, "ncells") == 2);
+  CHECK(hdf5::read_attribute_int(f, "nbins") == nbins);
+  CHECK(hdf5::read_attribute_int(f, "nnz", "/cells/cell1") == 4);
+  CHECK(hdf5::has_group(f, "/cells/cell1/bins"));
+  CHECK(hdf5::has_group(f, "/cells/cell2/chroms"));
+
+  auto read_dataset = [&](const std::string& name) {
+    const auto d = hdf5::open_dataset(f, name, H5::DSetAccPropList::DEFAULT);
+    std::vector<i64> buff(static_cast<usize>(d.getSpace().getSimpleExtentNpoints()));
+    if (!buff.empty()) {
+      std::ignore = hdf5::read_numbers(d, buff, 0);
+    }
+    return buff;
+  };
+
+  CHECK(read_dataset("/cells/cell1/pixels/bin1_id") == std::vector<i64>{12, 12, 13, 15});
+  CHECK(read_dataset("/cells/cell1/pixels/bin2_id") == std::vector<i64>{12, 14, 14, 15});
+  CHECK(read_dataset("/cells/cell1/pixels/count") == std::vector<i64>{1, 2, 3, 4});
+  CHECK(read_dataset("/cells/cell1/indexes/chrom_offset") == std::vector<i64>{0, 10, 16});
+
+  // Bins 12-15 map to the matrix columns. Bins without pixels point to the next non-empty bin
+  auto expected_bin1_offsets = std::vector<i64>(nbins - 3, 0);
+  expected_bin1_offsets.insert(expected_bin1_offsets.end(), {2, 3, 3, 4});
+  CHECK(read_dataset("/cells/cell1/indexes/bin1_offset") == expected_bin1_offsets);
+
+  CHECK(read_dataset("/cells/cell2/pixels/bin1_id").empty());
+  CHECK(read_dataset("/cells/cell2/indexes/bin1_offset") == std::vector<i64>(nbins + 1, 0));
+  CHECK(read_dataset("/bins/start").size() == nbins);
+  CHECK(read_dataset("/bins/end").back() == 550);
+}
+
+TEST_CASE("CMatrix to scool - multiple chunks", "[io][cooler][short]") {
+  const auto output_file = testdir() / "cmatrix_to_scool_chunks.scool";
+  std::filesystem::create_directories(testdir());
+
+  const std::vector<std::pair<std::string, usize>> chroms{{"chr1", 1000}};
+  const usize bin_size = 100;
+  const usize chunk_size = 3;
+
+  // 7 pixels: two full chunks followed by a partial chunk
+  ContactMatrixDense<> cmatrix(2, 10);
+  std::vector<i64> expected_bin1_ids{};
+  std::vector<i64> expected_counts{};
+  for (usize i = 0; i < 7; ++i) {
+    cmatrix.unsafe_set(i, i, static_cast<contacts_t>(i + 1));
+    expected_bin1_ids.push_back(static_cast<i64>(i));
+    expected_counts.push_back(static_cast<i64>(i + 1));
+  }
+
+  {
+    SCoolWriter<> w(output_file, chroms, bin_size, 6, chunk_size);
+    auto cell = w.make_cell("cell", cmatrix, "chr1", 0);
+    CHECK(cell.nnz() == 7);
+    CHECK(cell.bin1_id_chunks.size() == 3);
+    CHECK(cell.count_chunks.size() == 3);
+    w.append_cell(cell);
+  }
+
+  H5::H5File f(output_file.string(), H5F_ACC_RDONLY);
+  auto read_dataset = [&](const std::string& name) {
+    const auto d = hdf5::open_dataset(f, name, H5::DSetAccPropList::DEFAULT);
+    std::vector<i64> buff(static_cast<usize>(d.getSpace().getSimpleExtentNpoints()));
+    std::ignore = hdf5::read_numbers(d, buff, 0);
+    return buff;
+  };
+
+  CHECK(read_dataset("/cells/cell/pixels/bin1_id") == expected_bin1_ids);
+  CHECK(read_dataset("/cells/cell/pixels/bin2_id") == expected_bin1_ids);
+  CHECK(read_dataset("/cells/cell/pixels/count") == expected_counts);
+}
+
 }  // namespace modle::test::cooler
@@ -0,0 +1,138 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+#include "modle/burnin_tracker.hpp"  // for BurninTracker
+
+#include <algorithm>  // for min
+#include <catch2/catch_test_macros.hpp>
+#include <deque>    // for deque
+#include <utility>  // for make_pair
+
+#include "modle/common/common.hpp"      // for usize, isize
+#include "modle/common/random.hpp"      // for PRNG, uniform_real_distribution
+#include "modle/stats/descriptive.hpp"  // for mean
+
+namespace modle::test::libmodle {
+
+// Reference implementation (i.e. Simulation::evaluate_burnin from previous releases): smooth the
+// full history and count the number of times the moving average decreases
+[[nodiscard]] static bool moving_average_is_stable(const std::deque<double>& history,
+                                                   const usize capacity, const usize window_size) {
+  if (history.size() != capacity || window_size >= capacity) {
+    return false;
+  }
+  usize n = 0;
+  for (auto it1 = history.begin() + 1, it2 = history.begin() + static_cast<isize>(window_size + 1);
+       it2 != history.end(); ++it1, ++it2) {
+    n += static_cast<usize>(stats::mean(it1 - 1, it2 - 1) > stats::mean(it1, it2));
+  }
+  const auto r = static_cast<double>(n) / static_cast<double>(capacity - window_size - n);
+  return r >= 0.95 && r <= 1.05;
+}
+
+TEST_CASE("Burn-in tracker - basic", "[burnin][simulation][short]") {
+  BurninTracker tracker(4, 1);
+  CHECK(tracker.empty());
+  CHECK(tracker.capacity() == 4);
+  CHECK(tracker.window_size() == 1);
+
+  for (usize i = 0; i < 10; ++i) {
+    tracker.push_back(static_cast<double>(i), 1.0);
+    CHECK(tracker.size() == std::min(i + 1, usize(4)));
+  }
+  CHECK(tracker.full());
+  // Monotonically increasing values never reach a stable state
+  CHECK_FALSE(tracker.is_stable());
+
+  tracker.clear();
+  CHECK(tracker.empty());
+  CHECK_FALSE(tracker.is_stable());
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("Burn-in tracker - compare with moving average", "[burnin][simulation][short]") {
+  auto rand_eng = random::PRNG(7316571232591ULL);
+  BurninTracker tracker{};
+
+  for (const auto& [capacity, window_size] : {std::make_pair(usize(100), usize(5)),
+                                              std::make_pair(usize(41), usize(1)),
+                                              std::make_pair(usize(25), usize(5)),
+                                              std::make_pair(usize(10), usize(9)),
+                                              std::make_pair(usize(10), usize(10))}) {
+    tracker.reset(capacity, window_size);
+    std::deque<double> avg_loop_sizes{};
+    std::deque<double> cfx_of_variations{};
+
+    usize num_stable = 0;
+    for (usize i = 0; i < 50 * capacity; ++i) {
+      // Values start trending upward, and then flatten out
+      const auto trend = static_cast<double>(std::min(i, 10 * capacity));
+      const auto avg_loop_size = trend + random::uniform_real_distribution<double>{0, 10}(rand_eng);
+      const auto cfx_of_variation = random::uniform_real_distribution<double>{0, 1}(rand_eng);
+
+      tracker.push_back(avg_loop_size, cfx_of_variation);
+      if (avg_loop_sizes.size() == capacity) {
+        avg_loop_sizes.pop_front();
+        cfx_of_variations.pop_front();
+      }
+      avg_loop_sizes.push_back(avg_loop_size);
+      cfx_of_variations.push_back(cfx_of_variation);
+
+      const auto expected = moving_average_is_stable(cfx_of_variations, capacity, window_size) &&
+                            moving_average_is_stable(avg_loop_sizes, capacity, window_size);
+      CHECK(tracker.is_stable() == expected);
+      num_stable += static_cast<usize>(expected);
+    }
+    if (window_size + 1 < capacity) {
+      CHECK(num_stable != 0);
+    }
+  }
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("Burn-in tracker - near-flat history", "[burnin][simulation][short]") {
+  // Values are multiples of 0.1 (which are not exactly representable), so that some pairs of
+  // windows have averages that are only equal up to rounding errors. Burn-in must end at the same
+  // epoch as with the reference implementation
+  auto rand_eng = random::PRNG(2806316913442467571ULL);
+  BurninTracker tracker{};
+
+  for (const auto& [capacity, window_size] : {std::make_pair(usize(100), usize(5)),
+                                              std::make_pair(usize(41), usize(3)),
+                                              std::make_pair(usize(26), usize(10))}) {
+    tracker.reset(capacity, window_size);
+    std::deque<double> avg_loop_sizes{};
+    std::deque<double> cfx_of_variations{};
+
+    usize epoch = 0;
+    usize expected_epoch = 0;
+    for (usize i = 0; i < 200 * capacity; ++i) {
+      auto dist = random::uniform_int_distribution<u32>{0, 49};
+      const auto avg_loop_size = 100'000.0 + 0.1 * static_cast<double>(dist(rand_eng));
+      const auto cfx_of_variation = 0.1 * static_cast<double>(dist(rand_eng));
+
+      tracker.push_back(avg_loop_size, cfx_of_variation);
+      if (avg_loop_sizes.size() == capacity) {
+        avg_loop_sizes.pop_front();
+        cfx_of_variations.pop_front();
+      }
+      avg_loop_sizes.push_back(avg_loop_size);
+      cfx_of_variations.push_back(cfx_of_variation);
+
+      const auto expected = moving_average_is_stable(cfx_of_variations, capacity, window_size) &&
+                            moving_average_is_stable(avg_loop_sizes, capacity, window_size);
+      CHECK(tracker.is_stable() == expected);
+      if (epoch == 0 && tracker.is_stable()) {
+        epoch = i + 1;
+      }
+      if (expected_epoch == 0 && expected) {
+        expected_epoch = i + 1;
+      }
+    }
+    CHECK(expected_epoch != 0);
+    CHECK(epoch == expected_epoch);
+  }
+}
+
+}  // namespace modle::test::libmodle
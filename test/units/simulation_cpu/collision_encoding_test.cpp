@@ -17,9 +17,9 @@ namespace modle::test::libmodle {
 
 [[maybe_unused]] constexpr usize EVENT_BITS = 5;
 [[maybe_unused]] constexpr usize RESERVED_EVENT_BITS = 8;
-[[maybe_unused]] constexpr usize INDEX_BITS = (sizeof(u32f) * 8) - RESERVED_EVENT_BITS;
-[[maybe_unused]] constexpr u32f EVENT_MASK = (~u32f(0)) << (INDEX_BITS - 1);
-[[maybe_unused]] constexpr u32f INDEX_MASK = ~EVENT_MASK;
+[[maybe_unused]] constexpr usize INDEX_BITS = (sizeof(u32) * 8) - RESERVED_EVENT_BITS;
+[[maybe_unused]] constexpr u32 EVENT_MASK = (~u32(0)) << (INDEX_BITS - 1);
+[[maybe_unused]] constexpr u32 INDEX_MASK = ~EVENT_MASK;
 
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 TEST_CASE("Collision encoding", "[simulation][short]") {
@@ -69,6 +69,10 @@ TEST_CASE("Collision encoding", "[simulation][short]") {
     CHECK_THROWS_WITH(
         (Collision<>{idx, event}.collision_avoided()),
         Catch::Matchers::EndsWith("idx must be 0 when no collision has occurred/been avoided"));
+
+    event = Collision<>::COLLISION | Collision<>::LEF_BAR;
+    CHECK_THROWS_WITH((Collision<>{Collision<>::max_index() + 1, event}.collision_occurred()),
+                      Catch::Matchers::EndsWith("invalid collision index"));
   }
 
   Collision<> collision{};
@@ -84,6 +88,7 @@ TEST_CASE("Collision encoding", "[simulation][short]") {
   CHECK(collision.decode_index() == idx);
 
   idx = INDEX_MASK;
+  CHECK(Collision<>::max_index() == idx);
   collision.set(idx, Collision<>::COLLISION | Collision<>::LEF_LEF_SECONDARY);
   CHECK(collision.collision_occurred(Collision<>::LEF_LEF_SECONDARY));
   CHECK(collision.decode_index() == idx);
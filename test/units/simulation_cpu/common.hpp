@@ -10,9 +10,13 @@
 #include <algorithm>
 #include <catch2/catch_test_macros.hpp>
 #include <cstddef>
+#include <random>
 #include <vector>
 
 #include "modle/common/common.hpp"
+#include "modle/common/simulation_config.hpp"
+#include "modle/contact_matrix_dense.hpp"
+#include "modle/extrusion_barriers.hpp"
 #include "modle/extrusion_factors.hpp"
 #include "modle/simulation.hpp"
 
@@ -20,7 +24,9 @@ namespace modle::test::libmodle {
 
 inline constexpr auto DEFAULT_PRNG{random::PRNG(10556020843759504871ULL)};
 
-using CollisionT = Collision<u32f>;
+using CollisionT = Collision<u32>;
+using lef_idx_t = Simulation::lef_idx_t;
+using lef_move_t = Simulation::lef_move_t;
 constexpr auto NO_COLLISION = CollisionT::NO_COLLISION;
 constexpr auto COLLISION = CollisionT::COLLISION;
 constexpr auto CHROM_BOUNDARY = COLLISION | CollisionT::CHROM_BOUNDARY;
@@ -36,13 +42,13 @@ template <class I>
              ExtrusionUnit{static_cast<bp_t>(p2)}};
 }
 
-template <class BPCollection, class CollisionCollection>
+template <class MoveCollection, class CollisionCollection>
 [[maybe_unused]] inline void print_debug_info(
-    usize i, const BPCollection& rev_moves, const BPCollection& fwd_moves,
-    const BPCollection& rev_moves_expected, const BPCollection& fwd_moves_expected,
+    usize i, const MoveCollection& rev_moves, const MoveCollection& fwd_moves,
+    const MoveCollection& rev_moves_expected, const MoveCollection& fwd_moves_expected,
     const CollisionCollection& rev_collisions, const CollisionCollection& rev_collisions_expected,
     const CollisionCollection& fwd_collisions, const CollisionCollection& fwd_collisions_expected) {
-  static_assert(std::is_same_v<typename BPCollection::value_type, bp_t>);
+  static_assert(std::is_same_v<typename MoveCollection::value_type, lef_move_t>);
   fmt::print(stderr, FMT_STRING("i={}; rev_move={}/{}; fwd_move={}/{};\n"), i, rev_moves[i],
              rev_moves_expected[i], fwd_moves[i], fwd_moves_expected[i]);
   fmt::print(
@@ -62,15 +68,15 @@ template <class CollisionCollection>
              fwd_collisions_expected[i]);
 }
 
-template <class LefCollection, class BPCollection, class CollisionCollection>
+template <class LefCollection, class MoveCollection, class CollisionCollection>
 [[maybe_unused]] inline void check_simulation_result(
-    const LefCollection& lefs, const BPCollection& rev_moves, const BPCollection& fwd_moves,
-    const BPCollection& rev_moves_expected, const BPCollection& fwd_moves_expected,
+    const LefCollection& lefs, const MoveCollection& rev_moves, const MoveCollection& fwd_moves,
+    const MoveCollection& rev_moves_expected, const MoveCollection& fwd_moves_expected,
     const CollisionCollection& rev_collisions, const CollisionCollection& rev_collisions_expected,
     const CollisionCollection& fwd_collisions, const CollisionCollection& fwd_collisions_expected,
     bool print_debug_info_ = false) {
   static_assert(std::is_same_v<typename LefCollection::value_type, Lef>);
-  static_assert(std::is_same_v<typename BPCollection::value_type, bp_t>);
+  static_assert(std::is_same_v<typename MoveCollection::value_type, lef_move_t>);
   for (usize i = 0; i < lefs.size(); ++i) {
     CHECK(rev_collisions[i] == rev_collisions_expected[i]);
     CHECK(fwd_collisions[i] == fwd_collisions_expected[i]);
@@ -104,12 +110,12 @@ template <class LefCollection, class CollisionCollection>
   }
 }
 
-template <class LefCollection, class UsizeCollection>
+template <class LefCollection, class RankCollection>
 inline void check_that_lefs_are_sorted_by_idx(const LefCollection& lefs,
-                                              const UsizeCollection& rev_ranks,
-                                              const UsizeCollection& fwd_ranks) {
+                                              const RankCollection& rev_ranks,
+                                              const RankCollection& fwd_ranks) {
   static_assert(std::is_same_v<typename LefCollection::value_type, Lef>);
-  static_assert(std::is_same_v<typename UsizeCollection::value_type, usize>);
+  static_assert(std::is_same_v<typename RankCollection::value_type, lef_idx_t>);
   CHECK(std::is_sorted(fwd_ranks.begin(), fwd_ranks.end(), [&](const auto r1, const auto r2) {
     return lefs[r1].fwd_unit.pos() < lefs[r2].fwd_unit.pos();
   }));
@@ -118,12 +124,12 @@ inline void check_that_lefs_are_sorted_by_idx(const LefCollection& lefs,
   }));
 }
 
-template <class LefCollection, class UsizeCollection>
+template <class LefCollection, class RankCollection>
 inline void require_that_lefs_are_sorted_by_idx(const LefCollection& lefs,
-                                                const UsizeCollection& rev_ranks,
-                                                const UsizeCollection& fwd_ranks) {
+                                                const RankCollection& rev_ranks,
+                                                const RankCollection& fwd_ranks) {
   static_assert(std::is_same_v<typename LefCollection::value_type, Lef>);
-  static_assert(std::is_same_v<typename UsizeCollection::value_type, usize>);
+  static_assert(std::is_same_v<typename RankCollection::value_type, lef_idx_t>);
   REQUIRE(std::is_sorted(fwd_ranks.begin(), fwd_ranks.end(), [&](const auto r1, const auto r2) {
     return lefs[r1].fwd_unit.pos() < lefs[r2].fwd_unit.pos();
   }));
@@ -156,6 +162,42 @@ inline void require_that_lefs_are_sorted_by_idx(const LefCollection& lefs,
   return {0, name, chrom_start, chrom_end, chrom_size};
 }
 
+// Config used by tests simulating whole windows: LEFs are released at the rate required to keep
+// the number of bound LEFs stable
+[[nodiscard]] inline modle::Config init_window_config(bool fast_sampling) {
+  modle::Config c{};
+  c.seed = 123456789;  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+  c.diagonal_width = 1'000'000;
+  c.prob_of_lef_release = static_cast<double>(c.rev_extrusion_speed + c.fwd_extrusion_speed) /
+                          static_cast<double>(c.avg_lef_processivity);
+  c.prob_of_lef_release_burnin = c.prob_of_lef_release;
+  c.fast_sampling = fast_sampling;
+  c.nthreads = 1;
+  return c;
+}
+
+[[nodiscard]] inline std::vector<ExtrusionBarrier> generate_barriers(bp_t chrom_size,
+                                                                     usize num_barriers) {
+  std::mt19937_64 rand_eng{42};  // NOLINT(cert-msc32-c,cert-msc51-cpp)
+  std::vector<ExtrusionBarrier> barriers;
+  for (usize i = 0; i < num_barriers; ++i) {
+    const auto pos = static_cast<bp_t>(rand_eng() % chrom_size);
+    barriers.emplace_back(pos, 0.9, 0.7, (rand_eng() & 1U) != 0 ? '+' : '-');
+  }
+  std::sort(barriers.begin(), barriers.end());
+  return barriers;
+}
+
+[[nodiscard]] inline bool same_contacts(const ContactMatrixDense<contacts_t>& m1,
+                                        const ContactMatrixDense<contacts_t>& m2) {
+  if (m1.ncols() != m2.ncols() || m1.nrows() != m2.nrows()) {
+    return false;
+  }
+  const auto v1 = m1.get_raw_count_vector();
+  const auto v2 = m2.get_raw_count_vector();
+  return std::equal(v1.begin(), v1.end(), v2.begin(), v2.end());
+}
+
 // This function is here as a compatibility layer between the old and new way to construct extrusion
 // barriers, and should be removed at some point in the future.
 template <ExtrusionBarriers::State state = ExtrusionBarriers::State::ACTIVE, class... Args>
@@ -0,0 +1,112 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+#include <absl/strings/str_split.h>  // for StrSplit
+
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>  // for path, operator/
+#include <fstream>     // for ifstream, ofstream
+#include <string>      // for string, getline
+#include <vector>      // for vector
+
+#include "modle/common/common.hpp"              // for usize
+#include "modle/common/simulation_config.hpp"   // for Config
+#include "modle/profiler.hpp"                   // for ProfileCounters
+#include "modle/simulation.hpp"                 // for Simulation
+#include "modle/test/self_deleting_folder.hpp"  // for SelfDeletingFolder
+
+namespace modle::test {
+inline const SelfDeletingFolder testdir{true};  // NOLINT(cert-err58-cpp)
+}  // namespace modle::test
+
+namespace modle::test::libmodle {
+
+[[nodiscard]] static std::vector<std::vector<std::string>> read_tsv(
+    const std::filesystem::path& path) {
+  std::ifstream fp(path);
+  std::vector<std::vector<std::string>> records{};
+  std::string line{};
+  while (std::getline(fp, line)) {
+    records.emplace_back(absl::StrSplit(line, '\t'));
+  }
+  return records;
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("Profile report sections", "[simulation][short]") {
+  const auto path_to_chrom_sizes = testdir() / "profile_report.chrom.sizes";
+  const auto path_to_extr_barriers = testdir() / "profile_report_barriers.bed";
+  {
+    std::ofstream fp(path_to_chrom_sizes);
+    fp << "chr1\t5000000\nchr2\t4000000\n";
+  }
+  {
+    std::ofstream fp(path_to_extr_barriers);
+    fp << "chr1\t100000\t100001\tbarrier\t0\t+\nchr2\t200000\t200001\tbarrier\t0\t-\n";
+  }
+
+  Config c{};
+  c.path_to_chrom_sizes = path_to_chrom_sizes;
+  c.path_to_extr_barriers = path_to_extr_barriers;
+  c.path_to_profile_report = testdir() / "profile_report.tsv";
+  c.write_profile_report = true;
+  c.nthreads = 2;
+  Simulation sim(c);
+
+  // One entry for each simulation thread plus one for the thread writing contacts to disk
+  std::vector<ProfileCounters> thread_profiles(c.nthreads + 1);
+  thread_profiles[0].cells = 3;
+  thread_profiles[1].cells = 5;
+  thread_profiles[2].hdf5_write_ns = 1'000'000'000;
+
+  std::vector<ProfileCounters> chrom_profiles(2);
+  chrom_profiles[0].cells = 4;
+  chrom_profiles[0].epochs = 100;
+  chrom_profiles[1].cells = 4;
+  chrom_profiles[1].epochs = 50;
+  chrom_profiles[1].hdf5_write_ns = 1'000'000'000;
+
+  sim.test_write_profile_report(thread_profiles, chrom_profiles);
+  const auto records = read_tsv(c.path_to_profile_report);
+
+  // Header + 3 thread records + 2 chromosome records + 1 total record
+  REQUIRE(records.size() == 7);
+  const std::vector<std::string> header_fields =
+      absl::StrSplit(ProfileCounters::tsv_header, '\t');
+  REQUIRE(records.front().size() == header_fields.size() + 2);
+  CHECK(records.front()[0] == "scope");
+  CHECK(records.front()[1] == "name");
+  for (usize i = 0; i < header_fields.size(); ++i) {
+    CHECK(records.front()[i + 2] == header_fields[i]);
+  }
+  for (const auto& record : records) {
+    CHECK(record.size() == records.front().size());
+  }
+
+  CHECK(records[1][0] == "thread");
+  CHECK(records[1][1] == "0");
+  CHECK(records[1][2] == "3");
+  CHECK(records[2][0] == "thread");
+  CHECK(records[2][1] == "1");
+  CHECK(records[2][2] == "5");
+  CHECK(records[3][0] == "thread");
+  CHECK(records[3][1] == "writer");
+  CHECK(records[3].back() == "1.000000");
+
+  CHECK(records[4][0] == "chrom");
+  CHECK(records[4][1] == "chr1");
+  CHECK(records[4][3] == "100");
+  CHECK(records[5][0] == "chrom");
+  CHECK(records[5][1] == "chr2");
+  CHECK(records[5][3] == "50");
+
+  // Totals are computed by summing counters across chromosomes
+  CHECK(records[6][0] == "total");
+  CHECK(records[6][1] == "-");
+  CHECK(records[6][2] == "8");
+  CHECK(records[6][3] == "150");
+  CHECK(records[6].back() == "1.000000");
+}
+
+}  // namespace modle::test::libmodle
@@ -4,6 +4,7 @@
 
 #include <absl/types/span.h>  // for MakeSpan
 
+#include <algorithm>                                // for sort, equal
 #include <boost/dynamic_bitset/dynamic_bitset.hpp>  // for dynamic_bitset
 #include <cassert>                                  // for assert
 #include <catch2/catch_test_macros.hpp>
@@ -49,11 +50,11 @@ TEST_CASE("Simulation 001", "[simulation][short]") {
   // clang-format on
   REQUIRE(barriers.size() == nbarriers);
 
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2, 3, 4, 5, 6};
-  const std::array<usize, nlefs> fwd_ranks{0, 1, 2, 3, 4, 6, 5};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2, 3, 4, 5, 6};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{0, 1, 2, 3, 4, 6, 5};
 
-  std::array<bp_t, nlefs> rev_moves{25, 75, 75, 75, 75, 75, 75};
-  std::array<bp_t, nlefs> fwd_moves{75, 75, 75, 75, 75, 75, 75};
+  std::array<lef_move_t, nlefs> rev_moves{25, 75, 75, 75, 75, 75, 75};
+  std::array<lef_move_t, nlefs> fwd_moves{75, 75, 75, 75, 75, 75, 75};
 
   // clang-format off
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{5, CHROM_BOUNDARY},
@@ -73,8 +74,8 @@ TEST_CASE("Simulation 001", "[simulation][short]") {
   std::array<CollisionT, nlefs> rev_collisions;
   std::array<CollisionT, nlefs> fwd_collisions;
 
-  const std::array<bp_t, nlefs> rev_moves_expected{25, 44, 25, 54, 25, 75, 75};
-  const std::array<bp_t, nlefs> fwd_moves_expected{69, 24, 48,  0, 75, 75, 75};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{25, 44, 25, 54, 25, 75, 75};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{69, 24, 48,  0, 75, 75, 75};
   // clang-format on
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
@@ -119,11 +120,11 @@ TEST_CASE("Simulation 002", "[simulation][short]") {
   // clang-format on
   REQUIRE(barriers.size() == nbarriers);
 
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2, 3, 4, 5, 6};
-  const std::array<usize, nlefs> fwd_ranks{1, 0, 2, 3, 4, 5, 6};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2, 3, 4, 5, 6};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{1, 0, 2, 3, 4, 5, 6};
 
-  std::array<bp_t, nlefs> rev_moves{75, 75, 75, 75, 75, 75, 75};
-  std::array<bp_t, nlefs> fwd_moves{75, 75, 75, 75, 75, 75, 24};
+  std::array<lef_move_t, nlefs> rev_moves{75, 75, 75, 75, 75, 75, 75};
+  std::array<lef_move_t, nlefs> fwd_moves{75, 75, 75, 75, 75, 75, 24};
 
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{},
                                                               CollisionT{},
@@ -143,8 +144,8 @@ TEST_CASE("Simulation 002", "[simulation][short]") {
   std::array<CollisionT, nlefs> fwd_collisions;
 
   // clang-format off
-  const std::array<bp_t, nlefs> rev_moves_expected{75, 75, 75,  0, 48, 25, 69};
-  const std::array<bp_t, nlefs> fwd_moves_expected{75, 75, 25, 53, 24, 44, 24};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{75, 75, 75,  0, 48, 25, 69};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{75, 75, 25, 53, 24, 44, 24};
   // clang-format on
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
@@ -191,11 +192,11 @@ TEST_CASE("Simulation 003 - Soft collisions on", "[simulation][short]") {
   // clang-format on
   REQUIRE(barriers.size() == nbarriers);
 
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2, 3, 4, 5, 6};
-  const std::array<usize, nlefs> fwd_ranks{1, 0, 2, 3, 4, 5, 6};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2, 3, 4, 5, 6};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{1, 0, 2, 3, 4, 5, 6};
 
-  std::array<bp_t, nlefs> rev_moves{75, 75, 75, 75, 75, 75, 75};
-  std::array<bp_t, nlefs> fwd_moves{75, 75, 75, 75, 75, 75, 24};
+  std::array<lef_move_t, nlefs> rev_moves{75, 75, 75, 75, 75, 75, 75};
+  std::array<lef_move_t, nlefs> fwd_moves{75, 75, 75, 75, 75, 75, 24};
 
   // clang-format off
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{0, LEF_BAR},
@@ -215,8 +216,8 @@ TEST_CASE("Simulation 003 - Soft collisions on", "[simulation][short]") {
   std::array<CollisionT, nlefs> rev_collisions;
   std::array<CollisionT, nlefs> fwd_collisions;
 
-  const std::array<bp_t, nlefs> rev_moves_expected{49, 75, 75,  0, 48, 25, 69};
-  const std::array<bp_t, nlefs> fwd_moves_expected{24, 48, 24, 53, 24, 44, 24};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{49, 75, 75,  0, 48, 25, 69};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{24, 48, 24, 53, 24, 44, 24};
   // clang-format on
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
@@ -262,11 +263,11 @@ TEST_CASE("Simulation 004 - Inactive barriers", "[simulation][short]") {
   // clang-format on
   REQUIRE(barriers.size() == nbarriers);
 
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2, 3, 4, 5, 6};
-  const std::array<usize, nlefs> fwd_ranks{1, 0, 2, 3, 4, 5, 6};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2, 3, 4, 5, 6};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{1, 0, 2, 3, 4, 5, 6};
 
-  std::array<bp_t, nlefs> rev_moves{75, 75, 75, 75, 75, 75, 75};
-  std::array<bp_t, nlefs> fwd_moves{75, 75, 75, 75, 75, 75, 24};
+  std::array<lef_move_t, nlefs> rev_moves{75, 75, 75, 75, 75, 75, 75};
+  std::array<lef_move_t, nlefs> fwd_moves{75, 75, 75, 75, 75, 75, 24};
 
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{},
                                                               CollisionT{},
@@ -285,8 +286,8 @@ TEST_CASE("Simulation 004 - Inactive barriers", "[simulation][short]") {
   std::array<CollisionT, nlefs> rev_collisions;
   std::array<CollisionT, nlefs> fwd_collisions;
 
-  const std::array<bp_t, nlefs> rev_moves_expected{75, 75, 75, 13, 61, 25, 60};
-  const std::array<bp_t, nlefs> fwd_moves_expected{75, 75, 12, 53, 24, 59, 24};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{75, 75, 75, 13, 61, 25, 60};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{75, 75, 12, 53, 24, 59, 24};
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
 
@@ -324,11 +325,11 @@ TEST_CASE("Simulation 005 - Multiple LEFs located at the same site", "[simulatio
   const auto barriers = construct_barriers(ExtrusionBarrier{100, 1.0, 0.0, '-'});
   REQUIRE(barriers.size() == nbarriers);
 
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2, 3, 4, 5};
-  const std::array<usize, nlefs> fwd_ranks{0, 1, 2, 3, 4, 5};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2, 3, 4, 5};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{0, 1, 2, 3, 4, 5};
 
-  std::array<bp_t, nlefs> rev_moves{25, 25, 25, 25, 25, 25};
-  std::array<bp_t, nlefs> fwd_moves{25, 25, 25, 24,  8,  9};
+  std::array<lef_move_t, nlefs> rev_moves{25, 25, 25, 25, 25, 25};
+  std::array<lef_move_t, nlefs> fwd_moves{25, 25, 25, 24,  8,  9};
 
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{},
                                                               CollisionT{0, LEF_LEF_PRIMARY},
@@ -345,8 +346,8 @@ TEST_CASE("Simulation 005 - Multiple LEFs located at the same site", "[simulatio
   std::array<CollisionT, nlefs> rev_collisions;
   std::array<CollisionT, nlefs> fwd_collisions;
 
-  const std::array<bp_t, nlefs> rev_moves_expected{25,  5,  4, 8, 8, 7};
-  const std::array<bp_t, nlefs> fwd_moves_expected{ 4, 18, 19, 6, 8, 9};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{25,  5,  4, 8, 8, 7};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{ 4, 18, 19, 6, 8, 9};
   // clang-format on
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
@@ -388,11 +389,11 @@ TEST_CASE("Simulation 006 - Few inactive LEFs", "[simulation][short]") {
   const auto barriers = construct_barriers(ExtrusionBarrier{100, 1.0, 0.0, '-'});
   REQUIRE(barriers.size() == nbarriers);
 
-  const std::array<usize, nlefs> rev_ranks{0, 1, 3, 4, 2, 5};
-  const std::array<usize, nlefs> fwd_ranks{0, 1, 3, 4, 2, 5};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 3, 4, 2, 5};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{0, 1, 3, 4, 2, 5};
 
-  std::array<bp_t, nlefs> rev_moves{25, 25, 0, 25, 25, 0};
-  std::array<bp_t, nlefs> fwd_moves{25, 25, 0, 24,  9, 0};
+  std::array<lef_move_t, nlefs> rev_moves{25, 25, 0, 25, 25, 0};
+  std::array<lef_move_t, nlefs> fwd_moves{25, 25, 0, 24,  9, 0};
   // clang-format off
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{},
                                                               CollisionT{0, LEF_LEF_PRIMARY},
@@ -409,8 +410,8 @@ TEST_CASE("Simulation 006 - Few inactive LEFs", "[simulation][short]") {
   std::array<CollisionT, nlefs> rev_collisions;
   std::array<CollisionT, nlefs> fwd_collisions;
 
-  const std::array<bp_t, nlefs> rev_moves_expected{25,  5, 0, 9, 8, 0};
-  const std::array<bp_t, nlefs> fwd_moves_expected{ 4, 19, 0, 6, 9, 0};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{25,  5, 0, 9, 8, 0};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{ 4, 19, 0, 6, 9, 0};
   // clang-format on
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
@@ -447,11 +448,11 @@ TEST_CASE("Simulation 007 - LEF-LEF collision overrides LEF-BAR collision 1",
   // clang-format on
   REQUIRE(barriers.size() == nbarriers);
 
-  const std::array<usize, nlefs> rev_ranks{0, 1};
-  const std::array<usize, nlefs> fwd_ranks{0, 1};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{0, 1};
 
-  std::array<bp_t, nlefs> rev_moves{20, 20};
-  std::array<bp_t, nlefs> fwd_moves{20, 20};
+  std::array<lef_move_t, nlefs> rev_moves{20, 20};
+  std::array<lef_move_t, nlefs> fwd_moves{20, 20};
 
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{},
                                                               CollisionT{0, LEF_LEF_PRIMARY}};
@@ -461,8 +462,8 @@ TEST_CASE("Simulation 007 - LEF-LEF collision overrides LEF-BAR collision 1",
   std::array<CollisionT, nlefs> fwd_collisions;
 
   // clang-format off
-  const std::array<bp_t, nlefs> rev_moves_expected{20,  7};
-  const std::array<bp_t, nlefs> fwd_moves_expected{ 7, 20};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{20,  7};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{ 7, 20};
   // clang-format on
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
@@ -497,11 +498,11 @@ TEST_CASE("Simulation 008 - LEF-LEF collision overrides LEF-BAR collision 2",
   // clang-format on
   REQUIRE(barriers.size() == nbarriers);
 
-  const std::array<usize, nlefs> rev_ranks{0, 1};
-  const std::array<usize, nlefs> fwd_ranks{0, 1};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{0, 1};
 
-  std::array<bp_t, nlefs> rev_moves{20, 20};
-  std::array<bp_t, nlefs> fwd_moves{20, 20};
+  std::array<lef_move_t, nlefs> rev_moves{20, 20};
+  std::array<lef_move_t, nlefs> fwd_moves{20, 20};
 
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{},
                                                               CollisionT{0, LEF_LEF_PRIMARY}};
@@ -511,8 +512,8 @@ TEST_CASE("Simulation 008 - LEF-LEF collision overrides LEF-BAR collision 2",
   std::array<CollisionT, nlefs> fwd_collisions;
 
   // clang-format off
-  const std::array<bp_t, nlefs> rev_moves_expected{20,  7};
-  const std::array<bp_t, nlefs> fwd_moves_expected{ 7, 20};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{20,  7};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{ 7, 20};
   // clang-format on
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
@@ -550,11 +551,11 @@ TEST_CASE("Simulation 009 - Ensure stacked LEFs do not interfere with surroundin
   // clang-format on
   REQUIRE(barriers.size() == nbarriers);
 
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2, 3, 4};
-  const std::array<usize, nlefs> fwd_ranks{0, 1, 2, 3, 4};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2, 3, 4};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{0, 1, 2, 3, 4};
 
-  std::array<bp_t, nlefs> rev_moves{10, 10, 10, 10, 10};
-  std::array<bp_t, nlefs> fwd_moves{10, 10, 10, 10, 10};
+  std::array<lef_move_t, nlefs> rev_moves{10, 10, 10, 10, 10};
+  std::array<lef_move_t, nlefs> fwd_moves{10, 10, 10, 10, 10};
   // clang-format off
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{},
                                                               CollisionT{0, LEF_BAR},
@@ -569,8 +570,8 @@ TEST_CASE("Simulation 009 - Ensure stacked LEFs do not interfere with surroundin
   std::array<CollisionT, nlefs> rev_collisions;
   std::array<CollisionT, nlefs> fwd_collisions;
 
-  const std::array<bp_t, nlefs> rev_moves_expected{10, 0,  0,  0,  0};
-  const std::array<bp_t, nlefs> fwd_moves_expected{0,  0, 10, 10, 10};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{10, 0,  0,  0,  0};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{0,  0, 10, 10, 10};
   // clang-format on
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
@@ -612,11 +613,11 @@ TEST_CASE("Simulation 010 - Ensure stacked LEFs do not interfere with surroundin
   // clang-format on
   REQUIRE(barriers.size() == nbarriers);
 
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2, 5, 3, 4};
-  const std::array<usize, nlefs> fwd_ranks{0, 5, 1, 2, 3, 4};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2, 5, 3, 4};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{0, 5, 1, 2, 3, 4};
 
-  std::array<bp_t, nlefs> rev_moves{10, 10, 10, 10, 10, 10};
-  std::array<bp_t, nlefs> fwd_moves{10, 10, 10, 10, 10, 10};
+  std::array<lef_move_t, nlefs> rev_moves{10, 10, 10, 10, 10, 10};
+  std::array<lef_move_t, nlefs> fwd_moves{10, 10, 10, 10, 10, 10};
   // clang-format off
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{},
                                                               CollisionT{0, LEF_BAR},
@@ -633,8 +634,8 @@ TEST_CASE("Simulation 010 - Ensure stacked LEFs do not interfere with surroundin
   std::array<CollisionT, nlefs> rev_collisions;
   std::array<CollisionT, nlefs> fwd_collisions;
 
-  const std::array<bp_t, nlefs> rev_moves_expected{10, 0,  0,  0,  0, 0};
-  const std::array<bp_t, nlefs> fwd_moves_expected{ 0, 0, 10, 10, 10, 0};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{10, 0,  0,  0,  0, 0};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{ 0, 0, 10, 10, 10, 0};
   // clang-format on
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
@@ -673,11 +674,11 @@ TEST_CASE("Simulation 011 - fix_secondary_lef_lef_collisions", "[simulation][sho
   const auto barriers = construct_barriers(ExtrusionBarrier{100, 1.0, 0.0, '-'});
   REQUIRE(barriers.size() == nbarriers);
 
-  std::array<usize, nlefs> rev_ranks{0, 1};
-  std::array<usize, nlefs> fwd_ranks{0, 1};
+  std::array<lef_idx_t, nlefs> rev_ranks{0, 1};
+  std::array<lef_idx_t, nlefs> fwd_ranks{0, 1};
 
-  std::array<bp_t, nlefs> rev_moves{10, 10};
-  std::array<bp_t, nlefs> fwd_moves{10, 10};
+  std::array<lef_move_t, nlefs> rev_moves{10, 10};
+  std::array<lef_move_t, nlefs> fwd_moves{10, 10};
   // clang-format off
   std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{},
                                                         CollisionT{}};
@@ -690,8 +691,8 @@ TEST_CASE("Simulation 011 - fix_secondary_lef_lef_collisions", "[simulation][sho
   std::array<CollisionT, nlefs> fwd_collisions;
 
   // clang-format off
-  const std::array<bp_t, nlefs> rev_moves_expected{10, 10};
-  const std::array<bp_t, nlefs> fwd_moves_expected{ 0,  3};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{10, 10};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{ 0,  3};
   // clang-format on
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
@@ -738,11 +739,11 @@ TEST_CASE("Simulation 012 - fix_secondary_lef_lef_collisions", "[simulation][sho
   const auto barriers = construct_barriers(ExtrusionBarrier{25, 1.0, 0.0, '+'});
   REQUIRE(barriers.size() == nbarriers);
 
-  std::array<usize, nlefs> rev_ranks{0, 1};
-  std::array<usize, nlefs> fwd_ranks{0, 1};
+  std::array<lef_idx_t, nlefs> rev_ranks{0, 1};
+  std::array<lef_idx_t, nlefs> fwd_ranks{0, 1};
 
-  std::array<bp_t, nlefs> rev_moves{10, 10};
-  std::array<bp_t, nlefs> fwd_moves{10, 10};
+  std::array<lef_move_t, nlefs> rev_moves{10, 10};
+  std::array<lef_move_t, nlefs> fwd_moves{10, 10};
   // clang-format off
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{0, LEF_LEF_SECONDARY},
                                                               CollisionT{0, LEF_BAR}};
@@ -753,8 +754,8 @@ TEST_CASE("Simulation 012 - fix_secondary_lef_lef_collisions", "[simulation][sho
   std::array<CollisionT, nlefs> rev_collisions;
   std::array<CollisionT, nlefs> fwd_collisions;
 
-  const std::array<bp_t, nlefs> rev_moves_expected{3, 0};
-  const std::array<bp_t, nlefs> fwd_moves_expected{10, 10};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{3, 0};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{10, 10};
   // clang-format on
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
@@ -782,4 +783,97 @@ TEST_CASE("Simulation 012 - fix_secondary_lef_lef_collisions", "[simulation][sho
                           fwd_collisions_expected);
 }
 
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("Simulation 013 - Fused collision pipeline", "[simulation][short]") {
+  auto c = init_config(25, 25);
+  c.probability_of_extrusion_unit_bypass = 0.25;
+  c.lef_bar_minor_collision_pblock = 0.5;
+  constexpr usize nlefs = 250;
+  constexpr usize nbarriers = 50;
+  constexpr usize iterations = 250;
+  const Chromosome chrom{0, "chr1", 0, 5000, 5000};
+  auto rand_eng = DEFAULT_PRNG;
+
+  auto c_fused = c;
+  c_fused.fused_collision_pipeline = true;
+  modle::Simulation sim{c, false};
+  modle::Simulation sim_fused{c_fused, false};
+
+  auto rand_pos = [&](bp_t lb, bp_t ub) {
+    return random::uniform_int_distribution<bp_t>{lb, ub}(rand_eng);
+  };
+
+  for (usize it = 0; it < iterations; ++it) {
+    std::vector<Lef> lefs(nlefs);
+    for (auto& lef : lefs) {
+      // Leave ~10% of LEFs unbound
+      if (random::bernoulli_trial{0.9}(rand_eng)) {
+        const auto pos = rand_pos(chrom.start_pos(), chrom.end_pos() - 1);
+        lef = construct_lef(pos, std::min(pos + rand_pos(0, 250), chrom.end_pos() - 1));
+      }
+    }
+
+    std::vector<bp_t> barrier_pos(nbarriers);
+    std::generate(barrier_pos.begin(), barrier_pos.end(),
+                  [&]() { return rand_pos(chrom.start_pos(), chrom.end_pos() - 1); });
+    std::sort(barrier_pos.begin(), barrier_pos.end());
+    ExtrusionBarriers barriers;
+    for (const auto pos : barrier_pos) {
+      const auto dir = random::bernoulli_trial{0.5}(rand_eng) ? '+' : '-';
+      const auto state = random::bernoulli_trial{0.75}(rand_eng)
+                             ? ExtrusionBarriers::State::ACTIVE
+                             : ExtrusionBarriers::State::INACTIVE;
+      barriers.push_back(ExtrusionBarrier{pos, 1.0, 0.0, dir}, state);
+    }
+
+    std::vector<lef_idx_t> rev_ranks(nlefs);
+    std::vector<lef_idx_t> fwd_ranks(nlefs);
+    Simulation::test_rank_lefs(lefs, absl::MakeSpan(rev_ranks), absl::MakeSpan(fwd_ranks), false,
+                               true);
+
+    std::vector<lef_move_t> rev_moves(nlefs, 0);
+    std::vector<lef_move_t> fwd_moves(nlefs, 0);
+    for (usize i = 0; i < nlefs; ++i) {
+      if (lefs[i].is_bound()) {
+        rev_moves[i] = static_cast<lef_move_t>(rand_pos(0, 50));
+        fwd_moves[i] = static_cast<lef_move_t>(rand_pos(0, 50));
+      }
+    }
+    Simulation::test_adjust_and_clamp_moves(chrom, lefs, rev_ranks, fwd_ranks,
+                                            absl::MakeSpan(rev_moves), absl::MakeSpan(fwd_moves));
+
+    auto lefs_fused = lefs;
+    auto rev_ranks_fused = rev_ranks;
+    auto fwd_ranks_fused = fwd_ranks;
+    auto rev_moves_fused = rev_moves;
+    auto fwd_moves_fused = fwd_moves;
+    std::vector<CollisionT> rev_collisions(nlefs);
+    std::vector<CollisionT> fwd_collisions(nlefs);
+    std::vector<CollisionT> rev_collisions_fused(nlefs);
+    std::vector<CollisionT> fwd_collisions_fused(nlefs);
+
+    const auto seed = rand_eng();
+    auto rand_eng1 = random::PRNG(seed);
+    auto rand_eng2 = random::PRNG(seed);
+
+    sim.test_process_collisions_pipeline(
+        chrom, absl::MakeSpan(lefs), barriers, absl::MakeSpan(rev_ranks),
+        absl::MakeSpan(fwd_ranks), absl::MakeSpan(rev_moves), absl::MakeSpan(fwd_moves),
+        absl::MakeSpan(rev_collisions), absl::MakeSpan(fwd_collisions), rand_eng1);
+    sim_fused.test_process_collisions_pipeline(
+        chrom, absl::MakeSpan(lefs_fused), barriers, absl::MakeSpan(rev_ranks_fused),
+        absl::MakeSpan(fwd_ranks_fused), absl::MakeSpan(rev_moves_fused),
+        absl::MakeSpan(fwd_moves_fused), absl::MakeSpan(rev_collisions_fused),
+        absl::MakeSpan(fwd_collisions_fused), rand_eng2);
+
+    CHECK(rev_ranks == rev_ranks_fused);
+    CHECK(fwd_ranks == fwd_ranks_fused);
+    CHECK(rev_moves == rev_moves_fused);
+    CHECK(fwd_moves == fwd_moves_fused);
+    CHECK(std::equal(rev_collisions.begin(), rev_collisions.end(), rev_collisions_fused.begin()));
+    CHECK(std::equal(fwd_collisions.begin(), fwd_collisions.end(), fwd_collisions_fused.begin()));
+    CHECK(rand_eng1() == rand_eng2());
+  }
+}
+
 }  // namespace modle::test::libmodle
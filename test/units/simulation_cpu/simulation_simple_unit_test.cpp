@@ -6,7 +6,9 @@
 
 #include <algorithm>  // for all_of, equal, copy, for_each, gene...
 #include <cassert>    // for assert
+#include <catch2/catch_approx.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <cmath>        // for pow
 #include <iterator>     // for back_insert_iterator, back_inserter
 #include <memory>       // for allocator, allocator_traits<>::valu...
 #include <numeric>      // for iota
@@ -29,8 +31,8 @@ TEST_CASE("Bind LEFs 001", "[bind-lefs][simulation][short]") {
   const auto chrom = init_chromosome("chr1", 1000);
   const usize nlefs = 10;
   std::array<Lef, nlefs> lefs;
-  std::array<usize, nlefs> rank1;
-  std::array<usize, nlefs> rank2;
+  std::array<lef_idx_t, nlefs> rank1;
+  std::array<lef_idx_t, nlefs> rank2;
   std::iota(rank1.begin(), rank1.end(), 0);
   std::copy(rank1.begin(), rank1.end(), rank2.begin());
   std::array<usize, nlefs> mask{};
@@ -67,7 +69,7 @@ TEST_CASE("Bind LEFs 001", "[bind-lefs][simulation][short]") {
 TEST_CASE("Bind LEFs 002 - No LEFs to bind", "[bind-lefs][simulation][short]") {
   const auto chrom = init_chromosome("chr1", 1000);
   std::vector<Lef> lefs;
-  std::vector<usize> rank1, rank2;
+  std::vector<lef_idx_t> rank1, rank2;
   boost::dynamic_bitset<> mask1;
   std::vector<int> mask2;
   auto rand_eng = DEFAULT_PRNG;
@@ -111,8 +113,8 @@ TEST_CASE("Bind LEFs 003 - Empty mask (i.e. bind all LEFs)", "[bind-lefs][simula
   const auto chrom = init_chromosome("chr1", 1000);
   const usize nlefs = 10;
   std::array<Lef, nlefs> lefs{};
-  std::array<usize, nlefs> rank1{};
-  std::array<usize, nlefs> rank2{};
+  std::array<lef_idx_t, nlefs> rank1{};
+  std::array<lef_idx_t, nlefs> rank2{};
   std::iota(rank1.begin(), rank1.end(), 0);
   std::copy(rank1.begin(), rank1.end(), rank2.begin());
   boost::dynamic_bitset<> mask;
@@ -138,14 +140,14 @@ TEST_CASE("Adjust LEF moves 001", "[adjust-lef-moves][simulation][short]") {
                                     construct_lef(90, 90, 3)};
 
   // clang-format on
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2};
-  const std::array<usize, nlefs> fwd_ranks{1, 0, 2};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{1, 0, 2};
 
-  std::array<bp_t, nlefs> rev_moves{5, 10, 15};
-  std::array<bp_t, nlefs> fwd_moves{10, 20, 10};
+  std::array<lef_move_t, nlefs> rev_moves{5, 10, 15};
+  std::array<lef_move_t, nlefs> fwd_moves{10, 20, 10};
 
-  const std::array<bp_t, nlefs> rev_moves_adjusted{5, 10, 15};
-  const std::array<bp_t, nlefs> fwd_moves_adjusted{16, 20, 10};
+  const std::array<lef_move_t, nlefs> rev_moves_adjusted{5, 10, 15};
+  const std::array<lef_move_t, nlefs> fwd_moves_adjusted{16, 20, 10};
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
 
@@ -174,14 +176,14 @@ TEST_CASE("Adjust LEF moves 002", "[adjust-lef-moves][simulation][short]") {
                                     construct_lef(125, 305, 5)};
 
   // clang-format on
-  const std::array<usize, nlefs> rev_ranks{0, 1, 5, 2, 3, 4};
-  const std::array<usize, nlefs> fwd_ranks{0, 1, 4, 3, 5, 2};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 5, 2, 3, 4};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{0, 1, 4, 3, 5, 2};
 
-  std::array<bp_t, nlefs> rev_moves{10, 10, 5, 25, 50, 10};
-  std::array<bp_t, nlefs> fwd_moves{25, 10, 5, 20, 20, 0};
+  std::array<lef_move_t, nlefs> rev_moves{10, 10, 5, 25, 50, 10};
+  std::array<lef_move_t, nlefs> fwd_moves{25, 10, 5, 20, 20, 0};
 
-  const std::array<bp_t, nlefs> rev_moves_adjusted{10, 10, 12, 31, 50, 10};
-  const std::array<bp_t, nlefs> fwd_moves_adjusted{25, 16, 12, 20, 20, 16};
+  const std::array<lef_move_t, nlefs> rev_moves_adjusted{10, 10, 12, 31, 50, 10};
+  const std::array<lef_move_t, nlefs> fwd_moves_adjusted{25, 16, 12, 20, 20, 16};
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
 
@@ -204,10 +206,10 @@ TEST_CASE("Generate LEF moves 001", "[generate-lef-moves][simulation][long]") {
   const usize iters = 1000;
   auto rand_eng = DEFAULT_PRNG;
   std::array<Lef, nlefs> lefs{};
-  std::array<usize, nlefs> rev_ranks{};
-  std::array<usize, nlefs> fwd_ranks{};
-  std::array<bp_t, nlefs> rev_moves{};
-  std::array<bp_t, nlefs> fwd_moves{};
+  std::array<lef_idx_t, nlefs> rev_ranks{};
+  std::array<lef_idx_t, nlefs> fwd_ranks{};
+  std::array<lef_move_t, nlefs> rev_moves{};
+  std::array<lef_move_t, nlefs> fwd_moves{};
   auto c = Config{};
   c.bin_size = 500;
   c.rev_extrusion_speed = c.bin_size;
@@ -260,16 +262,16 @@ TEST_CASE("Detect LEF-LEF collisions 001", "[lef-lef-collisions][simulation][sho
     construct_lef(18, 23, 3)
   };
   // clang-format on
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2, 3};
-  const std::array<usize, nlefs> fwd_ranks{0, 1, 2, 3};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2, 3};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{0, 1, 2, 3};
 
   const ExtrusionBarriers barriers{};
 
   std::array<CollisionT, nlefs> fwd_collisions;
   std::array<CollisionT, nlefs> rev_collisions;
 
-  std::array<bp_t, nlefs> rev_moves{0, 3, 3, 3};
-  std::array<bp_t, nlefs> fwd_moves{2, 2, 2, 2};
+  std::array<lef_move_t, nlefs> rev_moves{0, 3, 3, 3};
+  std::array<lef_move_t, nlefs> fwd_moves{2, 2, 2, 2};
   // clang-format off
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{5, CHROM_BOUNDARY},
                                                               CollisionT{0, LEF_LEF_PRIMARY},
@@ -314,16 +316,16 @@ TEST_CASE("Process LEF-LEF collisions 001", "[lef-lef-collisions][simulation][sh
     construct_lef(18, 23, 3)
   };
   // clang-format on
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2, 3};
-  const std::array<usize, nlefs> fwd_ranks{0, 1, 2, 3};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2, 3};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{0, 1, 2, 3};
 
   const ExtrusionBarriers barriers{};
 
   std::array<CollisionT, nlefs> fwd_collisions;
   std::array<CollisionT, nlefs> rev_collisions;
 
-  std::array<bp_t, nlefs> rev_moves{0, 3, 3, 3};
-  std::array<bp_t, nlefs> fwd_moves{2, 2, 2, 2};
+  std::array<lef_move_t, nlefs> rev_moves{0, 3, 3, 3};
+  std::array<lef_move_t, nlefs> fwd_moves{2, 2, 2, 2};
   // clang-format off
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{5, CHROM_BOUNDARY},
                                                               CollisionT{0, LEF_LEF_PRIMARY},
@@ -335,8 +337,8 @@ TEST_CASE("Process LEF-LEF collisions 001", "[lef-lef-collisions][simulation][sh
                                                               CollisionT{}};
   // clang-format on
 
-  const std::array<bp_t, nlefs> rev_moves_expected{0, 1, 3, 2};
-  const std::array<bp_t, nlefs> fwd_moves_expected{0, 2, 1, 2};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{0, 1, 3, 2};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{0, 2, 1, 2};
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
 
@@ -376,16 +378,16 @@ std::vector<Lef> lefs{
     construct_lef(11, 15, 3)
 };
   // clang-format on
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2, 3};
-  const std::array<usize, nlefs> fwd_ranks{0, 1, 2, 3};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2, 3};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{0, 1, 2, 3};
 
   const ExtrusionBarriers barriers{};
 
   std::array<CollisionT, nlefs> rev_collisions;
   std::array<CollisionT, nlefs> fwd_collisions;
 
-  std::array<bp_t, nlefs> rev_moves{0, 3, 3, 4};
-  std::array<bp_t, nlefs> fwd_moves{3, 2, 1, 0};
+  std::array<lef_move_t, nlefs> rev_moves{0, 3, 3, 4};
+  std::array<lef_move_t, nlefs> fwd_moves{3, 2, 1, 0};
   // clang-format off
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{5, CHROM_BOUNDARY},
                                                               CollisionT{},
@@ -397,8 +399,8 @@ std::vector<Lef> lefs{
                                                               CollisionT{3, CHROM_BOUNDARY}};
   // clang-format on
 
-  const std::array<bp_t, nlefs> rev_moves_expected{0, 3, 2, 3};
-  const std::array<bp_t, nlefs> fwd_moves_expected{0, 0, 1, 0};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{0, 3, 2, 3};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{0, 0, 1, 0};
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
 
@@ -438,16 +440,16 @@ std::vector<Lef> lefs{
     construct_lef(140, 141, 2)
 };
   // clang-format on
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2};
-  const std::array<usize, nlefs> fwd_ranks{2, 1, 0};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{2, 1, 0};
 
   const ExtrusionBarriers barriers{};
 
   std::array<CollisionT, nlefs> rev_collisions;
   std::array<CollisionT, nlefs> fwd_collisions;
 
-  std::array<bp_t, nlefs> rev_moves{20, 30, 40};
-  std::array<bp_t, nlefs> fwd_moves{20, 40, 59};
+  std::array<lef_move_t, nlefs> rev_moves{20, 30, 40};
+  std::array<lef_move_t, nlefs> fwd_moves{20, 40, 59};
   // clang-format off
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{5, CHROM_BOUNDARY},
                                                               CollisionT{0, LEF_LEF_SECONDARY},
@@ -457,8 +459,8 @@ std::vector<Lef> lefs{
                                                               CollisionT{1, LEF_LEF_SECONDARY}};
   // clang-format on
 
-  const std::array<bp_t, nlefs> rev_moves_expected{20, 29, 38};
-  const std::array<bp_t, nlefs> fwd_moves_expected{20, 39, 57};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{20, 29, 38};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{20, 39, 57};
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
 
@@ -496,11 +498,11 @@ TEST_CASE("Detect LEF-BAR collisions 001 - wo soft collisions fwd CTCFs",
   // clang-format on
   REQUIRE(barriers.size() == nbarriers);
 
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2};
-  const std::array<usize, nlefs> fwd_ranks{0, 1, 2};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{0, 1, 2};
 
-  std::array<bp_t, nlefs> rev_moves{0, 2, 2};
-  std::array<bp_t, nlefs> fwd_moves{2, 2, 2};
+  std::array<lef_move_t, nlefs> rev_moves{0, 2, 2};
+  std::array<lef_move_t, nlefs> fwd_moves{2, 2, 2};
 
   // clang-format off
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{},
@@ -514,8 +516,8 @@ TEST_CASE("Detect LEF-BAR collisions 001 - wo soft collisions fwd CTCFs",
   std::array<CollisionT, nlefs> rev_collisions;
   std::array<CollisionT, nlefs> fwd_collisions;
 
-  const std::array<bp_t, nlefs> rev_moves_expected{0, 0, 0};
-  const std::array<bp_t, nlefs> fwd_moves_expected{2, 2, 2};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{0, 0, 0};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{2, 2, 2};
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
 
@@ -551,11 +553,11 @@ TEST_CASE("Detect LEF-BAR collisions 002 - wo soft-collisions rev CTCFs",
   // clang-format on
   REQUIRE(barriers.size() == nbarriers);
 
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2};
-  const std::array<usize, nlefs> fwd_ranks{0, 1, 2};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{0, 1, 2};
 
-  std::array<bp_t, nlefs> rev_moves{0, 2, 2};
-  std::array<bp_t, nlefs> fwd_moves{2, 2, 2};
+  std::array<lef_move_t, nlefs> rev_moves{0, 2, 2};
+  std::array<lef_move_t, nlefs> fwd_moves{2, 2, 2};
 
   // clang-format off
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{},
@@ -569,8 +571,8 @@ TEST_CASE("Detect LEF-BAR collisions 002 - wo soft-collisions rev CTCFs",
   std::array<CollisionT, nlefs> rev_collisions;
   std::array<CollisionT, nlefs> fwd_collisions;
 
-  const std::array<bp_t, nlefs> rev_moves_expected{0, 2, 2};
-  const std::array<bp_t, nlefs> fwd_moves_expected{0, 2, 2};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{0, 2, 2};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{0, 2, 2};
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
 
@@ -608,11 +610,11 @@ TEST_CASE("Detect LEF-BAR collisions 003 - w soft-collisions fwd CTCFs",
   // clang-format on
   REQUIRE(barriers.size() == nbarriers);
 
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2};
-  const std::array<usize, nlefs> fwd_ranks{0, 1, 2};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{0, 1, 2};
 
-  std::array<bp_t, nlefs> rev_moves{0, 2, 2};
-  std::array<bp_t, nlefs> fwd_moves{2, 2, 2};
+  std::array<lef_move_t, nlefs> rev_moves{0, 2, 2};
+  std::array<lef_move_t, nlefs> fwd_moves{2, 2, 2};
 
   // clang-format off
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{},
@@ -626,8 +628,8 @@ TEST_CASE("Detect LEF-BAR collisions 003 - w soft-collisions fwd CTCFs",
   std::array<CollisionT, nlefs> rev_collisions;
   std::array<CollisionT, nlefs> fwd_collisions;
 
-  const std::array<bp_t, nlefs> rev_moves_expected{0, 0, 0};
-  const std::array<bp_t, nlefs> fwd_moves_expected{0, 2, 2};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{0, 0, 0};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{0, 2, 2};
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
 
@@ -667,11 +669,11 @@ TEST_CASE("Detect LEF-BAR collisions 004 - wo soft-collisions mixed CTCFs",
   // clang-format on
   REQUIRE(barriers.size() == nbarriers);
 
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2, 3, 4};
-  const std::array<usize, nlefs> fwd_ranks{0, 1, 2, 3, 4};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2, 3, 4};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{0, 1, 2, 3, 4};
 
-  std::array<bp_t, nlefs> rev_moves{5, 5, 5, 5, 5};
-  std::array<bp_t, nlefs> fwd_moves{5, 5, 5, 5, 5};
+  std::array<lef_move_t, nlefs> rev_moves{5, 5, 5, 5, 5};
+  std::array<lef_move_t, nlefs> fwd_moves{5, 5, 5, 5, 5};
 
   // clang-format off
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{},
@@ -689,8 +691,8 @@ TEST_CASE("Detect LEF-BAR collisions 004 - wo soft-collisions mixed CTCFs",
   std::array<CollisionT, nlefs> rev_collisions;
   std::array<CollisionT, nlefs> fwd_collisions;
 
-  const std::array<bp_t, nlefs> rev_moves_expected{5, 0, 2, 1, 5};
-  const std::array<bp_t, nlefs> fwd_moves_expected{5, 5, 5, 2, 5};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{5, 0, 2, 1, 5};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{5, 5, 5, 2, 5};
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
 
@@ -730,11 +732,11 @@ TEST_CASE("Detect LEF-BAR collisions 005 - wo soft-collisions mixed CTCFs, diffe
   // clang-format on
   REQUIRE(barriers.size() == nbarriers);
 
-  const std::array<usize, nlefs> rev_ranks{0, 1, 2, 3, 4};
-  const std::array<usize, nlefs> fwd_ranks{0, 1, 2, 3, 4};
+  const std::array<lef_idx_t, nlefs> rev_ranks{0, 1, 2, 3, 4};
+  const std::array<lef_idx_t, nlefs> fwd_ranks{0, 1, 2, 3, 4};
 
-  std::array<bp_t, nlefs> rev_moves{2, 2, 2, 2, 2};
-  std::array<bp_t, nlefs> fwd_moves{5, 5, 5, 5, 5};
+  std::array<lef_move_t, nlefs> rev_moves{2, 2, 2, 2, 2};
+  std::array<lef_move_t, nlefs> fwd_moves{5, 5, 5, 5, 5};
 
   // clang-format off
   const std::array<CollisionT, nlefs> rev_collisions_expected{CollisionT{},
@@ -752,8 +754,8 @@ TEST_CASE("Detect LEF-BAR collisions 005 - wo soft-collisions mixed CTCFs, diffe
   std::array<CollisionT, nlefs> rev_collisions;
   std::array<CollisionT, nlefs> fwd_collisions;
 
-  const std::array<bp_t, nlefs> rev_moves_expected{2, 0, 2, 1, 2};
-  const std::array<bp_t, nlefs> fwd_moves_expected{5, 5, 5, 2, 5};
+  const std::array<lef_move_t, nlefs> rev_moves_expected{2, 0, 2, 1, 2};
+  const std::array<lef_move_t, nlefs> fwd_moves_expected{5, 5, 5, 2, 5};
 
   require_that_lefs_are_sorted_by_idx(lefs, rev_ranks, fwd_ranks);
 
@@ -793,14 +795,14 @@ TEST_CASE("LEFs ranking 001 - Rev extr. unit tied", "[simulation][short]") {
   };
   // clang-format on
 
-  std::array<usize, nlefs> rev_ranks{};
-  std::array<usize, nlefs> fwd_ranks{};
+  std::array<lef_idx_t, nlefs> rev_ranks{};
+  std::array<lef_idx_t, nlefs> fwd_ranks{};
 
-  const std::array<usize, nlefs> rev_ranks_expected1{0, 1, 2, 5, 3, 4};
-  const std::array<usize, nlefs> fwd_ranks_expected1{0, 5, 1, 2, 3, 4};
+  const std::array<lef_idx_t, nlefs> rev_ranks_expected1{0, 1, 2, 5, 3, 4};
+  const std::array<lef_idx_t, nlefs> fwd_ranks_expected1{0, 5, 1, 2, 3, 4};
 
-  const std::array<usize, nlefs> rev_ranks_expected2{0, 1, 3, 2, 4, 5};
-  const std::array<usize, nlefs> fwd_ranks_expected2{0, 2, 1, 3, 4, 5};
+  const std::array<lef_idx_t, nlefs> rev_ranks_expected2{0, 1, 3, 2, 4, 5};
+  const std::array<lef_idx_t, nlefs> fwd_ranks_expected2{0, 2, 1, 3, 4, 5};
 
   Simulation::test_rank_lefs(lefs1, absl::MakeSpan(rev_ranks), absl::MakeSpan(fwd_ranks), false,
                              true);
@@ -841,14 +843,14 @@ TEST_CASE("LEFs ranking 002 - Fwd extr. unit tied", "[simulation][short]") {
   };
   // clang-format on
 
-  std::array<usize, nlefs> rev_ranks{};
-  std::array<usize, nlefs> fwd_ranks{};
+  std::array<lef_idx_t, nlefs> rev_ranks{};
+  std::array<lef_idx_t, nlefs> fwd_ranks{};
 
-  const std::array<usize, nlefs> rev_ranks_expected1{0, 1, 2, 3, 5, 4};
-  const std::array<usize, nlefs> fwd_ranks_expected1{0, 5, 1, 2, 3, 4};
+  const std::array<lef_idx_t, nlefs> rev_ranks_expected1{0, 1, 2, 3, 5, 4};
+  const std::array<lef_idx_t, nlefs> fwd_ranks_expected1{0, 5, 1, 2, 3, 4};
 
-  const std::array<usize, nlefs> rev_ranks_expected2{0, 2, 3, 4, 1, 5};
-  const std::array<usize, nlefs> fwd_ranks_expected2{0, 1, 2, 3, 4, 5};
+  const std::array<lef_idx_t, nlefs> rev_ranks_expected2{0, 2, 3, 4, 1, 5};
+  const std::array<lef_idx_t, nlefs> fwd_ranks_expected2{0, 1, 2, 3, 4, 5};
 
   Simulation::test_rank_lefs(lefs1, absl::MakeSpan(rev_ranks), absl::MakeSpan(fwd_ranks), false,
                              true);
@@ -865,4 +867,236 @@ TEST_CASE("LEFs ranking 002 - Fwd extr. unit tied", "[simulation][short]") {
   }
 }
 
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("LEFs ranking 003 - Incremental ranking", "[simulation][short]") {
+  constexpr usize nlefs = 1000;
+  constexpr usize nepochs = 250;
+  constexpr bp_t chrom_size = 1'000'000;
+  auto rand_eng = DEFAULT_PRNG;
+
+  auto generate_pos = [&](bp_t lb, bp_t ub) {
+    return random::uniform_int_distribution<bp_t>{lb, ub}(rand_eng);
+  };
+
+  std::vector<Lef> lefs(nlefs);
+  for (auto& lef : lefs) {
+    const auto pos = generate_pos(chrom_size / 4, 3 * chrom_size / 4);
+    lef = construct_lef(pos, pos, 0);
+  }
+
+  std::vector<lef_idx_t> rev_ranks(nlefs);
+  std::vector<lef_idx_t> fwd_ranks(nlefs);
+  std::vector<lef_idx_t> rev_ranks_expected(nlefs);
+  std::vector<lef_idx_t> fwd_ranks_expected(nlefs);
+  Simulation::test_rank_lefs(lefs, absl::MakeSpan(rev_ranks), absl::MakeSpan(fwd_ranks), false,
+                             true);
+
+  auto check_ranks = [&](const auto& ranks, const auto& ranks_expected, auto get_unit) {
+    // Units with identical position and binding epoch can appear in any order
+    for (usize i = 0; i < nlefs; ++i) {
+      const auto& lef1 = lefs[ranks[i]];
+      const auto& lef2 = lefs[ranks_expected[i]];
+      CHECK(get_unit(lef1).pos() == get_unit(lef2).pos());
+      CHECK(lef1.binding_epoch == lef2.binding_epoch);
+    }
+  };
+
+  for (usize epoch = 1; epoch < nepochs; ++epoch) {
+    for (auto& lef : lefs) {
+      if (lef.is_bound()) {
+        // Extrude LEFs and occasionally release them
+        if (random::bernoulli_trial{0.01}(rand_eng)) {
+          lef.release();
+          continue;
+        }
+        const auto rev_pos = lef.rev_unit.pos() - generate_pos(0, 1000);
+        const auto fwd_pos = lef.fwd_unit.pos() + generate_pos(0, 1000);
+        lef = construct_lef(rev_pos, fwd_pos, lef.binding_epoch);
+      } else if (random::bernoulli_trial{0.5}(rand_eng)) {
+        // Bind LEFs, sometimes on top of an existing LEF to produce ties
+        const auto& other = lefs[generate_pos(0, nlefs - 1)];
+        const auto pos = other.is_bound() && random::bernoulli_trial{0.25}(rand_eng)
+                             ? other.rev_unit.pos()
+                             : generate_pos(chrom_size / 4, 3 * chrom_size / 4);
+        lef = construct_lef(pos, pos, epoch);
+      }
+    }
+
+    std::copy(rev_ranks.begin(), rev_ranks.end(), rev_ranks_expected.begin());
+    std::copy(fwd_ranks.begin(), fwd_ranks.end(), fwd_ranks_expected.begin());
+    Simulation::test_rank_lefs(lefs, absl::MakeSpan(rev_ranks), absl::MakeSpan(fwd_ranks), true);
+    Simulation::test_rank_lefs(lefs, absl::MakeSpan(rev_ranks_expected),
+                               absl::MakeSpan(fwd_ranks_expected), false);
+
+    check_ranks(rev_ranks, rev_ranks_expected, [](const Lef& lef) { return lef.rev_unit; });
+    check_ranks(fwd_ranks, fwd_ranks_expected, [](const Lef& lef) { return lef.fwd_unit; });
+  }
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("Release LEFs 001", "[simulation][short]") {
+  using State = ExtrusionBarriers::State;
+  constexpr usize nlefs = 10'000;
+  constexpr usize nepochs = 50;
+
+  auto c = Config{};
+  c.prob_of_lef_release = 0.02;
+  c.prob_of_lef_release_burnin = 0.1;
+  c.hard_stall_lef_stability_multiplier = 5.0;
+  const auto sim = Simulation{c, false};
+
+  // The second half of the LEFs is stalled by a pair of convergent barriers
+  const ExtrusionBarriers barriers{{500, 600},   {dna::REV, dna::FWD}, {0.9, 0.9},
+                                   {0.1, 0.1},   {State::ACTIVE, State::ACTIVE}};
+  std::vector<Lef> lefs(nlefs, construct_lef(550, 550, 0));
+  std::vector<CollisionT> rev_collisions(nlefs);
+  std::vector<CollisionT> fwd_collisions(nlefs);
+  std::vector<Simulation::LefRelease> releases(nlefs);
+  auto stall_lefs = [&](bool stall) {
+    for (usize i = nlefs / 2; i < nlefs; ++i) {
+      rev_collisions[i].clear();
+      fwd_collisions[i].clear();
+      if (stall) {
+        rev_collisions[i].set(0, LEF_BAR);
+        fwd_collisions[i].set(1, LEF_BAR);
+      }
+    }
+  };
+
+  auto rand_eng = random::BatchPRNG{10556020843759504871ULL};
+  auto run_epochs = [&](usize first_epoch, usize last_epoch) {
+    for (auto epoch = first_epoch; epoch < last_epoch; ++epoch) {
+      sim.test_release_lefs(absl::MakeSpan(lefs), barriers, rev_collisions, fwd_collisions,
+                            absl::MakeSpan(releases), epoch, rand_eng, true);
+    }
+  };
+
+  auto fraction_bound = [&](usize first_lef, usize last_lef) {
+    const auto n = std::count_if(lefs.begin() + static_cast<isize>(first_lef),
+                                 lefs.begin() + static_cast<isize>(last_lef),
+                                 [](const auto& lef) { return lef.is_bound(); });
+    return static_cast<double>(n) / static_cast<double>(last_lef - first_lef);
+  };
+
+  const auto p_free = c.prob_of_lef_release;
+  const auto p_stalled = p_free / c.hard_stall_lef_stability_multiplier;
+
+  stall_lefs(true);
+  run_epochs(0, nepochs);
+  const auto survival_free = std::pow(1.0 - p_free, nepochs);
+  const auto survival_stalled = std::pow(1.0 - p_stalled, nepochs);
+  CHECK(fraction_bound(0, nlefs / 2) == Catch::Approx(survival_free).margin(0.03));
+  CHECK(fraction_bound(nlefs / 2, nlefs) == Catch::Approx(survival_stalled).margin(0.03));
+
+  // Releasing the stall should bring the hazard of stalled LEFs back to that of free LEFs
+  stall_lefs(false);
+  run_epochs(nepochs, 2 * nepochs);
+  CHECK(fraction_bound(0, nlefs / 2) ==
+        Catch::Approx(survival_free * survival_free).margin(0.03));
+  CHECK(fraction_bound(nlefs / 2, nlefs) ==
+        Catch::Approx(survival_stalled * survival_free).margin(0.03));
+
+  // Rebound LEFs should get a new release schedule
+  for (auto& lef : lefs) {
+    if (!lef.is_bound()) {
+      lef = construct_lef(550, 550, 2 * nepochs);
+    }
+  }
+  run_epochs(2 * nepochs, 2 * nepochs + 1);
+  CHECK(fraction_bound(0, nlefs) == Catch::Approx(1.0 - p_free).margin(0.01));
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("Sample LEF positions 001", "[simulation][short]") {
+  constexpr bp_t chrom_size = 1'000'000;
+  constexpr bp_t bin_size = 1'000;
+  constexpr usize nlefs = 100;
+
+  auto c = Config{};
+  c.bin_size = bin_size;
+  c.contact_sampling_strategy = Config::ContactSamplingStrategy::loop;
+  const auto sim = Simulation{c, false};
+
+  // Eligible LEFs are bound in every 5th bin. The last LEFs are either unbound or bound at the
+  // chromosome boundaries, and should never be sampled
+  std::vector<Lef> lefs(nlefs);
+  for (usize i = 0; i < nlefs - 10; ++i) {
+    const auto pos = bp_t((i * 5 * bin_size) + (bin_size / 2));
+    lefs[i] = construct_lef(pos, pos, 0);
+  }
+  lefs[nlefs - 2] = construct_lef(0, 0, 0);
+  lefs[nlefs - 1] = construct_lef(chrom_size - 1, chrom_size - 1, 0);
+  const usize num_eligible_lefs = nlefs - 10;
+
+  auto rand_eng = random::BatchPRNG{10556020843759504871ULL};
+  // Test both the sparse (fewer events than LEFs) and dense sampling strategies
+  for (const usize num_events : {usize(50), usize(90'000)}) {
+    auto chrom = init_chromosome("chr1", chrom_size);
+    chrom.allocate_lef_occupancy_buffer(bin_size);
+    sim.test_register_1d_lef_occupancy(chrom, lefs, num_events, rand_eng);
+
+    const auto& occupancy = chrom.lef_1d_occupancy();
+    u64 tot_occupancy = 0;
+    for (usize i = 0; i < occupancy.size(); ++i) {
+      const auto n = occupancy[i].load();
+      tot_occupancy += n;
+      if (i % 5 != 0 || i / 5 >= num_eligible_lefs) {
+        CHECK(n == 0);
+      } else if (num_events > nlefs) {
+        // Each event increments the occupancy of the bins overlapping the rev and fwd unit
+        const auto expected = 2.0 * static_cast<double>(num_events) / num_eligible_lefs;
+        CHECK(static_cast<double>(n) == Catch::Approx(expected).epsilon(0.15));
+      }
+    }
+    CHECK(tot_occupancy == 2 * num_events);
+  }
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("Sample and register contacts 001", "[simulation][short]") {
+  constexpr bp_t chrom_size = 1'000'000;
+  constexpr bp_t bin_size = 1'000;
+  constexpr usize nlefs = 10;
+  constexpr usize num_events = 100;
+
+  auto c = Config{};
+  c.bin_size = bin_size;
+  c.diagonal_width = chrom_size;
+  c.fast_sampling = true;
+  const auto sim = Simulation{c, false};
+
+  auto chrom = init_chromosome("chr1", chrom_size);
+  chrom.allocate_contact_matrix(c.bin_size, c.diagonal_width);
+
+  Simulation::Task task{};
+  task.chrom = &chrom;
+  task.num_target_contacts = 10 * num_events;
+  task.num_lefs = nlefs;
+
+  Simulation::State s{};
+  s = task;
+  s.resize_buffers();
+  s.reset_buffers();
+  s.num_active_lefs = s.num_lefs;
+  s.batch_rand_eng = random::BatchPRNG{10556020843759504871ULL};
+
+  // None of the LEFs are bound: no contacts should be registered nor counted
+  sim.test_sample_and_register_contacts(s, num_events);
+  CHECK(s.num_contacts == 0);
+  CHECK(s.contact_buff.empty());
+
+  // LEFs bound outside of the region where contacts are sampled are not eligible either
+  s.get_lefs()[0] = construct_lef(0, 0, 0);
+  s.get_lefs()[1] = construct_lef(chrom_size - 1, chrom_size - 1, 0);
+  sim.test_sample_and_register_contacts(s, num_events);
+  CHECK(s.num_contacts == 0);
+  CHECK(s.contact_buff.empty());
+
+  // Once a LEF can be sampled, all the requested contacts are registered
+  s.get_lefs()[2] = construct_lef(chrom_size / 2, chrom_size / 2, 0);
+  sim.test_sample_and_register_contacts(s, num_events);
+  CHECK(s.num_contacts == num_events);
+  CHECK(s.contact_buff.size() == num_events);
+}
+
 }  // namespace modle::test::libmodle
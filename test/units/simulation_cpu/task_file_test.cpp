@@ -0,0 +1,166 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+#include "modle/task_file.hpp"  // for Reader, Writer, Record
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+#include <filesystem>  // for path, operator/, copy_file, file_size, resize_file
+#include <fstream>     // for fstream, ofstream
+#include <ios>         // for streamoff
+#include <vector>      // for vector
+
+#include "modle/common/common.hpp"              // for u64, usize
+#include "modle/test/self_deleting_folder.hpp"  // for SelfDeletingFolder
+
+namespace modle::test {
+inline const SelfDeletingFolder testdir{true};  // NOLINT(cert-err58-cpp)
+}  // namespace modle::test
+
+namespace modle::test::libmodle {
+
+[[nodiscard]] static task_file::Record make_record(const u64 id) {
+  task_file::Record r{};
+  r.id = id;
+  r.chrom_id = id % 3;
+  r.cell_id = id;
+  r.num_lefs = 2 * id;
+  r.window_start = 1000 * id;
+  r.window_end = r.window_start + 5000;
+  r.num_feats1 = id % 7;
+  return r;
+}
+
+[[nodiscard]] static u64 read_u64(const std::filesystem::path& path, const u64 offset) {
+  std::ifstream fs(path, std::ios::binary);
+  fs.seekg(static_cast<std::streamoff>(offset));
+  u64 value{};
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  fs.read(reinterpret_cast<char*>(&value), sizeof(u64));
+  return value;
+}
+
+static void overwrite_u64(const std::filesystem::path& path, const u64 offset, const u64 value) {
+  std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+  fs.seekp(static_cast<std::streamoff>(offset));
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  fs.write(reinterpret_cast<const char*>(&value), sizeof(u64));
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("Task file - roundtrip", "[io][simulation][short]") {
+  const auto path = testdir() / "task_file_roundtrip.bin";
+  const std::vector<task_file::ChromInfo> chroms{{0, "chr1"}, {1, "chr2"}, {2, "chrX"}};
+  constexpr usize num_records = 1000;
+  constexpr usize block_size = 64;
+
+  {
+    task_file::Writer w(path, chroms, block_size);
+    for (u64 i = 0; i < num_records; ++i) {
+      w.write(make_record(i));
+    }
+    w.close();
+  }
+
+  REQUIRE(task_file::is_task_file(path));
+  task_file::Reader r(path);
+  REQUIRE(r.chromosomes().size() == chroms.size());
+  for (usize i = 0; i < chroms.size(); ++i) {
+    CHECK(r.chromosomes()[i].id == chroms[i].id);
+    CHECK(r.chromosomes()[i].name == chroms[i].name);
+  }
+  CHECK(r.num_records() == num_records);
+  REQUIRE(r.num_blocks() == (num_records + block_size - 1) / block_size);
+
+  std::vector<task_file::Record> buff{};
+  u64 expected_id = 0;
+  for (usize i = 0; i < r.num_blocks(); ++i) {
+    r.read_block(i, buff);
+    for (const auto& record : buff) {
+      const auto expected = make_record(expected_id++);
+      CHECK(record.id == expected.id);
+      CHECK(record.chrom_id == expected.chrom_id);
+      CHECK(record.num_lefs == expected.num_lefs);
+      CHECK(record.window_end == expected.window_end);
+      CHECK(record.num_feats1 == expected.num_feats1);
+    }
+  }
+  CHECK(expected_id == num_records);
+
+  // Block lookup by task ID
+  CHECK(r.find_blocks({}).empty());
+  CHECK(r.find_blocks(std::vector<u64>{num_records}).empty());
+  CHECK(r.find_blocks(std::vector<u64>{0, 1, 63}) == std::vector<usize>{0});
+  CHECK(r.find_blocks(std::vector<u64>{63, 64, 999}) == std::vector<usize>{0, 1, 15});
+
+  r.read_block(15, buff);
+  REQUIRE(buff.size() == num_records % block_size);
+  CHECK(buff.front().id == 960);
+  CHECK(buff.back().id == 999);
+}
+
+TEST_CASE("Task file - invalid files", "[io][simulation][short]") {
+  const auto path_tsv = testdir() / "task_file_invalid.tsv";
+  {
+    std::ofstream fs(path_tsv);
+    fs << "0\tchr1\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\t0\n";
+  }
+  CHECK_FALSE(task_file::is_task_file(path_tsv));
+  CHECK_THROWS(task_file::Reader(path_tsv));
+
+  // Files are finalized when the writer goes out of scope
+  const auto path_unclosed = testdir() / "task_file_unclosed.bin";
+  {
+    task_file::Writer w(path_unclosed, {});
+    w.write(make_record(0));
+  }
+  CHECK(task_file::is_task_file(path_unclosed));
+  CHECK(task_file::Reader(path_unclosed).num_records() == 1);
+
+  // Files that were not finalized are missing the block index
+  const auto path_truncated = testdir() / "task_file_truncated.bin";
+  std::filesystem::copy_file(path_unclosed, path_truncated,
+                             std::filesystem::copy_options::overwrite_existing);
+  std::filesystem::resize_file(path_truncated, std::filesystem::file_size(path_truncated) - 1);
+  CHECK(task_file::is_task_file(path_truncated));
+  CHECK_THROWS_WITH(task_file::Reader(path_truncated),
+                    Catch::Matchers::ContainsSubstring("footer is missing or corrupted"));
+
+  // Sizes read from corrupted files should be rejected before they are used to allocate memory
+  constexpr u64 huge_size = u64(1) << 60U;
+  const auto file_size = static_cast<u64>(std::filesystem::file_size(path_unclosed));
+  const auto footer_offset = file_size - (2 * sizeof(u64)) - task_file::MAGIC.size();
+  const auto index_offset = read_u64(path_unclosed, footer_offset);
+  auto corrupt_file = [&](const std::string& name, const u64 offset, const u64 value) {
+    const auto path = testdir() / name;
+    std::filesystem::copy_file(path_unclosed, path,
+                               std::filesystem::copy_options::overwrite_existing);
+    overwrite_u64(path, offset, value);
+    return path;
+  };
+
+  // Number of chromosomes (header)
+  const auto num_chroms_offset = task_file::MAGIC.size() + (2 * sizeof(u32));
+  CHECK_THROWS_WITH(
+      task_file::Reader(corrupt_file("task_file_corrupt_header.bin", num_chroms_offset, huge_size)),
+      Catch::Matchers::ContainsSubstring("header is truncated or corrupted"));
+
+  // Number of blocks (footer)
+  CHECK_THROWS_WITH(task_file::Reader(corrupt_file("task_file_corrupt_num_blocks.bin",
+                                                   footer_offset + sizeof(u64), huge_size)),
+                    Catch::Matchers::ContainsSubstring("block index is corrupted"));
+
+  // Size of the first block (index)
+  CHECK_THROWS_WITH(task_file::Reader(corrupt_file("task_file_corrupt_block_size.bin",
+                                                   index_offset + sizeof(u64), huge_size)),
+                    Catch::Matchers::ContainsSubstring("block index is corrupted"));
+
+  // Number of records in the first block (index)
+  task_file::Reader r(corrupt_file("task_file_corrupt_num_records.bin",
+                                   index_offset + (2 * sizeof(u64)), huge_size));
+  std::vector<task_file::Record> buff{};
+  CHECK_THROWS_WITH(r.read_block(0, buff), Catch::Matchers::ContainsSubstring("is truncated"));
+}
+
+}  // namespace modle::test::libmodle
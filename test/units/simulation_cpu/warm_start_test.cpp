@@ -0,0 +1,117 @@
+// Copyright (C) 2022 Roberto Rossini <roberros@uio.no>
+//
+// SPDX-License-Identifier: MIT
+
+#include <absl/types/span.h>  // for MakeConstSpan
+
+#include <catch2/catch_test_macros.hpp>
+#include <memory>   // for make_shared, shared_ptr
+#include <utility>  // for make_pair, move
+#include <vector>   // for vector
+
+#include "./common.hpp"                        // for generate_barriers, init_window_config, same...
+#include "modle/common/common.hpp"             // for bp_t, usize, contacts_t
+#include "modle/common/simulation_config.hpp"  // for Config
+#include "modle/contact_matrix_dense.hpp"      // for ContactMatrixDense
+#include "modle/genome.hpp"                    // for Chromosome
+#include "modle/simulation.hpp"                // for Simulation
+
+namespace modle::test::libmodle {
+
+[[nodiscard]] static Config init_warm_start_config(const bool fast_sampling) {
+  auto c = init_window_config(fast_sampling);
+  c.warm_start = true;
+  c.warm_start_epochs = 0;
+  return c;
+}
+
+static void check_warm_start_seeding(const Config& c) {
+  const Simulation sim(c, false);
+  const bp_t chrom_size = 2'000'000;
+  Chromosome chrom{0, "chr1", 0, chrom_size, chrom_size};
+  const auto barriers = generate_barriers(chrom_size, 40);
+
+  Simulation::TaskPW task{};
+  task.chrom = &chrom;
+  task.num_target_epochs = c.target_simulation_epochs;
+  task.num_target_contacts = 50'000;
+  task.num_lefs = 40;
+  task.barriers = absl::MakeConstSpan(barriers);
+  task.window_start = 0;
+  task.window_end = chrom_size;
+  task.active_window_start = 0;
+  task.active_window_end = chrom_size;
+  task.reference_contacts = std::make_shared<const ContactMatrixDense<contacts_t>>();
+
+  auto simulate_cell = [&](Simulation::State& s, const usize cell_id,
+                           std::shared_ptr<Simulation::WindowSnapshot> snapshot) {
+    task.id = cell_id;
+    task.cell_id = cell_id;
+    task.window_snapshot = std::move(snapshot);
+    s = task;
+    s.resize_buffers();
+    s.reset_buffers();
+    s.contacts = std::make_shared<ContactMatrixDense<contacts_t>>();
+    s.contacts->unsafe_resize(task.window_end - task.window_start, c.diagonal_width, c.bin_size);
+    sim.test_simulate_one_cell_from_snapshot(s);
+  };
+
+  // Snapshots are seeded based on the window, while cells restored from a snapshot are reseeded
+  // based on the snapshot seed and their cell id
+  const auto snapshot_seed = chrom.hash(c.seed, task.window_start);
+
+  // Cell #1 builds the first snapshot, while cell #2 is restored from it
+  auto snapshot1 = std::make_shared<Simulation::WindowSnapshot>();
+  Simulation::State cell1{};
+  simulate_cell(cell1, 1, snapshot1);
+  Simulation::State cell2{};
+  simulate_cell(cell2, 2, snapshot1);
+
+  // Cell #2 builds the second snapshot, while cell #1 is restored from it
+  auto snapshot2 = std::make_shared<Simulation::WindowSnapshot>();
+  Simulation::State cell2_{};
+  simulate_cell(cell2_, 2, snapshot2);
+  Simulation::State cell1_{};
+  simulate_cell(cell1_, 1, snapshot2);
+
+  CHECK(snapshot1->seed == snapshot_seed);
+  CHECK(snapshot2->seed == snapshot_seed);
+  CHECK(cell1.seed == chrom.hash(snapshot_seed, 1));
+  CHECK(cell2.seed == chrom.hash(snapshot_seed, 2));
+
+  // Cells restored from the same snapshot draw different random numbers
+  REQUIRE(cell1.num_contacts >= task.num_target_contacts);
+  REQUIRE(cell2.num_contacts >= task.num_target_contacts);
+  CHECK(!same_contacts(*cell1.contacts, *cell2.contacts));
+
+  // Cells do not depend on which of the tasks referring to the window built the snapshot
+  for (const auto& [s, s_expected] : {std::make_pair(&cell1_, &cell1),
+                                      std::make_pair(&cell2_, &cell2)}) {
+    CHECK(s->seed == s_expected->seed);
+    CHECK(s->epoch == s_expected->epoch);
+    CHECK(s->num_burnin_epochs == s_expected->num_burnin_epochs);
+    CHECK(s->num_contacts == s_expected->num_contacts);
+
+    const auto lefs = s->get_lefs();
+    const auto lefs_expected = s_expected->get_lefs();
+    REQUIRE(lefs.size() == lefs_expected.size());
+    for (usize i = 0; i < lefs.size(); ++i) {
+      CHECK(lefs[i].rev_unit.pos() == lefs_expected[i].rev_unit.pos());
+      CHECK(lefs[i].fwd_unit.pos() == lefs_expected[i].fwd_unit.pos());
+    }
+
+    CHECK(same_contacts(*s->contacts, *s_expected->contacts));
+  }
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("Simulation warm-start - per-cell seeding", "[simulation][short]") {
+  SECTION("default sampling") {
+    check_warm_start_seeding(init_warm_start_config(false));
+  }
+  SECTION("fast sampling") {
+    check_warm_start_seeding(init_warm_start_config(true));
+  }
+}
+
+}  // namespace modle::test::libmodle
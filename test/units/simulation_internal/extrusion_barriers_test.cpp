@@ -6,8 +6,10 @@
 
 #include <catch2/catch_approx.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <vector>  // for vector
 
 #include "modle/common/common.hpp"  // for dna::Direction
+#include "modle/common/random.hpp"  // for PRNG
 
 namespace modle::test::libmodle {
 
@@ -64,6 +66,69 @@ TEST_CASE("Extrusion barriers - sort", "[barriers][simulation][short]") {
   CHECK(std::is_sorted(barriers.pos().begin(), barriers.pos().end()));
 }
 
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("Extrusion barriers - shared table", "[barriers][simulation][short]") {
+  using State = ExtrusionBarriers::State;
+  const auto table = ExtrusionBarriers{{300, 100, 200},
+                                       {dna::FWD, dna::REV, dna::FWD},
+                                       {0.9, 0.8, 0.7},
+                                       {0.6, 0.5, 0.4},
+                                       {State::INACTIVE, State::INACTIVE, State::INACTIVE}};
+
+  ExtrusionBarriers barriers{};
+  barriers.assign(table, State::ACTIVE);
+  REQUIRE(barriers.shares_table_with(table));
+  REQUIRE(barriers.size() == table.size());
+  CHECK(barriers.pos() == table.pos());
+  CHECK(barriers.count_active() == barriers.size());
+  CHECK(table.count_active() == 0);
+
+  // Changing barrier states or sorting an already sorted table does not copy the table
+  auto rand_eng = random::PRNG(8714254316227137853ULL);
+  barriers.init_states(rand_eng);
+  barriers.next_state(rand_eng);
+  barriers.next_state_scheduled(rand_eng);
+  barriers.set(0, State::INACTIVE);
+  barriers.sort();
+  CHECK(barriers.shares_table_with(table));
+
+  // Disabling barriers does not copy the table either
+  barriers.set(2, State::ACTIVE);
+  barriers.disable(2);
+  CHECK(barriers.shares_table_with(table));
+  CHECK(barriers.is_disabled(2));
+  CHECK(!table.is_disabled(2));
+  CHECK(barriers.is_not_active(2));
+  CHECK(barriers.stp_active(2) == 0.0);
+  CHECK(barriers.stp_inactive(2) == 1.0);
+  CHECK(table.stp_active(2) == Catch::Approx(0.9));
+  // Bulk accessors return the content of the barrier table
+  CHECK(barriers.stp_active()[2]() == Catch::Approx(0.9));
+  CHECK(barriers.stp_inactive()[2]() == Catch::Approx(0.6));
+  for (usize i = 0; i < 100; ++i) {
+    barriers.next_state(rand_eng);
+    barriers.next_state_scheduled(rand_eng);
+    CHECK(barriers.is_not_active(2));
+  }
+  barriers.assign(table);
+  CHECK(!barriers.is_disabled(2));
+
+  // Modifying the table of a copy does not affect the original
+  barriers.set(1, 150, dna::REV, 0.0, 1.0, State::INACTIVE);
+  CHECK(!barriers.shares_table_with(table));
+  CHECK(barriers.pos(1) == 150);
+  CHECK(table.pos(1) == 200);
+  CHECK(table.stp_active(1) == Catch::Approx(0.7));
+
+  // Modifying the original after its table has been copied does not affect the copy
+  const auto barriers_copy = barriers;  // NOLINT(performance-unnecessary-copy-initialization)
+  REQUIRE(barriers_copy.shares_table_with(barriers));
+  barriers.set(1, 175, dna::REV, 0.0, 1.0, State::INACTIVE);
+  CHECK(!barriers_copy.shares_table_with(barriers));
+  CHECK(barriers.pos(1) == 175);
+  CHECK(barriers_copy.pos(1) == 150);
+}
+
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 TEST_CASE("Extrusion barriers - compute_occupancy", "[barriers][simulation][short]") {
   auto stp_active = 1.0;
@@ -92,4 +157,59 @@ TEST_CASE("Extrusion barriers - compute_occupancy", "[barriers][simulation][shor
   CHECK(ExtrusionBarrier::compute_occupancy_from_stp(stp_active, stp_inactive) == 0.0);
 }
 
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+TEST_CASE("Extrusion barriers - next_state", "[barriers][simulation][short]") {
+  using State = ExtrusionBarriers::State;
+  const auto stp_inactive = 0.7;
+  const auto occupancies = std::vector<double>{0.5, 0.85, 0.93};
+  constexpr usize num_epochs = 1'000'000;
+
+  auto barriers = ExtrusionBarriers{};
+  for (usize i = 0; i < occupancies.size(); ++i) {
+    const auto stp_active =
+        ExtrusionBarrier::compute_stp_active_from_occupancy(stp_inactive, occupancies[i]);
+    barriers.push_back(bp_t(100 * (i + 1)), dna::FWD, stp_active, stp_inactive);
+  }
+  // Never changes state
+  barriers.push_back(bp_t(1000), dna::REV, 1.0, 0.0, State::ACTIVE);
+
+  auto rand_eng = random::PRNG(10556020843759504871ULL);
+  barriers.init_states(rand_eng);
+
+  auto check_transitions = [&](auto&& next_state) {
+    std::vector<usize> epochs_active(barriers.size(), 0);
+    std::vector<usize> num_transitions(barriers.size(), 0);
+    auto prev_states = barriers.state();
+    for (usize epoch = 0; epoch < num_epochs; ++epoch) {
+      next_state();
+      for (usize i = 0; i < barriers.size(); ++i) {
+        epochs_active[i] += barriers.is_active(i);
+        num_transitions[i] += barriers.state(i) != prev_states[i];
+      }
+      prev_states = barriers.state();
+    }
+
+    for (usize i = 0; i < occupancies.size(); ++i) {
+      // Fraction of epochs spent in the active state should match the stationary occupancy
+      const auto occupancy = static_cast<double>(epochs_active[i]) / num_epochs;
+      CHECK(occupancy == Catch::Approx(occupancies[i]).margin(0.01));
+
+      // Transition rate at equilibrium: occ * (1 - stp_active) + (1 - occ) * (1 - stp_inactive)
+      const auto expected_rate = 2.0 * (1.0 - occupancies[i]) * (1.0 - stp_inactive);
+      const auto rate = static_cast<double>(num_transitions[i]) / num_epochs;
+      CHECK(rate == Catch::Approx(expected_rate).margin(0.01));
+    }
+
+    CHECK(epochs_active.back() == num_epochs);
+    CHECK(num_transitions.back() == 0);
+  };
+
+  SECTION("one trial per epoch") {
+    check_transitions([&]() { barriers.next_state(rand_eng); });
+  }
+  SECTION("scheduled transitions") {
+    check_transitions([&]() { barriers.next_state_scheduled(rand_eng); });
+  }
+}
+
 }  // namespace modle::test::libmodle